@@ -42,6 +42,20 @@ SET(WITH_VIGRANUMPY ${WITH_VIGRANUMPY}
     CACHE BOOL "Build VIGRA Python bindings ?"
     FORCE)
     
+IF(NOT DEFINED WITH_OPENMP)
+    SET(WITH_OPENMP "ON")
+ENDIF()
+SET(WITH_OPENMP ${WITH_OPENMP}
+    CACHE BOOL "Enable multi-threaded algorithms via OpenMP (if supported by the compiler) ?"
+    FORCE)
+    
+IF(NOT DEFINED WITH_BLAS)
+    SET(WITH_BLAS "OFF")
+ENDIF()
+SET(WITH_BLAS ${WITH_BLAS}
+    CACHE BOOL "Also test matrix multiplication with a system BLAS library (if found) ?"
+    FORCE)
+    
 IF(NOT DEFINED WITH_VALGRIND)
     SET(WITH_VALGRIND "OFF")
 ENDIF()
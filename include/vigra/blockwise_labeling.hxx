@@ -0,0 +1,583 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_BLOCKWISE_LABELING_HXX
+#define VIGRA_BLOCKWISE_LABELING_HXX
+
+#include <algorithm>
+#include <functional>
+#include "multi_array.hxx"
+#include "labelimage.hxx"
+#include "labelvolume.hxx"
+#include "union_find.hxx"
+#include "parallel.hxx"
+
+namespace vigra {
+
+namespace detail {
+
+template <class EqualityFunctor>
+struct LabelImageSlab
+{
+    bool eight_neighbors;
+    EqualityFunctor equal;
+
+    LabelImageSlab(bool eight, EqualityFunctor e)
+    : eight_neighbors(eight), equal(e)
+    {}
+
+    template <class T1, class S1, class T2, class S2>
+    unsigned int operator()(MultiArrayView<2, T1, S1> const & src,
+                            MultiArrayView<2, T2, S2> dest) const
+    {
+        return labelImage(srcImageRange(src), destImage(dest), eight_neighbors, equal);
+    }
+};
+
+template <class ValueType, class EqualityFunctor>
+struct LabelImageWithBackgroundSlab
+{
+    bool eight_neighbors;
+    ValueType background;
+    EqualityFunctor equal;
+
+    LabelImageWithBackgroundSlab(bool eight, ValueType b, EqualityFunctor e)
+    : eight_neighbors(eight), background(b), equal(e)
+    {}
+
+    template <class T1, class S1, class T2, class S2>
+    unsigned int operator()(MultiArrayView<2, T1, S1> const & src,
+                            MultiArrayView<2, T2, S2> dest) const
+    {
+        // labelImageWithBackground() doesn't touch the background pixels,
+        // but the merging step relies on them being 0
+        dest.init(0);
+        return labelImageWithBackground(srcImageRange(src), destImage(dest),
+                                        eight_neighbors, background, equal);
+    }
+};
+
+template <class Neighborhood3D, class EqualityFunctor>
+struct LabelVolumeSlab
+{
+    EqualityFunctor equal;
+
+    LabelVolumeSlab(EqualityFunctor e)
+    : equal(e)
+    {}
+
+    template <class T1, class S1, class T2, class S2>
+    unsigned int operator()(MultiArrayView<3, T1, S1> const & src,
+                            MultiArrayView<3, T2, S2> dest) const
+    {
+        return labelVolume(srcMultiArrayRange(src), destMultiArray(dest), Neighborhood3D(), equal);
+    }
+};
+
+template <class Neighborhood3D, class ValueType, class EqualityFunctor>
+struct LabelVolumeWithBackgroundSlab
+{
+    ValueType background;
+    EqualityFunctor equal;
+
+    LabelVolumeWithBackgroundSlab(ValueType b, EqualityFunctor e)
+    : background(b), equal(e)
+    {}
+
+    template <class T1, class S1, class T2, class S2>
+    unsigned int operator()(MultiArrayView<3, T1, S1> const & src,
+                            MultiArrayView<3, T2, S2> dest) const
+    {
+        return labelVolumeWithBackground(srcMultiArrayRange(src), destMultiArray(dest),
+                                         Neighborhood3D(), background, equal);
+    }
+};
+
+    // offsets from a pixel in the first line (resp. slice) of a slab
+    // to its neighbors in the last line (resp. slice) of the preceding slab
+inline ArrayVector<MultiArrayShape<2>::type>
+labelingFaceNeighbors(bool eight_neighbors)
+{
+    typedef MultiArrayShape<2>::type Shape;
+    ArrayVector<Shape> res;
+    for(MultiArrayIndex x = -1; x <= 1; ++x)
+        if(x == 0 || eight_neighbors)
+            res.push_back(Shape(x, -1));
+    return res;
+}
+
+template <class Neighborhood3D>
+ArrayVector<MultiArrayShape<3>::type>
+labelingFaceNeighbors(Neighborhood3D)
+{
+    typedef MultiArrayShape<3>::type Shape;
+    ArrayVector<Shape> res;
+    for(int k = 0; k < Neighborhood3D::DirectionCount; ++k)
+    {
+        Diff3D d = Neighborhood3D::diff(k);
+        if(d[2] == -1)
+            res.push_back(Shape(d[0], d[1], d[2]));
+    }
+    return res;
+}
+
+/* Label the slabs [b*blockSize, (b+1)*blockSize) along the last axis independently
+   and store the number of regions of every slab.
+*/
+template <unsigned int N, class T1, class S1, class T2, class S2, class SlabLabeler>
+struct LabelBlocksFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    MultiArrayView<N, T1, S1>   src;
+    MultiArrayView<N, T2, S2>   dest;
+    SlabLabeler const &         labeler;
+    MultiArrayIndex             blockSize;
+    unsigned int *              counts;
+
+    LabelBlocksFunctor(MultiArrayView<N, T1, S1> const & s,
+                       MultiArrayView<N, T2, S2> const & d,
+                       SlabLabeler const & l, MultiArrayIndex b, unsigned int * c)
+    : src(s), dest(d), labeler(l), blockSize(b), counts(c)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        for(; begin < end; ++begin)
+        {
+            Shape start, stop(src.shape());
+            start[N-1] = begin * blockSize;
+            stop[N-1]  = std::min(start[N-1] + blockSize, src.shape(N-1));
+            counts[begin] = labeler(src.subarray(start, stop), dest.subarray(start, stop));
+        }
+    }
+};
+
+/* Map the slab labels to their global region labels.
+*/
+template <unsigned int N, class T2, class S2>
+struct RelabelBlocksFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    MultiArrayView<N, T2, S2>       dest;
+    UnionFindArray<T2> const &      labels;
+    ArrayVector<T2> const &         offsets;
+    MultiArrayIndex                 blockSize;
+
+    RelabelBlocksFunctor(MultiArrayView<N, T2, S2> const & d, UnionFindArray<T2> const & l,
+                         ArrayVector<T2> const & o, MultiArrayIndex b)
+    : dest(d), labels(l), offsets(o), blockSize(b)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        for(; begin < end; ++begin)
+        {
+            Shape start, stop(dest.shape());
+            start[N-1] = begin * blockSize;
+            stop[N-1]  = std::min(start[N-1] + blockSize, dest.shape(N-1));
+            MultiArrayView<N, T2, StridedArrayTag> block(dest.subarray(start, stop));
+            T2 offset = offsets[begin];
+            typename MultiArrayView<N, T2, StridedArrayTag>::iterator i = block.begin(),
+                                                                      iend = block.end();
+            for(; i != iend; ++i)
+                if(*i != 0) // background
+                    *i = labels[*i + offset];
+        }
+    }
+};
+
+template <unsigned int N, class T1, class S1, class T2, class S2,
+          class SlabLabeler, class EqualityFunctor>
+unsigned int
+labelBlockwiseImpl(MultiArrayView<N, T1, S1> const & src,
+                   MultiArrayView<N, T2, S2> dest,
+                   SlabLabeler const & labeler,
+                   ArrayVector<typename MultiArrayShape<N>::type> const & faceNeighbors,
+                   EqualityFunctor equal,
+                   int nthreads, MultiArrayIndex blockSize)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    vigra_precondition(src.shape() == dest.shape(),
+        "labelBlockwise(): shape mismatch between input and output.");
+    vigra_precondition(blockSize >= 1,
+        "labelBlockwise(): block size must be positive.");
+
+    if(src.size() == 0)
+        return 0;
+
+    MultiArrayIndex size = src.shape(N-1);
+    std::ptrdiff_t blocks = (size + blockSize - 1) / blockSize;
+    if(blocks == 1)
+        return labeler(src, dest);
+
+    // pass 1: label the slabs independently
+    ArrayVector<unsigned int> counts(blocks);
+    LabelBlocksFunctor<N, T1, S1, T2, S2, SlabLabeler>
+        labelBlocks(src, dest, labeler, blockSize, counts.begin());
+    parallelForChunks(blocks, labelBlocks, nthreads);
+
+    // slab b's labels are mapped to the global range (offsets[b], offsets[b] + counts[b]]
+    // in scan order, so that the global union-find yields the serial label order
+    ArrayVector<T2> offsets(blocks);
+    double total = 0.0;
+    for(std::ptrdiff_t b = 0; b < blocks; ++b)
+    {
+        offsets[b] = (T2)total;
+        total += counts[b];
+    }
+    vigra_invariant(total < (double)NumericTraits<T2>::max(),
+        "connected components: Need more labels than can be represented in the destination type.");
+    UnionFindArray<T2> labels((T2)total + 1);
+
+    // pass 2: merge the regions touching across the faces between slabs
+    Shape faceShape(src.shape());
+    faceShape[N-1] = 1;
+    MultiArrayIndex faceSize = prod(faceShape);
+    for(std::ptrdiff_t b = 1; b < blocks; ++b)
+    {
+        Shape p;
+        p[N-1] = b * blockSize;
+        for(MultiArrayIndex k = 0; k < faceSize; ++k)
+        {
+            T2 label = dest[p];
+            if(label != 0)
+            {
+                for(unsigned int j = 0; j < faceNeighbors.size(); ++j)
+                {
+                    Shape q(p + faceNeighbors[j]);
+                    if(!src.isInside(q) || dest[q] == 0 || !equal(src[p], src[q]))
+                        continue;
+                    labels.makeUnion(label + offsets[b], dest[q] + offsets[b-1]);
+                }
+            }
+            // next pixel of the face in scan order
+            for(unsigned int d = 0; d < N-1; ++d)
+            {
+                if(++p[d] < faceShape[d])
+                    break;
+                p[d] = 0;
+            }
+        }
+    }
+    unsigned int count = labels.makeContiguous();
+
+    // pass 3: assign the final labels
+    RelabelBlocksFunctor<N, T2, S2> relabelBlocks(dest, labels, offsets, blockSize);
+    parallelForChunks(blocks, relabelBlocks, nthreads);
+    return count;
+}
+
+} // namespace detail
+
+/** \addtogroup Labeling
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                  labelImageBlockwise                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Multi-threaded connected components labeling of an image.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <class T1, class S1, class T2, class S2>
+        unsigned int
+        labelImageBlockwise(MultiArrayView<2, T1, S1> const & src,
+                            MultiArrayView<2, T2, S2> dest,
+                            bool eight_neighbors,
+                            int nthreads, MultiArrayIndex blockSize = 64);
+
+        template <class T1, class S1, class T2, class S2, class EqualityFunctor>
+        unsigned int
+        labelImageBlockwise(MultiArrayView<2, T1, S1> const & src,
+                            MultiArrayView<2, T2, S2> dest,
+                            bool eight_neighbors,
+                            int nthreads, MultiArrayIndex blockSize,
+                            EqualityFunctor equal);
+
+        template <class T1, class S1, class T2, class S2, class ValueType>
+        unsigned int
+        labelImageWithBackgroundBlockwise(MultiArrayView<2, T1, S1> const & src,
+                                          MultiArrayView<2, T2, S2> dest,
+                                          bool eight_neighbors, ValueType background_value,
+                                          int nthreads, MultiArrayIndex blockSize = 64);
+
+        template <class T1, class S1, class T2, class S2,
+                  class ValueType, class EqualityFunctor>
+        unsigned int
+        labelImageWithBackgroundBlockwise(MultiArrayView<2, T1, S1> const & src,
+                                          MultiArrayView<2, T2, S2> dest,
+                                          bool eight_neighbors, ValueType background_value,
+                                          int nthreads, MultiArrayIndex blockSize,
+                                          EqualityFunctor equal);
+    }
+    \endcode
+
+    These functions compute exactly the same labeling as \ref labelImage() and
+    \ref labelImageWithBackground() (including the order of the labels), but
+    distribute the work over <tt>nthreads</tt> threads (see \ref parallelThreadCount()):
+
+    <ol>
+    <li> The image is divided into stripes of <tt>blockSize</tt> lines, and each
+         stripe is labeled independently by the serial algorithm.
+    <li> The regions of adjacent stripes which touch across the face between
+         the stripes are merged by means of a union-find structure. Since the
+         stripe labels are ordered along the scan order, merging always keeps
+         the region's label of the first stripe.
+    <li> All pixels are relabeled such that the labels form the consecutive
+         sequence 1, 2, ... in scan order.
+    </ol>
+
+    Passes 1 and 3 run in parallel, the (comparatively cheap) merging is serial.
+    In contrast to \ref labelImageWithBackground(), which leaves the background
+    pixels of the destination unchanged, <tt>labelImageWithBackgroundBlockwise()</tt>
+    sets them to 0 (as \ref labelVolumeWithBackground() does).
+    The destination's value type must be able to hold the sum of the region
+    counts of all stripes.
+
+    Return: the number of regions found (= largest region label)
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/blockwise_labeling.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<2, UInt8> mask(w, h);
+    MultiArray<2, UInt32> labels(w, h);
+    ...
+    // find 8-connected foreground regions on 4 threads
+    unsigned int max_region_label =
+        labelImageWithBackgroundBlockwise(mask, labels, true, 0, 4);
+    \endcode
+*/
+doxygen_overloaded_function(template <...> unsigned int labelImageBlockwise)
+
+template <class T1, class S1, class T2, class S2, class EqualityFunctor>
+inline unsigned int
+labelImageBlockwise(MultiArrayView<2, T1, S1> const & src,
+                    MultiArrayView<2, T2, S2> dest,
+                    bool eight_neighbors,
+                    int nthreads, MultiArrayIndex blockSize,
+                    EqualityFunctor equal)
+{
+    return detail::labelBlockwiseImpl(src, dest,
+                                      detail::LabelImageSlab<EqualityFunctor>(eight_neighbors, equal),
+                                      detail::labelingFaceNeighbors(eight_neighbors), equal,
+                                      nthreads, blockSize);
+}
+
+template <class T1, class S1, class T2, class S2>
+inline unsigned int
+labelImageBlockwise(MultiArrayView<2, T1, S1> const & src,
+                    MultiArrayView<2, T2, S2> dest,
+                    bool eight_neighbors,
+                    int nthreads, MultiArrayIndex blockSize = 64)
+{
+    return labelImageBlockwise(src, dest, eight_neighbors, nthreads, blockSize,
+                               std::equal_to<T1>());
+}
+
+template <class T1, class S1, class T2, class S2,
+          class ValueType, class EqualityFunctor>
+inline unsigned int
+labelImageWithBackgroundBlockwise(MultiArrayView<2, T1, S1> const & src,
+                                  MultiArrayView<2, T2, S2> dest,
+                                  bool eight_neighbors, ValueType background_value,
+                                  int nthreads, MultiArrayIndex blockSize,
+                                  EqualityFunctor equal)
+{
+    return detail::labelBlockwiseImpl(src, dest,
+                                      detail::LabelImageWithBackgroundSlab<ValueType, EqualityFunctor>(
+                                                             eight_neighbors, background_value, equal),
+                                      detail::labelingFaceNeighbors(eight_neighbors), equal,
+                                      nthreads, blockSize);
+}
+
+template <class T1, class S1, class T2, class S2, class ValueType>
+inline unsigned int
+labelImageWithBackgroundBlockwise(MultiArrayView<2, T1, S1> const & src,
+                                  MultiArrayView<2, T2, S2> dest,
+                                  bool eight_neighbors, ValueType background_value,
+                                  int nthreads, MultiArrayIndex blockSize = 64)
+{
+    return labelImageWithBackgroundBlockwise(src, dest, eight_neighbors, background_value,
+                                             nthreads, blockSize, std::equal_to<T1>());
+}
+
+/********************************************************/
+/*                                                      */
+/*                 labelVolumeBlockwise                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Multi-threaded connected components labeling of a volume.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <class T1, class S1, class T2, class S2, class Neighborhood3D>
+        unsigned int
+        labelVolumeBlockwise(MultiArrayView<3, T1, S1> const & src,
+                             MultiArrayView<3, T2, S2> dest,
+                             Neighborhood3D neighborhood3D,
+                             int nthreads, MultiArrayIndex blockSize = 64);
+
+        template <class T1, class S1, class T2, class S2,
+                  class Neighborhood3D, class EqualityFunctor>
+        unsigned int
+        labelVolumeBlockwise(MultiArrayView<3, T1, S1> const & src,
+                             MultiArrayView<3, T2, S2> dest,
+                             Neighborhood3D neighborhood3D,
+                             int nthreads, MultiArrayIndex blockSize,
+                             EqualityFunctor equal);
+
+        template <class T1, class S1, class T2, class S2,
+                  class Neighborhood3D, class ValueType>
+        unsigned int
+        labelVolumeWithBackgroundBlockwise(MultiArrayView<3, T1, S1> const & src,
+                                           MultiArrayView<3, T2, S2> dest,
+                                           Neighborhood3D neighborhood3D,
+                                           ValueType backgroundValue,
+                                           int nthreads, MultiArrayIndex blockSize = 64);
+
+        template <class T1, class S1, class T2, class S2,
+                  class Neighborhood3D, class ValueType, class EqualityFunctor>
+        unsigned int
+        labelVolumeWithBackgroundBlockwise(MultiArrayView<3, T1, S1> const & src,
+                                           MultiArrayView<3, T2, S2> dest,
+                                           Neighborhood3D neighborhood3D,
+                                           ValueType backgroundValue,
+                                           int nthreads, MultiArrayIndex blockSize,
+                                           EqualityFunctor equal);
+    }
+    \endcode
+
+    These functions compute exactly the same labeling as \ref labelVolume() and
+    \ref labelVolumeWithBackground() (including the order of the labels).
+    The volume is divided into slabs of <tt>blockSize</tt> slices along the z-axis
+    which are labeled concurrently on <tt>nthreads</tt> threads. The regions touching
+    across the faces between the slabs are then merged, and the labels are made
+    contiguous in scan order. See \ref labelImageBlockwise() for details.
+
+    Return: the number of regions found (= largest region label)
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/blockwise_labeling.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt8> mask(shape);
+    MultiArray<3, UInt32> labels(shape);
+    ...
+    // find 26-connected foreground regions using all available threads
+    unsigned int max_region_label =
+        labelVolumeWithBackgroundBlockwise(mask, labels, NeighborCode3DTwentySix(), 0, 0);
+    \endcode
+*/
+doxygen_overloaded_function(template <...> unsigned int labelVolumeBlockwise)
+
+template <class T1, class S1, class T2, class S2,
+          class Neighborhood3D, class EqualityFunctor>
+inline unsigned int
+labelVolumeBlockwise(MultiArrayView<3, T1, S1> const & src,
+                     MultiArrayView<3, T2, S2> dest,
+                     Neighborhood3D neighborhood3D,
+                     int nthreads, MultiArrayIndex blockSize,
+                     EqualityFunctor equal)
+{
+    return detail::labelBlockwiseImpl(src, dest,
+                                      detail::LabelVolumeSlab<Neighborhood3D, EqualityFunctor>(equal),
+                                      detail::labelingFaceNeighbors(neighborhood3D), equal,
+                                      nthreads, blockSize);
+}
+
+template <class T1, class S1, class T2, class S2, class Neighborhood3D>
+inline unsigned int
+labelVolumeBlockwise(MultiArrayView<3, T1, S1> const & src,
+                     MultiArrayView<3, T2, S2> dest,
+                     Neighborhood3D neighborhood3D,
+                     int nthreads, MultiArrayIndex blockSize = 64)
+{
+    return labelVolumeBlockwise(src, dest, neighborhood3D, nthreads, blockSize,
+                                std::equal_to<T1>());
+}
+
+template <class T1, class S1, class T2, class S2,
+          class Neighborhood3D, class ValueType, class EqualityFunctor>
+inline unsigned int
+labelVolumeWithBackgroundBlockwise(MultiArrayView<3, T1, S1> const & src,
+                                   MultiArrayView<3, T2, S2> dest,
+                                   Neighborhood3D neighborhood3D,
+                                   ValueType backgroundValue,
+                                   int nthreads, MultiArrayIndex blockSize,
+                                   EqualityFunctor equal)
+{
+    return detail::labelBlockwiseImpl(src, dest,
+                                      detail::LabelVolumeWithBackgroundSlab<Neighborhood3D, ValueType, 
+                                                                            EqualityFunctor>(backgroundValue, equal),
+                                      detail::labelingFaceNeighbors(neighborhood3D), equal,
+                                      nthreads, blockSize);
+}
+
+template <class T1, class S1, class T2, class S2,
+          class Neighborhood3D, class ValueType>
+inline unsigned int
+labelVolumeWithBackgroundBlockwise(MultiArrayView<3, T1, S1> const & src,
+                                   MultiArrayView<3, T2, S2> dest,
+                                   Neighborhood3D neighborhood3D,
+                                   ValueType backgroundValue,
+                                   int nthreads, MultiArrayIndex blockSize = 64)
+{
+    return labelVolumeWithBackgroundBlockwise(src, dest, neighborhood3D, backgroundValue,
+                                              nthreads, blockSize, std::equal_to<T1>());
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_BLOCKWISE_LABELING_HXX
@@ -0,0 +1,1264 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_BLOCKWISE_SEEDEDREGIONGROWING_HXX
+#define VIGRA_BLOCKWISE_SEEDEDREGIONGROWING_HXX
+
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <vector>
+#include "multi_array.hxx"
+#include "seededregiongrowing.hxx"
+#include "seededregiongrowing3d.hxx"
+#include "parallel.hxx"
+
+namespace vigra {
+namespace detail {
+
+/* Candidate of the blockwise region growing. The ordering is the same
+   as in SeedRgPixel::Compare and SeedRgVoxel::Compare: by cost, then by
+   the distance to the nearest seed pixel, then by insertion order.
+*/
+template <unsigned int N, class COST>
+struct SeedRgBlockwiseCandidate
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    Shape location_, nearest_;
+    COST cost_;
+    int count_;
+    int label_;
+    int dist_;
+
+    SeedRgBlockwiseCandidate()
+    : cost_(), count_(0), label_(0), dist_(0)
+    {}
+
+    SeedRgBlockwiseCandidate(Shape const & location, Shape const & nearest,
+                             COST const & cost, int count, int label)
+    : location_(location), nearest_(nearest),
+      cost_(cost), count_(count), label_(label),
+      dist_((int)squaredNorm(location - nearest))
+    {}
+
+    struct Compare
+    {
+        // must implement > since priority_queue looks for largest element
+        bool operator()(SeedRgBlockwiseCandidate const & l,
+                        SeedRgBlockwiseCandidate const & r) const
+        {
+            if(r.cost_ == l.cost_)
+            {
+                if(r.dist_ == l.dist_) return r.count_ < l.count_;
+
+                return r.dist_ < l.dist_;
+            }
+
+            return r.cost_ < l.cost_;
+        }
+    };
+};
+
+/* Statistics whose cost does not depend on the region and does not change
+   while the regions grow, so that the blocks can be flooded independently.
+*/
+template <class RegionStatistics>
+struct SeedRgHasStaticCost
+{
+    typedef VigraFalseType type;
+};
+
+template <class Value>
+struct SeedRgHasStaticCost<SeedRgDirectValueFunctor<Value> >
+{
+    typedef VigraTrueType type;
+};
+
+/* Time at which the serial algorithm pops a candidate, expressed without
+   the global insertion counter.
+
+   The serial queue pops the candidate with the smallest key (cost, distance,
+   insertion order). When a candidate is popped whose key exceeds all keys
+   popped before, everything still in the queue has a larger key, so the
+   candidates popped next until a still larger key comes up are exactly its
+   descendants with smaller keys, and the same holds recursively among these.
+   Hence a candidate is popped at the time given by the decreasing stack of
+   those keys on the chain from its initial candidate that are larger than
+   all later keys on the chain, and times are ordered lexicographically, a
+   stack coming before the stacks it is a prefix of. The insertion order of a
+   candidate is the time of its parent followed by the direction, initial
+   candidates come first in scan order. So the time of a candidate only
+   depends on its ancestors, and blocks flooded independently agree with the
+   serial algorithm about the order of their candidates.
+*/
+template <unsigned int N, class COST>
+struct SeedRgArrivalTime
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    Shape location_, nearest_;
+    COST cost_, bottomCost_;             // cost of this and of the first key on the stack
+    int dist_;
+    SeedRgArrivalTime const * parent_;   // time of the pushing pixel, 0 for initial candidates
+    MultiArrayIndex order_;              // direction resp. scan order of initial candidates
+    SeedRgArrivalTime const * below_;    // next key on the stack
+    SeedRgArrivalTime const * bottom_;   // first key on the stack, 0 if it is this key
+    SeedRgArrivalTime const * crossing_; // latest ancestor in another block
+    SeedRgArrivalTime const * previous_; // earlier time object of the same pixel
+    unsigned int depth_;
+
+    SeedRgArrivalTime()
+    : cost_(), bottomCost_(), dist_(0), parent_(0), order_(0), below_(0), bottom_(0), crossing_(0), previous_(0), depth_(1)
+    {}
+
+        // initial candidate
+    SeedRgArrivalTime(Shape const & location, Shape const & nearest,
+                      COST const & cost, MultiArrayIndex order)
+    : location_(location), nearest_(nearest), cost_(cost), bottomCost_(cost),
+      dist_((int)squaredNorm(location - nearest)),
+      parent_(0), order_(order), below_(0), bottom_(0), crossing_(0), previous_(0), depth_(1)
+    {}
+
+        // candidate pushed when the pixel with time 'parent' was labelled
+    SeedRgArrivalTime(Shape const & location, COST const & cost,
+                      SeedRgArrivalTime const & parent, MultiArrayIndex direction,
+                      SeedRgArrivalTime const * crossing)
+    : location_(location), nearest_(parent.nearest_), cost_(cost), bottomCost_(cost),
+      dist_((int)squaredNorm(location - parent.nearest_)),
+      parent_(&parent), order_(direction), below_(&parent), bottom_(0), crossing_(crossing),
+      previous_(0), depth_(1)
+    {
+        while(below_ != 0 && compareKeys(*below_, *this) < 0)
+            below_ = below_->below_;
+        if(below_ != 0)
+        {
+            bottom_ = &below_->bottom();
+            bottomCost_ = below_->bottomCost_;
+            depth_ = below_->depth_ + 1;
+        }
+    }
+
+    SeedRgArrivalTime const & bottom() const
+    {
+        return bottom_ == 0 ? *this : *bottom_;
+    }
+
+    static int compareKeys(SeedRgArrivalTime const & a, SeedRgArrivalTime const & b)
+    {
+        if(a.cost_ < b.cost_)
+            return -1;
+        if(b.cost_ < a.cost_)
+            return 1;
+        if(a.dist_ != b.dist_)
+            return a.dist_ < b.dist_ ? -1 : 1;
+        if(a.parent_ != b.parent_)
+        {
+            if(a.parent_ == 0)
+                return -1;
+            if(b.parent_ == 0)
+                return 1;
+            int c = compareTimes(*a.parent_, *b.parent_);
+            if(c != 0)
+                return c;
+        }
+        return a.order_ < b.order_ ? -1 : a.order_ > b.order_ ? 1 : 0;
+    }
+
+    static int compareTimes(SeedRgArrivalTime const & a, SeedRgArrivalTime const & b)
+    {
+        if(&a == &b)
+            return 0;
+        if(a.bottomCost_ < b.bottomCost_)
+            return -1;
+        if(b.bottomCost_ < a.bottomCost_)
+            return 1;
+        if(&a.bottom() != &b.bottom())
+        {
+            int c = compareKeys(a.bottom(), b.bottom());
+            if(c != 0)
+                return c;
+        }
+        if(a.depth_ == 1 && b.depth_ == 1)
+            return 0;
+
+        // compare the remaining keys from the bottom of the stacks, skipping
+        // the part both stacks share
+        SeedRgArrivalTime const * s = &a, * t = &b;
+        for(unsigned int k = a.depth_; k > b.depth_; --k)
+            s = s->below_;
+        for(unsigned int k = b.depth_; k > a.depth_; --k)
+            t = t->below_;
+        enum { BufferSize = 64 };
+        SeedRgArrivalTime const * buffer[2*BufferSize];
+        ArrayVector<SeedRgArrivalTime const *> heap;
+        SeedRgArrivalTime const ** sa = buffer, ** sb = buffer + BufferSize;
+        unsigned int size = 0;
+        for(; s != t; s = s->below_, t = t->below_, ++size)
+        {
+            if(size == BufferSize && heap.size() == 0)
+            {
+                heap.resize(2*std::min(a.depth_, b.depth_));
+                std::copy(sa, sa + size, heap.begin());
+                std::copy(sb, sb + size, heap.begin() + heap.size() / 2);
+                sa = heap.begin();
+                sb = heap.begin() + heap.size() / 2;
+            }
+            sa[size] = s;
+            sb[size] = t;
+        }
+        while(size > 0)
+        {
+            --size;
+            int c = compareKeys(*sa[size], *sb[size]);
+            if(c != 0)
+                return c;
+        }
+        return a.depth_ < b.depth_ ? -1 : a.depth_ > b.depth_ ? 1 : 0;
+    }
+};
+
+/* Candidate of the concurrent flooding, ordered by its arrival time.
+*/
+template <unsigned int N, class COST>
+struct SeedRgBlockwiseArrival
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef COST CostType;
+    typedef SeedRgArrivalTime<N, COST> Time;
+
+    int label_;
+    Time time_;
+
+    SeedRgBlockwiseArrival()
+    : label_(0)
+    {}
+
+    SeedRgBlockwiseArrival(int label, Time const & time)
+    : label_(label), time_(time)
+    {}
+
+    struct Compare
+    {
+        // must implement > since priority_queue looks for largest element
+        bool operator()(SeedRgBlockwiseArrival const & l,
+                        SeedRgBlockwiseArrival const & r) const
+        {
+            return Time::compareTimes(l.time_, r.time_) > 0;
+        }
+    };
+};
+
+template <unsigned int N>
+inline void
+seededRegionGrowingBlockRange(typename MultiArrayShape<N>::type const & shape,
+                              MultiArrayIndex blockSize,
+                              std::ptrdiff_t begin, std::ptrdiff_t end,
+                              typename MultiArrayShape<N>::type & start,
+                              typename MultiArrayShape<N>::type & stop)
+{
+    start = typename MultiArrayShape<N>::type();
+    stop  = shape;
+    start[N-1] = std::min<MultiArrayIndex>(begin * blockSize, shape[N-1]);
+    stop[N-1]  = std::min<MultiArrayIndex>(end * blockSize, shape[N-1]);
+}
+
+/* Copy the seeds of the blocks [begin, end) along the last axis into
+   the interior of the label array.
+*/
+template <unsigned int N, class T2, class S2>
+struct SeedRgBlockwiseCopySeedsFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    MultiArrayView<N, T2, S2>               seeds;
+    MultiArrayView<N, int, StridedArrayTag> regions;
+    MultiArrayIndex                         blockSize;
+
+    SeedRgBlockwiseCopySeedsFunctor(MultiArrayView<N, T2, S2> const & s,
+                                    MultiArrayView<N, int, StridedArrayTag> const & r,
+                                    MultiArrayIndex b)
+    : seeds(s), regions(r), blockSize(b)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        Shape start, stop;
+        seededRegionGrowingBlockRange<N>(seeds.shape(), blockSize, begin, end, start, stop);
+        MultiArrayView<N, T2, StridedArrayTag> s(seeds.subarray(start, stop));
+        MultiArrayView<N, int, StridedArrayTag> r(regions.subarray(start, stop));
+        typename MultiArrayView<N, T2, StridedArrayTag>::iterator i = s.begin(), iend = s.end();
+        typename MultiArrayView<N, int, StridedArrayTag>::iterator j = r.begin();
+        for(; i != iend; ++i, ++j)
+            *j = detail::RequiresExplicitCast<int>::cast(*i);
+    }
+};
+
+/* Collect the initial candidates of the blocks [begin, end) in scan order,
+   i.e. in the order in which the serial algorithm inserts them.
+*/
+template <unsigned int N, class T1, class S1, class RegionStatisticsArray, class Candidate>
+struct SeedRgBlockwiseCandidatesFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    MultiArrayView<N, T1, S1>               src;
+    MultiArrayView<N, int, StridedArrayTag> regions;
+    RegionStatisticsArray &                 stats;
+    ArrayVector<Shape> const &              neighbors;
+    ArrayVector<MultiArrayIndex> const &    offsets;
+    ArrayVector<ArrayVector<Candidate> > &  candidates;
+    MultiArrayIndex                         blockSize;
+
+    SeedRgBlockwiseCandidatesFunctor(MultiArrayView<N, T1, S1> const & s,
+                                     MultiArrayView<N, int, StridedArrayTag> const & r,
+                                     RegionStatisticsArray & st,
+                                     ArrayVector<Shape> const & n,
+                                     ArrayVector<MultiArrayIndex> const & o,
+                                     ArrayVector<ArrayVector<Candidate> > & c,
+                                     MultiArrayIndex b)
+    : src(s), regions(r), stats(st), neighbors(n), offsets(o), candidates(c), blockSize(b)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        int maxRegionLabel = (int)stats.maxRegionLabel();
+        for(; begin < end; ++begin)
+        {
+            Shape start, stop;
+            seededRegionGrowingBlockRange<N>(src.shape(), blockSize, begin, begin + 1, start, stop);
+            ArrayVector<Candidate> & blockCandidates = candidates[begin];
+            Shape pos(start);
+            for(MultiArrayIndex i = 0, size = prod(stop - start); i < size; ++i)
+            {
+                int const * r = &regions[pos];
+                if(*r == 0)
+                {
+                    for(unsigned int k=0; k<neighbors.size(); ++k)
+                    {
+                        int cneighbor = r[offsets[k]];
+                        if(cneighbor > 0)
+                            blockCandidates.push_back(Candidate(pos, pos + neighbors[k],
+                                                      stats[cneighbor].cost(src[pos]), 0, cneighbor));
+                    }
+                }
+                else
+                {
+                    vigra_precondition(*r <= maxRegionLabel,
+                        "seededRegionGrowingBlockwise(): Largest label exceeds size of RegionStatisticsArray.");
+                }
+                // advance pos in scan order
+                for(unsigned int d=0; d<N; ++d)
+                {
+                    if(++pos[d] < stop[d])
+                        break;
+                    pos[d] = start[d];
+                }
+            }
+        }
+    }
+};
+
+/* Write the labels of the blocks [begin, end) to dest, replacing the
+   watershed label by 0.
+*/
+template <unsigned int N, class T3, class S3>
+struct SeedRgBlockwiseWriteFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    MultiArrayView<N, int, StridedArrayTag> regions;
+    MultiArrayView<N, T3, S3>               dest;
+    MultiArrayIndex                         blockSize;
+
+    SeedRgBlockwiseWriteFunctor(MultiArrayView<N, int, StridedArrayTag> const & r,
+                                MultiArrayView<N, T3, S3> const & d,
+                                MultiArrayIndex b)
+    : regions(r), dest(d), blockSize(b)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        Shape start, stop;
+        seededRegionGrowingBlockRange<N>(dest.shape(), blockSize, begin, end, start, stop);
+        MultiArrayView<N, int, StridedArrayTag> r(regions.subarray(start, stop));
+        MultiArrayView<N, T3, StridedArrayTag> d(dest.subarray(start, stop));
+        typename MultiArrayView<N, int, StridedArrayTag>::iterator i = r.begin(), iend = r.end();
+        typename MultiArrayView<N, T3, StridedArrayTag>::iterator j = d.begin();
+        UnlabelWatersheds unlabel;
+        for(; i != iend; ++i, ++j)
+            *j = detail::RequiresExplicitCast<T3>::cast(unlabel(*i));
+    }
+};
+
+template <unsigned int N, class Neighborhood>
+void
+seededRegionGrowingBlockwiseNeighbors(MultiArrayView<N, int, StridedArrayTag> const & regions,
+                                      ArrayVector<typename MultiArrayShape<N>::type> & neighbors,
+                                      ArrayVector<MultiArrayIndex> & offsets)
+{
+    typedef typename Neighborhood::Direction Direction;
+
+    int directionCount = Neighborhood::DirectionCount;
+    neighbors.resize(directionCount);
+    offsets.resize(directionCount);
+    for(int i=0; i<directionCount; i++)
+    {
+        for(unsigned int d=0; d<N; ++d)
+            neighbors[i][d] = Neighborhood::diff((Direction)i)[d];
+        offsets[i] = dot(neighbors[i], regions.stride());
+    }
+}
+
+/* Labels and arrival times on the first and last line (resp. slice) of every
+   block as seen by its neighbors, face 2*b being the first and face 2*b+1 the
+   last one of block b: the current faces, the faces before their last change,
+   and the faces written by the blocks flooded in the current round.
+*/
+template <unsigned int N, class Time>
+struct SeedRgBlockwiseFaces
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ArrayVector<MultiArray<N, int> >          labels, oldLabels, nextLabels;
+    ArrayVector<MultiArray<N, Time const *> > times, oldTimes, nextTimes;
+    ArrayVector<bool>                         changed;
+
+    SeedRgBlockwiseFaces(Shape const & faceShape, std::ptrdiff_t blocks)
+    : labels(2*blocks, MultiArray<N, int>(faceShape)),
+      oldLabels(labels), nextLabels(labels),
+      times(2*blocks, MultiArray<N, Time const *>(faceShape)),
+      oldTimes(times), nextTimes(times),
+      changed(2*blocks, false)
+    {}
+
+        // make the faces written by the blocks in 'flooded' current, and
+        // return the blocks next to a changed face
+    void update(ArrayVector<std::ptrdiff_t> const & flooded, ArrayVector<std::ptrdiff_t> & dirty)
+    {
+        std::ptrdiff_t blocks = (std::ptrdiff_t)changed.size() / 2;
+        ArrayVector<bool> isDirty(blocks, false);
+        std::fill(changed.begin(), changed.end(), false);
+        for(unsigned int k = 0; k < flooded.size(); ++k)
+        {
+            for(int side = 0; side < 2; ++side)
+            {
+                std::ptrdiff_t b = flooded[k], f = 2*b + side, n = side == 0 ? b - 1 : b + 1;
+                if(nextLabels[f] == labels[f] && nextTimes[f] == times[f])
+                    continue;
+                oldLabels[f] = labels[f];
+                oldTimes[f] = times[f];
+                labels[f].swap(nextLabels[f]);
+                times[f].swap(nextTimes[f]);
+                changed[f] = true;
+                if(n >= 0 && n < blocks)
+                    isDirty[n] = true;
+            }
+        }
+        dirty.clear();
+        for(std::ptrdiff_t b = 0; b < blocks; ++b)
+            if(isDirty[b])
+                dirty.push_back(b);
+    }
+};
+
+/* Flood the blocks listed in 'dirty' independently, given the labels and
+   arrival times on the faces of their neighbors, and write their own faces to
+   the next face arrays. Pixels of the neighbors that have not been reached by
+   the flood (arrival time 0) are represented by their seed label.
+
+   In the first round, every block is flooded from its seeds. Afterwards, a
+   block only repairs its flood where the changed faces of its neighbors make a
+   difference: arrivals descending from a changed face pixel are undone,
+   candidates pushed by the changed face pixels replace later arrivals, and the
+   watershed decisions next to a changed pixel are checked again. The repairs
+   are done in the order of the arrival times, so that everything before the
+   current candidate is final, as in the serial algorithm.
+*/
+template <unsigned int N, class T1, class S1, class T2, class S2,
+          class RegionStatisticsArray, class Candidate>
+struct SeedRgBlockwiseFloodFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename Candidate::Time Time;
+    typedef std::priority_queue<Candidate, std::vector<Candidate>,
+                                typename Candidate::Compare> Queue;
+    typedef SeedRgBlockwiseFaces<N, Time> Faces;
+
+        // the state of the block being flooded
+    struct Block
+    {
+        Shape start, stop;
+        MultiArrayView<N, int, StridedArrayTag> regions;
+        MultiArrayView<N, Time const *> times, versions;
+        std::deque<Time> & arena;
+        Queue pheap;
+        ArrayVector<Shape> stack, undone;
+
+        Block(Shape const & begin, Shape const & end,
+              MultiArrayView<N, int, StridedArrayTag> const & r,
+              MultiArrayView<N, Time const *> const & t,
+              MultiArrayView<N, Time const *> const & v,
+              std::deque<Time> & a)
+        : start(begin), stop(end), regions(r), times(t), versions(v), arena(a)
+        {}
+
+        bool contains(Shape const & q) const
+        {
+            return q[N-1] >= start[N-1] && q[N-1] < stop[N-1] && regions.isInside(q);
+        }
+
+        bool atFace(Shape const & p) const
+        {
+            return p[N-1] == start[N-1] || p[N-1] == stop[N-1] - 1;
+        }
+
+            // pixel p of the block has been reached by the flood
+        bool arrived(Shape const & p) const
+        {
+            return regions[p] != 0 && times[p] != 0;
+        }
+
+            // pixel p of the block has been reached by the flood after time t
+        bool arrivedAfter(Shape const & p, Time const & t) const
+        {
+            return arrived(p) && Time::compareTimes(*times[p], t) > 0;
+        }
+    };
+
+    MultiArrayView<N, T1, S1>               src;
+    MultiArrayView<N, T2, S2>               seeds;
+    MultiArrayView<N, int, StridedArrayTag> regions;
+    MultiArrayView<N, Time const *>         times, versions;
+    RegionStatisticsArray const &           stats;
+    ArrayVector<Shape> const &              neighbors;
+    ArrayVector<MultiArrayIndex> const &    offsets;
+    ArrayVector<std::deque<Time> > &        arenas;
+    Faces &                                 faces;
+    ArrayVector<std::ptrdiff_t> const &     dirty;
+    bool                                    firstRound;
+    SRGType                                 srgType;
+    MultiArrayIndex                         blockSize;
+    double                                  max_cost;
+    ArrayVector<MultiArrayIndex>            opposite;
+    Shape                                   scanStride;
+
+    SeedRgBlockwiseFloodFunctor(MultiArrayView<N, T1, S1> const & s,
+                                MultiArrayView<N, T2, S2> const & sd,
+                                MultiArrayView<N, int, StridedArrayTag> const & r,
+                                MultiArrayView<N, Time const *> const & t,
+                                MultiArrayView<N, Time const *> const & v,
+                                RegionStatisticsArray const & st,
+                                ArrayVector<Shape> const & n,
+                                ArrayVector<MultiArrayIndex> const & o,
+                                ArrayVector<std::deque<Time> > & a,
+                                Faces & f, ArrayVector<std::ptrdiff_t> const & d, bool first,
+                                SRGType type, MultiArrayIndex b, double m)
+    : src(s), seeds(sd), regions(r), times(t), versions(v), stats(st),
+      neighbors(n), offsets(o), arenas(a), faces(f), dirty(d), firstRound(first),
+      srgType(type), blockSize(b), max_cost(m),
+      opposite(n.size()), scanStride(detail::defaultStride<N>(s.shape()))
+    {
+        for(unsigned int i=0; i<n.size(); ++i)
+            for(unsigned int j=0; j<n.size(); ++j)
+                if(n[j] == -n[i])
+                    opposite[i] = j;
+    }
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        for(; begin < end; ++begin)
+            flood(dirty[begin]);
+    }
+
+    static void next(Shape & pos, Shape const & start, Shape const & stop)
+    {
+        for(unsigned int d=0; d<N; ++d)
+        {
+            if(++pos[d] < stop[d])
+                break;
+            pos[d] = start[d];
+        }
+    }
+
+    bool keepContours() const
+    {
+        return (srgType & KeepContours) != 0;
+    }
+
+        // index of the neighboring face array containing q, or -1 if q is
+        // in the block or in the border
+    int face(Block const & block, Shape const & q) const
+    {
+        if(q[N-1] >= block.start[N-1] && q[N-1] < block.stop[N-1])
+            return -1;
+        for(unsigned int d=0; d<N; ++d)
+            if(q[d] < 0 || q[d] >= src.shape(d))
+                return -1;
+        int b = (int)(q[N-1] / blockSize);
+        return q[N-1] < block.start[N-1] ? 2*b + 1 : 2*b;
+    }
+
+    void push(Block & block, int label, Time const & time) const
+    {
+        if((srgType & StopAtThreshold) == 0 || !(time.cost_ > max_cost))
+            block.pheap.push(Candidate(label, time));
+    }
+
+        // candidate pushed into pixel p in direction i by the neighbor with
+        // the given label and time, or initial candidate if time is 0
+    void push(Block & block, Shape const & p, MultiArrayIndex i, int label, Time const * time) const
+    {
+        if(time == 0)
+        {
+            Shape q(p - neighbors[i]);
+            push(block, label, Time(p, q, stats[label].cost(src[p]),
+                                    dot(p, scanStride)*(MultiArrayIndex)neighbors.size() + opposite[i]));
+        }
+        else
+        {
+            bool crossing = time->location_[N-1] / blockSize != p[N-1] / blockSize;
+            push(block, label, Time(p, stats[label].cost(src[p]), *time, i,
+                                    crossing ? time : time->crossing_));
+        }
+    }
+
+        // ask for the watershed decision of the arrived pixel p at its time
+    void recheck(Block & block, Shape const & p) const
+    {
+        block.pheap.push(Candidate(0, *block.times[p]));
+    }
+
+        // push the candidates of the unlabelled pixel p from all its neighbors
+    void pushCandidates(Block & block, Shape const & p) const
+    {
+        bool atFace = block.atFace(p);
+        int const * r = &block.regions[p];
+        for(unsigned int i=0; i<neighbors.size(); ++i)
+        {
+            Shape q(p + neighbors[i]);
+            int f = atFace ? face(block, q) : -1, label;
+            Time const * time = 0;
+            if(f < 0)
+            {
+                label = r[offsets[i]];
+                if(label > 0)
+                    time = block.times[q];
+            }
+            else
+            {
+                label = detail::RequiresExplicitCast<int>::cast(seeds[q]);
+                if(label == 0)
+                {
+                    Shape fp(q);
+                    fp[N-1] = 0;
+                    label = faces.labels[f][fp];
+                    time = faces.times[f][fp];
+                    if(time == 0)
+                        continue;
+                }
+            }
+            if(label > 0)
+                push(block, p, opposite[i], label, time);
+        }
+    }
+
+        // push the candidates of the pixels of the block that are unlabelled
+        // or arrived later than the pixel p
+    void pushNeighbors(Block & block, Shape const & p, int label, Time const & time) const
+    {
+        bool atFace = block.atFace(p);
+        int const * r = &block.regions[p];
+        for(unsigned int i=0; i<neighbors.size(); ++i)
+        {
+            Shape q(p + neighbors[i]);
+            if(atFace && face(block, q) >= 0)
+                continue;
+            if(r[offsets[i]] == 0 ||
+               (!firstRound && block.contains(q) && block.arrivedAfter(q, time)))
+                push(block, q, i, label, &time);
+        }
+    }
+
+        // put the neighbors of p pushed by the given time on the undo stack, and
+        // check the watershed decisions of the neighbors that arrived later
+    void dependents(Block & block, Shape const & p, Time const * time,
+                    bool children, bool later) const
+    {
+        bool atFace = block.atFace(p);
+        for(unsigned int i=0; i<neighbors.size(); ++i)
+        {
+            Shape q(p + neighbors[i]);
+            if((atFace && face(block, q) >= 0) || !block.contains(q) || !block.arrived(q))
+                continue;
+            if(children && block.times[q]->parent_ == time)
+                block.stack.push_back(q);
+            else if(later && Time::compareTimes(*block.times[q], *time) > 0)
+                recheck(block, q);
+        }
+    }
+
+        // make the arrived pixels on the stack and their descendants in the
+        // block unlabelled, and push their candidates from the remaining neighbors
+    void undo(Block & block) const
+    {
+        while(block.stack.size() != 0)
+        {
+            Shape q(block.stack.back());
+            block.stack.pop_back();
+            if(block.regions[q] == 0)
+                continue;
+            block.regions[q] = 0;
+            block.undone.push_back(q);
+            dependents(block, q, block.times[q], true, keepContours());
+        }
+        for(unsigned int k = 0; k < block.undone.size(); ++k)
+            if(block.regions[block.undone[k]] == 0)
+                pushCandidates(block, block.undone[k]);
+        block.undone.clear();
+    }
+
+    void undo(Block & block, Shape const & p) const
+    {
+        block.stack.push_back(p);
+        undo(block);
+    }
+
+        // The parent of a candidate must still be labelled with its time. If it
+        // was pushed across a face, its latest ancestor in the block must be,
+        // since the candidate might otherwise descend from a previous flood of
+        // this block, and support itself in turn.
+    bool isCurrent(Block const & block, Time const & time) const
+    {
+        Time const * a = time.parent_;
+        if(a == 0)
+            return true;
+        for(; a != 0; a = a->crossing_)
+        {
+            Shape const & loc = a->location_;
+            if(loc[N-1] >= block.start[N-1] && loc[N-1] < block.stop[N-1])
+                return block.regions[loc] > 0 && block.times[loc] == a;
+        }
+        return true;
+    }
+
+        // label given to pixel p arriving at 'time' with 'label' when the
+        // contours are kept
+    int contourLabel(Block const & block, Shape const & p, int label, Time const & time) const
+    {
+        bool atFace = block.atFace(p);
+        int const * r = &block.regions[p];
+        for(unsigned int i=0; i<neighbors.size(); ++i)
+        {
+            Shape q(p + neighbors[i]);
+            int cneighbor, f = atFace ? face(block, q) : -1;
+            if(f < 0)
+            {
+                cneighbor = r[offsets[i]];
+                if(cneighbor > 0 && !firstRound && block.times[q] != 0 &&
+                   Time::compareTimes(*block.times[q], time) > 0)
+                    cneighbor = 0; // not yet reached
+            }
+            else
+            {
+                Shape fp(q);
+                fp[N-1] = 0;
+                Time const * t = faces.times[f][fp];
+                if(t == 0)
+                    cneighbor = detail::RequiresExplicitCast<int>::cast(seeds[q]);
+                else if(Time::compareTimes(*t, time) < 0)
+                    cneighbor = faces.labels[f][fp];
+                else
+                    cneighbor = 0; // not yet reached
+            }
+            if((cneighbor>0) && (cneighbor != label))
+                return SRGWatershedLabel;
+        }
+        return label;
+    }
+
+    void flood(std::ptrdiff_t b) const
+    {
+        Shape const & shape = src.shape();
+        Shape start, stop;
+        seededRegionGrowingBlockRange<N>(shape, blockSize, b, b + 1, start, stop);
+        Block block(start, stop, regions, times, versions, arenas[b]);
+        std::ptrdiff_t blocks = (shape[N-1] + blockSize - 1) / blockSize;
+        Shape faceShape(shape);
+        faceShape[N-1] = 1;
+        MultiArrayIndex faceSize = prod(faceShape);
+
+        if(firstRound)
+        {
+            // flood the block from its seeds and the seeds of its neighbors
+            int maxRegionLabel = (int)stats.maxRegionLabel();
+            Shape pos(start);
+            for(MultiArrayIndex k = 0, size = prod(stop - start); k < size; ++k, next(pos, start, stop))
+            {
+                int & r = block.regions[pos];
+                r = detail::RequiresExplicitCast<int>::cast(seeds[pos]);
+                vigra_precondition(r <= maxRegionLabel,
+                    "seededRegionGrowingBlockwise(): Largest label exceeds size of RegionStatisticsArray.");
+            }
+            pos = start;
+            for(MultiArrayIndex k = 0, size = prod(stop - start); k < size; ++k, next(pos, start, stop))
+                if(block.regions[pos] == 0)
+                    pushCandidates(block, pos);
+        }
+        else
+        {
+            // repair the flood next to the changed faces of the neighbors: first
+            // undo the arrivals pushed by the old faces, so that the candidates
+            // of the new faces are not compared with stale arrivals
+            for(int pass = 0; pass < 2; ++pass)
+            {
+                for(int side = 0; side < 2; ++side)
+                {
+                    std::ptrdiff_t n = side == 0 ? b - 1 : b + 1;
+                    if(n < 0 || n >= blocks)
+                        continue;
+                    int f = side == 0 ? 2*(int)n + 1 : 2*(int)n;
+                    if(!faces.changed[f])
+                        continue;
+                    Shape fp;
+                    for(MultiArrayIndex k = 0; k < faceSize; ++k, next(fp, Shape(), faceShape))
+                    {
+                        Time const * time = faces.times[f][fp], * old = faces.oldTimes[f][fp];
+                        int label = faces.labels[f][fp];
+                        if(time == old && label == faces.oldLabels[f][fp])
+                            continue;
+                        Shape q(fp);
+                        q[N-1] = side == 0 ? start[N-1] - 1 : stop[N-1];
+                        if(pass == 0)
+                        {
+                            if(old == 0)
+                                continue;
+                            for(unsigned int i=0; i<neighbors.size(); ++i)
+                            {
+                                Shape p(q + neighbors[i]);
+                                if(block.contains(p) && block.arrived(p) && block.times[p]->parent_ == old)
+                                    block.stack.push_back(p);
+                            }
+                            continue;
+                        }
+                        Time const * earlier = 0;
+                        if(keepContours())
+                            earlier = time == 0 || (old != 0 && Time::compareTimes(*old, *time) < 0)
+                                          ? old
+                                          : time;
+                        for(unsigned int i=0; i<neighbors.size(); ++i)
+                        {
+                            Shape p(q + neighbors[i]);
+                            if(!block.contains(p))
+                                continue;
+                            if(time != 0 && label > 0 &&
+                               (block.regions[p] == 0 || block.arrivedAfter(p, *time)))
+                                push(block, p, i, label, time);
+                            if(earlier != 0 && block.arrivedAfter(p, *earlier))
+                                recheck(block, p);
+                        }
+                    }
+                }
+                if(pass == 0)
+                    undo(block);
+            }
+        }
+
+        // flood the block in the order of the arrival times
+        while(block.pheap.size() != 0)
+        {
+            Candidate candidate = block.pheap.top();
+            block.pheap.pop();
+
+            Shape const & loc = candidate.time_.location_;
+            int & r = block.regions[loc];
+            Time const * & t = block.times[loc];
+            bool sameArrival = t != 0 && t->parent_ == candidate.time_.parent_ &&
+                               t->order_ == candidate.time_.order_;
+
+            if(candidate.label_ == 0)
+            {
+                // check the watershed decision of an arrived pixel
+                if(r == 0 || !sameArrival)
+                    continue;
+                int lab = contourLabel(block, loc,
+                                       detail::RequiresExplicitCast<int>::cast(seeds[t->nearest_]), *t);
+                if(lab == r)
+                    continue;
+                r = lab;
+                if(lab > 0)
+                    pushNeighbors(block, loc, lab, *t);
+                dependents(block, loc, t, lab < 0, true);
+                undo(block);
+                continue;
+            }
+
+            if(!isCurrent(block, candidate.time_))
+                continue;
+            if(r != 0)
+            {
+                // seeds and earlier arrivals stay
+                if(t == 0 || Time::compareTimes(*t, candidate.time_) <= 0)
+                    continue;
+                undo(block, loc);
+                sameArrival = false;
+            }
+
+            int lab = keepContours()
+                          ? contourLabel(block, loc, candidate.label_, candidate.time_)
+                          : candidate.label_;
+            r = lab;
+
+            // every arrival has a single time object, reused when the pixel
+            // arrives the same way again: the faces then only change when the
+            // arrivals change, and equal times are always the same object, so
+            // that comparing them does not recurse into their ancestors
+            if(!sameArrival)
+            {
+                for(t = block.versions[loc]; t != 0; t = t->previous_)
+                    if(t->parent_ == candidate.time_.parent_ && t->order_ == candidate.time_.order_)
+                        break;
+                if(t == 0)
+                {
+                    block.arena.push_back(candidate.time_);
+                    block.arena.back().previous_ = block.versions[loc];
+                    t = block.versions[loc] = &block.arena.back();
+                }
+            }
+
+            if(lab > 0)
+                pushNeighbors(block, loc, lab, *t);
+            if(keepContours() && !firstRound)
+                dependents(block, loc, t, false, true);
+        }
+
+        // publish the faces of the block
+        for(int side = 0; side < 2; ++side)
+        {
+            MultiArray<N, int> & labels = faces.nextLabels[2*b + side];
+            MultiArray<N, Time const *> & arrivals = faces.nextTimes[2*b + side];
+            Shape fp;
+            for(MultiArrayIndex k = 0; k < faceSize; ++k, next(fp, Shape(), faceShape))
+            {
+                Shape p(fp);
+                p[N-1] = side == 0 ? start[N-1] : stop[N-1] - 1;
+                labels[fp] = block.regions[p];
+                arrivals[fp] = block.regions[p] == 0 ? 0 : block.times[p];
+            }
+        }
+    }
+};
+
+/* Flood the blocks concurrently when the costs are static. In the first round,
+   every block is flooded from its own seeds and the seeds of its neighbors.
+   Afterwards, the candidates that the pixels on the faces of a neighbor push
+   into a block may arrive earlier than the block's own, so every block whose
+   neighbors changed a face repairs its flood, until no face changes. Since
+   arrival times only depend on earlier arrivals, the earliest wrong arrival
+   of a round is corrected in the next one, and the final labelling is the one
+   of the serial algorithm.
+*/
+template <unsigned int N, class T1, class S1, class T2, class S2, class T3, class S3,
+          class RegionStatisticsArray, class Neighborhood>
+void
+seededRegionGrowingBlockwiseImpl(MultiArrayView<N, T1, S1> const & src,
+                                 MultiArrayView<N, T2, S2> const & seeds,
+                                 MultiArrayView<N, T3, S3> dest,
+                                 RegionStatisticsArray & stats,
+                                 SRGType srgType, Neighborhood,
+                                 int nthreads, MultiArrayIndex blockSize,
+                                 double max_cost, VigraTrueType)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename RegionStatisticsArray::value_type RegionStatistics;
+    typedef typename PromoteTraits<typename RegionStatistics::cost_type, double>::Promote CostType;
+    typedef SeedRgBlockwiseArrival<N, CostType> Candidate;
+    typedef typename Candidate::Time Time;
+
+    Shape shape(src.shape());
+    std::ptrdiff_t blocks = (shape[N-1] + blockSize - 1) / blockSize;
+
+    MultiArray<N, int> regionsWithBorder(shape + Shape(2));
+    initMultiArrayBorder(destMultiArrayRange(regionsWithBorder), 1, SRGWatershedLabel);
+    MultiArrayView<N, int, StridedArrayTag> regions(regionsWithBorder.subarray(Shape(1), shape + Shape(1)));
+
+    ArrayVector<Shape> neighbors;
+    ArrayVector<MultiArrayIndex> offsets;
+    seededRegionGrowingBlockwiseNeighbors<N, Neighborhood>(regions, neighbors, offsets);
+
+    // arrival times of the pixels and the latest of their time objects,
+    // kept by the block they belong to
+    MultiArray<N, Time const *> times(shape), versions(shape);
+    ArrayVector<std::deque<Time> > arenas(blocks);
+    Shape faceShape(shape);
+    faceShape[N-1] = 1;
+    SeedRgBlockwiseFaces<N, Time> faces(faceShape, blocks);
+
+    ArrayVector<std::ptrdiff_t> flooded, dirty;
+    for(std::ptrdiff_t b = 0; b < blocks; ++b)
+        dirty.push_back(b);
+    for(bool firstRound = true; dirty.size() != 0; firstRound = false)
+    {
+        parallelForChunks((std::ptrdiff_t)dirty.size(),
+            SeedRgBlockwiseFloodFunctor<N, T1, S1, T2, S2, RegionStatisticsArray, Candidate>(
+                src, seeds, regions, times, versions, stats, neighbors, offsets, arenas,
+                faces, dirty, firstRound, srgType, blockSize, max_cost),
+            nthreads);
+        flooded.swap(dirty);
+        faces.update(flooded, dirty);
+    }
+
+    // write result
+    parallelForChunks(blocks, SeedRgBlockwiseWriteFunctor<N, T3, S3>(regions, dest, blockSize),
+                      nthreads);
+}
+
+/* Serial flooding for statistics that are updated while the regions grow.
+*/
+template <unsigned int N, class T1, class S1, class T2, class S2, class T3, class S3,
+          class RegionStatisticsArray, class Neighborhood>
+void
+seededRegionGrowingBlockwiseImpl(MultiArrayView<N, T1, S1> const & src,
+                                 MultiArrayView<N, T2, S2> const & seeds,
+                                 MultiArrayView<N, T3, S3> dest,
+                                 RegionStatisticsArray & stats,
+                                 SRGType srgType, Neighborhood,
+                                 int nthreads, MultiArrayIndex blockSize,
+                                 double max_cost, VigraFalseType)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename RegionStatisticsArray::value_type RegionStatistics;
+    typedef typename PromoteTraits<typename RegionStatistics::cost_type, double>::Promote CostType;
+    typedef SeedRgBlockwiseCandidate<N, CostType> Candidate;
+
+    Shape shape(src.shape());
+    std::ptrdiff_t blocks = (shape[N-1] + blockSize - 1) / blockSize;
+
+    // copy seed image in an image with border
+    MultiArray<N, int> regionsWithBorder(shape + Shape(2));
+    initMultiArrayBorder(destMultiArrayRange(regionsWithBorder), 1, SRGWatershedLabel);
+    MultiArrayView<N, int, StridedArrayTag> regions(regionsWithBorder.subarray(Shape(1), shape + Shape(1)));
+    parallelForChunks(blocks, SeedRgBlockwiseCopySeedsFunctor<N, T2, S2>(seeds, regions, blockSize),
+                      nthreads);
+
+    int directionCount = Neighborhood::DirectionCount;
+    ArrayVector<Shape> neighbors;
+    ArrayVector<MultiArrayIndex> offsets;
+    seededRegionGrowingBlockwiseNeighbors<N, Neighborhood>(regions, neighbors, offsets);
+
+    // find the initial candidates and their costs block by block,
+    // and insert them in scan order as the serial algorithm does
+    ArrayVector<ArrayVector<Candidate> > candidates(blocks);
+    parallelForChunks(blocks,
+        SeedRgBlockwiseCandidatesFunctor<N, T1, S1, RegionStatisticsArray, Candidate>(
+                                src, regions, stats, neighbors, offsets, candidates, blockSize),
+        nthreads);
+
+    std::priority_queue<Candidate, std::vector<Candidate>, typename Candidate::Compare> pheap;
+    int count = 0;
+    for(std::ptrdiff_t b = 0; b < blocks; ++b)
+    {
+        for(unsigned int k = 0; k < candidates[b].size(); ++k)
+        {
+            candidates[b][k].count_ = count++;
+            pheap.push(candidates[b][k]);
+        }
+        ArrayVector<Candidate>().swap(candidates[b]);
+    }
+
+    // perform region growing
+    while(pheap.size() != 0)
+    {
+        Candidate candidate = pheap.top();
+        pheap.pop();
+
+        if((srgType & StopAtThreshold) != 0 && candidate.cost_ > max_cost)
+            break;
+
+        int * r = &regions[candidate.location_];
+
+        if(*r) // already labelled region / watershed?
+            continue;
+
+        int lab = candidate.label_;
+        if((srgType & KeepContours) != 0)
+        {
+            for(int i=0; i<directionCount; i++)
+            {
+                int cneighbor = r[offsets[i]];
+                if((cneighbor>0) && (cneighbor != lab))
+                {
+                    lab = SRGWatershedLabel;
+                    break;
+                }
+            }
+        }
+
+        *r = lab;
+
+        if((srgType & KeepContours) == 0 || lab > 0)
+        {
+            // update statistics
+            stats[lab](src[candidate.location_]);
+
+            // find new candidate pixels
+            for(int i=0; i<directionCount; i++)
+            {
+                if(r[offsets[i]] == 0)
+                {
+                    Shape pos(candidate.location_ + neighbors[i]);
+                    pheap.push(Candidate(pos, candidate.nearest_, stats[lab].cost(src[pos]),
+                                         count++, lab));
+                }
+            }
+        }
+    }
+
+    // write result
+    parallelForChunks(blocks, SeedRgBlockwiseWriteFunctor<N, T3, S3>(regions, dest, blockSize),
+                      nthreads);
+}
+
+} // namespace detail
+
+/** \addtogroup SeededRegionGrowing
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*             seededRegionGrowingBlockwise             */
+/*                                                      */
+/********************************************************/
+
+/** \brief Seeded region growing on a 2D image or 3D volume, flooding blocks concurrently.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1, class T2, class S2, class T3, class S3,
+                  class RegionStatisticsArray, class Neighborhood>
+        void
+        seededRegionGrowingBlockwise(MultiArrayView<N, T1, S1> const & src,
+                                     MultiArrayView<N, T2, S2> const & seeds,
+                                     MultiArrayView<N, T3, S3> dest,
+                                     RegionStatisticsArray & stats,
+                                     SRGType srgType, Neighborhood neighborhood,
+                                     int nthreads, MultiArrayIndex blockSize = 64,
+                                     double max_cost = NumericTraits<double>::max());
+    }
+    \endcode
+
+    The result is exactly the labelling of \ref seededRegionGrowing() (<tt>N == 2</tt>)
+    resp. \ref seededRegionGrowing3D() (<tt>N == 3</tt>) with the same arguments,
+    for every statistics type and for all combinations of <tt>CompleteGrow</tt>,
+    <tt>KeepContours</tt> and <tt>StopAtThreshold</tt>.
+
+    The image or volume is divided into slabs of <tt>blockSize</tt> lines (resp. slices)
+    along the last axis, which are processed by <tt>nthreads</tt> threads
+    (see \ref parallelThreadCount()). When <tt>stats</tt> is an
+    \ref ArrayOfRegionStatistics of \ref SeedRgDirectValueFunctor (i.e. for watersheds),
+    the cost of a pixel does not depend on the region and does not change while
+    the regions grow, and the slabs are flooded concurrently: every candidate carries
+    the time at which the serial algorithm would process it, which is derived from
+    the costs and distances of its ancestors instead of a global insertion counter.
+    A slab whose neighbors deliver earlier candidates across their common face
+    repairs its flood in the next round, re-growing only the arrivals that the
+    changed faces affect, until no face changes any more. The repairs grow with
+    the number of slabs that a single region extends over, so the block size
+    should be large compared to the regions. For all other statistics, the costs are
+    updated after every merge, and the growing runs on a single thread in one global
+    queue, with only the setup and the output distributed over the threads.
+
+    <tt>stats</tt> is updated as in the serial algorithm. <tt>seeds</tt> and <tt>dest</tt>
+    may refer to the same array. Memory requirement: one <tt>int</tt> label array of the
+    size of the input (plus a one pixel border) and the candidate queue, and for concurrent
+    flooding additionally two pointers per pixel and one arrival time record per
+    arrival, including the arrivals changed by the repairs.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/blockwise_seededregiongrowing.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, float> boundaries(shape);
+    MultiArray<3, UInt32> labels(shape);   // contains the seeds
+    ...
+    UInt32 max_region_label = ...;
+
+    // the cost of a voxel is its boundary indicator value (i.e. watersheds)
+    ArrayOfRegionStatistics<SeedRgDirectValueFunctor<float> > stats(max_region_label);
+
+    // grow the seeds in place, flooding on 8 threads
+    seededRegionGrowingBlockwise(boundaries, labels, labels, stats,
+                                 CompleteGrow, NeighborCode3DSix(), 8);
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void seededRegionGrowingBlockwise)
+
+template <unsigned int N, class T1, class S1, class T2, class S2, class T3, class S3,
+          class RegionStatisticsArray, class Neighborhood>
+void
+seededRegionGrowingBlockwise(MultiArrayView<N, T1, S1> const & src,
+                             MultiArrayView<N, T2, S2> const & seeds,
+                             MultiArrayView<N, T3, S3> dest,
+                             RegionStatisticsArray & stats,
+                             SRGType srgType, Neighborhood,
+                             int nthreads, MultiArrayIndex blockSize = 64,
+                             double max_cost = NumericTraits<double>::max())
+{
+    vigra_precondition(src.shape() == seeds.shape() && src.shape() == dest.shape(),
+        "seededRegionGrowingBlockwise(): shape mismatch between input and output.");
+    vigra_precondition(blockSize >= 1,
+        "seededRegionGrowingBlockwise(): block size must be positive.");
+
+    if(src.size() == 0)
+        return;
+
+    typedef typename detail::SeedRgHasStaticCost<
+                 typename RegionStatisticsArray::value_type>::type StaticCost;
+    detail::seededRegionGrowingBlockwiseImpl(src, seeds, dest, stats, srgType,
+                                             Neighborhood(), nthreads, blockSize, max_cost,
+                                             StaticCost());
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_BLOCKWISE_SEEDEDREGIONGROWING_HXX
@@ -198,6 +198,17 @@ namespace vigra
             return vigra::Size2D(this->getWidth(), this->getHeight());
         }
 
+        // restrict decoding to a sub-rectangle of the image. Must be called
+        // before the first nextScanline(). Afterwards, nextScanline() only visits
+        // the rows roi.top() ... roi.bottom()-1, and currentScanlineOfBand()
+        // points to the pixel in column roi.left(). getWidth() and getHeight()
+        // still report the size of the entire image. Codecs that cannot skip
+        // data return false, and the caller must skip rows and columns itself.
+        virtual bool setRegionOfInterest( const vigra::Rect2D & )
+        {
+            return false;
+        }
+
         virtual unsigned int getOffset() const = 0;
 
         virtual const void * currentScanlineOfBand( unsigned int ) const = 0;
@@ -38,10 +38,15 @@
 #define VIGRA_COLORCONVERSIONS_HXX
 
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <string>
 #include "mathutil.hxx"
 #include "rgbvalue.hxx"
 #include "functortraits.hxx"
+#include "array_vector.hxx"
+#include "multi_array.hxx"
+#include "parallel.hxx"
 
 namespace vigra {
 
@@ -94,6 +99,8 @@ inline ValueType inverse_sRGBCorrection(double value, double norm)
                     : norm*VIGRA_CSTD::pow((value + 0.055)/1.055, 2.4)));
 }
 
+template <class Functor, class SrcType>
+class ColorConversionKernel;
 
 } // namespace detail
 
@@ -925,6 +932,9 @@ class RGBPrime2XYZFunctor
     }
 
   private:
+    template <class F, class S>
+    friend class detail::ColorConversionKernel;
+
     double gamma_;
     component_type max_;
 };
@@ -1546,6 +1556,9 @@ class RGB2LuvFunctor
     }
 
   private:
+    template <class F, class S>
+    friend class detail::ColorConversionKernel;
+
     RGB2XYZFunctor<T> rgb2xyz;
     XYZ2LuvFunctor<component_type> xyz2luv;
 };
@@ -1640,6 +1653,9 @@ class RGB2LabFunctor
     }
 
   private:
+    template <class F, class S>
+    friend class detail::ColorConversionKernel;
+
     RGB2XYZFunctor<T> rgb2xyz;
     XYZ2LabFunctor<component_type> xyz2lab;
 };
@@ -1862,6 +1878,9 @@ class RGBPrime2LuvFunctor
     }
 
   private:
+    template <class F, class S>
+    friend class detail::ColorConversionKernel;
+
     RGBPrime2XYZFunctor<T> rgb2xyz;
     XYZ2LuvFunctor<component_type> xyz2luv;
 };
@@ -1949,6 +1968,9 @@ class RGBPrime2LabFunctor
     }
 
   private:
+    template <class F, class S>
+    friend class detail::ColorConversionKernel;
+
     RGBPrime2XYZFunctor<T> rgb2xyz;
     XYZ2LabFunctor<component_type> xyz2lab;
 };
@@ -3415,6 +3437,545 @@ yPrimeUV2Polar(V const & yuv)
 
 //@}
 
+/********************************************************/
+/*                                                      */
+/*                   transformColors                    */
+/*                                                      */
+/********************************************************/
+
+namespace detail {
+
+    // Cube root with relative error below 1e-12: the initial guess (error
+    // about 3%) divides the exponent by three, two Halley iterations follow.
+inline double fastCbrt(double x)
+{
+    double a = x < 0.0 ? -x : x;
+    if(a < 1e-300)
+        return x < 0.0 ? -VIGRA_CSTD::pow(a, 1.0/3.0) : VIGRA_CSTD::pow(a, 1.0/3.0);
+    UInt64 bits;
+    std::memcpy(&bits, &a, sizeof(double));
+    bits = bits / 3 + ((UInt64)0x2a9f7893 << 32);
+    double y;
+    std::memcpy(&y, &bits, sizeof(double));
+    double y3 = y*y*y;
+    y *= (y3 + 2.0*a) / (2.0*y3 + a);
+    y3 = y*y*y;
+    y *= (y3 + 2.0*a) / (2.0*y3 + a);
+    return x < 0.0 ? -y : y;
+}
+
+    // The affine part y = M x + t of a color conversion. It is obtained by
+    // applying the functor to the origin and to three points on the coordinate 
+    // axes, which is exact when the functor is affine. The points are chosen
+    // far from the origin to minimize round-off when the functor computes in
+    // single precision.
+struct ColorAffineMap
+{
+    double m[3][4];
+
+    ColorAffineMap()
+    {
+        for(int i=0; i<3; ++i)
+            for(int j=0; j<4; ++j)
+                m[i][j] = i == j ? 1.0 : 0.0;
+    }
+
+    template <class Functor>
+    explicit ColorAffineMap(Functor const & f)
+    {
+        typedef typename Functor::argument_type Argument;
+        typedef typename Argument::value_type Value;
+        Value probe = NumericTraits<Value>::max() < Value(255) 
+                          ? NumericTraits<Value>::max() 
+                          : Value(255);
+        typename Functor::result_type t = f(Argument(0, 0, 0));
+        for(int j=0; j<3; ++j)
+        {
+            Argument e(0, 0, 0);
+            e[j] = probe;
+            typename Functor::result_type c = f(e);
+            for(int i=0; i<3; ++i)
+                m[i][j] = ((double)c[i] - (double)t[i]) / (double)probe;
+        }
+        for(int i=0; i<3; ++i)
+            m[i][3] = t[i];
+    }
+
+    void apply(double * a, double * b, double * c, int size) const
+    {
+        for(int k=0; k<size; ++k)
+        {
+            double x = a[k], y = b[k], z = c[k];
+            a[k] = m[0][0]*x + m[0][1]*y + m[0][2]*z + m[0][3];
+            b[k] = m[1][0]*x + m[1][1]*y + m[1][2]*z + m[1][3];
+            c[k] = m[2][0]*x + m[2][1]*y + m[2][2]*z + m[2][3];
+        }
+    }
+};
+
+    // Generic kernel: apply the functor pixel by pixel.
+template <class Functor, class SrcType>
+class ColorConversionKernel
+{
+  public:
+    explicit ColorConversionKernel(Functor const & f)
+    : f_(f)
+    {}
+
+    template <class DestType>
+    void operator()(SrcType const * s0, SrcType const * s1, SrcType const * s2, MultiArrayIndex sstride,
+                    DestType * d0, DestType * d1, DestType * d2, MultiArrayIndex dstride, 
+                    MultiArrayIndex size) const
+    {
+        typedef RequiresExplicitCast<DestType> Convert;
+        for(MultiArrayIndex k=0, s=0, d=0; k<size; ++k, s+=sstride, d+=dstride)
+        {
+            typename Functor::result_type res = f_(TinyVector<SrcType, 3>(s0[s], s1[s], s2[s]));
+            d0[d] = Convert::cast(res[0]);
+            d1[d] = Convert::cast(res[1]);
+            d2[d] = Convert::cast(res[2]);
+        }
+    }
+
+  private:
+    Functor f_;
+};
+
+    // Block kernel for conversions of the form 
+    //     (optional gamma correction) -> affine map -> (optional L*a*b* or L*u*v* mapping)
+    // Pixels are processed in blocks of separate component arrays, so that the 
+    // compiler can vectorize the arithmetic. Gamma correction of 8-bit data uses 
+    // a lookup table, cube roots are computed by fastCbrt().
+template <class SrcType>
+class ColorPipelineKernel
+{
+  public:
+    enum Target { Affine, Lab, Luv };
+    enum { BlockSize = 64 };
+
+    ColorPipelineKernel(ColorAffineMap const & map, Target target, 
+                        double gamma = 1.0, double max = 1.0)
+    : map_(map),
+      target_(target),
+      gamma_(gamma),
+      max_(max)
+    {
+        if(gamma_ != 1.0 && sizeof(SrcType) == 1 && NumericTraits<SrcType>::isIntegral::asBool)
+        {
+            lut_.resize(256);
+            for(int k=0; k<256; ++k)
+                lut_[k] = gammaCorrection<double>((SrcType)(UInt8)k / max_, gamma_);
+        }
+    }
+
+    template <class DestType>
+    void operator()(SrcType const * s0, SrcType const * s1, SrcType const * s2, MultiArrayIndex sstride,
+                    DestType * d0, DestType * d1, DestType * d2, MultiArrayIndex dstride, 
+                    MultiArrayIndex size) const
+    {
+        typedef RequiresExplicitCast<DestType> Convert;
+        double a[BlockSize], b[BlockSize], c[BlockSize];
+        for(MultiArrayIndex start=0; start<size; start+=BlockSize)
+        {
+            int n = (int)std::min<MultiArrayIndex>(BlockSize, size - start);
+            load(s0 + start*sstride, sstride, a, n);
+            load(s1 + start*sstride, sstride, b, n);
+            load(s2 + start*sstride, sstride, c, n);
+            map_.apply(a, b, c, n);
+            if(target_ == Lab)
+                xyz2lab(a, b, c, n);
+            else if(target_ == Luv)
+                xyz2luv(a, b, c, n);
+            DestType * q0 = d0 + start*dstride, * q1 = d1 + start*dstride, * q2 = d2 + start*dstride;
+            for(int k=0; k<n; ++k)
+            {
+                q0[k*dstride] = Convert::cast(a[k]);
+                q1[k*dstride] = Convert::cast(b[k]);
+                q2[k*dstride] = Convert::cast(c[k]);
+            }
+        }
+    }
+
+  private:
+    void load(SrcType const * s, MultiArrayIndex stride, double * d, int size) const
+    {
+        if(lut_.size() > 0)
+        {
+            for(int k=0; k<size; ++k, s+=stride)
+                d[k] = lut_[(UInt8)*s];
+        }
+        else if(gamma_ != 1.0)
+        {
+            for(int k=0; k<size; ++k, s+=stride)
+                d[k] = gammaCorrection<double>(*s / max_, gamma_);
+        }
+        else
+        {
+            for(int k=0; k<size; ++k, s+=stride)
+                d[k] = *s;
+        }
+    }
+
+        // same formulas as XYZ2LabFunctor and XYZ2LuvFunctor
+    static void xyz2lab(double * a, double * b, double * c, int size)
+    {
+        const double kappa = 24389.0/27.0, epsilon = 216.0/24389.0;
+        for(int k=0; k<size; ++k)
+        {
+            double xgamma = fastCbrt(a[k] / 0.950456),
+                   ygamma = fastCbrt(b[k]),
+                   zgamma = fastCbrt(c[k] / 1.088754);
+            a[k] = b[k] < epsilon 
+                      ? kappa * b[k]
+                      : 116.0 * ygamma - 16.0;
+            b[k] = 500.0*(xgamma - ygamma);
+            c[k] = 200.0*(ygamma - zgamma);
+        }
+    }
+
+    static void xyz2luv(double * a, double * b, double * c, int size)
+    {
+        const double kappa = 24389.0/27.0, epsilon = 216.0/24389.0;
+        for(int k=0; k<size; ++k)
+        {
+            if(b[k] == 0.0)
+            {
+                a[k] = c[k] = 0.0;
+                continue;
+            }
+            double L = b[k] < epsilon
+                          ? kappa * b[k]
+                          : 116.0 * fastCbrt(b[k]) - 16.0;
+            double denom = a[k] + 15.0*b[k] + 3.0*c[k];
+            double uprime = 4.0 * a[k] / denom;
+            double vprime = 9.0 * b[k] / denom;
+            a[k] = L;
+            b[k] = 13.0*L*(uprime - 0.197839);
+            c[k] = 13.0*L*(vprime - 0.468342);
+        }
+    }
+
+    ColorAffineMap map_;
+    Target target_;
+    double gamma_, max_;
+    ArrayVector<double> lut_;
+};
+
+#define VIGRA_AFFINE_COLOR_KERNEL(FUNCTOR, T) \
+template <class SrcType> \
+class ColorConversionKernel<FUNCTOR<T>, SrcType> \
+: public ColorPipelineKernel<SrcType> \
+{ \
+  public: \
+    explicit ColorConversionKernel(FUNCTOR<T> const & f) \
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(f), ColorPipelineKernel<SrcType>::Affine) \
+    {} \
+};
+
+    // forward transforms have a real-valued result for all T
+#define VIGRA_AFFINE_COLOR_KERNEL_ALL(FUNCTOR) \
+template <class T, class SrcType> \
+class ColorConversionKernel<FUNCTOR<T>, SrcType> \
+: public ColorPipelineKernel<SrcType> \
+{ \
+  public: \
+    explicit ColorConversionKernel(FUNCTOR<T> const & f) \
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(f), ColorPipelineKernel<SrcType>::Affine) \
+    {} \
+};
+
+VIGRA_AFFINE_COLOR_KERNEL_ALL(RGB2XYZFunctor)
+VIGRA_AFFINE_COLOR_KERNEL_ALL(RGBPrime2YPrimePbPrFunctor)
+VIGRA_AFFINE_COLOR_KERNEL_ALL(RGBPrime2YPrimeIQFunctor)
+VIGRA_AFFINE_COLOR_KERNEL_ALL(RGBPrime2YPrimeUVFunctor)
+VIGRA_AFFINE_COLOR_KERNEL_ALL(RGBPrime2YPrimeCbCrFunctor)
+
+    // inverse transforms round the result when T is integral
+VIGRA_AFFINE_COLOR_KERNEL(XYZ2RGBFunctor, float)
+VIGRA_AFFINE_COLOR_KERNEL(XYZ2RGBFunctor, double)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimePbPr2RGBPrimeFunctor, float)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimePbPr2RGBPrimeFunctor, double)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimeIQ2RGBPrimeFunctor, float)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimeIQ2RGBPrimeFunctor, double)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimeUV2RGBPrimeFunctor, float)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimeUV2RGBPrimeFunctor, double)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimeCbCr2RGBPrimeFunctor, float)
+VIGRA_AFFINE_COLOR_KERNEL(YPrimeCbCr2RGBPrimeFunctor, double)
+
+#undef VIGRA_AFFINE_COLOR_KERNEL
+#undef VIGRA_AFFINE_COLOR_KERNEL_ALL
+
+template <class T, class SrcType>
+class ColorConversionKernel<XYZ2LabFunctor<T>, SrcType>
+: public ColorPipelineKernel<SrcType>
+{
+  public:
+    explicit ColorConversionKernel(XYZ2LabFunctor<T> const &)
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(), ColorPipelineKernel<SrcType>::Lab)
+    {}
+};
+
+template <class T, class SrcType>
+class ColorConversionKernel<XYZ2LuvFunctor<T>, SrcType>
+: public ColorPipelineKernel<SrcType>
+{
+  public:
+    explicit ColorConversionKernel(XYZ2LuvFunctor<T> const &)
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(), ColorPipelineKernel<SrcType>::Luv)
+    {}
+};
+
+template <class T, class SrcType>
+class ColorConversionKernel<RGB2LabFunctor<T>, SrcType>
+: public ColorPipelineKernel<SrcType>
+{
+  public:
+    explicit ColorConversionKernel(RGB2LabFunctor<T> const & f)
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(f.rgb2xyz), ColorPipelineKernel<SrcType>::Lab)
+    {}
+};
+
+template <class T, class SrcType>
+class ColorConversionKernel<RGB2LuvFunctor<T>, SrcType>
+: public ColorPipelineKernel<SrcType>
+{
+  public:
+    explicit ColorConversionKernel(RGB2LuvFunctor<T> const & f)
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(f.rgb2xyz), ColorPipelineKernel<SrcType>::Luv)
+    {}
+};
+
+template <class T, class SrcType>
+class ColorConversionKernel<RGBPrime2XYZFunctor<T>, SrcType>
+: public ColorPipelineKernel<SrcType>
+{
+  public:
+    explicit ColorConversionKernel(RGBPrime2XYZFunctor<T> const & f)
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(RGB2XYZFunctor<double>(1.0)), 
+                                   ColorPipelineKernel<SrcType>::Affine, f.gamma_, f.max_)
+    {}
+};
+
+template <class T, class SrcType>
+class ColorConversionKernel<RGBPrime2LabFunctor<T>, SrcType>
+: public ColorPipelineKernel<SrcType>
+{
+  public:
+    explicit ColorConversionKernel(RGBPrime2LabFunctor<T> const & f)
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(RGB2XYZFunctor<double>(1.0)), 
+                                   ColorPipelineKernel<SrcType>::Lab, f.rgb2xyz.gamma_, f.rgb2xyz.max_)
+    {}
+};
+
+template <class T, class SrcType>
+class ColorConversionKernel<RGBPrime2LuvFunctor<T>, SrcType>
+: public ColorPipelineKernel<SrcType>
+{
+  public:
+    explicit ColorConversionKernel(RGBPrime2LuvFunctor<T> const & f)
+    : ColorPipelineKernel<SrcType>(ColorAffineMap(RGB2XYZFunctor<double>(1.0)), 
+                                   ColorPipelineKernel<SrcType>::Luv, f.rgb2xyz.gamma_, f.rgb2xyz.max_)
+    {}
+};
+
+    // Apply a kernel to all lines (along dimension 0) of a set of three 
+    // component arrays with shape 'shape' and strides 'sstride' and 'dstride'.
+template <unsigned int N, class SrcType, class DestType, class Kernel>
+struct ColorLinesFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    SrcType const * src[3];
+    DestType * dest[3];
+    Shape shape, sstride, dstride;
+    Kernel const * kernel;
+
+    void operator()(MultiArrayIndex begin, MultiArrayIndex end) const
+    {
+        for(MultiArrayIndex line=begin; line<end; ++line)
+        {
+            MultiArrayIndex l = line, soffset = 0, doffset = 0;
+            for(unsigned int k=1; k<N; ++k)
+            {
+                MultiArrayIndex c = l % shape[k];
+                l /= shape[k];
+                soffset += c*sstride[k];
+                doffset += c*dstride[k];
+            }
+            (*kernel)(src[0] + soffset, src[1] + soffset, src[2] + soffset, sstride[0],
+                      dest[0] + doffset, dest[1] + doffset, dest[2] + doffset, dstride[0], 
+                      shape[0]);
+        }
+    }
+};
+
+template <unsigned int N, class SrcType, class DestType, class Functor>
+void transformColorLines(ColorLinesFunctor<N, SrcType, DestType, 
+                                           ColorConversionKernel<Functor, SrcType> > & lines,
+                         Functor const & f, int nthreads)
+{
+    ColorConversionKernel<Functor, SrcType> kernel(f);
+    lines.kernel = &kernel;
+    // don't start threads for less than about 16k pixels per thread
+    MultiArrayIndex count = prod(lines.shape) / lines.shape[0];
+    parallelForChunks(count, lines, nthreads, 
+                      std::max<MultiArrayIndex>(1, (1 << 14) / lines.shape[0]));
+}
+
+} // namespace detail
+
+/** \addtogroup ColorConversions
+*/
+//@{
+
+/** \brief Convert the colors of an entire array with a color conversion functor.
+
+    This function gives the same results as
+    
+    \code
+    transformMultiArray(srcMultiArrayRange(src), destMultiArray(dest), f);
+    \endcode
+    
+    but is much faster for the common conversions. The pixels are 
+    processed block-wise, such that the linear (matrix) part of the conversion 
+    is vectorized by the compiler, and in <tt>nthreads</tt> threads (see 
+    \ref parallelThreadCount(); the default is a single thread, pass 0 to use 
+    all available threads). Dedicated implementations exist for
+    
+    <UL>
+    <LI> \ref RGB2XYZFunctor, \ref RGBPrime2XYZFunctor, \ref XYZ2LabFunctor, \ref XYZ2LuvFunctor,
+         \ref RGB2LabFunctor, \ref RGB2LuvFunctor, \ref RGBPrime2LabFunctor, \ref RGBPrime2LuvFunctor,
+    <LI> \ref RGBPrime2YPrimePbPrFunctor, \ref RGBPrime2YPrimeCbCrFunctor, \ref RGBPrime2YPrimeIQFunctor,
+         \ref RGBPrime2YPrimeUVFunctor,
+    <LI> \ref XYZ2RGBFunctor, \ref YPrimePbPr2RGBPrimeFunctor, \ref YPrimeCbCr2RGBPrimeFunctor, 
+         \ref YPrimeIQ2RGBPrimeFunctor and \ref YPrimeUV2RGBPrimeFunctor with 
+         <tt>float</tt> or <tt>double</tt> template argument.
+    </UL>
+    
+    All other functors are applied pixel by pixel (but still in parallel).
+    The cube roots of the L*a*b* and L*u*v* conversions are computed by an 
+    iterative approximation with relative error below 10<sup>-12</sup>, and
+    the gamma correction of 8-bit R'G'B' data uses a lookup table, so that 
+    the results differ from the functors' results only by floating point round-off 
+    (the dedicated implementations always compute in double precision). 
+    Unlike the functors, the L*a*b* and L*u*v* conversions accept slightly 
+    negative XYZ coordinates (e.g. resulting from numerical noise) and 
+    treat them symmetrically instead of returning NaN.
+    
+    \ref transformColors() works with interleaved color arrays, i.e. arrays whose 
+    value type has three components (<tt>TinyVector<T, 3></tt> or <tt>RGBValue<T></tt>), 
+    \ref transformColorBands() with planar arrays where the three color bands 
+    are stored along the last dimension. Source and destination must have the same
+    shape and may be the same array.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class V1, class S1, class V2, class S2, class Functor>
+        void
+        transformColors(MultiArrayView<N, V1, S1> const & src, MultiArrayView<N, V2, S2> dest,
+                        Functor const & f, int nthreads = 1);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/colorconversions.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<2, RGBValue<UInt8> > rgb(w, h);
+    MultiArray<2, TinyVector<float, 3> > lab(w, h);
+    ...
+    transformColors(rgb, lab, RGBPrime2LabFunctor<float>());     // single thread
+    transformColors(rgb, lab, RGBPrime2LabFunctor<float>(), 0);  // all available threads
+    \endcode
+*/
+template <unsigned int N, class V1, class S1, class V2, class S2, class Functor>
+void
+transformColors(MultiArrayView<N, V1, S1> const & src, MultiArrayView<N, V2, S2> dest,
+                Functor const & f, int nthreads = 1)
+{
+    typedef typename V1::value_type T1;
+    typedef typename V2::value_type T2;
+    vigra_precondition(src.shape() == dest.shape(),
+        "transformColors(): shape mismatch between input and output.");
+    vigra_precondition(sizeof(V1) == 3*sizeof(T1) && sizeof(V2) == 3*sizeof(T2),
+        "transformColors(): pixel types must have three components.");
+    if(src.size() == 0)
+        return;
+
+    detail::ColorLinesFunctor<N, T1, T2, detail::ColorConversionKernel<Functor, T1> > lines;
+    T1 const * s = reinterpret_cast<T1 const *>(src.data());
+    T2 * d = reinterpret_cast<T2 *>(dest.data());
+    for(int k=0; k<3; ++k)
+    {
+        lines.src[k] = s + k;
+        lines.dest[k] = d + k;
+    }
+    lines.shape = src.shape();
+    lines.sstride = 3*src.stride();
+    lines.dstride = 3*dest.stride();
+    detail::transformColorLines(lines, f, nthreads);
+}
+
+/** \brief Convert the colors of an array whose color bands are stored along the last dimension.
+
+    The array must have at least two dimensions, and the last dimension must have
+    size 3. See \ref transformColors() for details.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1, class T2, class S2, class Functor>
+        void
+        transformColorBands(MultiArrayView<N, T1, S1> const & src, MultiArrayView<N, T2, S2> dest,
+                            Functor const & f, int nthreads = 1);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/colorconversions.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, float> rgb(Shape3(w, h, 3)), luv(Shape3(w, h, 3));
+    ...
+    transformColorBands(rgb, luv, RGB2LuvFunctor<float>());
+    \endcode
+*/
+template <unsigned int N, class T1, class S1, class T2, class S2, class Functor>
+void
+transformColorBands(MultiArrayView<N, T1, S1> const & src, MultiArrayView<N, T2, S2> dest,
+                    Functor const & f, int nthreads = 1)
+{
+    vigra_precondition(src.shape() == dest.shape(),
+        "transformColorBands(): shape mismatch between input and output.");
+    vigra_precondition(N >= 2 && src.shape(N-1) == 3,
+        "transformColorBands(): last dimension must hold three color bands.");
+    if(src.size() == 0)
+        return;
+
+    detail::ColorLinesFunctor<N-1, T1, T2, detail::ColorConversionKernel<Functor, T1> > lines;
+    for(int k=0; k<3; ++k)
+    {
+        lines.src[k] = src.data() + k*src.stride(N-1);
+        lines.dest[k] = dest.data() + k*dest.stride(N-1);
+    }
+    for(unsigned int k=0; k<N-1; ++k)
+    {
+        lines.shape[k] = src.shape(k);
+        lines.sstride[k] = src.stride(k);
+        lines.dstride[k] = dest.stride(k);
+    }
+    detail::transformColorLines(lines, f, nthreads);
+}
+
+//@}
+
 } // namespace vigra 
 
 #endif /* VIGRA_COLORCONVERSIONS_HXX */
@@ -39,6 +39,10 @@
 
 #include <cmath>
 #include "stdimage.hxx"
+#include "array_vector.hxx"
+#include "multi_array.hxx"
+#include "multi_distance.hxx"
+#include "parallel.hxx"
 
 namespace vigra {
 
@@ -266,6 +270,137 @@ internalDistanceTransform(SrcImageIterator src_upperleft,
     }
 }
 
+namespace detail {
+
+/* Column pass of the exact Euclidean distance transform: compute the squared
+   distance to the nearest object pixel in the same column (scaled by the
+   squared vertical pixel pitch), or 'infinity' if the column contains no object.
+   Columns [begin, end) are processed row by row for cache efficiency.
+*/
+template <class SrcImageIterator, class SrcAccessor, class ValueType>
+struct DistanceTransformColumnPass
+{
+    SrcImageIterator src;
+    SrcAccessor sa;
+    ValueType background;
+    MultiArrayView<2, double> dist;
+    double pitch2, infinity;
+
+    DistanceTransformColumnPass(SrcImageIterator s, SrcAccessor a, ValueType b,
+                                MultiArrayView<2, double> const & d, double p, double i)
+    : src(s), sa(a), background(b), dist(d), pitch2(p*p), infinity(i)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        MultiArrayIndex w = end - begin, h = dist.shape(1);
+        MultiArrayView<2, double> d(dist.subarray(Shape2(begin, 0), Shape2(end, h)));
+
+        // top to bottom: number of rows to the nearest object above
+        // (values >= h mean that there is none)
+        for(MultiArrayIndex y = 0; y < h; ++y)
+        {
+            typename SrcImageIterator::row_iterator s = (src + Diff2D(begin, y)).rowIterator();
+            for(MultiArrayIndex x = 0; x < w; ++x, ++s)
+            {
+                if(sa(s) != background)
+                    d(x, y) = 0.0;
+                else
+                    d(x, y) = y == 0
+                                 ? (double)h
+                                 : d(x, y-1) + 1.0;
+            }
+        }
+
+        // bottom to top: combine with the nearest object below and square
+        ArrayVector<double> below(w);
+        for(MultiArrayIndex y = h-1; y >= 0; --y)
+        {
+            for(MultiArrayIndex x = 0; x < w; ++x)
+            {
+                double c = d(x, y);
+                if(y < h-1 && below[x] + 1.0 < c)
+                    c = below[x] + 1.0;
+                below[x] = c;
+                d(x, y) = c >= h
+                             ? infinity
+                             : pitch2*c*c;
+            }
+        }
+    }
+};
+
+/* Row pass of the exact Euclidean distance transform: lower envelope of the
+   parabolas centered at each pixel of a row (Felzenszwalb & Huttenlocher),
+   followed by the square root.
+*/
+template <class DestImageIterator, class DestAccessor>
+struct DistanceTransformRowPass
+{
+    MultiArrayView<2, double> dist;
+    DestImageIterator dest;
+    DestAccessor da;
+    double pitch;
+
+    DistanceTransformRowPass(MultiArrayView<2, double> const & d,
+                             DestImageIterator de, DestAccessor a, double p)
+    : dist(d), dest(de), da(a), pitch(p)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        MultiArrayIndex w = dist.shape(0);
+        ArrayVector<double> line(w);
+        for(MultiArrayIndex y = begin; y < end; ++y)
+        {
+            double const * row = &dist(0, y);
+            distParabola(row, row + w, StandardConstValueAccessor<double>(),
+                         line.begin(), StandardValueAccessor<double>(), pitch);
+
+            typename DestImageIterator::row_iterator d = (dest + Diff2D(0, y)).rowIterator();
+            for(MultiArrayIndex x = 0; x < w; ++x, ++d)
+                da.set(VIGRA_CSTD::sqrt(line[x]), d);
+        }
+    }
+};
+
+/* Exact Euclidean distance transform in linear time: a 1-D distance
+   transform along the columns, followed by the parabola lower envelope
+   along the rows. Both passes are parallelized over columns resp. rows.
+*/
+template <class SrcImageIterator, class SrcAccessor,
+          class DestImageIterator, class DestAccessor,
+          class ValueType>
+void
+euclideanDistanceTransform(SrcImageIterator src_upperleft,
+                           SrcImageIterator src_lowerright, SrcAccessor sa,
+                           DestImageIterator dest_upperleft, DestAccessor da,
+                           ValueType background, TinyVector<double, 2> const & pixelPitch,
+                           int nthreads)
+{
+    MultiArrayIndex w = src_lowerright.x - src_upperleft.x,
+                    h = src_lowerright.y - src_upperleft.y;
+    if(w <= 0 || h <= 0)
+        return;
+
+    // larger than any squared distance that can occur in the image
+    double infinity = sq(pixelPitch[0]*w) + sq(pixelPitch[1]*h);
+
+    MultiArray<2, double> dist(Shape2(w, h));
+
+    // chunks of at least 16 columns resp. rows to amortize the overhead
+    parallelForChunks(w,
+        DistanceTransformColumnPass<SrcImageIterator, SrcAccessor, ValueType>(
+            src_upperleft, sa, background, dist, pixelPitch[1], infinity),
+        nthreads, 16);
+    parallelForChunks(h,
+        DistanceTransformRowPass<DestImageIterator, DestAccessor>(
+            dist, dest_upperleft, da, pixelPitch[0]),
+        nthreads, 16);
+}
+
+} // namespace detail
+
 /********************************************************/
 /*                                                      */
 /*                 distanceTransform                    */
@@ -299,7 +434,15 @@ internalDistanceTransform(SrcImageIterator src_upperleft,
     </ul>
     
     If you use the L2 norm, the destination pixels must be real valued to give
-    correct results.
+    correct results. The Euclidean distance is computed exactly in linear time by
+    the separable algorithm of Felzenszwalb and Huttenlocher (a 1-D distance
+    transform of each column, followed by the lower envelope of parabolas along
+    each row, see also \ref separableMultiDistance()). The optional
+    <tt>pixelPitch</tt> gives the physical size of a pixel in x- and y-direction,
+    so that distances in anisotropic images are measured in physical units
+    (this is only supported for the L2 norm). Both passes can be executed in
+    parallel by passing a thread count <tt>nthreads</tt> (see
+    \ref ParallelProcessing); the L1 and L-infinity norms always run serially.
     
     <b> Declarations:</b>
     
@@ -313,6 +456,15 @@ internalDistanceTransform(SrcImageIterator src_upperleft,
                         SrcImageIterator src_lowerright, SrcAccessor sa,
                         DestImageIterator dest_upperleft, DestAccessor da,
                         ValueType background, int norm)
+
+        template <class SrcImageIterator, class SrcAccessor,
+                           class DestImageIterator, class DestAccessor,
+                           class ValueType>
+        void distanceTransform(SrcImageIterator src_upperleft, 
+                        SrcImageIterator src_lowerright, SrcAccessor sa,
+                        DestImageIterator dest_upperleft, DestAccessor da,
+                        ValueType background, int norm,
+                        TinyVector<double, 2> const & pixelPitch, int nthreads = 1)
     }
     \endcode
     
@@ -327,6 +479,15 @@ internalDistanceTransform(SrcImageIterator src_upperleft,
             triple<SrcImageIterator, SrcImageIterator, SrcAccessor> src,
             pair<DestImageIterator, DestAccessor> dest,
             ValueType background, int norm)
+
+        template <class SrcImageIterator, class SrcAccessor,
+                           class DestImageIterator, class DestAccessor,
+                           class ValueType>
+        void distanceTransform(
+            triple<SrcImageIterator, SrcImageIterator, SrcAccessor> src,
+            pair<DestImageIterator, DestAccessor> dest,
+            ValueType background, int norm,
+            TinyVector<double, 2> const & pixelPitch, int nthreads = 1)
     }
     \endcode
     
@@ -353,6 +514,10 @@ internalDistanceTransform(SrcImageIterator src_upperleft,
     vigra::distanceTransform(srcImageRange(edges), destImage(distance),
                              0,                   2);
     //                       ^ background label   ^ norm (Euclidean)
+
+    // the same for pixels that are twice as high as wide, using 4 threads
+    vigra::distanceTransform(srcImageRange(edges), destImage(distance),
+                             0, 2, vigra::TinyVector<double, 2>(1.0, 2.0), 4);
     \endcode
 
     <b> Required Interface:</b>
@@ -393,9 +558,9 @@ distanceTransform(SrcImageIterator src_upperleft,
     }
     else if(norm == 2)
     {
-        internalDistanceTransform(src_upperleft, src_lowerright, sa,
-                                  dest_upperleft, da, background,
-                                  InternalDistanceTransformL2NormFunctor());
+        detail::euclideanDistanceTransform(src_upperleft, src_lowerright, sa,
+                                           dest_upperleft, da, background,
+                                           TinyVector<double, 2>(1.0), 1);
     }
     else
     {
@@ -418,6 +583,48 @@ distanceTransform(
                       dest.first, dest.second, background, norm);
 }
 
+template <class SrcImageIterator, class SrcAccessor,
+                   class DestImageIterator, class DestAccessor,
+                   class ValueType>
+inline void
+distanceTransform(SrcImageIterator src_upperleft, 
+                SrcImageIterator src_lowerright, SrcAccessor sa,
+                DestImageIterator dest_upperleft, DestAccessor da,
+                ValueType background, int norm,
+                TinyVector<double, 2> const & pixelPitch, int nthreads = 1)
+{
+    if(norm == 2)
+    {
+        vigra_precondition(pixelPitch[0] > 0.0 && pixelPitch[1] > 0.0,
+            "distanceTransform(): pixel pitch must be positive.");
+        detail::euclideanDistanceTransform(src_upperleft, src_lowerright, sa,
+                                           dest_upperleft, da, background,
+                                           pixelPitch, nthreads);
+    }
+    else
+    {
+        vigra_precondition((pixelPitch == TinyVector<double, 2>(1.0)),
+            "distanceTransform(): anisotropic pixel pitch is only supported for the Euclidean norm.");
+        distanceTransform(src_upperleft, src_lowerright, sa,
+                          dest_upperleft, da, background, norm);
+    }
+}
+
+template <class SrcImageIterator, class SrcAccessor,
+                   class DestImageIterator, class DestAccessor,
+                   class ValueType>
+inline void
+distanceTransform(
+    triple<SrcImageIterator, SrcImageIterator, SrcAccessor> src,
+    pair<DestImageIterator, DestAccessor> dest,
+    ValueType background, int norm,
+    TinyVector<double, 2> const & pixelPitch, int nthreads = 1)
+{
+    distanceTransform(src.first, src.second, src.third,
+                      dest.first, dest.second, background, norm,
+                      pixelPitch, nthreads);
+}
+
 //@}
 
 } // namespace vigra
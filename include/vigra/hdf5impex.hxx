@@ -70,13 +70,27 @@
 # include <hdf5_hl.h>
 #endif
 
+// direct chunk access (H5Dread_chunk(), H5Dwrite_chunk()) requires HDF5 1.10.2 or later
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && (H5_VERS_MINOR > 10 || \
+                          (H5_VERS_MINOR == 10 && H5_VERS_RELEASE >= 2)))
+# define VIGRA_HDF5_DIRECT_CHUNK_IO
+#endif
+
+#ifdef H5_HAVE_FILTER_DEFLATE
+# include <zlib.h>
+#endif
+
 #include "impex.hxx"
 #include "multi_array.hxx"
 #include "multi_impex.hxx"
 #include "utilities.hxx"
 #include "error.hxx"
+#include "parallel.hxx"
 
 #include <algorithm>
+#include <list>
+#include <map>
+#include <vector>
 
 namespace vigra {
 
@@ -460,6 +474,272 @@ void HDF5_ls_insert(void*, const std::string &);
 VIGRA_EXPORT H5O_type_t HDF5_get_type(hid_t, const char*);
 extern "C" VIGRA_EXPORT herr_t HDF5_ls_inserter_callback(hid_t, const char*, const H5L_info_t*, void*);
 
+/********************************************************/
+/*                                                      */
+/*                   HDF5ChunkCache                     */
+/*                                                      */
+/********************************************************/
+
+/** \brief Least-recently-used cache of decompressed dataset chunks.
+
+    Used internally by \ref HDF5File to avoid repeated reading and decompression
+    of the same chunks (e.g. when overlapping blocks are read via 
+    \ref HDF5File::readBlock()). Chunks are identified by the absolute dataset name
+    and the chunk's coordinates in the file. When the total size of the cached chunks 
+    exceeds the capacity (in bytes), the least recently used chunks are discarded.
+    A capacity of 0 disables caching.
+
+    <b>\#include</b> \<vigra/hdf5impex.hxx\><br>
+    Namespace: vigra
+*/
+class HDF5ChunkCache
+{
+  public:
+    typedef std::pair<std::string, std::vector<hsize_t> > Key;
+    typedef ArrayVector<char> Chunk;
+
+        /** Create a cache with the given capacity in bytes.
+        */
+    explicit HDF5ChunkCache(std::size_t capacity = 0)
+    : capacity_(capacity),
+      size_(0)
+    {}
+
+        /** The maximum number of bytes held by the cache.
+        */
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+        /** The number of bytes currently held by the cache.
+        */
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+        /** Change the capacity, discarding the least recently used chunks 
+            if necessary.
+        */
+    void setCapacity(std::size_t capacity)
+    {
+        capacity_ = capacity;
+        shrink(capacity_);
+    }
+
+        /** Remove all chunks.
+        */
+    void clear()
+    {
+        lru_.clear();
+        index_.clear();
+        size_ = 0;
+    }
+
+        /** Remove the given chunk (if present).
+        */
+    void erase(Key const & key)
+    {
+        Index::iterator i = index_.find(key);
+        if(i != index_.end())
+            erase(i);
+    }
+
+        /** Remove all chunks of the given dataset.
+        */
+    void erase(std::string const & dataset)
+    {
+        Index::iterator i = index_.lower_bound(Key(dataset, std::vector<hsize_t>()));
+        while(i != index_.end() && i->first.first == dataset)
+            erase(i++);
+    }
+
+        /** Return a pointer to the chunk's data or 0 if the chunk is not
+            in the cache. The chunk becomes the most recently used one.
+            The pointer is valid until the next call to insert() or a 
+            function removing chunks.
+        */
+    Chunk const * find(Key const & key)
+    {
+        Index::iterator i = index_.find(key);
+        if(i == index_.end())
+            return 0;
+        lru_.splice(lru_.begin(), lru_, i->second);
+        return &i->second->second;
+    }
+
+        /** Insert a chunk as the most recently used one. The contents of
+            <tt>data</tt> are swapped into the cache (i.e. <tt>data</tt> is empty 
+            afterwards). Chunks bigger than the capacity are not inserted.
+        */
+    void insert(Key const & key, Chunk & data)
+    {
+        erase(key);
+        if(data.size() > capacity_)
+            return;
+        shrink(capacity_ - data.size());
+        lru_.push_front(std::make_pair(key, Chunk()));
+        lru_.front().second.swap(data);
+        index_[key] = lru_.begin();
+        size_ += lru_.front().second.size();
+    }
+
+  private:
+    typedef std::list<std::pair<Key, Chunk> > List;
+    typedef std::map<Key, List::iterator> Index;
+
+    void erase(Index::iterator i)
+    {
+        size_ -= i->second->second.size();
+        lru_.erase(i->second);
+        index_.erase(i);
+    }
+
+    void shrink(std::size_t limit)
+    {
+        while(size_ > limit)
+            erase(index_.find(lru_.back().first));
+    }
+
+    std::size_t capacity_, size_;
+    List lru_;
+    Index index_;
+};
+
+namespace detail {
+
+    // Copy the intersection of the chunk starting at 'chunkOrigin' with the
+    // block starting at 'blockOffset' between the chunk buffer and the block.
+template <unsigned int N, class T, class Shape>
+void copyChunkIntersection(MultiArrayView<N, T, UnstridedArrayTag> chunk, Shape const & chunkOrigin,
+                           MultiArrayView<N, T, UnstridedArrayTag> block, Shape const & blockOffset,
+                           bool toBlock)
+{
+    Shape start, stop;
+    for(unsigned int k=0; k<N; ++k)
+    {
+        start[k] = std::max(chunkOrigin[k], blockOffset[k]);
+        stop[k]  = std::min(chunkOrigin[k] + chunk.shape(k), blockOffset[k] + block.shape(k));
+    }
+    if(toBlock)
+        block.subarray(start - blockOffset, stop - blockOffset).copy(
+                        chunk.subarray(start - chunkOrigin, stop - chunkOrigin));
+    else
+        chunk.subarray(start - chunkOrigin, stop - chunkOrigin).copy(
+                        block.subarray(start - blockOffset, stop - blockOffset));
+}
+
+    // Decompress chunks read via H5Dread_chunk() and copy them into a block.
+    // Chunks with a non-zero entry in 'cached' are taken from the cache instead.
+    // On return, 'data' holds the decompressed chunks.
+template <unsigned int N, class T>
+struct HDF5ChunkDecoder
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ArrayVector<Shape> const & chunks;
+    ArrayVector<ArrayVector<char> const *> const & cached;
+    ArrayVector<ArrayVector<char> > & data;
+    ArrayVector<unsigned int> const & filterMasks;
+    bool compressed;
+    Shape chunkShape, blockOffset;
+    MultiArrayView<N, T, UnstridedArrayTag> block;
+
+    HDF5ChunkDecoder(ArrayVector<Shape> const & c, ArrayVector<ArrayVector<char> const *> const & ca,
+                     ArrayVector<ArrayVector<char> > & d, ArrayVector<unsigned int> const & f,
+                     bool comp, Shape const & cs, Shape const & bo,
+                     MultiArrayView<N, T, UnstridedArrayTag> const & b)
+    : chunks(c), cached(ca), data(d), filterMasks(f), compressed(comp),
+      chunkShape(cs), blockOffset(bo), block(b)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        std::size_t chunkBytes = prod(chunkShape)*sizeof(T);
+        for(; begin < end; ++begin)
+        {
+            char const * chunk;
+            if(cached[begin] != 0)
+            {
+                chunk = cached[begin]->data();
+            }
+            else
+            {
+                ArrayVector<char> & buffer = data[begin];
+                // bit 0 of the filter mask is set when the deflate filter was skipped
+                if(compressed && (filterMasks[begin] & 1) == 0)
+                {
+#ifdef H5_HAVE_FILTER_DEFLATE
+                    ArrayVector<char> decompressed(chunkBytes);
+                    uLongf size = chunkBytes;
+                    int status = uncompress((Bytef *)decompressed.data(), &size,
+                                            (Bytef const *)buffer.data(), buffer.size());
+                    vigra_postcondition(status == Z_OK && size == chunkBytes,
+                        "HDF5File::readBlock(): chunk decompression failed.");
+                    buffer.swap(decompressed);
+#endif
+                }
+                vigra_postcondition(buffer.size() == chunkBytes,
+                    "HDF5File::readBlock(): chunk has unexpected size.");
+                chunk = buffer.data();
+            }
+            copyChunkIntersection(MultiArrayView<N, T, UnstridedArrayTag>(chunkShape, (T *)chunk),
+                                  chunks[begin]*chunkShape, block, blockOffset, true);
+        }
+    }
+};
+
+    // Copy chunks from a block into full-sized chunk buffers (padding
+    // with zeros at the dataset border) and compress them if requested.
+template <unsigned int N, class T>
+struct HDF5ChunkEncoder
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ArrayVector<Shape> const & chunks;
+    ArrayVector<ArrayVector<char> > & data;
+    bool compressed;
+    int level;
+    Shape chunkShape, blockOffset;
+    MultiArrayView<N, T, UnstridedArrayTag> block;
+
+    HDF5ChunkEncoder(ArrayVector<Shape> const & c, ArrayVector<ArrayVector<char> > & d,
+                     bool comp, int l, Shape const & cs, Shape const & bo,
+                     MultiArrayView<N, T, UnstridedArrayTag> const & b)
+    : chunks(c), data(d), compressed(comp), level(l), chunkShape(cs), blockOffset(bo), block(b)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        std::size_t chunkBytes = prod(chunkShape)*sizeof(T);
+        for(; begin < end; ++begin)
+        {
+            ArrayVector<char> buffer(chunkBytes, (char)0);
+            copyChunkIntersection(MultiArrayView<N, T, UnstridedArrayTag>(chunkShape, (T *)buffer.data()),
+                                  chunks[begin]*chunkShape, block, blockOffset, false);
+            if(compressed)
+            {
+#ifdef H5_HAVE_FILTER_DEFLATE
+                uLongf size = compressBound(chunkBytes);
+                data[begin].resize(size);
+                int status = compress2((Bytef *)data[begin].data(), &size,
+                                       (Bytef const *)buffer.data(), chunkBytes, level);
+                vigra_postcondition(status == Z_OK,
+                    "HDF5File::writeBlock(): chunk compression failed.");
+                data[begin].resize(size);
+#endif
+            }
+            else
+            {
+                data[begin].swap(buffer);
+            }
+        }
+    }
+};
+
+} // namespace detail
+
 /********************************************************/
 /*                                                      */
 /*                     HDF5File                         */
@@ -476,6 +756,12 @@ string attributes can be attached to any dataset or group. Group- or dataset-han
 are encapsulated in the class and managed automatically. The internal file-system like
 structure can be accessed by functions like "cd()" or "mkdir()".
 
+Chunks of deflate compressed (or uncompressed) chunked datasets are transferred
+directly between file and memory and compressed or decompressed by multiple threads 
+(see \ref setThreadCount()). Decompressed chunks can be kept in a least-recently-used
+cache (see \ref setChunkCacheSize()), and pre-compressed chunks can be stored 
+without passing through the HDF5 filter pipeline (see \ref writeRawChunk()).
+
 
 <b>Example:</b>
 Write the MultiArray out_multi_array to file. Change the current directory to
@@ -505,6 +791,12 @@ class HDF5File
     // time tagging of datasets, turned off (= 0) by default.
     int track_time;
 
+    // number of threads for chunk (de-)compression, see setThreadCount()
+    int threadCount_;
+
+    // decompressed chunks of recently read datasets, see setChunkCacheSize()
+    HDF5ChunkCache chunkCache_;
+
     // helper class for ls()
     struct ls_closure
     {
@@ -559,7 +851,8 @@ class HDF5File
         private to enforce this).
         */
     HDF5File(std::string filename, OpenMode mode, int track_creation_times = 0)
-        : track_time(track_creation_times)
+        : track_time(track_creation_times),
+          threadCount_(1)
     {
         std::string errorMessage = "HDF5File: Could not create file '" + filename + "'.";
         fileHandle_ = HDF5Handle(createFile_(filename, mode), &H5Fclose, errorMessage.c_str());
@@ -1406,6 +1699,7 @@ class HDF5File
 
         // delete the dataset if it already exists
         deleteDataset_(parent, setname);
+        chunkCache_.erase(datasetName);
 
         // create dataspace
         // add an extra dimension in case that the data is non-scalar
@@ -1456,6 +1750,141 @@ class HDF5File
     inline void flushToDisk()
     {
         H5Fflush(fileHandle_, H5F_SCOPE_GLOBAL);
+    }
+
+        /** \brief Set the number of threads used to compress and decompress chunks.
+
+            Reading and writing chunked datasets whose only filter is deflate 
+            compression (or which are not filtered at all) bypasses the HDF5 
+            filter pipeline: the chunks are transferred as is, and compression
+            and decompression is done by a pool of <tt>n</tt> threads (HDF5 
+            itself is only called from the calling thread). <tt>n = 0</tt> uses 
+            all available threads, see \ref parallelThreadCount(). The default is 1.
+            Direct chunk transfer requires HDF5 1.10.2 or later, other HDF5 versions
+            and datasets with different filters or type conversion are read and 
+            written by HDF5 as usual.
+        */
+    void setThreadCount(int n)
+    {
+        threadCount_ = n;
+    }
+
+        /** \brief Get the number of threads used to compress and decompress chunks.
+        */
+    int threadCount() const
+    {
+        return threadCount_;
+    }
+
+        /** \brief Set the byte budget of the chunk cache.
+
+            Chunks that were decompressed by \ref read() or \ref readBlock() are kept 
+            in a least-recently-used cache, so that subsequent reads of overlapping 
+            blocks need not read and decompress them again. When the cache holds
+            more than <tt>bytes</tt> bytes of decompressed data, the least recently
+            used chunks are discarded. The default is 0, i.e. caching is disabled.
+        */
+    void setChunkCacheSize(std::size_t bytes)
+    {
+        chunkCache_.setCapacity(bytes);
+    }
+
+        /** \brief Get the byte budget of the chunk cache.
+        */
+    std::size_t chunkCacheSize() const
+    {
+        return chunkCache_.capacity();
+    }
+
+        /** \brief Discard all chunks in the chunk cache.
+        */
+    void clearChunkCache()
+    {
+        chunkCache_.clear();
+    }
+
+        /** \brief Write a chunk of a dataset as is, bypassing the HDF5 filter pipeline.
+
+            This is useful to store data that were already compressed elsewhere 
+            without decompressing them first. The chunk at 
+            <tt>chunkIndex*chunkShape</tt> (where <tt>chunkShape</tt> is the chunk 
+            shape of the dataset) is replaced by <tt>size</tt> bytes starting at 
+            <tt>data</tt>. If <tt>compressed</tt> is true, the data must be the 
+            output of the dataset's filters, e.g. a zlib stream (as created by 
+            zlib's <tt>compress2()</tt>) for deflate compressed datasets. Otherwise,
+            the data must be a complete uncompressed chunk, and HDF5 will skip
+            all (optional) filters when reading the chunk. In any case, the 
+            uncompressed chunk always has the full chunk shape, even at the 
+            border of the dataset.
+
+            Requires HDF5 1.10.2 or later.
+        */
+    template<unsigned int N>
+    void writeRawChunk(std::string datasetName, typename MultiArrayShape<N>::type chunkIndex,
+                       const char * data, std::size_t size, bool compressed = true)
+    {
+        // make datasetName clean
+        datasetName = get_absolute_path(datasetName);
+
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        std::string errorMessage = "HDF5File::writeRawChunk(): Error opening dataset '" + datasetName + "'.";
+        HDF5Handle datasetHandle(getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
+
+        ArrayVector<hsize_t> offset;
+        rawChunkOffset_(datasetHandle, chunkIndex, offset);
+        herr_t status = H5Dwrite_chunk(datasetHandle, H5P_DEFAULT, compressed ? 0u : ~0u,
+                                       offset.data(), size, data);
+        vigra_postcondition(status >= 0, "HDF5File::writeRawChunk(): write to "
+                                         "dataset '" + datasetName + "' failed.");
+        chunkCache_.erase(chunkKey_(datasetName, chunkIndex));
+#else
+        vigra_precondition(false, "HDF5File::writeRawChunk(): requires HDF5 1.10.2 or later.");
+#endif
+    }
+
+        /** \brief Read a chunk of a dataset as is, bypassing the HDF5 filter pipeline.
+
+            The chunk at <tt>chunkIndex*chunkShape</tt> (see \ref writeRawChunk()) 
+            is copied into <tt>data</tt>, which is resized as necessary. The function 
+            returns true if the data are compressed (i.e. were passed through the 
+            dataset's filters), and false if they are stored uncompressed.
+            The chunk must exist in the file.
+
+            Requires HDF5 1.10.2 or later.
+        */
+    template<unsigned int N>
+    bool readRawChunk(std::string datasetName, typename MultiArrayShape<N>::type chunkIndex,
+                      ArrayVector<char> & data)
+    {
+        // make datasetName clean
+        datasetName = get_absolute_path(datasetName);
+
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        std::string errorMessage = "HDF5File::readRawChunk(): Error opening dataset '" + datasetName + "'.";
+        HDF5Handle datasetHandle(getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
+
+        ArrayVector<hsize_t> offset;
+        rawChunkOffset_(datasetHandle, chunkIndex, offset);
+        hsize_t size = 0;
+        herr_t exists;
+        H5E_BEGIN_TRY {
+            exists = H5Dget_chunk_storage_size(datasetHandle, offset.data(), &size);
+        } H5E_END_TRY;
+        vigra_precondition(exists >= 0 && size > 0,
+            "HDF5File::readRawChunk(): chunk does not exist in dataset '" + datasetName + "'.");
+        data.resize(size);
+        uint32_t filterMask = 0;
+        herr_t status = H5Dread_chunk(datasetHandle, H5P_DEFAULT, offset.data(), &filterMask, data.data());
+        vigra_postcondition(status >= 0, "HDF5File::readRawChunk(): read from "
+                                         "dataset '" + datasetName + "' failed.");
+
+        HDF5Handle plist(H5Dget_create_plist(datasetHandle), &H5Pclose, 
+                         "HDF5File::readRawChunk(): unable to get property list.");
+        return H5Pget_nfilters(plist) > 0 && (filterMask & 1) == 0;
+#else
+        vigra_precondition(false, "HDF5File::readRawChunk(): requires HDF5 1.10.2 or later.");
+        return false;
+#endif
     }
 
   private:
@@ -1904,6 +2333,7 @@ class HDF5File
 
         // delete dataset, if it already exists
         deleteDataset_(groupHandle, setname.c_str());
+        chunkCache_.erase(datasetName);
 
         // set up properties list
         HDF5Handle plist(H5Pcreate(H5P_DATASET_CREATE), &H5Pclose, 
@@ -1933,6 +2363,12 @@ class HDF5File
         HDF5Handle datasetHandle(H5Dcreate(groupHandle, setname.c_str(), datatype, dataspace,H5P_DEFAULT, plist, H5P_DEFAULT), 
                                  &H5Dclose, "HDF5File::write(): Can not create dataset.");
 
+        // compress chunks in parallel if possible
+        if(chunkSize[0] > 0 && 
+           writeChunks_(datasetName, datasetHandle, typename MultiArrayShape<N>::type(), 
+                        array, datatype, numBandsOfType))
+            return;
+
         // Write the data to the HDF5 dataset as is
         herr_t write_status = H5Dwrite(datasetHandle, datatype, H5S_ALL,
                                        H5S_ALL, H5P_DEFAULT, array.data());
@@ -1989,6 +2425,11 @@ class HDF5File
         vigra_precondition(shape == array.shape(),
                            "HDF5File::read(): Array shape disagrees with dataset shape.");
 
+        // decompress chunks in parallel if possible
+        if(readChunks_(datasetName, datasetHandle, 
+                       typename MultiArrayShape<N>::type(), array, datatype, numBandsOfType))
+            return;
+
         // simply read in the data as is
         H5Dread( datasetHandle, datatype, H5S_ALL, H5S_ALL, H5P_DEFAULT, array.data() ); // .data() possible since void pointer!
     }
@@ -2031,6 +2472,10 @@ class HDF5File
         std::string errorMessage = "HDF5File::writeBlock(): Error opening dataset '" + datasetName + "'.";
         HDF5Handle datasetHandle (getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
 
+        // compress chunks in parallel if possible
+        if(writeChunks_(datasetName, datasetHandle, blockOffset, array, datatype, numBandsOfType))
+            return;
+
         // hyperslab parameters for position, size, ...
         hsize_t boffset [N];
         hsize_t bshape [N];
@@ -2075,6 +2520,10 @@ class HDF5File
         vigra_precondition(blockShape == array.shape(),
              "readHDF5_block(): Array shape disagrees with block size.");
 
+        // decompress chunks in parallel if possible
+        if(readChunks_(datasetName, datasetHandle, blockOffset, array, datatype, numBandsOfType))
+            return;
+
         // hyperslab parameters for position, size, ...
         hsize_t boffset [N];
         hsize_t bshape [N];
@@ -2102,6 +2551,345 @@ class HDF5File
         H5Dread( datasetHandle, datatype, memspace_handle, dataspaceHandle, H5P_DEFAULT, array.data() ); // .data() possible since void pointer!
     }
 
+
+        /* Key of a chunk in the chunk cache.
+        */
+    template<class Shape>
+    static HDF5ChunkCache::Key chunkKey_(std::string const & datasetName, Shape const & chunkIndex)
+    {
+        return HDF5ChunkCache::Key(datasetName, std::vector<hsize_t>(chunkIndex.begin(), chunkIndex.end()));
+    }
+
+        /* Indices of all chunks that intersect the given block.
+        */
+    template<class Shape>
+    static void chunksOfBlock_(Shape const & blockOffset, Shape const & blockShape, 
+                               Shape const & chunkShape, ArrayVector<Shape> & chunks)
+    {
+        chunks.clear();
+        Shape first, end;
+        for(int k=0; k<(int)Shape::static_size; ++k)
+        {
+            if(blockShape[k] <= 0)
+                return;
+            first[k] = blockOffset[k] / chunkShape[k];
+            end[k] = (blockOffset[k] + blockShape[k] - 1) / chunkShape[k] + 1;
+        }
+        Shape c(first);
+        for(int k=0; k<(int)Shape::static_size;)
+        {
+            chunks.push_back(c);
+            for(k=0; k<(int)Shape::static_size; ++k)
+            {
+                if(++c[k] < end[k])
+                    break;
+                c[k] = first[k];
+            }
+        }
+    }
+
+        /* Element offset of a chunk in HDF5 order (the band dimension, if any, comes last).
+        */
+    template<class Shape>
+    static void chunkOffset_(Shape const & chunkIndex, Shape const & chunkShape, int numBandsOfType,
+                             ArrayVector<hsize_t> & offset)
+    {
+        int N = Shape::static_size;
+        offset.resize(numBandsOfType > 1 ? N+1 : N);
+        for(int k=0; k<N; ++k)
+            offset[N-1-k] = chunkIndex[k]*chunkShape[k];
+        if(numBandsOfType > 1)
+            offset[N] = 0;
+    }
+
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        /* Element offset of a chunk for writeRawChunk() and readRawChunk().
+        */
+    template<class Shape>
+    void rawChunkOffset_(hid_t datasetHandle, Shape const & chunkIndex, ArrayVector<hsize_t> & offset)
+    {
+        int N = Shape::static_size;
+        HDF5Handle plist(H5Dget_create_plist(datasetHandle), &H5Pclose, 
+                         "HDF5File: unable to get property list.");
+        HDF5Handle dataspace(H5Dget_space(datasetHandle), &H5Sclose, 
+                             "HDF5File: unable to get dataspace.");
+        int dims = H5Sget_simple_extent_ndims(dataspace);
+        vigra_precondition(H5Pget_layout(plist) == H5D_CHUNKED,
+            "HDF5File: dataset is not chunked.");
+        vigra_precondition(dims == N || dims == N+1,
+            "HDF5File: chunk index dimension disagrees with dataset dimension.");
+        ArrayVector<hsize_t> cdims(dims);
+        H5Pget_chunk(plist, dims, cdims.data());
+        Shape chunkShape;
+        for(int k=0; k<N; ++k)
+            chunkShape[k] = cdims[N-1-k];
+        chunkOffset_(chunkIndex, chunkShape, dims - N + 1, offset);
+    }
+#endif
+
+        /* Check if the chunks of a dataset can be transferred directly, i.e. when the
+           dataset is chunked, stored with the memory type, not filtered by anything 
+           else than deflate, and all bands of an element are in the same chunk.
+           Then return the chunk shape, the dataset shape, the compression parameters
+           and (optionally) the fill value of an element.
+        */
+    template<unsigned int N, class T>
+    bool directChunkAccess_(hid_t datasetHandle, const hid_t datatype, const int numBandsOfType,
+                            typename MultiArrayShape<N>::type & chunkShape,
+                            typename MultiArrayShape<N>::type & datasetShape,
+                            bool & compressed, int & level, ArrayVector<char> * fillValue = 0)
+    {
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        HDF5Handle plist(H5Dget_create_plist(datasetHandle), &H5Pclose, 
+                         "HDF5File: unable to get property list.");
+        if(H5Pget_layout(plist) != H5D_CHUNKED)
+            return false;
+
+        int nfilters = H5Pget_nfilters(plist);
+        compressed = nfilters > 0;
+        level = 0;
+        if(nfilters > 1)
+            return false;
+        if(nfilters == 1)
+        {
+#ifdef H5_HAVE_FILTER_DEFLATE
+            unsigned int flags = 0, cd_values[1] = { 0 };
+            size_t cd_nelmts = 1;
+            if(H5Pget_filter2(plist, 0, &flags, &cd_nelmts, cd_values, 0, 0, 0) != H5Z_FILTER_DEFLATE)
+                return false;
+            level = cd_values[0];
+#else
+            return false;
+#endif
+        }
+
+        HDF5Handle filetype(H5Dget_type(datasetHandle), &H5Tclose, 
+                            "HDF5File: unable to get datatype.");
+        if(H5Tequal(filetype, datatype) <= 0 || H5Tget_size(datatype)*numBandsOfType != sizeof(T))
+            return false;
+
+        int offset = (numBandsOfType > 1)
+                        ? 1
+                        : 0;
+        HDF5Handle dataspace(H5Dget_space(datasetHandle), &H5Sclose, 
+                             "HDF5File: unable to get dataspace.");
+        if(H5Sget_simple_extent_ndims(dataspace) != (int)N + offset)
+            return false;
+        hsize_t dims[N+1], cdims[N+1];
+        H5Sget_simple_extent_dims(dataspace, dims, NULL);
+        H5Pget_chunk(plist, N + offset, cdims);
+        if(offset == 1 && cdims[N] != (hsize_t)numBandsOfType)
+            return false;
+        for(unsigned int k=0; k<N; ++k)
+        {
+            chunkShape[k] = cdims[N-1-k];
+            datasetShape[k] = dims[N-1-k];
+        }
+
+        if(fillValue != 0)
+        {
+            fillValue->resize(sizeof(T));
+            H5Pget_fill_value(plist, datatype, fillValue->data());
+            std::size_t bandSize = sizeof(T) / numBandsOfType;
+            for(std::size_t k=bandSize; k<sizeof(T); ++k)
+                (*fillValue)[k] = (*fillValue)[k - bandSize];
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+        /* Read a block from a chunked dataset via direct chunk transfer and parallel
+           decompression. Returns false if direct transfer is not possible.
+        */
+    template<unsigned int N, class T>
+    bool readChunks_(std::string const & datasetName, hid_t datasetHandle, 
+                     typename MultiArrayShape<N>::type const & blockOffset, 
+                     MultiArrayView<N, T, UnstridedArrayTag> array, 
+                     const hid_t datatype, const int numBandsOfType)
+    {
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        typedef typename MultiArrayShape<N>::type Shape;
+
+        Shape chunkShape, datasetShape;
+        bool compressed;
+        int level;
+        ArrayVector<char> fillValue;
+        if(!directChunkAccess_<N, T>(datasetHandle, datatype, numBandsOfType, 
+                                     chunkShape, datasetShape, compressed, level, &fillValue))
+            return false;
+        for(unsigned int k=0; k<N; ++k)
+            if(blockOffset[k] < 0 || blockOffset[k] + array.shape(k) > datasetShape[k])
+                return false; // let HDF5 report the error
+
+        ArrayVector<Shape> allChunks;
+        chunksOfBlock_(blockOffset, array.shape(), chunkShape, allChunks);
+        std::size_t chunkBytes = prod(chunkShape)*sizeof(T);
+        bool useCache = chunkCache_.capacity() > 0;
+
+        // process the chunks in batches to limit the memory for compressed data
+        std::size_t batchSize = std::max(64, 8*parallelThreadCount(threadCount_));
+        ArrayVector<hsize_t> offset;
+        for(std::size_t b = 0; b < allChunks.size(); b += batchSize)
+        {
+            ArrayVector<Shape> chunks(allChunks.begin() + b, 
+                                      allChunks.begin() + std::min(b + batchSize, allChunks.size()));
+            std::size_t count = chunks.size();
+            ArrayVector<ArrayVector<char> const *> cached(count, (ArrayVector<char> const *)0);
+            ArrayVector<ArrayVector<char> > data(count);
+            ArrayVector<unsigned int> filterMasks(count, 0u);
+
+            // HDF5 is only called from this thread
+            for(std::size_t k = 0; k < count; ++k)
+            {
+                if(useCache)
+                {
+                    cached[k] = chunkCache_.find(chunkKey_(datasetName, chunks[k]));
+                    if(cached[k] != 0)
+                        continue;
+                }
+                chunkOffset_(chunks[k], chunkShape, numBandsOfType, offset);
+                hsize_t size = 0;
+                herr_t exists;
+                // don't print an error message for chunks that have not been allocated
+                H5E_BEGIN_TRY {
+                    exists = H5Dget_chunk_storage_size(datasetHandle, offset.data(), &size);
+                } H5E_END_TRY;
+                if(exists < 0 || size == 0)
+                {
+                    // the chunk has never been written: use the fill value
+                    data[k].resize(chunkBytes);
+                    for(std::size_t i = 0; i < chunkBytes; i += sizeof(T))
+                        std::copy(fillValue.begin(), fillValue.end(), data[k].begin() + i);
+                    filterMasks[k] = ~0u;
+                    continue;
+                }
+                data[k].resize(size);
+                uint32_t filterMask = 0;
+                herr_t status = H5Dread_chunk(datasetHandle, H5P_DEFAULT, offset.data(), 
+                                              &filterMask, data[k].data());
+                vigra_postcondition(status >= 0, "HDF5File::readBlock(): read from "
+                                                 "dataset '" + datasetName + "' failed.");
+                filterMasks[k] = filterMask;
+            }
+
+            detail::HDF5ChunkDecoder<N, T> decoder(chunks, cached, data, filterMasks, compressed,
+                                                   chunkShape, blockOffset, array);
+            parallelForChunks(count, decoder, threadCount_);
+
+            if(useCache)
+                for(std::size_t k = 0; k < count; ++k)
+                    if(cached[k] == 0)
+                        chunkCache_.insert(chunkKey_(datasetName, chunks[k]), data[k]);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+        /* Write a block into a chunked dataset. Chunks completely covered by the block
+           are compressed in parallel and transferred directly, the remaining parts
+           are written via HDF5. Returns false if direct transfer is not possible.
+        */
+    template<unsigned int N, class T>
+    bool writeChunks_(std::string const & datasetName, hid_t datasetHandle, 
+                      typename MultiArrayShape<N>::type const & blockOffset, 
+                      MultiArrayView<N, T, UnstridedArrayTag> const & array, 
+                      const hid_t datatype, const int numBandsOfType)
+    {
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        typedef typename MultiArrayShape<N>::type Shape;
+
+        Shape chunkShape, datasetShape;
+        bool compressed;
+        int level;
+        if(!directChunkAccess_<N, T>(datasetHandle, datatype, numBandsOfType, 
+                                     chunkShape, datasetShape, compressed, level))
+            return false;
+        for(unsigned int k=0; k<N; ++k)
+            if(blockOffset[k] < 0 || blockOffset[k] + array.shape(k) > datasetShape[k])
+                return false; // let HDF5 report the error
+
+        ArrayVector<Shape> allChunks, fullChunks;
+        chunksOfBlock_(blockOffset, array.shape(), chunkShape, allChunks);
+        for(std::size_t c = 0; c < allChunks.size(); ++c)
+        {
+            chunkCache_.erase(chunkKey_(datasetName, allChunks[c]));
+
+            Shape start = allChunks[c]*chunkShape, 
+                  stop = min(start + chunkShape, datasetShape);
+            bool full = true;
+            for(unsigned int k=0; k<N; ++k)
+                if(start[k] < blockOffset[k] || stop[k] > blockOffset[k] + array.shape(k))
+                    full = false;
+            if(full)
+            {
+                fullChunks.push_back(allChunks[c]);
+                continue;
+            }
+            // partially covered chunks are updated by HDF5
+            start = max(start, blockOffset);
+            stop = min(stop, blockOffset + array.shape());
+            MultiArray<N, T> part(array.subarray(start - blockOffset, stop - blockOffset));
+            writeHyperslab_(datasetName, datasetHandle, start, part, datatype, numBandsOfType);
+        }
+
+        // process the chunks in batches to limit the memory for compressed data
+        std::size_t batchSize = std::max(64, 8*parallelThreadCount(threadCount_));
+        ArrayVector<hsize_t> offset;
+        for(std::size_t b = 0; b < fullChunks.size(); b += batchSize)
+        {
+            ArrayVector<Shape> chunks(fullChunks.begin() + b, 
+                                      fullChunks.begin() + std::min(b + batchSize, fullChunks.size()));
+            std::size_t count = chunks.size();
+            ArrayVector<ArrayVector<char> > data(count);
+
+            detail::HDF5ChunkEncoder<N, T> encoder(chunks, data, compressed, level,
+                                                   chunkShape, blockOffset, array);
+            parallelForChunks(count, encoder, threadCount_);
+
+            // HDF5 is only called from this thread
+            for(std::size_t k = 0; k < count; ++k)
+            {
+                chunkOffset_(chunks[k], chunkShape, numBandsOfType, offset);
+                herr_t status = H5Dwrite_chunk(datasetHandle, H5P_DEFAULT, 0, offset.data(), 
+                                               data[k].size(), data[k].data());
+                vigra_postcondition(status >= 0, "HDF5File::writeBlock(): write to "
+                                                 "dataset '" + datasetName + "' failed.");
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+        /* Write an array into a part of a dataset via HDF5's hyperslab selection.
+        */
+    template<unsigned int N, class T>
+    void writeHyperslab_(std::string const & datasetName, hid_t datasetHandle, 
+                         typename MultiArrayShape<N>::type const & blockOffset, 
+                         MultiArrayView<N, T, UnstridedArrayTag> const & array, 
+                         const hid_t datatype, const int numBandsOfType)
+    {
+        ArrayVector<hsize_t> boffset, bshape(N), bones(N+1, 1);
+        chunkOffset_(blockOffset, typename MultiArrayShape<N>::type(1), numBandsOfType, boffset);
+        for(unsigned int k=0; k<N; ++k)
+            bshape[N-1-k] = array.shape(k);
+        if(numBandsOfType > 1)
+            bshape.push_back(numBandsOfType);
+
+        HDF5Handle memspace(H5Screate_simple(bshape.size(), bshape.data(), NULL), &H5Sclose, 
+                            "HDF5File::writeBlock(): unable to create dataspace.");
+        HDF5Handle dataspace(H5Dget_space(datasetHandle), &H5Sclose, 
+                             "HDF5File::writeBlock(): unable to get dataspace.");
+        H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, boffset.data(), bones.data(), bones.data(), bshape.data());
+        herr_t status = H5Dwrite(datasetHandle, datatype, memspace, dataspace, H5P_DEFAULT, array.data());
+        vigra_postcondition(status >= 0, "HDF5File::writeBlock(): write to "
+                                         "dataset '" + datasetName + "' failed.");
+    }
 };  /* class HDF5File */
 
 namespace detail {
@@ -452,7 +452,8 @@ public:
     of its predecessor.  It actually represents a sequence of pyramid
     levels whose start and end index are configurable.  For Burt-style
     pyramids, see also \ref pyramidReduceBurtFilter and \ref
-    pyramidExpandBurtFilter.
+    pyramidExpandBurtFilter. Pyramids of images which don't fit into 
+    memory can be computed row by row with \ref vigra::BurtPyramidStream.
 
     A customized allocator can be passed as a template argument and
     via the constructor.  By default, the allocator of the
@@ -762,7 +763,7 @@ public:
         /** swap contents of this array with the contents of other
             (STL-Container interface)
          */
-    void swap(const ImagePyramid<ImageType, Alloc> &other)
+    void swap(ImagePyramid<ImageType, Alloc> &other)
     {
         images_.swap(other.images_);
         std::swap(lowestLevel_, other.lowestLevel_);
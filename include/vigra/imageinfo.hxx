@@ -142,6 +142,10 @@ class ImageExportInfo
             '.tif', '.tiff', '.xv', '.hdr'.
             EXR support requires libopenexr, JPEG support requires libjpeg,
             PNG support requires libpng and TIFF support requires libtiff.
+
+            The mode is passed on to the codec. TIFF supports "w" (write),
+            "a" (append another image to a multi-page file), and, with libtiff 4.0
+            or later, "w8" to create a BigTIFF file (necessary beyond 4 GB).
          **/
     VIGRA_EXPORT ImageExportInfo( const char *, const char * = "w" );
     VIGRA_EXPORT ~ImageExportInfo();
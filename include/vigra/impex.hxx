@@ -366,6 +366,33 @@ namespace vigra
         }
     } // read_band()
 
+    namespace detail {
+
+    template< class ImageIterator, class Accessor >
+    void importVectorImage( Decoder * dec, ImageIterator iter, Accessor a )
+    {
+        std::string pixeltype = dec->getPixelType();
+
+        if ( pixeltype == "UINT8" )
+            read_bands( dec, iter, a, (UInt8)0 );
+        else if ( pixeltype == "INT16" )
+            read_bands( dec, iter, a, Int16() );
+        else if ( pixeltype == "UINT16" )
+            read_bands( dec, iter, a, (UInt16)0 );
+        else if ( pixeltype == "INT32" )
+            read_bands( dec, iter, a, Int32() );
+        else if ( pixeltype == "UINT32" )
+            read_bands( dec, iter, a, (UInt32)0 );
+        else if ( pixeltype == "FLOAT" )
+            read_bands( dec, iter, a, float() );
+        else if ( pixeltype == "DOUBLE" )
+            read_bands( dec, iter, a, double() );
+        else
+            vigra_precondition( false, "invalid pixeltype" );
+    }
+
+    } // namespace detail
+
     /*!
       \brief used for reading images of vector type, such as integer of float rgb.
 
@@ -397,29 +424,39 @@ doxygen_overloaded_function(template <...> void importVectorImage)
     void importVectorImage( const ImageImportInfo & info, ImageIterator iter, Accessor a )
     {
         std::auto_ptr<Decoder> dec = decoder(info);
+        detail::importVectorImage( dec.get(), iter, a );
+
+        // close the decoder
+        dec->close();
+    }
+
+    namespace detail {
+
+    template< class ImageIterator, class Accessor >
+    void importScalarImage( Decoder * dec, ImageIterator iter, Accessor a )
+    {
         std::string pixeltype = dec->getPixelType();
 
         if ( pixeltype == "UINT8" )
-            read_bands( dec.get(), iter, a, (UInt8)0 );
+            read_band( dec, iter, a, (UInt8)0 );
         else if ( pixeltype == "INT16" )
-            read_bands( dec.get(), iter, a, Int16() );
+            read_band( dec, iter, a, Int16() );
         else if ( pixeltype == "UINT16" )
-            read_bands( dec.get(), iter, a, (UInt16)0 );
+            read_band( dec, iter, a, (UInt16)0 );
         else if ( pixeltype == "INT32" )
-            read_bands( dec.get(), iter, a, Int32() );
+            read_band( dec, iter, a, Int32() );
         else if ( pixeltype == "UINT32" )
-            read_bands( dec.get(), iter, a, (UInt32)0 );
+            read_band( dec, iter, a, (UInt32)0 );
         else if ( pixeltype == "FLOAT" )
-            read_bands( dec.get(), iter, a, float() );
+            read_band( dec, iter, a, float() );
         else if ( pixeltype == "DOUBLE" )
-            read_bands( dec.get(), iter, a, double() );
+            read_band( dec, iter, a, double() );
         else
             vigra_precondition( false, "invalid pixeltype" );
-
-        // close the decoder
-        dec->close();
     }
 
+    } // namespace detail
+
     /*!
       \brief used for reading images of  scalar type, such as integer and float grayscale.
 
@@ -451,24 +488,7 @@ doxygen_overloaded_function(template <...> void importScalarImage)
     void importScalarImage( const ImageImportInfo & info, ImageIterator iter, Accessor a )
     {
         std::auto_ptr<Decoder> dec = decoder(info);
-        std::string pixeltype = dec->getPixelType();
-
-        if ( pixeltype == "UINT8" )
-            read_band( dec.get(), iter, a, (UInt8)0 );
-        else if ( pixeltype == "INT16" )
-            read_band( dec.get(), iter, a, Int16() );
-        else if ( pixeltype == "UINT16" )
-            read_band( dec.get(), iter, a, (UInt16)0 );
-        else if ( pixeltype == "INT32" )
-            read_band( dec.get(), iter, a, Int32() );
-        else if ( pixeltype == "UINT32" )
-            read_band( dec.get(), iter, a, (UInt32)0 );
-        else if ( pixeltype == "FLOAT" )
-            read_band( dec.get(), iter, a, float() );
-        else if ( pixeltype == "DOUBLE" )
-            read_band( dec.get(), iter, a, double() );
-        else
-            vigra_precondition( false, "invalid pixeltype" );
+        detail::importScalarImage( dec.get(), iter, a );
 
         // close the decoder
         dec->close();
@@ -585,6 +605,201 @@ doxygen_overloaded_function(template <...> void importImage)
         importScalarImage( info, iter, a );
     }
 
+    namespace detail {
+
+    // Decoder adaptor which exposes the region of interest 'roi' of the
+    // image read by 'dec'. Codecs supporting Decoder::setRegionOfInterest()
+    // only decode the required data, for all others the adaptor skips the
+    // leading rows and shifts the scanline pointers to column roi.left().
+    class RegionOfInterestDecoder : public Decoder
+    {
+        Decoder * dec_;
+        Rect2D roi_;
+        unsigned int rowsToSkip_, bytesToSkip_;
+
+        static unsigned int pixelTypeSize( const std::string & pixeltype )
+        {
+            if ( pixeltype == "UINT8" || pixeltype == "INT8" )
+                return 1;
+            else if ( pixeltype == "UINT16" || pixeltype == "INT16" )
+                return 2;
+            else if ( pixeltype == "UINT32" || pixeltype == "INT32" || pixeltype == "FLOAT" )
+                return 4;
+            else if ( pixeltype == "DOUBLE" )
+                return 8;
+            vigra_precondition( false, "invalid pixeltype" );
+            return 0;
+        }
+
+      public:
+
+        RegionOfInterestDecoder( Decoder * dec, const Rect2D & roi )
+        : dec_( dec ), roi_( roi ), rowsToSkip_( 0 ), bytesToSkip_( 0 )
+        {
+            if ( !dec_->setRegionOfInterest( roi_ ) )
+            {
+                rowsToSkip_ = roi_.top();
+                bytesToSkip_ = roi_.left() * dec_->getOffset() *
+                               pixelTypeSize( dec_->getPixelType() );
+            }
+        }
+
+        void init( const std::string & )
+        {
+            vigra_fail( "RegionOfInterestDecoder::init(): not supported." );
+        }
+
+        void close()
+        {
+            dec_->close();
+        }
+
+        void abort()
+        {
+            dec_->abort();
+        }
+
+        std::string getFileType() const
+        {
+            return dec_->getFileType();
+        }
+
+        std::string getPixelType() const
+        {
+            return dec_->getPixelType();
+        }
+
+        unsigned int getWidth() const
+        {
+            return roi_.width();
+        }
+
+        unsigned int getHeight() const
+        {
+            return roi_.height();
+        }
+
+        unsigned int getNumBands() const
+        {
+            return dec_->getNumBands();
+        }
+
+        unsigned int getNumExtraBands() const
+        {
+            return dec_->getNumExtraBands();
+        }
+
+        unsigned int getOffset() const
+        {
+            return dec_->getOffset();
+        }
+
+        const void * currentScanlineOfBand( unsigned int band ) const
+        {
+            return static_cast< const UInt8 * >
+                (dec_->currentScanlineOfBand( band )) + bytesToSkip_;
+        }
+
+        void nextScanline()
+        {
+            for ( ; rowsToSkip_ > 0; --rowsToSkip_ )
+                dec_->nextScanline();
+            dec_->nextScanline();
+        }
+    };
+
+    template < class ImageIterator, class Accessor >
+    void importImage( Decoder * dec, ImageIterator iter, Accessor a, VigraFalseType )
+    {
+        importVectorImage( dec, iter, a );
+    }
+
+    template < class ImageIterator, class Accessor >
+    void importImage( Decoder * dec, ImageIterator iter, Accessor a, VigraTrueType )
+    {
+        importScalarImage( dec, iter, a );
+    }
+
+    } // namespace detail
+
+    /** \brief Read a rectangular region of the image specified by the given
+        \ref vigra::ImageImportInfo object.
+
+        The destination must have the size of <tt>roi</tt>, and its upper left
+        pixel receives the image pixel at <tt>roi.upperLeft()</tt>. Codecs that
+        support it decode only the data intersecting the region (e.g. tiled and
+        striped TIFF files only read the overlapping tiles or strips, so that
+        small windows can be cut out of very large images efficiently). Other
+        file types are decoded up to <tt>roi.bottom()</tt>, and the remaining
+        data is skipped.
+
+        <b> Declarations:</b>
+
+        pass arguments explicitly:
+        \code
+        namespace vigra {
+            template <class ImageIterator, class Accessor>
+            void
+            importImage(ImageImportInfo const & image, Rect2D const & roi,
+                        ImageIterator iter, Accessor a)
+        }
+        \endcode
+
+        use argument objects in conjunction with \ref ArgumentObjectFactories :
+        \code
+        namespace vigra {
+            template <class ImageIterator, class Accessor>
+            inline void
+            importImage(ImageImportInfo const & image, Rect2D const & roi,
+                        pair<ImageIterator, Accessor> dest)
+        }
+        \endcode
+
+        <b> Usage:</b>
+
+        <b>\#include</b> \<vigra/impex.hxx\><br>
+        Namespace: vigra
+
+        \code
+        vigra::ImageImportInfo info("huge_tiled.tif");
+
+        // read the 512x512 window starting at (1000, 2000)
+        vigra::Rect2D roi(vigra::Point2D(1000, 2000), vigra::Size2D(512, 512));
+        vigra::FImage window(roi.size());
+        vigra::importImage(info, roi, destImage(window));
+        \endcode
+
+        <b> Preconditions:</b>
+
+        <UL>
+        <LI> <tt>roi</tt> is non-empty and lies completely inside the image
+        <LI> the preconditions of the \ref importImage() variant without ROI apply
+        </UL>
+    */
+    template < class ImageIterator, class Accessor >
+    void importImage( const ImageImportInfo & info, const Rect2D & roi,
+                      ImageIterator iter, Accessor a )
+    {
+        typedef typename NumericTraits<typename Accessor::value_type>::isScalar is_scalar;
+
+        vigra_precondition( !roi.isEmpty() && Rect2D( info.size() ).contains( roi ),
+            "importImage(): region of interest must be a non-empty part of the image." );
+
+        std::auto_ptr<Decoder> dec = decoder(info);
+        detail::RegionOfInterestDecoder region( dec.get(), roi );
+        detail::importImage( &region, iter, a, is_scalar() );
+
+        // close the decoder
+        dec->close();
+    }
+
+    template < class ImageIterator, class Accessor >
+    void importImage( const ImageImportInfo & info, const Rect2D & roi,
+                      pair< ImageIterator, Accessor > dest )
+    {
+        importImage( info, roi, dest.first, dest.second );
+    }
+
     /*!
       \brief used for writing bands after the source data type has been figured out.
 
@@ -40,10 +40,27 @@
 #include <cmath>
 #include <iosfwd>
 #include <iomanip>
+#include "array_vector.hxx"
 #include "multi_array.hxx"
 #include "mathutil.hxx"
 #include "numerictraits.hxx"
 #include "multi_pointoperators.hxx"
+#include "metaprogramming.hxx"
+#include "parallel.hxx"
+
+#ifdef VIGRA_USE_BLAS
+extern "C" {
+
+    // Fortran BLAS matrix products (see mmul())
+void sgemm_(char const * transa, char const * transb, int const * m, int const * n, int const * k,
+            float const * alpha, float const * a, int const * lda, float const * b, int const * ldb,
+            float const * beta, float * c, int const * ldc);
+void dgemm_(char const * transa, char const * transb, int const * m, int const * n, int const * k,
+            double const * alpha, double const * a, int const * lda, double const * b, int const * ldb,
+            double const * beta, double * c, int const * ldc);
+
+}
+#endif
 
 
 namespace vigra
@@ -1565,22 +1582,264 @@ void smul(T a, const MultiArrayView<2, T, C2> &b, MultiArrayView<2, T, C3> &r)
     smul(b, a, r);
 }
 
-    /** perform matrix multiplication of matrices \a a and \a b.
-        The result is written into \a r. The three matrices must have matching shapes.
+namespace detail {
+
+/* Parameters of the cache-blocked matrix multiplication kernel (see mmul()):
+   the result is computed in tiles of MR x NR elements which are held in registers,
+   from panels of A (MC x KC, packed into MR-row strips) and B (KC x NC, packed into
+   NR-column strips) that fit into the L2 and L3 caches respectively.
+   The tile sizes were chosen such that gcc vectorizes the micro kernel well
+   for SSE2 as well as AVX targets. Types without a specialization use the
+   straightforward triple loop.
+*/
+template <class T>
+struct MmulBlocking
+{
+    typedef VigraFalseType Blocked;
+};
+
+template <>
+struct MmulBlocking<float>
+{
+    typedef VigraTrueType Blocked;
+    enum { MR = 32, NR = 4, MC = 128, KC = 256, NC = 2048 };
+};
+
+template <>
+struct MmulBlocking<double>
+{
+    typedef VigraTrueType Blocked;
+    enum { MR = 8, NR = 4, MC = 96, KC = 256, NC = 2048 };
+};
+
+    // copy rows [i0, i0+mc) and columns [k0, k0+kc) of a (with strides s0, s1)
+    // into strips of MR rows, padding the last strip with zeros
+template <class T>
+void mmulPackA(T const * a, MultiArrayIndex s0, MultiArrayIndex s1,
+               MultiArrayIndex i0, MultiArrayIndex mc,
+               MultiArrayIndex k0, MultiArrayIndex kc, T * packed)
+{
+    enum { MR = MmulBlocking<T>::MR };
+    for(MultiArrayIndex i = 0; i < mc; i += MR)
+    {
+        MultiArrayIndex rows = std::min<MultiArrayIndex>(MR, mc - i);
+        T const * col = a + (i0 + i)*s0 + k0*s1;
+        for(MultiArrayIndex k = 0; k < kc; ++k, col += s1, packed += MR)
+        {
+            MultiArrayIndex l = 0;
+            for(; l < rows; ++l)
+                packed[l] = col[l*s0];
+            for(; l < MR; ++l)
+                packed[l] = T();
+        }
+    }
+}
+
+    // copy rows [k0, k0+kc) and columns [j0, j0+nc) of b (with strides s0, s1)
+    // into strips of NR columns, padding the last strip with zeros
+template <class T>
+void mmulPackB(T const * b, MultiArrayIndex s0, MultiArrayIndex s1,
+               MultiArrayIndex k0, MultiArrayIndex kc,
+               MultiArrayIndex j0, MultiArrayIndex nc, T * packed)
+{
+    enum { NR = MmulBlocking<T>::NR };
+    for(MultiArrayIndex j = 0; j < nc; j += NR)
+    {
+        MultiArrayIndex cols = std::min<MultiArrayIndex>(NR, nc - j);
+        T const * row = b + k0*s0 + (j0 + j)*s1;
+        for(MultiArrayIndex k = 0; k < kc; ++k, row += s0, packed += NR)
+        {
+            MultiArrayIndex l = 0;
+            for(; l < cols; ++l)
+                packed[l] = row[l*s1];
+            for(; l < NR; ++l)
+                packed[l] = T();
+        }
+    }
+}
+
+    // multiply an MR-row strip of A with an NR-column strip of B and add
+    // (or assign, if 'overwrite' is true) the valid part to the result tile
+template <class T>
+inline void mmulMicroKernel(MultiArrayIndex kc, T const * ap, T const * bp,
+                            T * r, MultiArrayIndex s0, MultiArrayIndex s1,
+                            MultiArrayIndex rows, MultiArrayIndex cols, bool overwrite)
+{
+    enum { MR = MmulBlocking<T>::MR, NR = MmulBlocking<T>::NR };
+    // the fixed loop bounds allow the compiler to keep 'c' in (vector) registers
+    T c[NR][MR];
+    for(int j = 0; j < NR; ++j)
+        for(int i = 0; i < MR; ++i)
+            c[j][i] = T();
+    for(MultiArrayIndex k = 0; k < kc; ++k, ap += MR, bp += NR)
+        for(int j = 0; j < NR; ++j)
+            for(int i = 0; i < MR; ++i)
+                c[j][i] += ap[i] * bp[j];
+
+    for(MultiArrayIndex j = 0; j < cols; ++j)
+    {
+        T * rc = r + j*s1;
+        if(overwrite)
+            for(MultiArrayIndex i = 0; i < rows; ++i)
+                rc[i*s0] = c[j][i];
+        else
+            for(MultiArrayIndex i = 0; i < rows; ++i)
+                rc[i*s0] += c[j][i];
+    }
+}
+
+/* Compute the columns [colBegin, colEnd) of r = a * b with the blocked kernel.
+   Called once per thread with disjoint column ranges.
+*/
+template <class T>
+struct MmulBlockedFunctor
+{
+    enum { MR = MmulBlocking<T>::MR, NR = MmulBlocking<T>::NR, 
+           MC = MmulBlocking<T>::MC, KC = MmulBlocking<T>::KC, NC = MmulBlocking<T>::NC };
+
+    T const * a;
+    T const * b;
+    T * r;
+    MultiArrayIndex as0, as1, bs0, bs1, rs0, rs1;
+    MultiArrayIndex rows, cols, inner;
+
+    void operator()(std::ptrdiff_t stripBegin, std::ptrdiff_t stripEnd) const
+    {
+        MultiArrayIndex colBegin = stripBegin*NR,
+                        colEnd   = std::min<MultiArrayIndex>(stripEnd*NR, cols);
+        if(colBegin >= colEnd)
+            return;
+        MultiArrayIndex kcMax = std::min<MultiArrayIndex>(KC, inner),
+                        mcMax = std::min<MultiArrayIndex>(MC, (rows + MR - 1) / MR * MR),
+                        ncMax = std::min<MultiArrayIndex>(NC, (colEnd - colBegin + NR - 1) / NR * NR);
+        ArrayVector<T> packedA(mcMax*kcMax), packedB(kcMax*ncMax);
+
+        for(MultiArrayIndex j0 = colBegin; j0 < colEnd; j0 += NC)
+        {
+            MultiArrayIndex nc = std::min<MultiArrayIndex>(NC, colEnd - j0);
+            for(MultiArrayIndex k0 = 0; k0 < inner; k0 += KC)
+            {
+                MultiArrayIndex kc = std::min<MultiArrayIndex>(KC, inner - k0);
+                mmulPackB(b, bs0, bs1, k0, kc, j0, nc, packedB.begin());
+                for(MultiArrayIndex i0 = 0; i0 < rows; i0 += MC)
+                {
+                    MultiArrayIndex mc = std::min<MultiArrayIndex>(MC, rows - i0);
+                    mmulPackA(a, as0, as1, i0, mc, k0, kc, packedA.begin());
+                    for(MultiArrayIndex j = 0; j < nc; j += NR)
+                    {
+                        T const * bp = packedB.begin() + j*kc;
+                        for(MultiArrayIndex i = 0; i < mc; i += MR)
+                        {
+                            mmulMicroKernel(kc, packedA.begin() + i*kc, bp,
+                                            r + (i0 + i)*rs0 + (j0 + j)*rs1, rs0, rs1,
+                                            std::min<MultiArrayIndex>(MR, mc - i),
+                                            std::min<MultiArrayIndex>(NR, nc - j),
+                                            k0 == 0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
 
-    <b>\#include</b> \<vigra/matrix.hxx\> or<br>
-    <b>\#include</b> \<vigra/linear_algebra.hxx\><br>
-        Namespace: vigra::linalg
-     */
 template <class T, class C1, class C2, class C3>
-void mmul(const MultiArrayView<2, T, C1> &a, const MultiArrayView<2, T, C2> &b,
-         MultiArrayView<2, T, C3> &r)
+void mmulBlocked(const MultiArrayView<2, T, C1> &a, const MultiArrayView<2, T, C2> &b,
+                 MultiArrayView<2, T, C3> &r, int nthreads)
+{
+    MmulBlockedFunctor<T> f;
+    f.a = a.data();
+    f.b = b.data();
+    f.r = r.data();
+    f.as0 = a.stride(0); f.as1 = a.stride(1);
+    f.bs0 = b.stride(0); f.bs1 = b.stride(1);
+    f.rs0 = r.stride(0); f.rs1 = r.stride(1);
+    f.rows  = rowCount(r);
+    f.cols  = columnCount(r);
+    f.inner = columnCount(a);
+
+    // distribute the NR-column strips of the result over the threads,
+    // but give every thread enough work to amortize the packing of A
+    std::ptrdiff_t strips = (f.cols + MmulBlocking<T>::NR - 1) / MmulBlocking<T>::NR;
+    parallelForChunks(strips, f, nthreads, 64 / MmulBlocking<T>::NR);
+}
+
+#ifdef VIGRA_USE_BLAS
+
+    // determine the BLAS transposition flag and leading dimension of a matrix view,
+    // return false if the memory layout is not supported by BLAS
+template <class T, class C>
+bool mmulBlasLayout(MultiArrayView<2, T, C> const & m, char & trans, int & ld)
+{
+    MultiArrayIndex rows = rowCount(m), cols = columnCount(m);
+    if(m.stride(0) == 1 && m.stride(1) >= std::max<MultiArrayIndex>(1, rows) &&
+       m.stride(1) <= NumericTraits<int>::max())
+    {
+        trans = 'N';
+        ld = (int)m.stride(1);
+        return true;
+    }
+    if(m.stride(1) == 1 && m.stride(0) >= std::max<MultiArrayIndex>(1, cols) &&
+       m.stride(0) <= NumericTraits<int>::max())
+    {
+        trans = 'T';
+        ld = (int)m.stride(0);
+        return true;
+    }
+    return false;
+}
+
+inline void blasGemm(char ta, char tb, int m, int n, int k, float const * a, int lda,
+                     float const * b, int ldb, float * c, int ldc)
+{
+    float alpha = 1.0f, beta = 0.0f;
+    sgemm_(&ta, &tb, &m, &n, &k, &alpha, a, &lda, b, &ldb, &beta, c, &ldc);
+}
+
+inline void blasGemm(char ta, char tb, int m, int n, int k, double const * a, int lda,
+                     double const * b, int ldb, double * c, int ldc)
+{
+    double alpha = 1.0, beta = 0.0;
+    dgemm_(&ta, &tb, &m, &n, &k, &alpha, a, &lda, b, &ldb, &beta, c, &ldc);
+}
+
+    // compute r = a * b by BLAS ?gemm(), return false if the memory layout
+    // of the arguments is not supported
+template <class T, class C1, class C2, class C3>
+bool mmulBlas(const MultiArrayView<2, T, C1> &a, const MultiArrayView<2, T, C2> &b,
+              MultiArrayView<2, T, C3> &r)
+{
+    int maxSize = NumericTraits<int>::max();
+    if(rowCount(a) > maxSize || columnCount(a) > maxSize || columnCount(b) > maxSize)
+        return false;
+    char ta, tb, tr;
+    int lda, ldb, ldc;
+    if(!mmulBlasLayout(a, ta, lda) || !mmulBlasLayout(b, tb, ldb) || !mmulBlasLayout(r, tr, ldc))
+        return false;
+    if(tr == 'N')
+    {
+        blasGemm(ta, tb, (int)rowCount(r), (int)columnCount(r), (int)columnCount(a),
+                 a.data(), lda, b.data(), ldb, r.data(), ldc);
+    }
+    else
+    {
+        // r is row-major: compute the column-major r^T = b^T * a^T
+        blasGemm(tb == 'N' ? 'T' : 'N', ta == 'N' ? 'T' : 'N',
+                 (int)columnCount(r), (int)rowCount(r), (int)columnCount(a),
+                 b.data(), ldb, a.data(), lda, r.data(), ldc);
+    }
+    return true;
+}
+
+#endif // VIGRA_USE_BLAS
+
+template <class T, class C1, class C2, class C3>
+void mmulImpl(const MultiArrayView<2, T, C1> &a, const MultiArrayView<2, T, C2> &b,
+              MultiArrayView<2, T, C3> &r, int, VigraFalseType)
 {
     const MultiArrayIndex rrows = rowCount(r);
     const MultiArrayIndex rcols = columnCount(r);
     const MultiArrayIndex acols = columnCount(a);
-    vigra_precondition(rrows == rowCount(a) && rcols == columnCount(b) && acols == rowCount(b),
-                       "mmul(): Matrix shapes must agree.");
 
     // order of loops ensures that inner loop goes down columns
     for(MultiArrayIndex i = 0; i < rcols; ++i) 
@@ -1593,6 +1852,65 @@ void mmul(const MultiArrayView<2, T, C1> &a, const MultiArrayView<2, T, C2> &b,
     }
 }
 
+template <class T, class C1, class C2, class C3>
+void mmulImpl(const MultiArrayView<2, T, C1> &a, const MultiArrayView<2, T, C2> &b,
+              MultiArrayView<2, T, C3> &r, int nthreads, VigraTrueType)
+{
+    // packing doesn't pay off for small matrices
+    if(columnCount(a) == 0 || 
+       (double)rowCount(r)*columnCount(r)*columnCount(a) < 262144.0)
+    {
+        mmulImpl(a, b, r, 1, VigraFalseType());
+        return;
+    }
+#ifdef VIGRA_USE_BLAS
+    if(mmulBlas(a, b, r))
+        return;
+#endif
+    mmulBlocked(a, b, r, nthreads);
+}
+
+} // namespace detail
+
+    /** perform matrix multiplication of matrices \a a and \a b.
+        The result is written into \a r. The three matrices must have matching shapes,
+        and \a r must not overlap with \a a or \a b.
+
+        For <tt>float</tt> and <tt>double</tt> matrices that are not tiny, the product
+        is computed by a cache-blocked kernel: panels of \a a and \a b are copied into
+        contiguous buffers (so that arbitrary strides and transposed views are handled
+        efficiently), and the result is accumulated in small register tiles which the
+        compiler can vectorize. The columns of the result are distributed over
+        <tt>nthreads</tt> threads (see \ref parallelThreadCount()); the result doesn't
+        depend on the number of threads. Due to the different summation order, results
+        may differ from the naive algorithm within rounding accuracy.
+
+        When your program defines the macro <tt>VIGRA_USE_BLAS</tt> (e.g. by compiling with
+        <tt>-DVIGRA_USE_BLAS</tt>) and links against a BLAS library, the product is delegated to
+        <tt>sgemm()</tt> resp. <tt>dgemm()</tt> whenever the memory layout permits (in this
+        case, <tt>nthreads</tt> is ignored, and the BLAS library's own threading applies).
+        VIGRA never defines this macro itself, not even when configured with 
+        <tt>-DWITH_BLAS=1</tt> (which only adds BLAS variants of the tests). Since the macro 
+        selects a different implementation of this template, it must be defined either in 
+        all or in none of a program's translation units.
+
+    <b>\#include</b> \<vigra/matrix.hxx\> or<br>
+    <b>\#include</b> \<vigra/linear_algebra.hxx\><br>
+        Namespace: vigra::linalg
+     */
+template <class T, class C1, class C2, class C3>
+void mmul(const MultiArrayView<2, T, C1> &a, const MultiArrayView<2, T, C2> &b,
+         MultiArrayView<2, T, C3> &r, int nthreads = 1)
+{
+    const MultiArrayIndex rrows = rowCount(r);
+    const MultiArrayIndex rcols = columnCount(r);
+    const MultiArrayIndex acols = columnCount(a);
+    vigra_precondition(rrows == rowCount(a) && rcols == columnCount(b) && acols == rowCount(b),
+                       "mmul(): Matrix shapes must agree.");
+
+    detail::mmulImpl(a, b, r, nthreads, typename detail::MmulBlocking<T>::Blocked());
+}
+
     /** perform matrix multiplication of matrices \a a and \a b.
         \a a and \a b must have matching shapes.
         The result is returned as a temporary matrix.
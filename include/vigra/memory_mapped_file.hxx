@@ -0,0 +1,304 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MEMORY_MAPPED_FILE_HXX
+#define VIGRA_MEMORY_MAPPED_FILE_HXX
+
+#include <cstddef>
+#include <string>
+#include "config.hxx"
+#include "error.hxx"
+
+#ifdef _WIN32
+# include "windows.h"
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+
+namespace vigra {
+
+/** \brief Map a file into memory.
+
+    The file contents become accessible via the pointer returned by
+    data() without being read explicitly: the operating system loads the
+    pages on first access and may drop them again under memory pressure.
+    Opening even huge files is therefore instantaneous. The mapping is
+    released in the destructor.
+
+    Existing files can be mapped in three modes:
+
+    <DL>
+    <DT><tt>ReadOnly</tt><DD> The data must not be modified (writing causes
+            a segmentation fault).
+    <DT><tt>CopyOnWrite</tt><DD> The data may be modified, but the changes are
+            private to this mapping and never written back to the file.
+            Only modified pages occupy additional memory.
+    <DT><tt>ReadWrite</tt><DD> Changes are written back to the file (at the
+            latest when the mapping is closed, or explicitly by flush()).
+    </DL>
+
+    New files are created with the constructor or function taking a size.
+    They are always mapped in <tt>ReadWrite</tt> mode.
+
+    <b>\#include</b> \<vigra/memory_mapped_file.hxx\><br>
+    Namespace: vigra
+*/
+class MemoryMappedFile
+{
+  public:
+    enum AccessMode { ReadOnly, CopyOnWrite, ReadWrite };
+
+        /** Construct an empty object, which doesn't refer to a file.
+        */
+    MemoryMappedFile()
+    : data_(0), size_(0)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE), mapping_(0)
+#endif
+    {}
+
+        /** Map the existing file <tt>filename</tt> in the given mode.
+        */
+    MemoryMappedFile(std::string const & filename, AccessMode mode = ReadOnly)
+    : data_(0), size_(0)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE), mapping_(0)
+#endif
+    {
+        open(filename, mode);
+    }
+
+        /** Create (or truncate) the file <tt>filename</tt> such that it has
+            <tt>size</tt> bytes, and map it in <tt>ReadWrite</tt> mode.
+        */
+    MemoryMappedFile(std::string const & filename, std::size_t size)
+    : data_(0), size_(0)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE), mapping_(0)
+#endif
+    {
+        create(filename, size);
+    }
+
+    ~MemoryMappedFile()
+    {
+        close();
+    }
+
+        /** Map the existing file <tt>filename</tt> in the given mode.
+            A previously mapped file is closed first.
+        */
+    void open(std::string const & filename, AccessMode mode = ReadOnly)
+    {
+        map(filename, mode, 0, false);
+    }
+
+        /** Create (or truncate) the file <tt>filename</tt> such that it has
+            <tt>size</tt> bytes, and map it in <tt>ReadWrite</tt> mode.
+            A previously mapped file is closed first.
+        */
+    void create(std::string const & filename, std::size_t size)
+    {
+        vigra_precondition(size > 0,
+            "MemoryMappedFile::create(): size must be positive.");
+        map(filename, ReadWrite, size, true);
+    }
+
+        /** Write modified pages back to the file (<tt>ReadWrite</tt> mode only).
+        */
+    void flush()
+    {
+        if(data_ == 0)
+            return;
+#ifdef _WIN32
+        FlushViewOfFile(data_, 0);
+#else
+        msync(data_, size_, MS_SYNC);
+#endif
+    }
+
+        /** Unmap the file. Modifications in <tt>ReadWrite</tt> mode are
+            written back.
+        */
+    void close()
+    {
+#ifdef _WIN32
+        if(data_ != 0)
+            UnmapViewOfFile(data_);
+        if(mapping_ != 0)
+            CloseHandle(mapping_);
+        if(file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+        mapping_ = 0;
+#else
+        if(data_ != 0)
+            munmap(data_, size_);
+#endif
+        data_ = 0;
+        size_ = 0;
+    }
+
+        /** True if a file is currently mapped.
+        */
+    bool isOpen() const
+    {
+        return data_ != 0;
+    }
+
+        /** Pointer to the first byte of the mapped file.
+        */
+    char * data() const
+    {
+        return static_cast<char *>(data_);
+    }
+
+        /** Size of the mapped file in bytes.
+        */
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    MemoryMappedFile(MemoryMappedFile const &);
+    MemoryMappedFile & operator=(MemoryMappedFile const &);
+
+    void fail(std::string const & what, std::string const & filename)
+    {
+        close();
+        std::string message("MemoryMappedFile: Unable to " + what + " file '" + filename + "'.");
+        vigra_fail(message.c_str());
+    }
+
+    void map(std::string const & filename, AccessMode mode, std::size_t size, bool create)
+    {
+        close();
+#ifdef _WIN32
+        DWORD access = mode == ReadWrite
+                           ? GENERIC_READ | GENERIC_WRITE
+                           : GENERIC_READ;
+        file_ = CreateFileA(filename.c_str(), access, FILE_SHARE_READ, 0,
+                            create ? CREATE_ALWAYS : OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, 0);
+        if(file_ == INVALID_HANDLE_VALUE)
+            fail(create ? "create" : "open", filename);
+        if(!create)
+        {
+            LARGE_INTEGER fileSize;
+            if(!GetFileSizeEx(file_, &fileSize))
+                fail("query size of", filename);
+            size = (std::size_t)fileSize.QuadPart;
+        }
+        if(size == 0)
+            fail("map empty", filename);
+        DWORD protect = mode == ReadWrite
+                            ? PAGE_READWRITE
+                            : mode == CopyOnWrite
+                                  ? PAGE_WRITECOPY
+                                  : PAGE_READONLY,
+              view    = mode == ReadWrite
+                            ? FILE_MAP_WRITE
+                            : mode == CopyOnWrite
+                                  ? FILE_MAP_COPY
+                                  : FILE_MAP_READ;
+        unsigned long long size64 = size;
+        mapping_ = CreateFileMappingA(file_, 0, protect,
+                                      (DWORD)(size64 >> 32), (DWORD)(size64 & 0xffffffffu), 0);
+        if(mapping_ == 0)
+            fail("map", filename);
+        data_ = MapViewOfFile(mapping_, view, 0, 0, size);
+        if(data_ == 0)
+            fail("map", filename);
+#else
+        int fd = create
+                    ? ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666)
+                    : ::open(filename.c_str(), mode == ReadWrite ? O_RDWR : O_RDONLY);
+        if(fd < 0)
+            fail(create ? "create" : "open", filename);
+        if(create)
+        {
+            if(ftruncate(fd, (off_t)size) != 0)
+            {
+                ::close(fd);
+                fail("resize", filename);
+            }
+        }
+        else
+        {
+            struct stat info;
+            if(fstat(fd, &info) != 0)
+            {
+                ::close(fd);
+                fail("query size of", filename);
+            }
+            size = (std::size_t)info.st_size;
+        }
+        if(size == 0)
+        {
+            ::close(fd);
+            fail("map empty", filename);
+        }
+        int protect = mode == ReadOnly
+                          ? PROT_READ
+                          : PROT_READ | PROT_WRITE,
+            flags   = mode == CopyOnWrite
+                          ? MAP_PRIVATE
+                          : MAP_SHARED;
+        void * data = mmap(0, size, protect, flags, fd, 0);
+        // the mapping stays valid after the descriptor has been closed
+        ::close(fd);
+        if(data == MAP_FAILED)
+            fail("map", filename);
+        data_ = data;
+#endif
+        size_ = size;
+    }
+
+    void * data_;
+    std::size_t size_;
+#ifdef _WIN32
+    HANDLE file_, mapping_;
+#endif
+};
+
+} // namespace vigra
+
+#endif // VIGRA_MEMORY_MAPPED_FILE_HXX
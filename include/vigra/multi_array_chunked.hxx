@@ -0,0 +1,1458 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_ARRAY_CHUNKED_HXX
+#define VIGRA_MULTI_ARRAY_CHUNKED_HXX
+
+#include <cstring>
+#include <limits>
+#include <list>
+#include <string>
+#include <iterator>
+#include "multi_array.hxx"
+#include "multi_pointoperators.hxx"
+#include "array_vector.hxx"
+#include "memory_mapped_file.hxx"
+
+namespace vigra {
+
+template <unsigned int N, class T, class REFERENCE, class POINTER>
+class ChunkedArrayIterator;
+
+template <class T>
+class ChunkedArrayElementReference;
+
+/** \addtogroup ChunkedArrays Chunked arrays
+
+    Arrays that are too big for main memory.
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                    ChunkedArray                      */
+/*                                                      */
+/********************************************************/
+
+/** \brief Base class of arrays that are stored in independent, fixed-size chunks.
+
+    The array's shape is divided into chunks of shape <tt>chunkShape()</tt> 
+    (the chunks at the upper borders may be smaller). A chunk is only brought 
+    into memory when one of its elements is accessed for the first time,
+    and chunks which have not been used recently are unloaded again when
+    the memory occupied by all loaded chunks exceeds the 
+    <i>memory budget</i> (see \ref setMemoryBudget()). Modified chunks are 
+    written back to the backing store before they are unloaded. Where the 
+    data are actually stored is determined by the derived classes:
+    
+    <DL>
+    <DT>\ref vigra::ChunkedArrayLazy <DD> anonymous memory, allocated on first touch
+    <DT>\ref vigra::ChunkedArrayCompressed <DD> compressed in main memory
+    <DT>\ref vigra::ChunkedArrayMmap <DD> a memory-mapped file
+    <DT>\ref vigra::ChunkedArrayHDF5 <DD> a dataset in an HDF5 file (see 
+         \<vigra/multi_array_chunked_hdf5.hxx\>)
+    </DL>
+    
+    Individual elements are accessed via \ref getItem() and \ref setItem()
+    or the scan-order iterators returned by \ref begin() and \ref end(). 
+    For efficiency, algorithms should rather process the array chunk by 
+    chunk. This is supported by the chunked versions of
+    \ref inspectMultiArray() and \ref transformMultiArray(), by
+    \ref checkoutSubarray() and \ref commitSubarray() (which copy 
+    arbitrary blocks into or out of an ordinary \ref MultiArrayView), and 
+    by \ref ChunkedArray::ChunkLock, which provides a \ref MultiArrayView 
+    to the data of a single chunk.
+
+    A chunk cannot be unloaded while it is in use by a \ref ChunkedArray::ChunkLock
+    or an iterator, so the memory budget may be exceeded temporarily. 
+    ChunkedArray is not thread-safe.
+
+    <b>Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+
+    \code
+    typedef MultiArrayShape<3>::type Shape;
+    
+    // a 2000x2000x2000 volume in chunks of 64x64x64 voxels, kept compressed in memory,
+    // where at most 1 GB of chunks are uncompressed at any time
+    ChunkedArrayCompressed<3, float> array(Shape(2000, 2000, 2000), Shape(64, 64, 64), 1 << 30);
+    
+    array.setItem(Shape(1, 2, 3), 42.0f);
+    
+    // process the array chunk by chunk
+    FindMinMax<float> minmax;
+    inspectMultiArray(array, minmax);
+    
+    // copy a block into an ordinary array
+    MultiArray<3, float> block(Shape(100));
+    array.checkoutSubarray(Shape(500, 500, 500), block);
+    \endcode
+*/
+template <unsigned int N, class T>
+class ChunkedArray
+{
+  public:
+        /** the array's value type
+        */
+    typedef T value_type;
+
+        /** type of coordinates and shapes
+        */
+    typedef typename MultiArrayShape<N>::type shape_type;
+
+        /** the view type of a single chunk
+        */
+    typedef MultiArrayView<N, T, UnstridedArrayTag> view_type;
+
+        /** scan-order iterator (marks a chunk as modified when one of its 
+            elements is written, see \ref vigra::ChunkedArrayElementReference)
+        */
+    typedef ChunkedArrayIterator<N, T, ChunkedArrayElementReference<T>, T *> iterator;
+
+        /** read-only scan-order iterator
+        */
+    typedef ChunkedArrayIterator<N, T, T const &, T const *> const_iterator;
+
+        /** \brief Access to the data of a single chunk.
+
+            The chunk is loaded (if necessary) by the constructor and cannot be 
+            unloaded until the lock is destroyed. When the lock is constructed from
+            a non-const array, the chunk is marked as modified and will be written 
+            back to the backing store. Use a const array for read-only access.
+        */
+    class ChunkLock
+    {
+      public:
+        typedef typename ChunkedArray::view_type view_type;
+
+            /** Lock the chunk with the given index (i.e. the chunk starting at 
+                <tt>chunkIndex*array.chunkShape()</tt>) for reading and writing.
+            */
+        ChunkLock(ChunkedArray & array, shape_type const & chunkIndex)
+        : array_(array),
+          index_(chunkIndex),
+          view_(array.chunkStop(chunkIndex) - array.chunkStart(chunkIndex),
+                array.pinChunk(chunkIndex, true))
+        {}
+
+            /** Lock the chunk with the given index for reading.
+            */
+        ChunkLock(ChunkedArray const & array, shape_type const & chunkIndex)
+        : array_(array),
+          index_(chunkIndex),
+          view_(array.chunkStop(chunkIndex) - array.chunkStart(chunkIndex),
+                array.pinChunk(chunkIndex, false))
+        {}
+
+        ~ChunkLock()
+        {
+            array_.unpinChunk(index_);
+        }
+
+            /** The chunk's data.
+            */
+        view_type view() const
+        {
+            return view_;
+        }
+
+            /** Coordinate of the chunk's first element in the array.
+            */
+        shape_type start() const
+        {
+            return array_.chunkStart(index_);
+        }
+
+      private:
+        ChunkLock(ChunkLock const &);
+        ChunkLock & operator=(ChunkLock const &);
+
+        ChunkedArray const & array_;
+        shape_type index_;
+        view_type view_;
+    };
+
+        /** Create an array of the given shape and chunk shape whose loaded chunks 
+            may occupy at most <tt>memoryBudget</tt> bytes.
+        */
+    ChunkedArray(shape_type const & shape, shape_type const & chunkShape, 
+                 std::size_t memoryBudget)
+    : shape_(shape),
+      chunkShape_(chunkShape),
+      memoryBudget_(memoryBudget),
+      residentBytes_(0)
+    {
+        for(unsigned int k=0; k<N; ++k)
+        {
+            vigra_precondition(shape[k] > 0 && chunkShape[k] > 0,
+                "ChunkedArray(): shape and chunk shape must be positive.");
+            chunkArrayShape_[k] = (shape[k] + chunkShape[k] - 1) / chunkShape[k];
+        }
+        chunks_.resize(prod(chunkArrayShape_));
+    }
+
+        /** Derived classes must unload all chunks in their destructor
+            (see \ref unloadChunks()).
+        */
+    virtual ~ChunkedArray()
+    {}
+
+        /** The array's shape.
+        */
+    shape_type const & shape() const
+    {
+        return shape_;
+    }
+
+        /** The array's length in dimension <tt>k</tt>.
+        */
+    MultiArrayIndex shape(int k) const
+    {
+        return shape_[k];
+    }
+
+        /** The number of elements in the array.
+        */
+    MultiArrayIndex size() const
+    {
+        return prod(shape_);
+    }
+
+        /** The shape of the chunks (except at the upper borders).
+        */
+    shape_type const & chunkShape() const
+    {
+        return chunkShape_;
+    }
+
+        /** The number of chunks along each dimension.
+        */
+    shape_type const & chunkArrayShape() const
+    {
+        return chunkArrayShape_;
+    }
+
+        /** Coordinate of the first element of the given chunk.
+        */
+    shape_type chunkStart(shape_type const & chunkIndex) const
+    {
+        return chunkIndex*chunkShape_;
+    }
+
+        /** Coordinate after the last element of the given chunk.
+        */
+    shape_type chunkStop(shape_type const & chunkIndex) const
+    {
+        return min(chunkStart(chunkIndex) + chunkShape_, shape_);
+    }
+
+        /** The maximum number of bytes occupied by loaded chunks (unless
+            more chunks are in use at the same time).
+        */
+    std::size_t memoryBudget() const
+    {
+        return memoryBudget_;
+    }
+
+        /** Change the memory budget, unloading chunks as necessary.
+        */
+    void setMemoryBudget(std::size_t bytes)
+    {
+        memoryBudget_ = bytes;
+        releaseChunks(memoryBudget_);
+    }
+
+        /** The number of bytes currently occupied by loaded chunks.
+        */
+    std::size_t residentBytes() const
+    {
+        return residentBytes_;
+    }
+
+        /** Read the element at coordinate <tt>p</tt>.
+        */
+    value_type getItem(shape_type const & p) const
+    {
+        checkCoordinate(p, "ChunkedArray::getItem()");
+        ChunkLock lock(*this, p / chunkShape_);
+        return lock.view()[p - lock.start()];
+    }
+
+        /** Write the element at coordinate <tt>p</tt>.
+        */
+    void setItem(shape_type const & p, value_type const & v)
+    {
+        checkCoordinate(p, "ChunkedArray::setItem()");
+        ChunkLock lock(*this, p / chunkShape_);
+        lock.view()[p - lock.start()] = v;
+    }
+
+        /** Read the element at coordinate <tt>p</tt> (same as \ref getItem()).
+        */
+    value_type operator[](shape_type const & p) const
+    {
+        return getItem(p);
+    }
+
+        /** Copy the block starting at <tt>start</tt> with the shape of 
+            <tt>subarray</tt> into <tt>subarray</tt>.
+        */
+    template <class U, class Stride>
+    void checkoutSubarray(shape_type const & start, MultiArrayView<N, U, Stride> subarray) const
+    {
+        shape_type stop = start + subarray.shape();
+        checkBlock(start, stop, "ChunkedArray::checkoutSubarray()");
+        ArrayVector<shape_type> chunks;
+        chunksOfBlock(start, stop, chunks);
+        for(std::size_t k=0; k<chunks.size(); ++k)
+        {
+            ChunkLock lock(*this, chunks[k]);
+            shape_type from = max(start, lock.start()),
+                       to   = min(stop,  lock.start() + lock.view().shape());
+            MultiArrayView<N, U, Stride> dest = subarray.subarray(from - start, to - start);
+            copyMultiArray(srcMultiArrayRange(lock.view().subarray(from - lock.start(), to - lock.start())),
+                           destMultiArray(dest));
+        }
+    }
+
+        /** Copy <tt>subarray</tt> into the block starting at <tt>start</tt>.
+        */
+    template <class U, class Stride>
+    void commitSubarray(shape_type const & start, MultiArrayView<N, U, Stride> const & subarray)
+    {
+        shape_type stop = start + subarray.shape();
+        checkBlock(start, stop, "ChunkedArray::commitSubarray()");
+        ArrayVector<shape_type> chunks;
+        chunksOfBlock(start, stop, chunks);
+        for(std::size_t k=0; k<chunks.size(); ++k)
+        {
+            ChunkLock lock(*this, chunks[k]);
+            shape_type from = max(start, lock.start()),
+                       to   = min(stop,  lock.start() + lock.view().shape());
+            view_type dest = lock.view().subarray(from - lock.start(), to - lock.start());
+            copyMultiArray(srcMultiArrayRange(subarray.subarray(from - start, to - start)),
+                           destMultiArray(dest));
+        }
+    }
+
+        /** Scan-order iterator to the first element.
+        */
+    iterator begin()
+    {
+        return iterator(this, 0);
+    }
+
+        /** Scan-order iterator past the last element.
+        */
+    iterator end()
+    {
+        return iterator(this, size());
+    }
+
+        /** Read-only scan-order iterator to the first element.
+        */
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+        /** Read-only scan-order iterator past the last element.
+        */
+    const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+        /** Write all modified chunks to the backing store (they remain loaded),
+            and flush the backing store itself (e.g. the HDF5 file). 
+            
+            Errors are reported by an exception. Call this function before the 
+            array is destroyed when errors must be detected: the destructors 
+            don't throw and discard modified chunks which cannot be written. 
+            Likewise, a chunk that cannot be written back when it is unloaded 
+            because a \ref ChunkLock or iterator releases it remains loaded 
+            and modified, so that the error is reported by the next 
+            <tt>flush()</tt>.
+        */
+    void flush()
+    {
+        for(std::size_t k=0; k<chunks_.size(); ++k)
+        {
+            if(chunks_[k].data != 0 && chunks_[k].dirty)
+            {
+                shape_type index = chunkIndex(k);
+                storeChunk(index, chunkStop(index) - chunkStart(index), chunks_[k].data);
+                chunks_[k].dirty = false;
+            }
+        }
+        flushStore();
+    }
+
+        /** Unload unused chunks (writing them back if modified) until
+            at most <tt>bytes</tt> bytes are occupied by loaded chunks.
+        */
+    void releaseChunks(std::size_t bytes = 0) const
+    {
+        typename std::list<std::size_t>::iterator i = lru_.end();
+        while(residentBytes_ > bytes && i != lru_.begin())
+        {
+            --i;
+            if(chunks_[*i].pins == 0)
+                unloadChunk(*(i++));
+        }
+    }
+
+  protected:
+        /** Return a pointer to the (contiguous) data of the given chunk,
+            loading it from the backing store or initializing it if necessary. 
+            <tt>shape</tt> is the chunk's actual shape.
+        */
+    virtual T * loadChunk(shape_type const & chunkIndex, shape_type const & shape) = 0;
+
+        /** Write a modified chunk to the backing store.
+        */
+    virtual void storeChunk(shape_type const & chunkIndex, shape_type const & shape, T * data) = 0;
+
+        /** Release the memory of a chunk that is no longer loaded (it has
+            already been stored if necessary). Must not throw.
+        */
+    virtual void releaseChunk(shape_type const & chunkIndex, shape_type const & shape, T * data) = 0;
+
+        /** Flush the backing store after \ref flush() has stored all modified
+            chunks (default: do nothing).
+        */
+    virtual void flushStore()
+    {}
+
+        /** Unload all chunks (writing back modified chunks if <tt>store</tt> is true).
+            Must be called in the destructor of derived classes, and therefore 
+            doesn't throw: modified chunks which cannot be written are discarded.
+        */
+    void unloadChunks(bool store = true)
+    {
+        for(std::size_t k=0; k<chunks_.size(); ++k)
+        {
+            if(chunks_[k].data == 0)
+                continue;
+            if(!store)
+                chunks_[k].dirty = false;
+            try
+            {
+                unloadChunk(k);
+            }
+            catch(...)
+            {
+                // the chunk is still loaded, release it without storing
+                chunks_[k].dirty = false;
+                unloadChunk(k);
+            }
+        }
+    }
+
+  private:
+    template <unsigned int, class, class, class>
+    friend class ChunkedArrayIterator;
+    friend class ChunkLock;
+
+    struct Chunk
+    {
+        Chunk()
+        : data(0), pins(0), dirty(false)
+        {}
+
+        T * data;
+        int pins;
+        bool dirty;
+        typename std::list<std::size_t>::iterator lru;
+    };
+
+    std::size_t linearIndex(shape_type const & chunkIndex) const
+    {
+        std::size_t res = 0;
+        for(int k=N-1; k>=0; --k)
+            res = res*chunkArrayShape_[k] + chunkIndex[k];
+        return res;
+    }
+
+    shape_type chunkIndex(std::size_t linear) const
+    {
+        shape_type res;
+        for(unsigned int k=0; k<N; ++k)
+        {
+            res[k] = linear % chunkArrayShape_[k];
+            linear /= chunkArrayShape_[k];
+        }
+        return res;
+    }
+
+    T * pinChunk(shape_type const & chunkIndex, bool modify) const
+    {
+        std::size_t k = linearIndex(chunkIndex);
+        Chunk & chunk = chunks_[k];
+        if(chunk.data == 0)
+        {
+            shape_type shape = chunkStop(chunkIndex) - chunkStart(chunkIndex);
+            chunk.data = const_cast<ChunkedArray *>(this)->loadChunk(chunkIndex, shape);
+            lru_.push_front(k);
+            chunk.lru = lru_.begin();
+            residentBytes_ += prod(shape)*sizeof(T);
+        }
+        else if(chunk.lru != lru_.begin())
+        {
+            lru_.splice(lru_.begin(), lru_, chunk.lru);
+        }
+        ++chunk.pins;
+        if(modify)
+            chunk.dirty = true;
+        return chunk.data;
+    }
+
+    void unpinChunk(shape_type const & chunkIndex) const
+    {
+        --chunks_[linearIndex(chunkIndex)].pins;
+        if(residentBytes_ > memoryBudget_)
+        {
+            // called from the destructors of ChunkLock and the iterators: a chunk 
+            // that cannot be stored remains loaded and modified, and flush() 
+            // reports the error
+            try
+            {
+                releaseChunks(memoryBudget_);
+            }
+            catch(...)
+            {}
+        }
+    }
+
+    bool * dirtyFlag(shape_type const & chunkIndex) const
+    {
+        return &chunks_[linearIndex(chunkIndex)].dirty;
+    }
+
+    void unloadChunk(std::size_t k) const
+    {
+        Chunk & chunk = chunks_[k];
+        shape_type index = chunkIndex(k),
+                   shape = chunkStop(index) - chunkStart(index);
+        ChunkedArray * self = const_cast<ChunkedArray *>(this);
+        if(chunk.dirty)
+            self->storeChunk(index, shape, chunk.data);
+        self->releaseChunk(index, shape, chunk.data);
+        lru_.erase(chunk.lru);
+        residentBytes_ -= prod(shape)*sizeof(T);
+        chunk.data = 0;
+        chunk.dirty = false;
+    }
+
+    void chunksOfBlock(shape_type const & start, shape_type const & stop, 
+                       ArrayVector<shape_type> & chunks) const
+    {
+        shape_type first = start / chunkShape_,
+                   end   = (stop - shape_type(1)) / chunkShape_ + shape_type(1),
+                   c(first);
+        for(unsigned int k=0; k<N;)
+        {
+            chunks.push_back(c);
+            for(k=0; k<N; ++k)
+            {
+                if(++c[k] < end[k])
+                    break;
+                c[k] = first[k];
+            }
+        }
+    }
+
+    void checkCoordinate(shape_type const & p, const char * function) const
+    {
+        for(unsigned int k=0; k<N; ++k)
+            vigra_precondition(p[k] >= 0 && p[k] < shape_[k],
+                std::string(function) + ": coordinate outside the array.");
+    }
+
+    void checkBlock(shape_type const & start, shape_type const & stop, const char * function) const
+    {
+        for(unsigned int k=0; k<N; ++k)
+            vigra_precondition(0 <= start[k] && start[k] < stop[k] && stop[k] <= shape_[k],
+                std::string(function) + ": block must be a non-empty part of the array.");
+    }
+
+    ChunkedArray(ChunkedArray const &);
+    ChunkedArray & operator=(ChunkedArray const &);
+
+    shape_type shape_, chunkShape_, chunkArrayShape_;
+    std::size_t memoryBudget_;
+    mutable std::size_t residentBytes_;
+    mutable ArrayVector<Chunk> chunks_;
+    mutable std::list<std::size_t> lru_;
+};
+
+/********************************************************/
+/*                                                      */
+/*            ChunkedArrayElementReference              */
+/*                                                      */
+/********************************************************/
+
+/** \brief Reference to an element of a \ref vigra::ChunkedArray.
+
+    This is the <tt>reference</tt> type of \ref vigra::ChunkedArray::iterator.
+    It converts to <tt>T const &</tt> for reading, whereas assignment 
+    (including the arithmetic assignment operators) writes the element and 
+    marks its chunk as modified. Thus, chunks which are only read via the 
+    non-const iterator are not written back to the backing store.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+*/
+template <class T>
+class ChunkedArrayElementReference
+{
+  public:
+    ChunkedArrayElementReference(T * ptr, bool * dirty)
+    : ptr_(ptr), dirty_(dirty)
+    {}
+
+    operator T const &() const
+    {
+        return *ptr_;
+    }
+
+    ChunkedArrayElementReference & operator=(T const & v)
+    {
+        *ptr_ = v;
+        *dirty_ = true;
+        return *this;
+    }
+
+    ChunkedArrayElementReference & operator=(ChunkedArrayElementReference const & other)
+    {
+        return operator=(static_cast<T const &>(other));
+    }
+
+    template <class U>
+    ChunkedArrayElementReference & operator+=(U const & v)
+    {
+        *ptr_ += v;
+        *dirty_ = true;
+        return *this;
+    }
+
+    template <class U>
+    ChunkedArrayElementReference & operator-=(U const & v)
+    {
+        *ptr_ -= v;
+        *dirty_ = true;
+        return *this;
+    }
+
+    template <class U>
+    ChunkedArrayElementReference & operator*=(U const & v)
+    {
+        *ptr_ *= v;
+        *dirty_ = true;
+        return *this;
+    }
+
+    template <class U>
+    ChunkedArrayElementReference & operator/=(U const & v)
+    {
+        *ptr_ /= v;
+        *dirty_ = true;
+        return *this;
+    }
+
+  private:
+    T * ptr_;
+    bool * dirty_;
+};
+
+namespace detail {
+
+template <class REFERENCE>
+struct ChunkedArrayDereference
+{
+    template <class T>
+    static REFERENCE exec(T * ptr, bool *)
+    {
+        return *ptr;
+    }
+};
+
+template <class T>
+struct ChunkedArrayDereference<ChunkedArrayElementReference<T> >
+{
+    static ChunkedArrayElementReference<T> exec(T * ptr, bool * dirty)
+    {
+        return ChunkedArrayElementReference<T>(ptr, dirty);
+    }
+};
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                ChunkedArrayIterator                  */
+/*                                                      */
+/********************************************************/
+
+/** \brief Scan-order iterator for \ref vigra::ChunkedArray.
+
+    Visits the elements in the same order as the scan-order iterator of 
+    \ref vigra::MultiArrayView (i.e. the first coordinate changes fastest).
+    The chunk containing the current element is locked while the iterator 
+    points into it. Moving along the first coordinate within a chunk is as fast
+    as incrementing a pointer. The non-const iterator marks a chunk as modified
+    only when an element is written via its reference (see 
+    \ref vigra::ChunkedArrayElementReference) or accessed via <tt>operator-></tt>.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N, class T, class REFERENCE, class POINTER>
+class ChunkedArrayIterator
+{
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef REFERENCE reference;
+    typedef POINTER pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename MultiArrayShape<N>::type shape_type;
+    typedef ChunkedArray<N, T> array_type;
+
+    ChunkedArrayIterator()
+    : array_(0), index_(0), size_(0), dirty_(0), ptr_(0), pinned_(false), modify_(false)
+    {}
+
+    ChunkedArrayIterator(array_type * array, MultiArrayIndex index)
+    : array_(array), index_(index), size_(array->size()), dirty_(0), ptr_(0), 
+      pinned_(false), modify_(true)
+    {
+        setPoint();
+        locate();
+    }
+
+    ChunkedArrayIterator(array_type const * array, MultiArrayIndex index)
+    : array_(const_cast<array_type *>(array)), index_(index), size_(array->size()), 
+      dirty_(0), ptr_(0), pinned_(false), modify_(false)
+    {
+        setPoint();
+        locate();
+    }
+
+    ChunkedArrayIterator(ChunkedArrayIterator const & other)
+    : array_(other.array_), index_(other.index_), size_(other.size_), point_(other.point_),
+      dirty_(0), ptr_(0), pinned_(false), modify_(other.modify_)
+    {
+        locate();
+    }
+
+    ChunkedArrayIterator & operator=(ChunkedArrayIterator const & other)
+    {
+        if(this != &other)
+        {
+            unpin();
+            array_ = other.array_;
+            index_ = other.index_;
+            size_ = other.size_;
+            point_ = other.point_;
+            modify_ = other.modify_;
+            locate();
+        }
+        return *this;
+    }
+
+    ~ChunkedArrayIterator()
+    {
+        unpin();
+    }
+
+    reference operator*() const
+    {
+        return detail::ChunkedArrayDereference<reference>::exec(ptr_, dirty_);
+    }
+
+    pointer operator->() const
+    {
+        if(modify_)
+            *dirty_ = true;
+        return ptr_;
+    }
+
+    ChunkedArrayIterator & operator++()
+    {
+        ++index_;
+        ++point_[0];
+        if(point_[0] < rowStop_)
+        {
+            ++ptr_;
+            return *this;
+        }
+        if(point_[0] == array_->shape(0))
+        {
+            point_[0] = 0;
+            for(unsigned int k=1; k<N; ++k)
+            {
+                if(++point_[k] < array_->shape(k))
+                    break;
+                if(k < N-1)
+                    point_[k] = 0;
+            }
+        }
+        locate();
+        return *this;
+    }
+
+    ChunkedArrayIterator operator++(int)
+    {
+        ChunkedArrayIterator res(*this);
+        ++*this;
+        return res;
+    }
+
+    bool operator==(ChunkedArrayIterator const & other) const
+    {
+        return index_ == other.index_;
+    }
+
+    bool operator!=(ChunkedArrayIterator const & other) const
+    {
+        return index_ != other.index_;
+    }
+
+        /** The coordinate of the current element.
+        */
+    shape_type const & point() const
+    {
+        return point_;
+    }
+
+        /** The scan-order index of the current element.
+        */
+    MultiArrayIndex scanOrderIndex() const
+    {
+        return index_;
+    }
+
+  private:
+    void setPoint()
+    {
+        MultiArrayIndex i = index_;
+        for(unsigned int k=0; k<N; ++k)
+        {
+            point_[k] = i % array_->shape(k);
+            i /= array_->shape(k);
+        }
+        if(index_ >= size_)
+            point_ = array_->shape();
+    }
+
+    void unpin()
+    {
+        if(pinned_)
+            array_->unpinChunk(chunk_);
+        pinned_ = false;
+    }
+
+    void locate()
+    {
+        if(array_ == 0 || index_ >= size_)
+        {
+            unpin();
+            return;
+        }
+        shape_type chunk = point_ / array_->chunkShape();
+        if(!pinned_ || chunk != chunk_)
+        {
+            unpin();
+            chunk_ = chunk;
+            chunkBase_ = array_->pinChunk(chunk_, false);
+            dirty_ = array_->dirtyFlag(chunk_);
+            pinned_ = true;
+            start_ = array_->chunkStart(chunk_);
+            stop_ = array_->chunkStop(chunk_);
+            stride_ = detail::defaultStride<N>(stop_ - start_);
+        }
+        ptr_ = chunkBase_ + dot(point_ - start_, stride_);
+        rowStop_ = stop_[0];
+    }
+
+    array_type * array_;
+    MultiArrayIndex index_, size_;
+    shape_type point_, chunk_, start_, stop_, stride_;
+    bool * dirty_;
+    T * chunkBase_;
+    T * ptr_;
+    MultiArrayIndex rowStop_;
+    bool pinned_, modify_;
+};
+
+/********************************************************/
+/*                                                      */
+/*                  ChunkedArrayLazy                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Chunked array in anonymous memory.
+
+    Chunks are allocated and initialized with the fill value when they are 
+    first accessed, so that large, sparsely used arrays only occupy memory 
+    for the chunks actually touched. Since main memory is the backing store,
+    chunks are never unloaded, and the memory budget is unlimited.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N, class T>
+class ChunkedArrayLazy
+: public ChunkedArray<N, T>
+{
+  public:
+    typedef ChunkedArray<N, T> base_type;
+    typedef typename base_type::shape_type shape_type;
+
+        /** Create an array with the given shape and chunk shape whose elements
+            are initialized with <tt>fill</tt>.
+        */
+    ChunkedArrayLazy(shape_type const & shape, shape_type const & chunkShape, 
+                     T const & fill = T())
+    : base_type(shape, chunkShape, std::numeric_limits<std::size_t>::max()),
+      fill_(fill),
+      storage_(prod(this->chunkArrayShape()), (T *)0)
+    {}
+
+    ~ChunkedArrayLazy()
+    {
+        this->unloadChunks(false);
+        for(std::size_t k=0; k<storage_.size(); ++k)
+            delete [] storage_[k];
+    }
+
+  protected:
+    virtual T * loadChunk(shape_type const & chunkIndex, shape_type const & shape)
+    {
+        T * & data = storage_[linearIndex(chunkIndex)];
+        if(data == 0)
+        {
+            data = new T[prod(shape)];
+            std::fill(data, data + prod(shape), fill_);
+        }
+        return data;
+    }
+
+    virtual void storeChunk(shape_type const &, shape_type const &, T *)
+    {}
+
+    virtual void releaseChunk(shape_type const &, shape_type const &, T *)
+    {}
+
+  private:
+    std::size_t linearIndex(shape_type const & chunkIndex) const
+    {
+        std::size_t res = 0;
+        for(int k=N-1; k>=0; --k)
+            res = res*this->chunkArrayShape()[k] + chunkIndex[k];
+        return res;
+    }
+
+    T fill_;
+    ArrayVector<T *> storage_;
+};
+
+namespace detail {
+
+    // Run-length encoding at the level of array elements: the output consists
+    // of blocks, each starting with a signed 32-bit count. A positive count
+    // is followed by as many literal elements, a negative count by a single
+    // element to be repeated -count times.
+template <class T>
+void runLengthEncode(T const * data, std::size_t size, ArrayVector<char> & res)
+{
+    res.clear();
+    std::size_t i = 0;
+    while(i < size)
+    {
+        std::size_t run = 1;
+        while(i + run < size && run < 0x7fffffff && 
+              std::memcmp(data + i + run, data + i, sizeof(T)) == 0)
+            ++run;
+        Int32 count;
+        std::size_t elements;
+        if(run >= 3)
+        {
+            count = -(Int32)run;
+            elements = 1;
+        }
+        else
+        {
+            // collect literals until the next run of at least 3 equal elements
+            std::size_t end = i + 1;
+            while(end < size && end - i < 0x7fffffff &&
+                  !(end + 2 < size && std::memcmp(data + end, data + end + 1, sizeof(T)) == 0 &&
+                                      std::memcmp(data + end, data + end + 2, sizeof(T)) == 0))
+                ++end;
+            run = end - i;
+            count = (Int32)run;
+            elements = run;
+        }
+        std::size_t pos = res.size();
+        res.resize(pos + sizeof(Int32) + elements*sizeof(T));
+        std::memcpy(res.data() + pos, &count, sizeof(Int32));
+        std::memcpy(res.data() + pos + sizeof(Int32), data + i, elements*sizeof(T));
+        i += run;
+    }
+}
+
+template <class T>
+void runLengthDecode(ArrayVector<char> const & code, T * data, std::size_t size)
+{
+    char const * p = code.data(), * end = p + code.size();
+    std::size_t i = 0;
+    while(p < end)
+    {
+        Int32 count;
+        std::memcpy(&count, p, sizeof(Int32));
+        p += sizeof(Int32);
+        std::size_t run = count < 0 ? -count : count;
+        vigra_postcondition(i + run <= size, "runLengthDecode(): corrupted data.");
+        if(count < 0)
+        {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            std::fill(data + i, data + i + run, v);
+            p += sizeof(T);
+        }
+        else
+        {
+            std::memcpy(data + i, p, run*sizeof(T));
+            p += run*sizeof(T);
+        }
+        i += run;
+    }
+    vigra_postcondition(i == size, "runLengthDecode(): corrupted data.");
+}
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*               ChunkedArrayCompressed                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Chunked array whose chunks are kept compressed in main memory.
+
+    Only the chunks currently loaded (bounded by the memory budget) are 
+    stored uncompressed. Unloaded chunks are run-length encoded at the level of 
+    array elements. This is very fast and works well for label images, masks 
+    and other piecewise constant data, but achieves little for noisy data.
+    Chunks that have never been accessed occupy no memory at all.
+    The element type must be copyable by <tt>memcpy()</tt>.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N, class T>
+class ChunkedArrayCompressed
+: public ChunkedArray<N, T>
+{
+  public:
+    typedef ChunkedArray<N, T> base_type;
+    typedef typename base_type::shape_type shape_type;
+
+        /** Create an array with the given shape and chunk shape whose elements
+            are initialized with <tt>fill</tt>. At most <tt>memoryBudget</tt> 
+            bytes of uncompressed chunks are kept in memory.
+        */
+    ChunkedArrayCompressed(shape_type const & shape, shape_type const & chunkShape, 
+                           std::size_t memoryBudget, T const & fill = T())
+    : base_type(shape, chunkShape, memoryBudget),
+      fill_(fill),
+      compressed_(prod(this->chunkArrayShape()))
+    {}
+
+    ~ChunkedArrayCompressed()
+    {
+        this->unloadChunks(false);
+    }
+
+        /** Number of bytes occupied by the compressed chunks.
+        */
+    std::size_t compressedBytes() const
+    {
+        std::size_t res = 0;
+        for(std::size_t k=0; k<compressed_.size(); ++k)
+            res += compressed_[k].size();
+        return res;
+    }
+
+  protected:
+    virtual T * loadChunk(shape_type const & chunkIndex, shape_type const & shape)
+    {
+        std::size_t size = prod(shape);
+        T * data = new T[size];
+        ArrayVector<char> const & code = compressed_[linearIndex(chunkIndex)];
+        if(code.size() == 0)
+            std::fill(data, data + size, fill_);
+        else
+            detail::runLengthDecode(code, data, size);
+        return data;
+    }
+
+    virtual void storeChunk(shape_type const & chunkIndex, shape_type const & shape, T * data)
+    {
+        detail::runLengthEncode(data, prod(shape), compressed_[linearIndex(chunkIndex)]);
+    }
+
+    virtual void releaseChunk(shape_type const &, shape_type const &, T * data)
+    {
+        delete [] data;
+    }
+
+  private:
+    std::size_t linearIndex(shape_type const & chunkIndex) const
+    {
+        std::size_t res = 0;
+        for(int k=N-1; k>=0; --k)
+            res = res*this->chunkArrayShape()[k] + chunkIndex[k];
+        return res;
+    }
+
+    T fill_;
+    ArrayVector<ArrayVector<char> > compressed_;
+};
+
+/********************************************************/
+/*                                                      */
+/*                  ChunkedArrayMmap                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Chunked array in a memory-mapped file.
+
+    The array is stored in a new file (an existing file of the same name is 
+    overwritten), where each chunk occupies a contiguous range of bytes. Loading
+    a chunk merely initializes it with the fill value on first access, the 
+    operating system brings pages into memory as needed and writes them back 
+    to the file when memory runs short. Thus, arrays bigger than main memory 
+    (but not bigger than the address space) can be used like ordinary arrays.
+    The memory budget is unlimited. The element type must be copyable 
+    by <tt>memcpy()</tt>.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N, class T>
+class ChunkedArrayMmap
+: public ChunkedArray<N, T>
+{
+  public:
+    typedef ChunkedArray<N, T> base_type;
+    typedef typename base_type::shape_type shape_type;
+
+        /** Create an array with the given shape and chunk shape in file 
+            <tt>filename</tt>, whose elements are initialized with <tt>fill</tt>.
+        */
+    ChunkedArrayMmap(std::string const & filename, 
+                     shape_type const & shape, shape_type const & chunkShape, 
+                     T const & fill = T())
+    : base_type(shape, chunkShape, std::numeric_limits<std::size_t>::max()),
+      fill_(fill),
+      offsets_(prod(this->chunkArrayShape()) + 1, 0),
+      initialized_(prod(this->chunkArrayShape()), false)
+    {
+        // chunks are stored consecutively in scan order of the chunk indices
+        shape_type index;
+        for(std::size_t k=0; k<offsets_.size()-1; ++k)
+        {
+            offsets_[k+1] = offsets_[k] + prod(this->chunkStop(index) - this->chunkStart(index));
+            for(unsigned int d=0; d<N; ++d)
+            {
+                if(++index[d] < this->chunkArrayShape()[d])
+                    break;
+                index[d] = 0;
+            }
+        }
+        file_.create(filename, offsets_.back()*sizeof(T));
+    }
+
+    ~ChunkedArrayMmap()
+    {
+        this->unloadChunks();
+    }
+
+  protected:
+    virtual T * loadChunk(shape_type const & chunkIndex, shape_type const & shape)
+    {
+        std::size_t k = linearIndex(chunkIndex);
+        T * data = (T *)file_.data() + offsets_[k];
+        if(!initialized_[k])
+        {
+            std::fill(data, data + prod(shape), fill_);
+            initialized_[k] = true;
+        }
+        return data;
+    }
+
+    virtual void storeChunk(shape_type const &, shape_type const &, T *)
+    {}
+
+    virtual void releaseChunk(shape_type const &, shape_type const &, T *)
+    {}
+
+    virtual void flushStore()
+    {
+        file_.flush();
+    }
+
+  private:
+    std::size_t linearIndex(shape_type const & chunkIndex) const
+    {
+        std::size_t res = 0;
+        for(int k=N-1; k>=0; --k)
+            res = res*this->chunkArrayShape()[k] + chunkIndex[k];
+        return res;
+    }
+
+    T fill_;
+    ArrayVector<std::size_t> offsets_;
+    ArrayVector<bool> initialized_;
+    MemoryMappedFile file_;
+};
+
+//@}
+
+/** \addtogroup MultiPointoperators
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*         inspectMultiArray / transformMultiArray      */
+/*                   for chunked arrays                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Call an analyzing functor for all elements of a \ref vigra::ChunkedArray.
+
+    The array is processed chunk by chunk, calling the ordinary 
+    \ref inspectMultiArray() for each chunk. See there for more documentation.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T, class Functor>
+        void
+        inspectMultiArray(ChunkedArray<N, T> const & array, Functor & f);
+    }
+    \endcode
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N, class T, class Functor>
+void
+inspectMultiArray(ChunkedArray<N, T> const & array, Functor & f)
+{
+    typedef typename ChunkedArray<N, T>::ChunkLock ChunkLock;
+    typename ChunkedArray<N, T>::shape_type index;
+    MultiArrayIndex count = prod(array.chunkArrayShape());
+    for(MultiArrayIndex k=0; k<count; ++k)
+    {
+        {
+            ChunkLock lock(array, index);
+            inspectMultiArray(srcMultiArrayRange(lock.view()), f);
+        }
+        for(unsigned int d=0; d<N; ++d)
+        {
+            if(++index[d] < array.chunkArrayShape()[d])
+                break;
+            index[d] = 0;
+        }
+    }
+}
+
+/** \brief Transform a \ref vigra::ChunkedArray or transform into a \ref vigra::ChunkedArray.
+
+    Source and destination must have the same shape. The destination is processed
+    chunk by chunk, calling the ordinary \ref transformMultiArray() for each chunk.
+    When both arrays are chunked with the same chunk shape, the source chunks are 
+    accessed directly, otherwise the corresponding source block is copied first.
+    See \ref transformMultiArray() for more documentation.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class T2, class Functor>
+        void
+        transformMultiArray(ChunkedArray<N, T1> const & source, ChunkedArray<N, T2> & dest, 
+                            Functor const & f);
+
+        template <unsigned int N, class T1, class T2, class Stride2, class Functor>
+        void
+        transformMultiArray(ChunkedArray<N, T1> const & source, MultiArrayView<N, T2, Stride2> dest, 
+                            Functor const & f);
+
+        template <unsigned int N, class T1, class Stride1, class T2, class Functor>
+        void
+        transformMultiArray(MultiArrayView<N, T1, Stride1> const & source, ChunkedArray<N, T2> & dest, 
+                            Functor const & f);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br>
+    Namespace: vigra
+
+    \code
+    ChunkedArrayCompressed<3, float> source(shape, chunkShape, budget),
+                                     dest(shape, chunkShape, budget);
+    ...
+    transformMultiArray(source, dest, sqrt(Arg1()));
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void transformMultiArray)
+
+template <unsigned int N, class T1, class T2, class Functor>
+void
+transformMultiArray(ChunkedArray<N, T1> const & source, ChunkedArray<N, T2> & dest, 
+                    Functor const & f)
+{
+    typedef typename ChunkedArray<N, T2>::ChunkLock ChunkLock;
+    typedef typename ChunkedArray<N, T1>::ChunkLock SourceLock;
+
+    vigra_precondition(source.shape() == dest.shape(),
+        "transformMultiArray(): shape mismatch between input and output.");
+
+    typename ChunkedArray<N, T2>::shape_type index;
+    MultiArrayIndex count = prod(dest.chunkArrayShape());
+    bool sameChunks = source.chunkShape() == dest.chunkShape();
+    MultiArray<N, T1> tmp;
+    for(MultiArrayIndex k=0; k<count; ++k)
+    {
+        {
+            ChunkLock lock(dest, index);
+            typename ChunkLock::view_type chunk = lock.view();
+            if(sameChunks)
+            {
+                SourceLock slock(source, index);
+                transformMultiArray(srcMultiArrayRange(slock.view()), 
+                                    destMultiArray(chunk), f);
+            }
+            else
+            {
+                tmp.reshape(chunk.shape());
+                source.checkoutSubarray(lock.start(), tmp);
+                transformMultiArray(srcMultiArrayRange(tmp), destMultiArray(chunk), f);
+            }
+        }
+        for(unsigned int d=0; d<N; ++d)
+        {
+            if(++index[d] < dest.chunkArrayShape()[d])
+                break;
+            index[d] = 0;
+        }
+    }
+}
+
+template <unsigned int N, class T1, class T2, class Stride2, class Functor>
+void
+transformMultiArray(ChunkedArray<N, T1> const & source, MultiArrayView<N, T2, Stride2> dest, 
+                    Functor const & f)
+{
+    typedef typename ChunkedArray<N, T1>::ChunkLock ChunkLock;
+
+    vigra_precondition(source.shape() == dest.shape(),
+        "transformMultiArray(): shape mismatch between input and output.");
+
+    typename ChunkedArray<N, T1>::shape_type index;
+    MultiArrayIndex count = prod(source.chunkArrayShape());
+    for(MultiArrayIndex k=0; k<count; ++k)
+    {
+        {
+            ChunkLock lock(source, index);
+            MultiArrayView<N, T2, Stride2> block = 
+                dest.subarray(lock.start(), lock.start() + lock.view().shape());
+            transformMultiArray(srcMultiArrayRange(lock.view()), destMultiArray(block), f);
+        }
+        for(unsigned int d=0; d<N; ++d)
+        {
+            if(++index[d] < source.chunkArrayShape()[d])
+                break;
+            index[d] = 0;
+        }
+    }
+}
+
+template <unsigned int N, class T1, class Stride1, class T2, class Functor>
+void
+transformMultiArray(MultiArrayView<N, T1, Stride1> const & source, ChunkedArray<N, T2> & dest, 
+                    Functor const & f)
+{
+    typedef typename ChunkedArray<N, T2>::ChunkLock ChunkLock;
+
+    vigra_precondition(source.shape() == dest.shape(),
+        "transformMultiArray(): shape mismatch between input and output.");
+
+    typename ChunkedArray<N, T2>::shape_type index;
+    MultiArrayIndex count = prod(dest.chunkArrayShape());
+    for(MultiArrayIndex k=0; k<count; ++k)
+    {
+        {
+            ChunkLock lock(dest, index);
+            typename ChunkLock::view_type chunk = lock.view();
+            transformMultiArray(
+                srcMultiArrayRange(source.subarray(lock.start(), lock.start() + chunk.shape())), 
+                destMultiArray(chunk), f);
+        }
+        for(unsigned int d=0; d<N; ++d)
+        {
+            if(++index[d] < dest.chunkArrayShape()[d])
+                break;
+            index[d] = 0;
+        }
+    }
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_ARRAY_CHUNKED_HXX
@@ -0,0 +1,189 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_ARRAY_CHUNKED_HDF5_HXX
+#define VIGRA_MULTI_ARRAY_CHUNKED_HDF5_HXX
+
+#include <string>
+#include "multi_array_chunked.hxx"
+#include "hdf5impex.hxx"
+
+namespace vigra {
+
+/** \addtogroup ChunkedArrays
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                  ChunkedArrayHDF5                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Chunked array stored in a dataset of an HDF5 file.
+
+    The chunks of the array coincide with the chunks of the HDF5 dataset, 
+    so that every chunk is read and written by a single HDF5 chunk operation
+    (which may be accelerated by \ref HDF5File::setThreadCount() and the 
+    HDF5File's own chunk cache). Modified chunks are written back when they are
+    unloaded, when \ref flush() is called, and in the destructor (which 
+    cannot report errors, so call \ref flush() first if they matter). The 
+    HDF5File must remain open during the lifetime of the array, and the 
+    dataset name is interpreted relative to the file's current group at 
+    every access. Only scalar element types are supported.
+
+    <b>Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_array_chunked_hdf5.hxx\><br>
+    Namespace: vigra
+
+    \code
+    HDF5File file("volume.h5", HDF5File::New);
+    
+    // create a new, zlib-compressed dataset of 1000^3 voxels in chunks of 64^3 voxels,
+    // keeping at most 256 MB of chunks in memory
+    ChunkedArrayHDF5<3, UInt8> array(file, "/volume", Shape3(1000), Shape3(64), 
+                                     6, 256 << 20);
+    array.setItem(Shape3(10, 20, 30), 255);
+    \endcode
+*/
+template <unsigned int N, class T>
+class ChunkedArrayHDF5
+: public ChunkedArray<N, T>
+{
+  public:
+    typedef ChunkedArray<N, T> base_type;
+    typedef typename base_type::shape_type shape_type;
+
+        /** Create a new dataset <tt>dataset</tt> (an existing dataset of the same 
+            name is replaced) with the given shape and chunk shape, whose elements
+            are initialized with <tt>fill</tt>. <tt>compression</tt> is the zlib 
+            compression level (0 means no compression).
+        */
+    ChunkedArrayHDF5(HDF5File & file, std::string const & dataset,
+                     shape_type const & shape, shape_type const & chunkShape,
+                     int compression, std::size_t memoryBudget, T const & fill = T())
+    : base_type(shape, min(chunkShape, shape), memoryBudget),
+      file_(file),
+      dataset_(dataset)
+    {
+        file_.createDataset<N, T>(dataset_, shape, fill, this->chunkShape(), compression);
+    }
+
+        /** Open the existing, chunked dataset <tt>dataset</tt>.
+        */
+    ChunkedArrayHDF5(HDF5File & file, std::string const & dataset, std::size_t memoryBudget)
+    : base_type(datasetShape(file, dataset), datasetChunkShape(file, dataset), memoryBudget),
+      file_(file),
+      dataset_(dataset)
+    {}
+
+    ~ChunkedArrayHDF5()
+    {
+        // doesn't throw, modified chunks that cannot be written are lost
+        this->unloadChunks();
+    }
+
+        /** The name of the dataset.
+        */
+    std::string const & dataset() const
+    {
+        return dataset_;
+    }
+
+  protected:
+    virtual T * loadChunk(shape_type const & chunkIndex, shape_type const & shape)
+    {
+        T * data = new T[prod(shape)];
+        MultiArrayView<N, T, UnstridedArrayTag> view(shape, data);
+        shape_type start = this->chunkStart(chunkIndex);
+        file_.readBlock(dataset_, start, shape, view);
+        return data;
+    }
+
+    virtual void storeChunk(shape_type const & chunkIndex, shape_type const & shape, T * data)
+    {
+        MultiArrayView<N, T, UnstridedArrayTag> view(shape, data);
+        file_.writeBlock(dataset_, this->chunkStart(chunkIndex), view);
+    }
+
+    virtual void releaseChunk(shape_type const &, shape_type const &, T * data)
+    {
+        delete [] data;
+    }
+
+    virtual void flushStore()
+    {
+        file_.flushToDisk();
+    }
+
+  private:
+    static shape_type datasetShape(HDF5File & file, std::string const & dataset)
+    {
+        ArrayVector<hsize_t> dims = file.getDatasetShape(dataset);
+        vigra_precondition(dims.size() == N,
+            "ChunkedArrayHDF5(): dataset has wrong dimension.");
+        shape_type res;
+        for(unsigned int k=0; k<N; ++k)
+            res[k] = dims[k];
+        return res;
+    }
+
+    static shape_type datasetChunkShape(HDF5File & file, std::string const & dataset)
+    {
+        HDF5Handle handle = file.getDatasetHandle(dataset);
+        HDF5Handle plist(H5Dget_create_plist(handle), &H5Pclose, 
+                         "ChunkedArrayHDF5(): unable to get property list.");
+        vigra_precondition(H5Pget_layout(plist) == H5D_CHUNKED,
+            "ChunkedArrayHDF5(): dataset is not chunked.");
+        hsize_t cdims[N];
+        H5Pget_chunk(plist, N, cdims);
+        // HDF5 stores the dimensions in reverse order
+        shape_type res;
+        for(unsigned int k=0; k<N; ++k)
+            res[k] = cdims[N-1-k];
+        return res;
+    }
+
+    HDF5File & file_;
+    std::string dataset_;
+};
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_ARRAY_CHUNKED_HDF5_HXX
@@ -0,0 +1,473 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_BLOCKWISE_HXX
+#define VIGRA_MULTI_BLOCKWISE_HXX
+
+#include <string>
+#include "multi_array.hxx"
+#include "multi_convolution.hxx"
+#include "hdf5impex.hxx"
+#include "parallel.hxx"
+
+namespace vigra {
+
+/** \addtogroup BlockwiseProcessing Blockwise Processing of Large Volumes
+
+    Apply filters to HDF5 datasets which are too large to fit into memory.
+
+    <b>\#include</b> \<vigra/multi_blockwise.hxx\><br>
+    Namespace: vigra
+
+    The functions in this group iterate over a dataset in blocks. Each block is 
+    read (via \ref HDF5File::readBlock()) together with a surrounding <i>halo</i>,
+    filtered in memory, and the block's core (i.e. the block without the halo) is 
+    written to the destination dataset (via \ref HDF5File::writeBlock()). Halos are 
+    clipped at the dataset's border, so that the border treatment of the filter 
+    applies there just as if the entire volume was processed at once. If the halo 
+    is at least as large as the filter's support, the result is therefore identical 
+    to whole-volume processing.
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                   BlockwiseOptions                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Options for \ref blockwiseProcessHDF5().
+
+    <b>\#include</b> \<vigra/multi_blockwise.hxx\><br>
+    Namespace: vigra
+
+    \code
+    // blocks of 128^3 voxels, processed by all available threads
+    BlockwiseOptions<3> opt = BlockwiseOptions<3>().blockShape(128).numThreads(0);
+    \endcode
+*/
+template <unsigned int N>
+class BlockwiseOptions
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    Shape block_shape;
+    int num_threads;
+
+    BlockwiseOptions()
+    : block_shape(128),
+      num_threads(1)
+    {}
+
+        /** Shape of the blocks (without halo). For best I/O performance, the block
+            shape should be a multiple of the dataset's chunk shape.
+
+            Default: <tt>128</tt> along every axis
+        */
+    BlockwiseOptions<N> & blockShape(Shape const & shape)
+    {
+        for(unsigned int k=0; k<N; ++k)
+            vigra_precondition(shape[k] > 0,
+                "BlockwiseOptions::blockShape(): block shape must be positive.");
+        block_shape = shape;
+        return *this;
+    }
+
+    BlockwiseOptions<N> & blockShape(MultiArrayIndex size)
+    {
+        return blockShape(Shape(size));
+    }
+
+        /** Number of threads that filter blocks concurrently. All HDF5 calls 
+            are serialized, since the HDF5 library is usually not thread-safe. 
+            See \ref parallelThreadCount() for the interpretation of <tt>n</tt>. 
+            Each thread needs memory for one block (including halo) of the 
+            source and destination types.
+
+            Default: <tt>1</tt>
+        */
+    BlockwiseOptions<N> & numThreads(int n)
+    {
+        vigra_precondition(n >= 0,
+            "BlockwiseOptions::numThreads(): number of threads must not be negative.");
+        num_threads = n;
+        return *this;
+    }
+};
+
+namespace detail {
+
+template <class SrcType, class DestType, unsigned int N, class Functor>
+struct BlockwiseHDF5Functor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    HDF5File * src, * dest;
+    std::string srcName, destName;
+    Functor const * f;
+    Shape shape, halo, blockShape, blocks;
+
+    void operator()(MultiArrayIndex begin, MultiArrayIndex end) const
+    {
+        Functor filter(*f);
+        for(MultiArrayIndex b = begin; b < end; ++b)
+        {
+            Shape blockIndex, coreBegin, coreEnd, outerBegin, outerEnd;
+            MultiArrayIndex r = b;
+            for(unsigned int k=0; k<N; ++k)
+            {
+                blockIndex[k] = r % blocks[k];
+                r /= blocks[k];
+            }
+            coreBegin  = blockIndex * blockShape;
+            coreEnd    = min(coreBegin + blockShape, shape);
+            outerBegin = max(coreBegin - halo, Shape());
+            outerEnd   = min(coreEnd + halo, shape);
+
+            MultiArray<N, SrcType> in(outerEnd - outerBegin);
+            MultiArray<N, DestType> out(coreEnd - coreBegin);
+
+            // exceptions must not leave the critical sections (their lock would 
+            // never be released), so HDF5 errors are rethrown afterwards
+            ParallelErrorState error;
+#ifdef _OPENMP
+            #pragma omp critical (vigra_hdf5)
+#endif
+            {
+                try
+                {
+                    src->readBlock(srcName, outerBegin, outerEnd - outerBegin, in);
+                }
+                catch(...)
+                {
+                    error.recordCurrent("blockwiseProcessHDF5(): unknown exception.");
+                }
+            }
+            error.rethrow();
+
+            filter(in, out, coreBegin - outerBegin, coreEnd - outerBegin);
+
+#ifdef _OPENMP
+            #pragma omp critical (vigra_hdf5)
+#endif
+            {
+                try
+                {
+                    dest->writeBlock(destName, coreBegin, out);
+                }
+                catch(...)
+                {
+                    error.recordCurrent("blockwiseProcessHDF5(): unknown exception.");
+                }
+            }
+            error.rethrow();
+        }
+    }
+};
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                 blockwiseProcessHDF5                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Filter an HDF5 dataset block by block.
+
+    The source dataset <tt>srcName</tt> in <tt>srcFile</tt> is split into blocks of shape 
+    <tt>opt.block_shape</tt> (blocks at the upper border may be smaller). For each block,
+    the region extended by <tt>halo</tt> (clipped at the dataset's border) is read 
+    into a <tt>MultiArray<N, SrcType></tt>. Then the functor is called as
+
+    \code
+    f(MultiArrayView<N, SrcType> const & src, MultiArrayView<N, DestType> dest, 
+      Shape const & start, Shape const & stop);
+    \endcode
+
+    where <tt>[start, stop)</tt> is the location of the block's core within <tt>src</tt>,
+    and <tt>dest</tt> (of shape <tt>stop - start</tt>) must be filled with the result 
+    for the core. Finally, <tt>dest</tt> is written into dataset <tt>destName</tt> of 
+    <tt>destFile</tt> at the core's position. The destination dataset is created 
+    beforehand with the shape of the source and chunks of the block shape (an 
+    existing dataset of that name is replaced), so it must differ from the source 
+    dataset.
+    
+    <tt>SrcType</tt> and <tt>DestType</tt> are the scalar types used in memory,
+    HDF5 converts from and to the type of the datasets if necessary. Both types must 
+    be specified explicitly, whereas <tt>N</tt> and <tt>Functor</tt> are deduced.
+
+    When <tt>opt.num_threads != 1</tt>, several blocks are filtered concurrently 
+    (each thread uses its own copy of the functor), but HDF5 calls are serialized.
+    The result does not depend on the block shape or number of threads, provided 
+    the halo is large enough for the filter. 
+    
+    \ref BlockwiseGaussianSmoothing and \ref BlockwiseGaussianGradientMagnitude 
+    are ready-made functors for filters from \ref MultiArrayConvolutionFilters,
+    which also compute the required halo.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <class SrcType, class DestType, unsigned int N, class Functor>
+        void 
+        blockwiseProcessHDF5(HDF5File & srcFile, std::string const & srcName,
+                             HDF5File & destFile, std::string const & destName,
+                             Functor const & f, TinyVector<MultiArrayIndex, N> const & halo,
+                             BlockwiseOptions<N> const & opt = BlockwiseOptions<N>());
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_blockwise.hxx\><br>
+    Namespace: vigra
+
+    \code
+    HDF5File file("stack.h5", HDF5File::Open);
+    
+    // Gaussian smoothing with 4 threads
+    BlockwiseGaussianSmoothing<3> smooth(3.0);
+    blockwiseProcessHDF5<float, float>(file, "raw", file, "smoothed", 
+                                       smooth, smooth.halo(), 
+                                       BlockwiseOptions<3>().blockShape(256).numThreads(4));
+                                       
+    // any other filter with finite support can be used by a custom functor, e.g.
+    struct Erosion
+    {
+        double radius;
+        
+        void operator()(MultiArrayView<3, UInt8> const & src, MultiArrayView<3, UInt8> dest,
+                        Shape3 const & start, Shape3 const & stop) const
+        {
+            MultiArray<3, UInt8> tmp(src.shape());
+            multiBinaryErosion(srcMultiArrayRange(src), destMultiArray(tmp), radius);
+            dest = tmp.subarray(start, stop);
+        }
+    };
+    
+    Erosion erosion = { 5.0 };
+    blockwiseProcessHDF5<UInt8, UInt8>(file, "mask", file, "eroded", erosion, Shape3(5));
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void blockwiseProcessHDF5)
+
+template <class SrcType, class DestType, unsigned int N, class Functor>
+void
+blockwiseProcessHDF5(HDF5File & srcFile, std::string const & srcName,
+                     HDF5File & destFile, std::string const & destName,
+                     Functor const & f, typename MultiArrayShape<N>::type const & halo,
+                     BlockwiseOptions<N> const & opt)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ArrayVector<hsize_t> datasetShape = srcFile.getDatasetShape(srcName);
+    vigra_precondition(datasetShape.size() == N,
+        "blockwiseProcessHDF5(): dimension of source dataset must match the halo's dimension.");
+    for(unsigned int k=0; k<N; ++k)
+        vigra_precondition(halo[k] >= 0,
+            "blockwiseProcessHDF5(): halo must not be negative.");
+
+    detail::BlockwiseHDF5Functor<SrcType, DestType, N, Functor> process;
+    process.src = &srcFile;
+    process.dest = &destFile;
+    process.srcName = srcName;
+    process.destName = destName;
+    process.f = &f;
+    process.halo = halo;
+
+    MultiArrayIndex blockCount = 1;
+    for(unsigned int k=0; k<N; ++k)
+    {
+        process.shape[k] = datasetShape[k];
+        process.blockShape[k] = std::min(opt.block_shape[k], process.shape[k]);
+        process.blocks[k] = (process.shape[k] + process.blockShape[k] - 1) / process.blockShape[k];
+        blockCount *= process.blocks[k];
+    }
+
+    destFile.createDataset<N, DestType>(destName, process.shape, DestType(), process.blockShape);
+
+    parallelForChunks(blockCount, process, opt.num_threads);
+}
+
+template <class SrcType, class DestType, int N, class Functor>
+inline void
+blockwiseProcessHDF5(HDF5File & srcFile, std::string const & srcName,
+                     HDF5File & destFile, std::string const & destName,
+                     Functor const & f, TinyVector<MultiArrayIndex, N> const & halo)
+{
+    blockwiseProcessHDF5<SrcType, DestType>(srcFile, srcName, destFile, destName, f, halo,
+                                            BlockwiseOptions<N>());
+}
+
+/********************************************************/
+/*                                                      */
+/*             BlockwiseGaussianSmoothing               */
+/*                                                      */
+/********************************************************/
+
+/** \brief Functor for blockwise \ref gaussianSmoothMultiArray().
+
+    To be used with \ref blockwiseProcessHDF5(). The constructor accepts the same
+    parameters as \ref gaussianSmoothMultiArray(), and <tt>halo()</tt> returns the
+    radius of the Gaussian kernels along each axis, which is the minimal halo for 
+    exact results. The entire block (including the halo) is filtered in the same way 
+    as a whole volume would be, so that the results are bit-identical, and the core 
+    is copied to the destination.
+
+    <b>\#include</b> \<vigra/multi_blockwise.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N>
+class BlockwiseGaussianSmoothing
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    explicit BlockwiseGaussianSmoothing(ConvolutionOptions<N> const & opt)
+    : opt_(opt)
+    {}
+
+    explicit BlockwiseGaussianSmoothing(double sigma, 
+                                        ConvolutionOptions<N> const & opt = ConvolutionOptions<N>())
+    : opt_(opt)
+    {
+        opt_.stdDev(sigma);
+    }
+
+    Shape halo() const
+    {
+        typename ConvolutionOptions<N>::ScaleIterator params = opt_.scaleParams();
+        Shape res;
+        for(unsigned int k=0; k<N; ++k, ++params)
+        {
+            Kernel1D<double> kernel;
+            kernel.initGaussian(params.sigma_scaled("BlockwiseGaussianSmoothing"), 1.0, opt_.window_ratio);
+            res[k] = kernel.right();
+        }
+        return res;
+    }
+
+    template <class T1, class S1, class T2, class S2>
+    void operator()(MultiArrayView<N, T1, S1> const & src, MultiArrayView<N, T2, S2> dest,
+                    Shape const & start, Shape const & stop) const
+    {
+        MultiArray<N, T2> tmp(src.shape());
+        gaussianSmoothMultiArray(srcMultiArrayRange(src), destMultiArray(tmp), opt_);
+        dest = tmp.subarray(start, stop);
+    }
+
+  private:
+    ConvolutionOptions<N> opt_;
+};
+
+/********************************************************/
+/*                                                      */
+/*          BlockwiseGaussianGradientMagnitude          */
+/*                                                      */
+/********************************************************/
+
+/** \brief Functor for blockwise computation of the Gaussian gradient magnitude.
+
+    To be used with \ref blockwiseProcessHDF5(). The gradient is computed by 
+    \ref gaussianGradientMultiArray() (the constructor accepts the same parameters),
+    and its Euclidean norm is stored in the destination. <tt>halo()</tt> returns
+    the minimal halo for exact results.
+
+    <b>\#include</b> \<vigra/multi_blockwise.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N>
+class BlockwiseGaussianGradientMagnitude
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    explicit BlockwiseGaussianGradientMagnitude(ConvolutionOptions<N> const & opt)
+    : opt_(opt)
+    {}
+
+    explicit BlockwiseGaussianGradientMagnitude(double sigma, 
+                                                ConvolutionOptions<N> const & opt = ConvolutionOptions<N>())
+    : opt_(opt)
+    {
+        opt_.stdDev(sigma);
+    }
+
+    Shape halo() const
+    {
+        typename ConvolutionOptions<N>::ScaleIterator params = opt_.scaleParams();
+        Shape res;
+        for(unsigned int k=0; k<N; ++k, ++params)
+        {
+            // the smoothing kernel is used along all axes except k
+            Kernel1D<double> smooth, derivative;
+            double sigma = params.sigma_scaled("BlockwiseGaussianGradientMagnitude");
+            smooth.initGaussian(sigma, 1.0, opt_.window_ratio);
+            derivative.initGaussianDerivative(sigma, 1, 1.0, opt_.window_ratio);
+            res[k] = std::max(smooth.right(), derivative.right());
+        }
+        return res;
+    }
+
+    template <class T1, class S1, class T2, class S2>
+    void operator()(MultiArrayView<N, T1, S1> const & src, MultiArrayView<N, T2, S2> dest,
+                    Shape const & start, Shape const & stop) const
+    {
+        typedef typename NumericTraits<T2>::RealPromote RealType;
+
+        typedef MultiArray<N, TinyVector<RealType, (int)N> > GradientArray;
+
+        GradientArray grad(src.shape());
+        gaussianGradientMultiArray(srcMultiArrayRange(src), destMultiArray(grad), opt_);
+        typename GradientArray::view_type core = grad.subarray(start, stop);
+        typename GradientArray::view_type::iterator g = core.begin();
+        typename MultiArrayView<N, T2, S2>::iterator d = dest.begin();
+        for(; g != core.end(); ++g, ++d)
+            *d = detail::RequiresExplicitCast<T2>::cast(norm(*g));
+    }
+
+  private:
+    ConvolutionOptions<N> opt_;
+};
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_BLOCKWISE_HXX
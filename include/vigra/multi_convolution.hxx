@@ -49,6 +49,8 @@
 #include "functorexpression.hxx"
 #include "tinyvector.hxx"
 #include "algorithm.hxx"
+#include "parallel.hxx"
+#include <iterator>
 
 namespace vigra
 {
@@ -333,13 +335,16 @@ class ConvolutionOptions
     ParamVec outer_scale;
     double window_ratio;
     Shape from_point, to_point;
+    int num_threads, block_lines;
      
     ConvolutionOptions()
     : sigma_eff(0.0),
       sigma_d(0.0),
       step_size(1.0),
       outer_scale(0.0),
-      window_ratio(0.0)
+      window_ratio(0.0),
+      num_threads(1),
+      block_lines(32)
     {}
 
     typedef typename detail::WrapDoubleIteratorTriple<ParamIt, ParamIt, ParamIt>
@@ -483,6 +488,44 @@ class ConvolutionOptions
         to_point = to;
         return *this;
     }
+
+        /** Number of threads used by the separable filter passes. 
+
+            Each pass of a separable convolution processes the 1D lines 
+            along one axis. These lines are independent, so they can be distributed
+            over several threads (each using its own line buffer). The result 
+            is identical to the serial computation. If <tt>n == 0</tt>, the number of 
+            threads is determined automatically. Parallel execution requires that VIGRA
+            is compiled with OpenMP support, see \ref parallelThreadCount().
+            
+            Default: <tt>1</tt> (i.e. serial execution)
+        */
+    ConvolutionOptions<dim> & numThreads(int n)
+    {
+        vigra_precondition(n >= 0,
+            "ConvolutionOptions::numThreads(): number of threads must not be negative.");
+        num_threads = n;
+        return *this;
+    }
+
+        /** Number of neighbouring lines that are convolved together. 
+
+            The lines along all axes except the innermost one are strided in memory,
+            so that copying a single line into the line buffer touches a different 
+            cache line for every element. Therefore, these passes gather <tt>n</tt>
+            neighbouring lines at once into a contiguous buffer, convolve them 
+            simultaneously, and scatter the results back. <tt>n = 1</tt> switches back to line-by-line 
+            processing. The result does not depend on this setting.
+            
+            Default: <tt>32</tt>
+        */
+    ConvolutionOptions<dim> & blockLines(int n)
+    {
+        vigra_precondition(n > 0,
+            "ConvolutionOptions::blockLines(): number of lines must be positive.");
+        block_lines = n;
+        return *this;
+    }
 };
 
 namespace detail
@@ -490,64 +533,278 @@ namespace detail
 
 /********************************************************/
 /*                                                      */
-/*        internalSeparableConvolveMultiArray           */
+/*              SeparableConvolveLinesFunctor           */
 /*                                                      */
 /********************************************************/
 
-template <class SrcIterator, class SrcShape, class SrcAccessor,
-          class DestIterator, class DestAccessor, class KernelIterator>
-void
-internalSeparableConvolveMultiArrayTmp(
-                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
-                      DestIterator di, DestAccessor dest, KernelIterator kit)
+    // Choose the axis along which the lines of a pass in dimension 'dim'
+    // are distributed over the threads (the longest remaining axis).
+template <class Shape>
+unsigned int
+separableConvolveSplitAxis(Shape const & shape, unsigned int dim)
 {
-    enum { N = 1 + SrcIterator::level };
-
-    typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
-    typedef typename AccessorTraits<TmpType>::default_accessor TmpAcessor;
+    unsigned int split = dim;
+    for(unsigned int k=0; k<(unsigned int)shape.size(); ++k)
+        if(k != dim && (split == dim || shape[k] > shape[split]))
+            split = k;
+    return split;
+}
 
-    // temporary array to hold the current line to enable in-place operation
-    ArrayVector<TmpType> tmp( shape[0] );
+    // Convolve all lines parallel to axis 'dim' in the ROI [sstart, sstop) of
+    // the source and write the results into the ROI [dstart, dstop) of the
+    // destination (both ROIs must have equal extent except along 'dim').
+    // operator() restricts the work to the range [begin, end) along axis 'split'
+    // (relative to the ROI start), so that disjoint ranges can be processed
+    // by different threads. Each call allocates its own line buffers.
+    //
+    // When 'dim' is not the innermost axis, the lines are strided in memory.
+    // They are then processed in blocks of 'block_lines' neighbouring lines:
+    // the block is gathered into a contiguous (interleaved) buffer, all lines are
+    // convolved simultaneously, and the results are scattered back. Since
+    // neighbouring lines are adjacent along the innermost axis, the gather and 
+    // scatter loops touch consecutive memory instead of one cache line per element.
+template <class SrcIterator, class Shape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class Kernel, class TmpType>
+struct SeparableConvolveLinesFunctor
+{
+    enum { N = 1 + SrcIterator::level };
 
     typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
     typedef MultiArrayNavigator<DestIterator, N> DNavigator;
-    
-    TmpAcessor acc;
+    typedef typename AccessorTraits<TmpType>::default_accessor TmpAccessor;
+
+    SrcIterator s;
+    Shape sstart, sstop;
+    SrcAccessor src;
+    DestIterator d;
+    Shape dstart, dstop;
+    DestAccessor dest;
+    Kernel const * kernel;
+    unsigned int dim, split;
+    int lstart, lstop, doffset, block_lines;
+
+    SeparableConvolveLinesFunctor(SrcIterator s_, Shape const & sstart_, Shape const & sstop_, SrcAccessor src_,
+                                  DestIterator d_, Shape const & dstart_, Shape const & dstop_, DestAccessor dest_,
+                                  Kernel const & kernel_, unsigned int dim_,
+                                  int lstart_ = 0, int lstop_ = 0, int doffset_ = 0)
+    : s(s_), sstart(sstart_), sstop(sstop_), src(src_),
+      d(d_), dstart(dstart_), dstop(dstop_), dest(dest_),
+      kernel(&kernel_), dim(dim_), split(separableConvolveSplitAxis(sstop_ - sstart_, dim_)),
+      lstart(lstart_), lstop(lstop_), doffset(doffset_), block_lines(1)
+    {}
 
+        // number of independent work items
+    MultiArrayIndex size() const
     {
-        // only operate on first dimension here
-        SNavigator snav( si, shape, 0 );
-        DNavigator dnav( di, shape, 0 );
-        
+        return split == dim
+                   ? 1
+                   : sstop[split] - sstart[split];
+    }
+
+    void operator()(MultiArrayIndex begin, MultiArrayIndex end) const
+    {
+        Shape ss(sstart), se(sstop), ds(dstart), de(dstop);
+        if(split != dim)
+        {
+            ss[split] = sstart[split] + begin;
+            se[split] = sstart[split] + end;
+            ds[split] = dstart[split] + begin;
+            de[split] = dstart[split] + end;
+        }
+
+        SNavigator snav( s, ss, se, dim );
+        DNavigator dnav( d, ds, de, dim );
+
+        if(dim == 0 || block_lines <= 1)
+            convolveLines(snav, dnav, se[dim] - ss[dim]);
+        else
+            convolveBlocks(snav, dnav, se[dim] - ss[dim]);
+    }
+
+    void convolveLines(SNavigator & snav, DNavigator & dnav, int size) const
+    {
+        // temporary array to hold the current line to enable in-place operation
+        ArrayVector<TmpType> tmp( size );
+        TmpAccessor acc;
+
         for( ; snav.hasMore(); snav++, dnav++ )
         {
              // first copy source to tmp for maximum cache efficiency
              copyLine(snav.begin(), snav.end(), src, tmp.begin(), acc);
 
              convolveLine(srcIterRange(tmp.begin(), tmp.end(), acc),
-                          destIter( dnav.begin(), dest ),
-                          kernel1d( *kit ) );
+                          destIter( dnav.begin() + doffset, dest ),
+                          kernel1d( *kernel ), lstart, lstop);
         }
-        ++kit;
     }
 
-    // operate on further dimensions
-    for( int d = 1; d < N; ++d, ++kit )
+    void convolveBlocks(SNavigator & snav, DNavigator & dnav, int size) const
     {
-        DNavigator dnav( di, shape, d );
-
-        tmp.resize( shape[d] );
+        typedef typename SNavigator::iterator SLineIterator;
+        typedef typename DNavigator::iterator DLineIterator;
+        typedef typename Kernel::value_type KernelValue;
+        typedef typename PromoteTraits<TmpType, KernelValue>::Promote SumType;
+        typedef MultiArrayView<1, TmpType, StridedArrayTag> LineView;
+
+        int kleft = kernel->left(), kright = kernel->right();
+        int symmetry = convolveLineSymmetry<TmpType>(kernel->center(), kernel->accessor(),
+                                                     kleft, kright);
+
+        // lines shorter than the kernel are reported by convolveLine(), and 
+        // BORDER_TREATMENT_AVOID must leave the borders of 'dest' untouched
+        if(size < std::max(kright, -kleft) + 1 || 
+           kernel->borderTreatment() == BORDER_TREATMENT_AVOID)
+        {
+            convolveLines(snav, dnav, size);
+            return;
+        }
 
-        for( ; dnav.hasMore(); dnav++ )
+        int start = lstart, 
+            stop  = lstop != 0
+                        ? lstop
+                        : size,
+            dsize = stop - start;
+        // range where the kernel fits completely into the line
+        int istart = std::min(std::max(start, kright), stop),
+            istop  = std::max(std::min(stop, size + kleft), istart);
+
+        ArrayVector<TmpType> in( block_lines*size ), out( block_lines*dsize );
+        ArrayVector<SumType> sum( block_lines );
+        ArrayVector<SLineIterator> slines( block_lines );
+        ArrayVector<DLineIterator> dlines( block_lines );
+        TmpAccessor acc;
+
+        while(snav.hasMore())
         {
-             // first copy source to tmp since convolveLine() cannot work in-place
-             copyLine(dnav.begin(), dnav.end(), dest, tmp.begin(), acc);
+            int count = 0;
+            for( ; count < block_lines && snav.hasMore(); ++count, snav++, dnav++ )
+            {
+                slines[count] = snav.begin();
+                dlines[count] = dnav.begin() + doffset;
+            }
 
-             convolveLine(srcIterRange(tmp.begin(), tmp.end(), acc),
-                          destIter( dnav.begin(), dest ),
-                          kernel1d( *kit ) );
+            // gather the block interleaved, i.e. in[k*count+l] is element k of line l
+            for(int k=0; k<size; ++k)
+                for(int l=0; l<count; ++l)
+                    in[k*count+l] = src(slines[l] + k);
+
+            // the borders are handled line by line
+            for(int l=0; l<count; ++l)
+            {
+                LineView lin(Shape1(size), Shape1(count), in.begin()+l),
+                         lout(Shape1(dsize), Shape1(count), out.begin()+l);
+                if(start < istart)
+                    convolveLine(srcIterRange(lin.traverser_begin(), lin.traverser_end(), acc),
+                                 destIter(lout.traverser_begin(), acc),
+                                 kernel1d( *kernel ), start, istart);
+                if(istop < stop)
+                    convolveLine(srcIterRange(lin.traverser_begin(), lin.traverser_end(), acc),
+                                 destIter(lout.traverser_begin() + (istop - start), acc),
+                                 kernel1d( *kernel ), istop, stop);
+            }
+
+            // in the interior, all lines of the block are convolved simultaneously
+            // (same order of summation as in convolveLine(), so that the results 
+            // are identical). The inner loops run over contiguous memory.
+            for(int x=istart; x<istop; ++x)
+            {
+                for(int l=0; l<count; ++l)
+                    sum[l] = NumericTraits<SumType>::zero();
+                if(symmetry == 0)
+                {
+                    for(int j=kright; j>=kleft; --j)
+                    {
+                        KernelValue kv = (*kernel)[j];
+                        TmpType const * p = in.begin() + (x-j)*count;
+                        for(int l=0; l<count; ++l)
+                            sum[l] += kv * p[l];
+                    }
+                }
+                else
+                {
+                    if(symmetry > 0)
+                    {
+                        KernelValue kv = (*kernel)[0];
+                        TmpType const * p = in.begin() + x*count;
+                        for(int l=0; l<count; ++l)
+                            sum[l] += kv * p[l];
+                    }
+                    for(int j=1; j<=kright; ++j)
+                    {
+                        KernelValue kv = (*kernel)[j];
+                        TmpType const * p = in.begin() + (x-j)*count;
+                        TmpType const * q = in.begin() + (x+j)*count;
+                        if(symmetry > 0)
+                            for(int l=0; l<count; ++l)
+                                sum[l] += kv * ((SumType)p[l] + (SumType)q[l]);
+                        else
+                            for(int l=0; l<count; ++l)
+                                sum[l] += kv * ((SumType)p[l] - (SumType)q[l]);
+                    }
+                }
+                TmpType * q = out.begin() + (x-start)*count;
+                for(int l=0; l<count; ++l)
+                    q[l] = detail::RequiresExplicitCast<TmpType>::cast(sum[l]);
+            }
+
+            // scatter the results
+            for(int k=0; k<dsize; ++k)
+                for(int l=0; l<count; ++l)
+                    dest.set(out[k*count+l], dlines[l] + k);
         }
     }
+};
+
+template <class SrcIterator, class Shape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class Kernel, class TmpType>
+inline void
+separableConvolveLines(SeparableConvolveLinesFunctor<SrcIterator, Shape, SrcAccessor,
+                                   DestIterator, DestAccessor, Kernel, TmpType> f,
+                       int nthreads, int blockLines)
+{
+    f.block_lines = blockLines;
+    parallelForChunks(f.size(), f, nthreads);
+}
+
+/********************************************************/
+/*                                                      */
+/*        internalSeparableConvolveMultiArray           */
+/*                                                      */
+/********************************************************/
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelIterator>
+void
+internalSeparableConvolveMultiArrayTmp(
+                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                      DestIterator di, DestAccessor dest, KernelIterator kit,
+                      int nthreads = 1, int blockLines = 1)
+{
+    enum { N = 1 + SrcIterator::level };
+
+    typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
+    typedef typename std::iterator_traits<KernelIterator>::value_type Kernel;
+
+    SrcShape zero;
+
+    // only operate on first dimension here
+    separableConvolveLines(
+        SeparableConvolveLinesFunctor<SrcIterator, SrcShape, SrcAccessor,
+                                      DestIterator, DestAccessor, Kernel, TmpType>(
+              si, zero, shape, src, di, zero, shape, dest, *kit, 0),
+        nthreads, blockLines);
+    ++kit;
+
+    // operate on further dimensions (in-place on the destination, 
+    // convolveLine() cannot work in-place, but the functor copies each line first)
+    for( int d = 1; d < N; ++d, ++kit )
+    {
+        separableConvolveLines(
+            SeparableConvolveLinesFunctor<DestIterator, SrcShape, DestAccessor,
+                                          DestIterator, DestAccessor, Kernel, TmpType>(
+                  di, zero, shape, dest, di, zero, shape, dest, *kit, d),
+            nthreads, blockLines);
+    }
 }
 
 /********************************************************/
@@ -562,7 +819,8 @@ void
 internalSeparableConvolveSubarray(
                       SrcIterator si, SrcShape const & shape, SrcAccessor src,
                       DestIterator di, DestAccessor dest, KernelIterator kit,
-                      SrcShape const & start, SrcShape const & stop)
+                      SrcShape const & start, SrcShape const & stop,
+                      int nthreads = 1, int blockLines = 1)
 {
     enum { N = 1 + SrcIterator::level };
 
@@ -570,6 +828,7 @@ internalSeparableConvolveSubarray(
     typedef MultiArray<N, TmpType> TmpArray;
     typedef typename TmpArray::traverser TmpIterator;
     typedef typename AccessorTraits<TmpType>::default_accessor TmpAcessor;
+    typedef typename std::iterator_traits<KernelIterator>::value_type Kernel;
     
     SrcShape sstart, sstop, axisorder, tmpshape;
     TinyVector<double, N> overhead;
@@ -592,52 +851,33 @@ internalSeparableConvolveSubarray(
     // temporary array to hold the current line to enable in-place operation
     MultiArray<N, TmpType> tmp(dstop);
 
-    typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
-    typedef MultiArrayNavigator<TmpIterator, N> TNavigator;
-    typedef MultiArrayNavigator<DestIterator, N> DNavigator;
-    
     TmpAcessor acc;
 
     {
         // only operate on first dimension here
-        SNavigator snav( si, sstart, sstop, axisorder[0]);
-        TNavigator tnav( tmp.traverser_begin(), dstart, dstop, axisorder[0]);
-        
-        ArrayVector<TmpType> tmpline(sstop[axisorder[0]] - sstart[axisorder[0]]);
-        
         int lstart = start[axisorder[0]] - sstart[axisorder[0]];
         int lstop  = lstart + (stop[axisorder[0]] - start[axisorder[0]]);
 
-        for( ; snav.hasMore(); snav++, tnav++ )
-        {
-            // first copy source to tmp for maximum cache efficiency
-            copyLine(snav.begin(), snav.end(), src, tmpline.begin(), acc);
-            
-            convolveLine(srcIterRange(tmpline.begin(), tmpline.end(), acc),
-                         destIter(tnav.begin(), acc),
-                         kernel1d( kit[axisorder[0]] ), lstart, lstop);
-        }
+        separableConvolveLines(
+            SeparableConvolveLinesFunctor<SrcIterator, SrcShape, SrcAccessor,
+                                          TmpIterator, TmpAcessor, Kernel, TmpType>(
+                  si, sstart, sstop, src, tmp.traverser_begin(), dstart, dstop, acc,
+                  kit[axisorder[0]], axisorder[0], lstart, lstop),
+            nthreads, blockLines);
     }
     
     // operate on further dimensions
     for( int d = 1; d < N; ++d)
     {
-        TNavigator tnav( tmp.traverser_begin(), dstart, dstop, axisorder[d]);
-        
-        ArrayVector<TmpType> tmpline(dstop[axisorder[d]] - dstart[axisorder[d]]);
-        
         int lstart = start[axisorder[d]] - sstart[axisorder[d]];
         int lstop  = lstart + (stop[axisorder[d]] - start[axisorder[d]]);
 
-        for( ; tnav.hasMore(); tnav++ )
-        {
-            // first copy source to tmp because convolveLine() cannot work in-place
-            copyLine(tnav.begin(), tnav.end(), acc, tmpline.begin(), acc );
-
-            convolveLine(srcIterRange(tmpline.begin(), tmpline.end(), acc),
-                         destIter( tnav.begin() + lstart, acc ),
-                         kernel1d( kit[axisorder[d]] ), lstart, lstop);
-        }
+        separableConvolveLines(
+            SeparableConvolveLinesFunctor<TmpIterator, SrcShape, TmpAcessor,
+                                          TmpIterator, TmpAcessor, Kernel, TmpType>(
+                  tmp.traverser_begin(), dstart, dstop, acc, tmp.traverser_begin(), dstart, dstop, acc,
+                  kit[axisorder[d]], axisorder[d], lstart, lstop, lstart),
+            nthreads, blockLines);
         
         dstart[axisorder[d]] = lstart;
         dstop[axisorder[d]] = lstop;
@@ -699,6 +939,11 @@ scaleKernel(K & kernel, double a)
     subarray, and it is assumed that the output array only refers to the
     subarray (i.e. <tt>diter</tt> points to the element corresponding to 
     <tt>start</tt>). 
+    
+    The lines of each pass can be processed by several threads in parallel 
+    when a \ref ConvolutionOptions object with <tt>numThreads()</tt> is passed
+    (the subarray is then taken from the options object as well). The result 
+    does not depend on the number of threads. 
 
     <b> Declarations:</b>
 
@@ -724,6 +969,15 @@ scaleKernel(K & kernel, double a)
                                     KernelIterator kernels,
                                     SrcShape const & start = SrcShape(),
                                     SrcShape const & stop = SrcShape());
+
+        // likewise, but take subarray and number of threads from the options object
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class DestIterator, class DestAccessor, class KernelIterator>
+        void
+        separableConvolveMultiArray(SrcIterator siter, SrcShape const & shape, SrcAccessor src,
+                                    DestIterator diter, DestAccessor dest,
+                                    KernelIterator kernels,
+                                    ConvolutionOptions<SrcShape::static_size> const & opt);
     }
     \endcode
 
@@ -749,6 +1003,15 @@ scaleKernel(K & kernel, double a)
                                     KernelIterator kernels,
                                     SrcShape const & start = SrcShape(),
                                     SrcShape const & stop = SrcShape());
+
+        // likewise, but take subarray and number of threads from the options object
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class DestIterator, class DestAccessor, class KernelIterator>
+        void
+        separableConvolveMultiArray(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                                    pair<DestIterator, DestAccessor> const & dest,
+                                    KernelIterator kernels,
+                                    ConvolutionOptions<SrcShape::static_size> const & opt);
     }
     \endcode
 
@@ -784,14 +1047,16 @@ scaleKernel(K & kernel, double a)
 */
 doxygen_overloaded_function(template <...> void separableConvolveMultiArray)
 
+namespace detail {
+
 template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class KernelIterator>
 void
-separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src,
-                             DestIterator d, DestAccessor dest, 
-                             KernelIterator kernels,
-                             SrcShape const & start = SrcShape(),
-                             SrcShape const & stop = SrcShape())
+separableConvolveMultiArrayImpl( SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                 DestIterator d, DestAccessor dest, 
+                                 KernelIterator kernels,
+                                 SrcShape const & start, SrcShape const & stop,
+                                 int nthreads, int blockLines)
 {
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
 
@@ -802,23 +1067,62 @@ separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor
             vigra_precondition(0 <= start[k] && start[k] < stop[k] && stop[k] <= shape[k],
               "separableConvolveMultiArray(): invalid subarray shape.");
 
-        detail::internalSeparableConvolveSubarray(s, shape, src, d, dest, kernels, start, stop);
+        detail::internalSeparableConvolveSubarray(s, shape, src, d, dest, kernels, start, stop, nthreads, blockLines);
     }
     else if(!IsSameType<TmpType, typename DestAccessor::value_type>::boolResult)
     {
         // need a temporary array to avoid rounding errors
         MultiArray<SrcShape::static_size, TmpType> tmpArray(shape);
         detail::internalSeparableConvolveMultiArrayTmp( s, shape, src,
-             tmpArray.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor(), kernels );
+             tmpArray.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor(), kernels, nthreads, blockLines );
         copyMultiArray(srcMultiArrayRange(tmpArray), destIter(d, dest));
     }
     else
     {
         // work directly on the destination array
-        detail::internalSeparableConvolveMultiArrayTmp( s, shape, src, d, dest, kernels );
+        detail::internalSeparableConvolveMultiArrayTmp( s, shape, src, d, dest, kernels, nthreads, blockLines );
     }
 }
 
+} // namespace detail
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelIterator>
+inline void
+separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                             DestIterator d, DestAccessor dest, 
+                             KernelIterator kernels,
+                             ConvolutionOptions<SrcShape::static_size> const & opt)
+{
+    detail::separableConvolveMultiArrayImpl(s, shape, src, d, dest, kernels, 
+                                            opt.from_point, opt.to_point, opt.num_threads, opt.block_lines);
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelIterator>
+inline void
+separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                             DestIterator d, DestAccessor dest, 
+                             KernelIterator kernels,
+                             SrcShape const & start = SrcShape(),
+                             SrcShape const & stop = SrcShape())
+{
+    separableConvolveMultiArray(s, shape, src, d, dest, kernels, 
+                                ConvolutionOptions<SrcShape::static_size>().subarray(start, stop));
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelIterator>
+inline void
+separableConvolveMultiArray(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                            pair<DestIterator, DestAccessor> const & dest, 
+                            KernelIterator kit,
+                            ConvolutionOptions<SrcShape::static_size> const & opt)
+{
+    separableConvolveMultiArray( source.first, source.second, source.third,
+                                 dest.first, dest.second, kit, opt );
+}
+
 template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class KernelIterator>
 inline
@@ -949,11 +1253,9 @@ convolveMultiArrayOneDimension(SrcIterator s, SrcShape const & shape, SrcAccesso
                         "than the data dimensionality" );
 
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
-    typedef typename AccessorTraits<TmpType>::default_const_accessor TmpAccessor;
-    ArrayVector<TmpType> tmp( shape[dim] );
-
-    typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
-    typedef MultiArrayNavigator<DestIterator, N> DNavigator;
+    typedef detail::SeparableConvolveLinesFunctor<SrcIterator, SrcShape, SrcAccessor,
+                                                  DestIterator, DestAccessor, 
+                                                  Kernel1D<T>, TmpType> LinesFunctor;
     
     SrcShape sstart, sstop(shape), dstart, dstop(shape);
     
@@ -966,19 +1268,10 @@ convolveMultiArrayOneDimension(SrcIterator s, SrcShape const & shape, SrcAccesso
         dstop = stop - start;
     }
 
-    SNavigator snav( s, sstart, sstop, dim );
-    DNavigator dnav( d, dstart, dstop, dim );
-
-    for( ; snav.hasMore(); snav++, dnav++ )
-    {
-         // first copy source to temp for maximum cache efficiency
-         copyLine( snav.begin(), snav.end(), src,
-           tmp.begin(), typename AccessorTraits<TmpType>::default_accessor() );
-
-         convolveLine(srcIterRange( tmp.begin(), tmp.end(), TmpAccessor()),
-                      destIter( dnav.begin(), dest ),
-                      kernel1d( kernel), start[dim], stop[dim]);
-    }
+    detail::separableConvolveLines(
+        LinesFunctor(s, sstart, sstop, src, d, dstart, dstop, dest, 
+                     kernel, dim, start[dim], stop[dim]),
+        1, ConvolutionOptions<N>().block_lines);
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -1091,7 +1384,7 @@ gaussianSmoothMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src
     for (int dim = 0; dim < N; ++dim, ++params)
         kernels[dim].initGaussian(params.sigma_scaled(function_name), 1.0, opt.window_ratio);
 
-    separableConvolveMultiArray(s, shape, src, d, dest, kernels.begin(), opt.from_point, opt.to_point);
+    separableConvolveMultiArray(s, shape, src, d, dest, kernels.begin(), opt);
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -1257,8 +1550,7 @@ gaussianGradientMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor s
         ArrayVector<Kernel1D<KernelType> > kernels(plain_kernels);
         kernels[dim].initGaussianDerivative(params2.sigma_scaled(), 1, 1.0, opt.window_ratio);
         detail::scaleKernel(kernels[dim], 1.0 / params2.step_size());
-        separableConvolveMultiArray(si, shape, src, di, ElementAccessor(dim, dest), kernels.begin(), 
-                                    opt.from_point, opt.to_point);
+        separableConvolveMultiArray(si, shape, src, di, ElementAccessor(dim, dest), kernels.begin(), opt);
     }
 }
 
@@ -1560,13 +1852,13 @@ laplacianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccesso
         if (dim == 0)
         {
             separableConvolveMultiArray( si, shape, src, 
-                                         di, dest, kernels.begin(), opt.from_point, opt.to_point);
+                                         di, dest, kernels.begin(), opt);
         }
         else
         {
             separableConvolveMultiArray( si, shape, src, 
                                          derivative.traverser_begin(), DerivativeAccessor(), 
-                                         kernels.begin(), opt.from_point, opt.to_point);
+                                         kernels.begin(), opt);
             combineTwoMultiArrays(di, dshape, dest, derivative.traverser_begin(), DerivativeAccessor(), 
                                   di, dest, Arg1() + Arg2() );
         }
@@ -1747,7 +2039,7 @@ hessianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor
             detail::scaleKernel(kernels[i], 1 / params_i.step_size());
             detail::scaleKernel(kernels[j], 1 / params_j.step_size());
             separableConvolveMultiArray(si, shape, src, di, ElementAccessor(b, dest),
-                                        kernels.begin(), opt.from_point, opt.to_point);
+                                        kernels.begin(), opt);
         }
     }
 }
@@ -227,6 +227,146 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
     internalSeparableMultiArrayDistTmp( si, shape, src, di, dest, sigmas, false );
 }
 
+/********************************************************/
+/*                                                      */
+/*           distParabola with feature output           */
+/*                                                      */
+/********************************************************/
+
+    // Same lower envelope computation as distParabola(), but each parabola
+    // additionally carries the feature (i.e. nearest seed coordinate) of the
+    // line position it originates from. The feature of the parabola realizing
+    // the minimum is written to 'fd' together with the squared distance.
+template <class SrcIterator, class FeatureSrcIterator,
+          class DestIterator, class FeatureDestIterator>
+void distParabolaWithFeatures(SrcIterator is, SrcIterator iend, FeatureSrcIterator fs,
+                              DestIterator id, FeatureDestIterator fd, double sigma)
+{
+    double w = iend - is;
+    double sigma2 = sigma * sigma;
+    double sigma22 = 2.0 * sigma2;
+
+    typedef DistParabolaStackEntry<double> Influence;
+    std::vector<Influence> _stack;
+    _stack.push_back(Influence(*is, 0.0, 0.0, w));
+
+    ++is;
+    double current = 1.0;
+    while(current < w )
+    {
+        Influence & s = _stack.back();
+        double diff = current - s.center;
+        double intersection = current + (*is - s.prevVal - sigma2*sq(diff)) / (sigma22 * diff);
+
+        if( intersection < s.left) // previous point has no influence
+        {
+            _stack.pop_back();
+            if(_stack.empty())
+            {
+                _stack.push_back(Influence(*is, 0.0, current, w));
+            }
+            else
+            {
+                continue; // try new top of stack without advancing current
+            }
+        }
+        else if(intersection < s.right)
+        {
+            s.right = intersection;
+            _stack.push_back(Influence(*is, intersection, current, w));
+        }
+        ++is;
+        ++current;
+    }
+
+    typename std::vector<Influence>::iterator it = _stack.begin();
+    for(current = 0.0; current < w; ++current, ++id, ++fd)
+    {
+        while( current >= it->right)
+            ++it;
+        *id = sigma2 * sq(current - it->center) + it->prevVal;
+        *fd = fs[(int)it->center];
+    }
+}
+
+/********************************************************/
+/*                                                      */
+/*         internalSeparableMultiFeatureTransform       */
+/*                                                      */
+/********************************************************/
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          unsigned int N, class Feature, class Array>
+void internalSeparableMultiFeatureTransform(
+                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                      MultiArrayView<N, double, UnstridedArrayTag> dist,
+                      MultiArrayView<N, Feature, UnstridedArrayTag> features,
+                      bool background, Array const & pixelPitch)
+{
+    typedef typename SrcAccessor::value_type SrcType;
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    SrcType zero = NumericTraits<SrcType>::zero();
+
+    // a value larger than any squared distance in the array plays the role of infinity
+    double maxDist = 0.0;
+    for(unsigned int k=0; k<N; ++k)
+        maxDist += sq(pixelPitch[k]*shape[k]);
+
+    using namespace vigra::functor;
+
+    if(background == true)
+        transformMultiArray( si, shape, src, dist.traverser_begin(), 
+                             typename AccessorTraits<double>::default_accessor(),
+                             ifThenElse( Arg1() == Param(zero), Param(maxDist), Param(0.0) ));
+    else
+        transformMultiArray( si, shape, src, dist.traverser_begin(), 
+                             typename AccessorTraits<double>::default_accessor(),
+                             ifThenElse( Arg1() != Param(zero), Param(maxDist), Param(0.0) ));
+
+    // initially, every point is its own feature
+    Shape p;
+    typename MultiArrayView<N, Feature, UnstridedArrayTag>::iterator f = features.begin(),
+                                                                    fend = features.end();
+    for(; f != fend; ++f)
+    {
+        *f = p;
+        for(unsigned int k=0; k<N; ++k)
+        {
+            if(++p[k] < shape[k])
+                break;
+            p[k] = 0;
+        }
+    }
+
+    typedef typename MultiArrayView<N, double, UnstridedArrayTag>::traverser DistTraverser;
+    typedef typename MultiArrayView<N, Feature, UnstridedArrayTag>::traverser FeatureTraverser;
+    typedef MultiArrayNavigator<DistTraverser, N> DNavigator;
+    typedef MultiArrayNavigator<FeatureTraverser, N> FNavigator;
+
+    ArrayVector<double> tmp;
+    ArrayVector<Feature> ftmp;
+
+    for(unsigned int d = 0; d < N; ++d)
+    {
+        DNavigator dnav(dist.traverser_begin(), shape, d);
+        FNavigator fnav(features.traverser_begin(), shape, d);
+
+        tmp.resize(shape[d]);
+        ftmp.resize(shape[d]);
+
+        for( ; dnav.hasMore(); dnav++, fnav++ )
+        {
+            // copy the current line to temp for in-place operation
+            std::copy(dnav.begin(), dnav.end(), tmp.begin());
+            std::copy(fnav.begin(), fnav.end(), ftmp.begin());
+
+            detail::distParabolaWithFeatures(tmp.begin(), tmp.end(), ftmp.begin(),
+                                             dnav.begin(), fnav.begin(), pixelPitch[d]);
+        }
+    }
+}
+
 } // namespace detail
 
 /** \addtogroup MultiArrayDistanceTransform Euclidean distance transform for multi-dimensional arrays.
@@ -552,6 +692,253 @@ inline void separableMultiDistance( triple<SrcIterator, SrcShape, SrcAccessor> c
                             dest.first, dest.second, background );
 }
 
+/********************************************************/
+/*                                                      */
+/*           separableMultiFeatureTransform             */
+/*                                                      */
+/********************************************************/
+
+/** \brief Euclidean feature transform on multi-dimensional arrays.
+
+    <b> Declarations:</b>
+
+    pass arguments explicitly:
+    \code
+    namespace vigra {
+        // compute distances and features, explicitly specify pixel pitch
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class DestIterator, class DestAccessor,
+                  class FeatureIterator, class FeatureAccessor, class Array>
+        void
+        separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                       DestIterator d, DestAccessor dest,
+                                       FeatureIterator f, FeatureAccessor feature,
+                                       bool background,
+                                       Array const & pixelPitch);
+
+        // compute distances and features, use pixel pitch = 1.0 for each coordinate
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class DestIterator, class DestAccessor,
+                  class FeatureIterator, class FeatureAccessor>
+        void
+        separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                       DestIterator d, DestAccessor dest,
+                                       FeatureIterator f, FeatureAccessor feature,
+                                       bool background);
+
+        // compute only the features, explicitly specify pixel pitch
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class FeatureIterator, class FeatureAccessor, class Array>
+        void
+        separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                       FeatureIterator f, FeatureAccessor feature,
+                                       bool background,
+                                       Array const & pixelPitch);
+
+        // compute only the features, use pixel pitch = 1.0 for each coordinate
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class FeatureIterator, class FeatureAccessor>
+        void
+        separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                       FeatureIterator f, FeatureAccessor feature,
+                                       bool background);
+    }
+    \endcode
+
+    use argument objects in conjunction with \ref ArgumentObjectFactories :
+    \code
+    namespace vigra {
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class DestIterator, class DestAccessor,
+                  class FeatureIterator, class FeatureAccessor, class Array>
+        void
+        separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                                       pair<DestIterator, DestAccessor> const & dest,
+                                       pair<FeatureIterator, FeatureAccessor> const & features,
+                                       bool background,
+                                       Array const & pixelPitch);
+
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class DestIterator, class DestAccessor,
+                  class FeatureIterator, class FeatureAccessor>
+        void
+        separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                                       pair<DestIterator, DestAccessor> const & dest,
+                                       pair<FeatureIterator, FeatureAccessor> const & features,
+                                       bool background);
+
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class FeatureIterator, class FeatureAccessor, class Array>
+        void
+        separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                                       pair<FeatureIterator, FeatureAccessor> const & features,
+                                       bool background,
+                                       Array const & pixelPitch);
+
+        template <class SrcIterator, class SrcShape, class SrcAccessor,
+                  class FeatureIterator, class FeatureAccessor>
+        void
+        separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                                       pair<FeatureIterator, FeatureAccessor> const & features,
+                                       bool background);
+    }
+    \endcode
+
+    In addition to the Euclidean distance computed by \ref separableMultiDistance(),
+    this function determines for every point the coordinate of the nearest
+    seed point (the <i>feature transform</i>). The seeds are the non-zero
+    elements of the source array if <i>background</i> is true, and the zero 
+    elements otherwise (i.e. the same points that get distance zero in
+    \ref separableMultiDistance()). When several seeds are equally close, one of 
+    them is chosen arbitrarily. If the array contains no seed at all, the 
+    resulting features are undefined.
+
+    The feature array's value_type must be constructible from 
+    <tt>MultiArrayShape<N>::type</tt>, e.g. <tt>TinyVector<int, N></tt>. 
+    The destination array (if given) receives the Euclidean distance to 
+    the seed stored in the feature array, and an optional pixel pitch is handled as in 
+    \ref separableMultiDistSquared(). Internally, the parabola pass of the 
+    distance transform simply carries the index of the minimizing parabola 
+    along, so that the cost is only slightly higher than that of the distance 
+    transform itself.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_distance.hxx\>
+
+    \code
+    MultiArray<3, unsigned int> labels(shape);    // labeled seeds, background is 0
+    MultiArray<3, TinyVector<int, 3> > nearest(shape);
+    ...
+
+    // find the nearest seed for each background point
+    separableMultiFeatureTransform(srcMultiArrayRange(labels), destMultiArray(nearest), true);
+    
+    // propagate the seed labels to obtain the Voronoi tesselation
+    for(int z=0; z<shape[2]; ++z)
+        for(int y=0; y<shape[1]; ++y)
+            for(int x=0; x<shape[0]; ++x)
+                labels(x,y,z) = labels[nearest(x,y,z)];
+    \endcode
+
+    \see vigra::separableMultiDistance(), vigra::seededRegionGrowing()
+*/
+doxygen_overloaded_function(template <...> void separableMultiFeatureTransform)
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class FeatureIterator, class FeatureAccessor, class Array>
+void separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                    DestIterator d, DestAccessor dest,
+                                    FeatureIterator f, FeatureAccessor feature,
+                                    bool background, Array const & pixelPitch)
+{
+    enum { N = SrcShape::static_size };
+    typedef typename FeatureAccessor::value_type Feature;
+
+    MultiArray<N, double> dist(shape);
+    MultiArray<N, Feature> features(shape);
+
+    detail::internalSeparableMultiFeatureTransform(s, shape, src, dist, features, 
+                                                   background, pixelPitch);
+
+    using namespace vigra::functor;
+    transformMultiArray(srcMultiArrayRange(dist), destIter(d, dest), sqrt(Arg1()));
+    copyMultiArray(srcMultiArrayRange(features), destIter(f, feature));
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class FeatureIterator, class FeatureAccessor>
+inline
+void separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                    DestIterator d, DestAccessor dest,
+                                    FeatureIterator f, FeatureAccessor feature,
+                                    bool background)
+{
+    ArrayVector<double> pixelPitch(shape.size(), 1.0);
+    separableMultiFeatureTransform(s, shape, src, d, dest, f, feature, background, pixelPitch);
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class FeatureIterator, class FeatureAccessor, class Array>
+void separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                    FeatureIterator f, FeatureAccessor feature,
+                                    bool background, Array const & pixelPitch)
+{
+    enum { N = SrcShape::static_size };
+    typedef typename FeatureAccessor::value_type Feature;
+
+    MultiArray<N, double> dist(shape);
+    MultiArray<N, Feature> features(shape);
+
+    detail::internalSeparableMultiFeatureTransform(s, shape, src, dist, features, 
+                                                   background, pixelPitch);
+
+    copyMultiArray(srcMultiArrayRange(features), destIter(f, feature));
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class FeatureIterator, class FeatureAccessor>
+inline
+void separableMultiFeatureTransform(SrcIterator s, SrcShape const & shape, SrcAccessor src,
+                                    FeatureIterator f, FeatureAccessor feature,
+                                    bool background)
+{
+    ArrayVector<double> pixelPitch(shape.size(), 1.0);
+    separableMultiFeatureTransform(s, shape, src, f, feature, background, pixelPitch);
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class FeatureIterator, class FeatureAccessor, class Array>
+inline void 
+separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                               pair<DestIterator, DestAccessor> const & dest,
+                               pair<FeatureIterator, FeatureAccessor> const & features,
+                               bool background, Array const & pixelPitch)
+{
+    separableMultiFeatureTransform(source.first, source.second, source.third,
+                                   dest.first, dest.second, features.first, features.second,
+                                   background, pixelPitch);
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class FeatureIterator, class FeatureAccessor>
+inline void 
+separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                               pair<DestIterator, DestAccessor> const & dest,
+                               pair<FeatureIterator, FeatureAccessor> const & features,
+                               bool background)
+{
+    separableMultiFeatureTransform(source.first, source.second, source.third,
+                                   dest.first, dest.second, features.first, features.second,
+                                   background);
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class FeatureIterator, class FeatureAccessor, class Array>
+inline void 
+separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                               pair<FeatureIterator, FeatureAccessor> const & features,
+                               bool background, Array const & pixelPitch)
+{
+    separableMultiFeatureTransform(source.first, source.second, source.third,
+                                   features.first, features.second, background, pixelPitch);
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class FeatureIterator, class FeatureAccessor>
+inline void 
+separableMultiFeatureTransform(triple<SrcIterator, SrcShape, SrcAccessor> const & source,
+                               pair<FeatureIterator, FeatureAccessor> const & features,
+                               bool background)
+{
+    separableMultiFeatureTransform(source.first, source.second, source.third,
+                                   features.first, features.second, background);
+}
+
 //@}
 
 } //-- namespace vigra
@@ -40,6 +40,11 @@
 #include "multi_array.hxx"
 #include "navigator.hxx"
 #include "copyimage.hxx"
+#include "parallel.hxx"
+#include "multi_convolution.hxx"
+#include <map>
+#include <vector>
+#include <string>
 
 namespace vigra {
 
@@ -364,6 +369,206 @@ fftwPlanExecute(fftwl_plan plan, FFTWComplex<long double> * in,  long double * o
     fftwl_execute_dft_c2r(plan, (fftwl_complex *)in, out);
 }
 
+    // FFTW can apply a plan to new arrays only if their alignment 
+    // is the same as during planning
+inline int fftwAlignmentOf(double * p)
+{
+    return fftw_alignment_of(p);
+}
+
+inline int fftwAlignmentOf(float * p)
+{
+    return fftwf_alignment_of(p);
+}
+
+inline int fftwAlignmentOf(long double * p)
+{
+    return fftwl_alignment_of(p);
+}
+
+inline bool fftwImportWisdom(double, char const * filename)
+{
+    return fftw_import_wisdom_from_filename(filename) != 0;
+}
+
+inline bool fftwImportWisdom(float, char const * filename)
+{
+    return fftwf_import_wisdom_from_filename(filename) != 0;
+}
+
+inline bool fftwImportWisdom(long double, char const * filename)
+{
+    return fftwl_import_wisdom_from_filename(filename) != 0;
+}
+
+inline bool fftwExportWisdom(double, char const * filename)
+{
+    return fftw_export_wisdom_to_filename(filename) != 0;
+}
+
+inline bool fftwExportWisdom(float, char const * filename)
+{
+    return fftwf_export_wisdom_to_filename(filename) != 0;
+}
+
+inline bool fftwExportWisdom(long double, char const * filename)
+{
+    return fftwl_export_wisdom_to_filename(filename) != 0;
+}
+
+#ifdef VIGRA_FFTW_THREADS
+
+inline void fftwPlanWithThreads(double, int nthreads)
+{
+    static bool initialized = (fftw_init_threads() != 0);
+    if(initialized)
+        fftw_plan_with_nthreads(nthreads);
+}
+
+inline void fftwPlanWithThreads(float, int nthreads)
+{
+    static bool initialized = (fftwf_init_threads() != 0);
+    if(initialized)
+        fftwf_plan_with_nthreads(nthreads);
+}
+
+inline void fftwPlanWithThreads(long double, int nthreads)
+{
+    static bool initialized = (fftwl_init_threads() != 0);
+    if(initialized)
+        fftwl_plan_with_nthreads(nthreads);
+}
+
+#else
+
+template <class Real>
+inline void fftwPlanWithThreads(Real, int)
+{}
+
+#endif // VIGRA_FFTW_THREADS
+
+    // number of threads for newly created plans (process-wide)
+inline int & fftwThreadCountSetting()
+{
+    static int nthreads = 1;
+    return nthreads;
+}
+
+    // FFTW's threads don't depend on OpenMP, so explicit requests are 
+    // honoured even without it
+inline int fftwPlannerThreadCount()
+{
+#ifdef VIGRA_FFTW_THREADS
+    int nthreads = fftwThreadCountSetting();
+    return nthreads > 0
+               ? nthreads
+               : parallelThreadCount(0);
+#else
+    return 1;
+#endif
+}
+
+    // Process-wide cache of FFTW plans. A plan is identified by the transform
+    // type, shape, memory layout, alignment, planner flags and thread count 
+    // and applied to new arrays with FFTW's new-array execute functions. 
+    // Plans are reference counted, so that clear() only destroys plans 
+    // which are not held by an FFTWPlan object. Since the FFTW planner is 
+    // not thread-safe, all accesses must be enclosed in 
+    // '#pragma omp critical (vigra_fftw_planner)'.
+template <class Real>
+class FFTWPlanCache
+{
+  public:
+    typedef typename FFTWReal2Complex<Real>::plan_type PlanType;
+    typedef std::vector<std::ptrdiff_t> Key;
+
+    static FFTWPlanCache & instance()
+    {
+        // deliberately never destroyed, so that FFTWPlan objects 
+        // with static storage duration can still release their plans
+        static FFTWPlanCache * cache = new FFTWPlanCache;
+        return *cache;
+    }
+
+    template <class Src, class Dest>
+    PlanType acquire(unsigned int N, int * shape,
+                     Src * in, int * instrides, int instep,
+                     Dest * out, int * outstrides, int outstep,
+                     int sign, unsigned int planner_flags)
+    {
+        int nthreads = fftwPlannerThreadCount();
+
+        Key key;
+        key.push_back(sizeof(Src));
+        key.push_back(sizeof(Dest));
+        key.push_back(sign);
+        key.push_back(planner_flags);
+        key.push_back(nthreads);
+        key.push_back((void*)in == (void*)out);
+        key.push_back(fftwAlignmentOf((Real*)in));
+        key.push_back(fftwAlignmentOf((Real*)out));
+        key.push_back(instep);
+        key.push_back(outstep);
+        key.insert(key.end(), shape, shape + N);
+        key.insert(key.end(), instrides, instrides + N);
+        key.insert(key.end(), outstrides, outstrides + N);
+
+        typename std::map<Key, PlanType>::iterator i = plans_.find(key);
+        PlanType plan = 0;
+        if(i != plans_.end())
+        {
+            plan = i->second;
+        }
+        else
+        {
+            fftwPlanWithThreads(Real(), nthreads);
+            plan = fftwPlanCreate(N, shape, in, instrides, instep,
+                                  out, outstrides, outstep, sign, planner_flags);
+            if(plan == 0)
+                return 0;
+            plans_[key] = plan;
+        }
+        ++references_[plan];
+        return plan;
+    }
+
+    void release(PlanType plan)
+    {
+        if(plan == 0)
+            return;
+        typename std::map<PlanType, int>::iterator i = references_.find(plan);
+        if(i != references_.end() && i->second > 0)
+            --i->second;
+    }
+
+    void clear()
+    {
+        typename std::map<Key, PlanType>::iterator i = plans_.begin();
+        while(i != plans_.end())
+        {
+            if(references_[i->second] == 0)
+            {
+                references_.erase(i->second);
+                fftwPlanDestroy(i->second);
+                plans_.erase(i++);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    int size() const
+    {
+        return plans_.size();
+    }
+
+  private:
+    std::map<Key, PlanType> plans_;
+    std::map<PlanType, int> references_;
+};
+
 inline 
 int fftwPaddingSize(int s)
 {
@@ -763,6 +968,124 @@ fftwCorrespondingShapeC2R(TinyVector<T, N> shape, bool oddDimension0 = false)
     return shape;
 }
 
+/********************************************************/
+/*                                                      */
+/*                  FFTW plans and wisdom               */
+/*                                                      */
+/********************************************************/
+
+/** \brief Set the number of threads used by FFT plans created from now on.
+
+    When VIGRA is compiled with <tt>VIGRA_FFTW_THREADS</tt> defined (which requires
+    linking against <tt>libfftw3_threads</tt> or <tt>libfftw3_omp</tt>, and the
+    corresponding <tt>float</tt> and <tt>long double</tt> variants if needed), subsequently
+    created \ref FFTWPlan and \ref FFTWConvolvePlan objects (and thus \ref fourierTransform() 
+    and \ref convolveFFT()) execute each transform with <tt>nthreads</tt> threads 
+    (see <a href="http://www.fftw.org/doc/Multi_002dthreaded-FFTW.html">multi-threaded FFTW</a>).
+    As usual, <tt>nthreads = 0</tt> refers to all available threads (see \ref parallelThreadCount()). 
+    Without <tt>VIGRA_FFTW_THREADS</tt>, all transforms are single-threaded. The default is 1.
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\>
+*/
+inline void fftwSetThreadCount(int nthreads)
+{
+    #pragma omp critical (vigra_fftw_planner)
+    {
+        detail::fftwThreadCountSetting() = nthreads;
+    }
+}
+
+/** \brief Get the number of threads for FFT plans (see \ref fftwSetThreadCount()).
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\>
+*/
+inline int fftwThreadCount()
+{
+    int res;
+    #pragma omp critical (vigra_fftw_planner)
+    {
+        res = detail::fftwPlannerThreadCount();
+    }
+    return res;
+}
+
+/** \brief Load FFTW <a href="http://www.fftw.org/doc/Wisdom.html">wisdom</a> from a file.
+
+    Accumulated wisdom allows the planner to immediately create optimal plans, even
+    with planner flags like <tt>FFTW_MEASURE</tt> or <tt>FFTW_PATIENT</tt>. The template 
+    parameter selects the FFTW library (<tt>double</tt>, <tt>float</tt>, or <tt>long double</tt>).
+    Returns <tt>false</tt> when the file cannot be read.
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\>
+
+    \code
+    fftwImportWisdom<double>("fftw.wisdom");
+    ... // compute transforms with FFTW_MEASURE
+    fftwExportWisdom<double>("fftw.wisdom");
+    \endcode
+*/
+template <class Real>
+bool fftwImportWisdom(std::string const & filename)
+{
+    bool res;
+    #pragma omp critical (vigra_fftw_planner)
+    {
+        res = detail::fftwImportWisdom(Real(), filename.c_str());
+    }
+    return res;
+}
+
+/** \brief Save the FFTW <a href="http://www.fftw.org/doc/Wisdom.html">wisdom</a> accumulated so far.
+
+    See \ref fftwImportWisdom() for details. Returns <tt>false</tt> when the file cannot be written.
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\>
+*/
+template <class Real>
+bool fftwExportWisdom(std::string const & filename)
+{
+    bool res;
+    #pragma omp critical (vigra_fftw_planner)
+    {
+        res = detail::fftwExportWisdom(Real(), filename.c_str());
+    }
+    return res;
+}
+
+/** \brief Destroy the cached FFTW plans of the given precision.
+
+    All plans created by \ref FFTWPlan (and thus by the FFT and convolution functions)
+    are cached, so that subsequent transforms of the same kind don't have to run the
+    planner again. This function destroys all cached plans which are not currently 
+    used by an \ref FFTWPlan object. The template parameter selects the precision 
+    (<tt>double</tt>, <tt>float</tt>, or <tt>long double</tt>).
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\>
+*/
+template <class Real>
+void fftwClearPlanCache()
+{
+    #pragma omp critical (vigra_fftw_planner)
+    {
+        detail::FFTWPlanCache<Real>::instance().clear();
+    }
+}
+
+/** \brief Number of cached FFTW plans of the given precision (see \ref fftwClearPlanCache()).
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\>
+*/
+template <class Real>
+int fftwPlanCacheSize()
+{
+    int res;
+    #pragma omp critical (vigra_fftw_planner)
+    {
+        res = detail::FFTWPlanCache<Real>::instance().size();
+    }
+    return res;
+}
+
 /********************************************************/
 /*                                                      */
 /*                       FFTWPlan                       */
@@ -780,6 +1103,11 @@ fftwCorrespondingShapeC2R(TinyVector<T, N> shape, bool oddDimension0 = false)
     about FFTW's planning process (by providing non-default planning flags) and/or want to re-use
     plans for several transformations.
     
+    The underlying FFTW plans are taken from a process-wide cache: when a plan for the same 
+    transform type, shape, memory layout, alignment, planner flags, and thread count 
+    (see \ref fftwSetThreadCount()) has been created before, it is reused instead of 
+    running the FFTW planner again. Plans can be created concurrently from several threads.
+    
     <b> Usage:</b>
 
     <b>\#include</b> \<vigra/multi_fft.hxx\><br>
@@ -893,6 +1221,10 @@ class FFTWPlan
         if(this != &other)
         {
             FFTWPlan & o = const_cast<FFTWPlan &>(other);
+            #pragma omp critical (vigra_fftw_planner)
+            {
+                detail::FFTWPlanCache<Real>::instance().release(plan);
+            }
             plan = o.plan;
             shape.swap(o.shape);
             instrides.swap(o.instrides);
@@ -907,7 +1239,10 @@ class FFTWPlan
         */
     ~FFTWPlan()
     {
-        detail::fftwPlanDestroy(plan);
+        #pragma omp critical (vigra_fftw_planner)
+        {
+            detail::FFTWPlanCache<Real>::instance().release(plan);
+        }
     }
 
         /** \brief Init a complex-to-complex transform.
@@ -1059,11 +1394,16 @@ FFTWPlan<N, Real>::initImpl(MI ins, MO outs, int SIGN, unsigned int planner_flag
         ototal[j] = outs.stride(j-1) / outs.stride(j);
     }
     
-    PlanType newPlan = detail::fftwPlanCreate(N, newShape.begin(), 
-                                  ins.data(), itotal.begin(), ins.stride(N-1),
-                                  outs.data(), ototal.begin(), outs.stride(N-1),
-                                  SIGN, planner_flags);
-    detail::fftwPlanDestroy(plan);
+    PlanType newPlan;
+    #pragma omp critical (vigra_fftw_planner)
+    {
+        detail::FFTWPlanCache<Real> & cache = detail::FFTWPlanCache<Real>::instance();
+        newPlan = cache.acquire(N, newShape.begin(), 
+                                ins.data(), itotal.begin(), ins.stride(N-1),
+                                outs.data(), ototal.begin(), outs.stride(N-1),
+                                SIGN, planner_flags);
+        cache.release(plan);
+    }
     plan = newPlan;
     shape.swap(newShape);
     instrides.swap(newIStrides);
@@ -1467,7 +1807,34 @@ class FFTWConvolvePlan
         executeManyImpl(in, kernels, kernelsEnd, outs, UseFourierKernel());
     }
 
+        /** \brief Execute a plan to convolve a sequence of real arrays with the same kernel.
+         
+            The kernel (defined in the spatial domain) is transformed only once, and its 
+            spectrum is reused for all arrays <tt>[ins, insEnd)</tt>. The results are written 
+            to the sequence starting at <tt>outs</tt>. All arrays must have the shape the plan 
+            was created for, and both iterators must be random access iterators. The arrays 
+            are distributed over <tt>nthreads</tt> threads (see \ref parallelForChunks()).
+        */
+    template <class InIterator, class C2, class OutIterator>
+    void executeBatch(InIterator ins, InIterator insEnd,
+                      MultiArrayView<N, Real, C2> kernel,
+                      OutIterator outs, int nthreads = 1);
+                     
+        /** \brief Execute a plan to convolve a sequence of real arrays with the same 
+                   Fourier domain kernel (in half-space format).
+         
+            See the previous function for details.
+        */
+    template <class InIterator, class C2, class OutIterator>
+    void executeBatch(InIterator ins, InIterator insEnd,
+                      MultiArrayView<N, FFTWComplex<Real>, C2> kernel,
+                      OutIterator outs, int nthreads = 1);
+
   private:
+
+    template <class InIterator, class OutIterator>
+    void executeBatchImpl(InIterator ins, InIterator insEnd,
+                          OutIterator outs, Shape const & paddedShape, int nthreads);
   
     template <class KernelIterator, class OutIterator>
     Shape checkShapes(Shape in, 
@@ -1817,8 +2184,118 @@ FFTWConvolvePlan<N, Real>::executeMany(MultiArrayView<N, FFTWComplex<Real>, C1>
     }
 }
 
+template <unsigned int N, class Real>
+template <class InIterator, class C2, class OutIterator>
+void 
+FFTWConvolvePlan<N, Real>::executeBatch(InIterator ins, InIterator insEnd,
+                                        MultiArrayView<N, Real, C2> kernel,
+                                        OutIterator outs, int nthreads)
+{
+    vigra_precondition(!useFourierKernel,
+       "FFTWConvolvePlan::executeBatch(): plan was generated for Fourier kernel, got spatial kernel.");
+    vigra_precondition(ins != insEnd,
+       "FFTWConvolvePlan::executeBatch(): empty input sequence.");
+
+    Shape paddedShape = fftwBestPaddedShapeR2C(ins->shape() + kernel.shape() - Shape(1));
+    vigra_precondition(paddedShape == realArray.shape(),
+       "FFTWConvolvePlan::executeBatch(): shape mismatch between input and plan.");
+
+    detail::fftEmbedKernel(kernel, realKernel);
+    forward_plan.execute(realKernel, fourierKernel);
+    
+    executeBatchImpl(ins, insEnd, outs, paddedShape, nthreads);
+}
+
+template <unsigned int N, class Real>
+template <class InIterator, class C2, class OutIterator>
+void 
+FFTWConvolvePlan<N, Real>::executeBatch(InIterator ins, InIterator insEnd,
+                                        MultiArrayView<N, FFTWComplex<Real>, C2> kernel,
+                                        OutIterator outs, int nthreads)
+{
+    vigra_precondition(useFourierKernel,
+       "FFTWConvolvePlan::executeBatch(): plan was generated for spatial kernel, got Fourier kernel.");
+    vigra_precondition(ins != insEnd,
+       "FFTWConvolvePlan::executeBatch(): empty input sequence.");
+    vigra_precondition(kernel.shape() == fourierArray.shape(),
+       "FFTWConvolvePlan::executeBatch(): shape mismatch between kernel and plan.");
+
+    Shape paddedShape = fftwCorrespondingShapeC2R(kernel.shape(), odd(ins->shape(0)));
+    vigra_precondition(paddedShape == realArray.shape(),
+       "FFTWConvolvePlan::executeBatch(): shape mismatch between input and plan.");
+
+    fourierKernel = kernel;
+    moveDCToHalfspaceUpperLeft(fourierKernel);
+
+    executeBatchImpl(ins, insEnd, outs, paddedShape, nthreads);
+}
+
 #endif // DOXYGEN
 
+namespace detail {
+
+    // convolve the arrays [begin, end) with the spectrum 'fourierKernel', 
+    // each chunk uses its own (aligned) work array
+template <unsigned int N, class Real, class InIterator, class OutIterator>
+struct FFTWConvolveBatchFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef FFTWComplex<Real> Complex;
+    typedef MultiArrayView<N, Real, UnstridedArrayTag >     RArray;
+    typedef MultiArray<N, Complex, FFTWAllocator<Complex> > CArray;
+
+    FFTWPlan<N, Real> const & forward_plan;
+    FFTWPlan<N, Real> const & backward_plan;
+    CArray const & fourierKernel;
+    Shape const & paddedShape;
+    Shape const & realStrides;
+    InIterator ins;
+    OutIterator outs;
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        CArray fourierArray(fourierKernel.shape());
+        RArray realArray(paddedShape, realStrides, (Real*)fourierArray.data());
+
+        for(; begin < end; ++begin)
+        {
+            Shape shape = ins[begin].shape(),
+                  left = div(paddedShape - shape, MultiArrayIndex(2)),
+                  right = shape + left;
+
+            detail::fftEmbedArray(ins[begin], realArray);
+            forward_plan.execute(realArray, fourierArray);
+            fourierArray *= fourierKernel;
+            backward_plan.execute(fourierArray, realArray);
+            outs[begin] = realArray.subarray(left, right);
+        }
+    }
+};
+
+} // namespace detail
+
+template <unsigned int N, class Real>
+template <class InIterator, class OutIterator>
+void 
+FFTWConvolvePlan<N, Real>::executeBatchImpl(InIterator ins, InIterator insEnd,
+                                            OutIterator outs, Shape const & paddedShape, 
+                                            int nthreads)
+{
+    std::ptrdiff_t count = insEnd - ins;
+    for(std::ptrdiff_t k=0; k<count; ++k)
+    {
+        vigra_precondition(ins[k].shape() == ins->shape(),
+           "FFTWConvolvePlan::executeBatch(): all inputs must have the same shape.");
+        vigra_precondition(ins[k].shape() == outs[k].shape(),
+           "FFTWConvolvePlan::executeBatch(): shape mismatch between input and (one) output.");
+    }
+
+    Shape realStrides = realArray.stride();
+    detail::FFTWConvolveBatchFunctor<N, Real, InIterator, OutIterator> 
+        f = { forward_plan, backward_plan, fourierKernel, paddedShape, realStrides, ins, outs };
+    parallelForChunks(count, f, nthreads);
+}
+
 template <unsigned int N, class Real>
 template <class KernelIterator, class OutIterator>
 typename FFTWConvolvePlan<N, Real>::Shape 
@@ -1996,6 +2473,19 @@ fourierTransformInverse(MultiArrayView<N, FFTWComplex<Real>, C1> in,
                             (using an iterator pair specifying the kernel sequence). 
                             This has the advantage that the forward transform of the input array needs 
                             to be executed only once.
+        <DT><b>convolveFFTBatch</b><DD> Like <tt>convolveFFT</tt>, but you may provide many input arrays 
+                            (of the same shape) at once, using an iterator pair. This has the advantage that 
+                            the kernel needs to be transformed only once. The arrays can be processed
+                            in parallel.
+        <DT><b>convolveFFTBlockwise</b><DD> Like <tt>convolveFFT</tt>, but the input is split into
+                            blocks of FFT-friendly size which are transformed separately 
+                            (overlap-save method) and can be processed in parallel. 
+                            This needs much less memory for large arrays and is usually faster 
+                            when the kernel is much smaller than the input.
+        <DT><b>separableConvolveAuto</b><DD> Convolve a real-valued input array with a separable kernel, 
+                            given as a sequence of 1D kernels. Depending on the kernel size, the 
+                            computation is either performed in the spatial domain (by means of 
+                            \ref separableConvolveMultiArray()) or by <tt>convolveFFTBlockwise</tt>.
         <DT><b>convolveFFTComplex</b><DD> Convolve a complex-valued input array with a complex-valued kernel, 
                             resulting in a complex-valued output array. An additional flag is used to 
                             specify whether the kernel is defined in the spatial or frequency domain.
@@ -2049,8 +2539,19 @@ fourierTransformInverse(MultiArrayView<N, FFTWComplex<Real>, C1> in,
     
     The Fourier transform functions internally create <a href="http://www.fftw.org/doc/Using-Plans.html">FFTW plans</a>
     which control the algorithm details. The plans are creates with the flag <tt>FFTW_ESTIMATE</tt>, i.e.
-    optimal settings are guessed or read from saved "wisdom" files. If you need more control over planning,
-    you can use the class \ref FFTWConvolvePlan.
+    optimal settings are guessed or read from saved "wisdom" files (see \ref fftwImportWisdom()). 
+    Plans are cached, so that repeated calls with arrays of the same shape don't run the planner again.
+    
+    All real-valued convolution functions treat the array borders by reflection (like 
+    <tt>BORDER_TREATMENT_REFLECT</tt>), and the kernel center is at index <tt>kernel.shape() / 2</tt>.
+    <tt>convolveFFT</tt> transforms the entire (padded) input at once, so that the memory for the 
+    temporary arrays grows with the size of the input. <tt>convolveFFTBlockwise</tt> instead computes
+    the result block by block with the overlap-save method: each block plus a margin of 
+    <tt>kernel.shape() - 1</tt> pixels is copied into a work array of FFT-friendly size, multiplied with 
+    the kernel spectrum (which is computed only once), and transformed back. Only one work array per 
+    thread is needed, and the results are identical to <tt>convolveFFT</tt> up to round-off.
+    The number of threads per transform can be set with \ref fftwSetThreadCount(). 
+    If you need more control over planning, you can use the class \ref FFTWConvolvePlan.
     
     See also \ref applyFourierFilter() for corresponding functionality on the basis of the
     old image iterator interface.
@@ -2092,6 +2593,56 @@ fourierTransformInverse(MultiArrayView<N, FFTWComplex<Real>, C1> in,
     }
     \endcode
 
+    Series of real-valued convolutions of many arrays with the same kernel in the spatial or 
+    Fourier domain (the input and out sequences must have the same length and random access
+    iterators, the arrays are distributed over <tt>nthreads</tt> threads):
+    \code
+    namespace vigra {
+        template <unsigned int N, class Real, 
+                  class InIterator, class C2, class OutIterator>
+        void 
+        convolveFFTBatch(InIterator ins, InIterator insEnd, 
+                         MultiArrayView<N, Real, C2> kernel,
+                         OutIterator outs, int nthreads = 1);
+
+        template <unsigned int N, class Real, 
+                  class InIterator, class C2, class OutIterator>
+        void 
+        convolveFFTBatch(InIterator ins, InIterator insEnd, 
+                         MultiArrayView<N, FFTWComplex<Real>, C2> kernel,
+                         OutIterator outs, int nthreads = 1);
+    }
+    \endcode
+
+    Blockwise real-valued convolution (<tt>blockShape</tt> is the minimal size of the 
+    blocks, which is enlarged to the next FFT-friendly size; the default chooses the block 
+    size according to the kernel size. The blocks are distributed over <tt>nthreads</tt> 
+    threads):
+    \code
+    namespace vigra {
+        template <unsigned int N, class Real, class C1, class C2, class C3>
+        void 
+        convolveFFTBlockwise(MultiArrayView<N, Real, C1> in, 
+                             MultiArrayView<N, Real, C2> kernel,
+                             MultiArrayView<N, Real, C3> out,
+                             typename MultiArrayShape<N>::type blockShape = typename MultiArrayShape<N>::type(),
+                             int nthreads = 1);
+    }
+    \endcode
+
+    Real-valued convolution with a separable kernel (the sequence <tt>kernels</tt> must 
+    contain N 1D kernels, e.g. <tt>Kernel1D<double></tt>, their border treatment is ignored):
+    \code
+    namespace vigra {
+        template <unsigned int N, class Real, class C1, class KernelIterator, class C3>
+        void 
+        separableConvolveAuto(MultiArrayView<N, Real, C1> in, 
+                              KernelIterator kernels,
+                              MultiArrayView<N, Real, C3> out,
+                              int nthreads = 1);
+    }
+    \endcode
+
     Complex-valued convolution (parameter <tt>fourierDomainKernel</tt> determines if
     the kernel is defined in the spatial or Fourier domain):
     \code
@@ -2149,6 +2700,18 @@ fourierTransformInverse(MultiArrayView<N, FFTWComplex<Real>, C1> in,
             fourier_kernel(x, y) = exp(-0.5*sq(x / double(w))) * exp(-0.5*sq((y-y0)/double(h)));
 
     convolveFFT(src, fourier_kernel, dest);
+    
+    // convolve a large array with a non-separable kernel in blocks, using 4 threads
+    MultiArray<2, double> large_src(Shape2(30000, 30000)), large_dest(large_src.shape()),
+                          large_kernel(Shape2(101, 101));
+    ...
+    convolveFFTBlockwise(large_src, large_kernel, large_dest, Shape2(), 4);
+    
+    // Gaussian smoothing in the spatial domain (small sigma) or by blockwise FFT (large sigma)
+    Kernel1D<double> gauss1d;
+    gauss1d.initGaussian(sigma);
+    ArrayVector<Kernel1D<double> > kernels(2, gauss1d);
+    separableConvolveAuto(src, kernels.begin(), dest);
     \endcode
 */
 doxygen_overloaded_function(template <...> void convolveFFT)
@@ -2205,6 +2768,291 @@ convolveFFTMany(MultiArrayView<N, Real, C1> in,
     plan.executeMany(in, kernels, kernelsEnd, outs);
 }
 
+/** \brief Convolve a sequence of real-valued arrays with the same kernel by means of the Fourier transform.
+
+    See \ref convolveFFT() for details.
+*/
+doxygen_overloaded_function(template <...> void convolveFFTBatch)
+
+template <unsigned int N, class Real, 
+          class InIterator, class C2, class OutIterator>
+void 
+convolveFFTBatch(InIterator ins, InIterator insEnd, 
+                 MultiArrayView<N, Real, C2> kernel,
+                 OutIterator outs, int nthreads = 1)
+{
+    vigra_precondition(ins != insEnd,
+       "convolveFFTBatch(): empty input sequence.");
+    FFTWConvolvePlan<N, Real> plan;
+    plan.init(ins->shape(), kernel.shape());
+    plan.executeBatch(ins, insEnd, kernel, outs, nthreads);
+}
+
+template <unsigned int N, class Real, 
+          class InIterator, class C2, class OutIterator>
+void 
+convolveFFTBatch(InIterator ins, InIterator insEnd, 
+                 MultiArrayView<N, FFTWComplex<Real>, C2> kernel,
+                 OutIterator outs, int nthreads = 1)
+{
+    vigra_precondition(ins != insEnd,
+       "convolveFFTBatch(): empty input sequence.");
+    FFTWConvolvePlan<N, Real> plan;
+    plan.initFourierKernel(ins->shape(), kernel.shape());
+    plan.executeBatch(ins, insEnd, kernel, outs, nthreads);
+}
+
+namespace detail {
+
+    // mirror an index into [0, n), consistent with fftEmbedArray()
+    // and BORDER_TREATMENT_REFLECT
+inline MultiArrayIndex
+fftReflectIndex(MultiArrayIndex i, MultiArrayIndex n)
+{
+    if(n == 1)
+        return 0;
+    MultiArrayIndex period = 2*n - 2;
+    if(i < 0)
+        i = -i;
+    i %= period;
+    return i < n
+               ? i
+               : period - i;
+}
+
+    // copy the source elements index[0][i0], index[1][i1], ... to dest(i0, i1, ...)
+template <int K>
+struct FFTGatherArray
+{
+    template <class T1, class T2, class Shape>
+    static void exec(T1 const * src, Shape const & sstride, 
+                     T2 * dest, Shape const & dstride,
+                     ArrayVector<MultiArrayIndex> const * index)
+    {
+        int size = index[K].size();
+        for(int k=0; k<size; ++k)
+            FFTGatherArray<K-1>::exec(src + index[K][k]*sstride[K], sstride,
+                                      dest + k*dstride[K], dstride, index);
+    }
+};
+
+template <>
+struct FFTGatherArray<0>
+{
+    template <class T1, class T2, class Shape>
+    static void exec(T1 const * src, Shape const & sstride, 
+                     T2 * dest, Shape const & dstride,
+                     ArrayVector<MultiArrayIndex> const * index)
+    {
+        int size = index[0].size();
+        for(int k=0; k<size; ++k)
+            dest[k*dstride[0]] = src[index[0][k]*sstride[0]];
+    }
+};
+
+    // padded shape of the blocks for convolveFFTBlockwise(): by default, blocks are
+    // about 4 times the kernel size (but at least 64), and never larger than needed 
+    // for the entire input
+template <class Shape>
+Shape
+fftwBlockPaddedShape(Shape const & in, Shape const & kernel, Shape const & block)
+{
+    Shape padded;
+    for(unsigned int k=0; k<Shape::static_size; ++k)
+    {
+        padded[k] = block[k] > 0
+                        ? block[k] + kernel[k] - 1
+                        : std::max<MultiArrayIndex>(4*kernel[k], 64);
+        padded[k] = std::min<MultiArrayIndex>(padded[k], in[k] + kernel[k] - 1);
+    }
+    return fftwBestPaddedShapeR2C(padded);
+}
+
+    // estimate if spatial separable convolution needs fewer operations than 
+    // blockwise FFT (2 real transforms at about 2.5*log2(size) operations per 
+    // element, plus the complex product, inflated by the block overlap) 
+template <class Shape>
+bool
+preferSpatialConvolution(Shape const & in, Shape const & kernel, Shape const & padded)
+{
+    double spatial = 0.0, 
+           paddedSize = prod(padded),
+           blockSize = prod(padded - kernel + Shape(1));
+    for(unsigned int k=0; k<Shape::static_size; ++k)
+    {
+        // the spatial implementation needs lines longer than the kernel radius
+        if(in[k] <= kernel[k] / 2)
+            return false;
+        spatial += 2.0*kernel[k];
+    }
+    double fft = paddedSize / blockSize * (5.0*std::log(paddedSize)/std::log(2.0) + 3.0);
+    return spatial <= fft;
+}
+
+    // convolve the blocks [begin, end) of 'in' (numbered in scan order) by means 
+    // of the overlap-save method, each chunk uses its own (aligned) work array
+template <unsigned int N, class Real, class C1, class C3>
+struct FFTWConvolveBlockFunctor
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef FFTWComplex<Real> Complex;
+    typedef MultiArrayView<N, Real, UnstridedArrayTag >     RArray;
+    typedef MultiArray<N, Complex, FFTWAllocator<Complex> > CArray;
+
+    FFTWPlan<N, Real> const & forward_plan;
+    FFTWPlan<N, Real> const & backward_plan;
+    CArray const & fourierKernel;
+    MultiArrayView<N, Real, C1> const & in;
+    MultiArrayView<N, Real, C3> const & out;
+    Shape const & paddedShape;
+    Shape const & realStrides;
+    Shape const & blockShape;
+    Shape const & blockCount;
+    Shape const & leftBorder;
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        CArray fourierArray(fourierKernel.shape());
+        RArray realArray(paddedShape, realStrides, (Real*)fourierArray.data());
+        ArrayVector<MultiArrayIndex> index[N];
+
+        for(; begin < end; ++begin)
+        {
+            Shape blockStart, blockEnd;
+            std::ptrdiff_t b = begin;
+            for(unsigned int k=0; k<N; ++k)
+            {
+                blockStart[k] = (b % blockCount[k]) * blockShape[k];
+                blockEnd[k] = std::min(blockStart[k] + blockShape[k], in.shape(k));
+                b /= blockCount[k];
+
+                MultiArrayIndex origin = blockStart[k] - leftBorder[k];
+                index[k].resize(paddedShape[k]);
+                for(int i=0; i<paddedShape[k]; ++i)
+                    index[k][i] = fftReflectIndex(origin + i, in.shape(k));
+            }
+
+            FFTGatherArray<(int)N-1>::exec(in.data(), in.stride(), 
+                                           realArray.data(), realArray.stride(), index);
+            forward_plan.execute(realArray, fourierArray);
+            fourierArray *= fourierKernel;
+            backward_plan.execute(fourierArray, realArray);
+            out.subarray(blockStart, blockEnd) = 
+                realArray.subarray(leftBorder, leftBorder + blockEnd - blockStart);
+        }
+    }
+};
+
+} // namespace detail
+
+/** \brief Convolve a real-valued array in blocks by means of the Fourier transform (overlap-save method).
+
+    See \ref convolveFFT() for details.
+*/
+doxygen_overloaded_function(template <...> void convolveFFTBlockwise)
+
+template <unsigned int N, class Real, class C1, class C2, class C3>
+void 
+convolveFFTBlockwise(MultiArrayView<N, Real, C1> in, 
+                     MultiArrayView<N, Real, C2> kernel,
+                     MultiArrayView<N, Real, C3> out,
+                     typename MultiArrayShape<N>::type blockShape = typename MultiArrayShape<N>::type(),
+                     int nthreads = 1)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef FFTWComplex<Real> Complex;
+    typedef MultiArrayView<N, Real, UnstridedArrayTag >     RArray;
+    typedef MultiArray<N, Complex, FFTWAllocator<Complex> > CArray;
+
+    vigra_precondition(in.shape() == out.shape(),
+        "convolveFFTBlockwise(): input and output must have the same shape.");
+    vigra_precondition(kernel.size() > 0 && in.size() > 0,
+        "convolveFFTBlockwise(): input and kernel must not be empty.");
+    vigra_precondition(&out[out.shape() - Shape(1)] < &in[Shape()] || 
+                       &in[in.shape() - Shape(1)] < &out[Shape()],
+        "convolveFFTBlockwise(): input and output must not overlap.");
+
+    Shape paddedShape = detail::fftwBlockPaddedShape(in.shape(), kernel.shape(), blockShape),
+          leftBorder  = kernel.shape() - Shape(1) - kernel.shape() / 2,
+          blockCount;
+    blockShape = paddedShape - kernel.shape() + Shape(1);
+    for(unsigned int k=0; k<N; ++k)
+        blockCount[k] = (in.shape(k) + blockShape[k] - 1) / blockShape[k];
+    
+    CArray fourierKernel(fftwCorrespondingShapeR2C(paddedShape));
+    Shape realStrides = 2*fourierKernel.stride();
+    realStrides[0] = 1;
+    RArray realKernel(paddedShape, realStrides, (Real*)fourierKernel.data());
+
+    FFTWPlan<N, Real> forward_plan(realKernel, fourierKernel);
+    FFTWPlan<N, Real> backward_plan(fourierKernel, realKernel);
+
+    detail::fftEmbedKernel(kernel, realKernel);
+    forward_plan.execute(realKernel, fourierKernel);
+
+    detail::FFTWConvolveBlockFunctor<N, Real, C1, C3> 
+        f = { forward_plan, backward_plan, fourierKernel, in, out,
+              paddedShape, realStrides, blockShape, blockCount, leftBorder };
+    parallelForChunks(prod(blockCount), f, nthreads);
+}
+
+/** \brief Convolve a real-valued array with a separable kernel, either in the spatial domain 
+           or by means of the Fourier transform.
+
+    See \ref convolveFFT() for details.
+*/
+doxygen_overloaded_function(template <...> void separableConvolveAuto)
+
+template <unsigned int N, class Real, class C1, class KernelIterator, class C3>
+void 
+separableConvolveAuto(MultiArrayView<N, Real, C1> in, 
+                      KernelIterator kernels,
+                      MultiArrayView<N, Real, C3> out,
+                      int nthreads = 1)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename std::iterator_traits<KernelIterator>::value_type Kernel;
+    typedef typename MultiArrayView<N, Real, UnstridedArrayTag>::traverser Traverser;
+    typedef MultiArrayNavigator<Traverser, N> Navigator;
+    
+    vigra_precondition(in.shape() == out.shape(),
+        "separableConvolveAuto(): input and output must have the same shape.");
+
+    // the FFT kernel is centered, so it must be large enough for asymmetric 1D kernels
+    ArrayVector<Kernel> k1d(kernels, kernels + N);
+    Shape radius, kernelShape;
+    for(unsigned int k=0; k<N; ++k)
+    {
+        k1d[k].setBorderTreatment(BORDER_TREATMENT_REFLECT);
+        radius[k] = std::max(-k1d[k].left(), k1d[k].right());
+        kernelShape[k] = 2*radius[k] + 1;
+    }
+
+    Shape paddedShape = detail::fftwBlockPaddedShape(in.shape(), kernelShape, Shape());
+    if(detail::preferSpatialConvolution(in.shape(), kernelShape, paddedShape))
+    {
+        separableConvolveMultiArray(srcMultiArrayRange(in), destMultiArray(out), k1d.begin(),
+                                    ConvolutionOptions<N>().numThreads(nthreads));
+        return;
+    }
+
+    // outer product of the 1D kernels
+    MultiArray<N, Real> kernel(kernelShape, Real(1.0));
+    for(unsigned int d=0; d<N; ++d)
+    {
+        Navigator nav(kernel.traverser_begin(), kernel.shape(), d);
+        for( ; nav.hasMore(); nav++ )
+        {
+            typename Navigator::iterator i = nav.begin();
+            for(int k=-radius[d]; k<=radius[d]; ++k)
+                i[k + radius[d]] *= (k < k1d[d].left() || k > k1d[d].right())
+                                       ? Real(0.0)
+                                       : Real(k1d[d][k]);
+        }
+    }
+    convolveFFTBlockwise(in, kernel, out, Shape(), nthreads);
+}
+
 /** \brief Convolve a complex-valued array with a sequence of kernels by means of the Fourier transform.
 
     See \ref convolveFFT() for details.
@@ -49,6 +49,7 @@
 #include "impex.hxx"
 #include "multi_array.hxx"
 #include "multi_pointoperators.hxx"
+#include "memory_mapped_file.hxx"
 
 #ifdef _MSC_VER
 # include <direct.h>
@@ -161,6 +162,12 @@ class VolumeImportInfo
 
     VIGRA_EXPORT const std::string &description() const;
 
+        /** Path of the raw voxel file if the volume is described by an info file
+            (relative names are resolved against the directory of the info file),
+            empty if the volume is stored as a sequence of images.
+         **/
+    VIGRA_EXPORT std::string rawFilename() const;
+
     template <class T, class Stride>
     void importImpl(MultiArrayView <3, T, Stride> &volume) const;
 
@@ -380,35 +387,6 @@ class VolumeExportInfo
     double fromMin_, fromMax_, toMin_, toMax_;
 };
 
-namespace detail {
-
-template <class DestIterator, class Shape, class T>
-inline void
-readVolumeImpl(DestIterator d, Shape const & shape, std::ifstream & s, ArrayVector<T> & buffer, MetaInt<0>)
-{
-    s.read((char*)buffer.begin(), shape[0]*sizeof(T));
-
-    DestIterator dend = d + shape[0];
-    int k = 0;
-    for(; d < dend; ++d, k++)
-    {
-        *d = buffer[k];
-    }
-}
-
-template <class DestIterator, class Shape, class T, int N>
-void
-readVolumeImpl(DestIterator d, Shape const & shape, std::ifstream & s, ArrayVector<T> & buffer, MetaInt<N>)
-{
-    DestIterator dend = d + shape[N];
-    for(; d < dend; ++d)
-    {
-        readVolumeImpl(d.begin(), shape, s, buffer, MetaInt<N-1>());
-    }
-}
-
-} // namespace detail
-
 template <class T, class Stride>
 void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> &volume) const
 {
@@ -416,52 +394,11 @@ void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> &volume) const
 
     if(rawFilename_.size())
     {
-        std::string dirName, baseName;
-        char oldCWD[2048];
-
-#ifdef _MSC_VER
-        if(_getcwd(oldCWD, 2048) == 0)
-        {
-            perror("getcwd");
-            vigra_fail("VolumeImportInfo: Unable to query current directory (getcwd).");
-        }
-        if(_chdir(path_.c_str()))
-        {
-            perror("chdir");
-            vigra_fail("VolumeImportInfo: Unable to change to new directory (chdir).");
-        }
-#else
-        if(getcwd(oldCWD, 2048) == 0)
-        {
-            perror("getcwd");
-            vigra_fail("VolumeImportInfo: Unable to query current directory (getcwd).");
-        }
-        if(chdir(path_.c_str()))
-        {
-            perror("chdir");
-            vigra_fail("VolumeImportInfo: Unable to change to new directory (chdir).");
-        }
-#endif
-
-        std::ifstream s(rawFilename_.c_str(), std::ios::binary);
-        vigra_precondition(s.good(), "RAW file could not be opened");
-
-        ArrayVector<T> buffer(shape_[0]);
-        detail::readVolumeImpl(volume.traverser_begin(), shape_, s, buffer, vigra::MetaInt<2>());
-
-        //vigra_precondition(s.good(), "RAW file could not be opened");
-        //s.read((char*)volume.data(), shape_[0]*shape_[1]*shape_[2]*sizeof(T));
-
-#ifdef _MSC_VER
-        if(_chdir(oldCWD))
-            perror("chdir");
-#else
-        if(chdir(oldCWD))
-            perror("chdir");
-#endif
-
-        vigra_postcondition(
-            volume.shape() == shape(), "imported volume has wrong size");
+        // map the raw file and copy the voxels directly into the volume
+        MemoryMappedFile file(rawFilename());
+        vigra_precondition(file.size() == prod(shape_)*sizeof(T),
+            "importVolume(): size of RAW file doesn't match volume shape and value_type.");
+        volume.copy(MultiArrayView<3, T>(shape_, reinterpret_cast<T *>(file.data())));
     }
     else
     {
@@ -545,10 +482,12 @@ void importVolume (MultiArray <3, T, Allocator> & volume,
          <li> width = [positive integer] (required)
          <li> height = [positive integer] (required)
          <li> depth = [positive integer] (required)
-         <li> datatype = [UNSIGNED_CHAR | UNSIGNED_BYTE] (default: UNSIGNED_CHAR)
+         <li> datatype = [UNSIGNED_CHAR | UNSIGNED_BYTE | UINT8 | INT16 | UINT16 | INT32 | UINT32 | FLOAT | DOUBLE] (default: UNSIGNED_CHAR)
          </UL>
          The voxel type is currently assumed to be binary compatible to the <tt>value_type T</TT>
          of the <tt>MuliArray</tt>. Lines starting with "#" are ignored.
+         The raw file is memory-mapped and copied into the volume in one step.
+         To avoid the copy altogether, use \ref vigra::MemoryMappedVolume instead.
     </UL>
 
     In either case, the <tt>volume</tt> will be reshaped to match the count and
@@ -588,6 +527,145 @@ void importVolume(VolumeImportInfo const & info, MultiArrayView <3, T, Stride> &
     info.importImpl(volume);
 }
 
+/** \brief A 3D volume whose voxels live in a memory-mapped raw file.
+
+    This is a <tt>MultiArrayView<3, T></tt> to the contents of a raw voxel file
+    as described by an info file (see \ref importVolume()). The data are neither
+    read nor copied when the object is constructed: the operating system loads
+    the pages as they are accessed, so that opening even huge volumes is
+    instantaneous, and only the parts actually used occupy memory. The mapping
+    is released when the object is destroyed, so the view must not be used
+    afterwards.
+
+    Existing volumes are mapped in <tt>MemoryMappedFile::CopyOnWrite</tt> mode by
+    default (modifications are allowed but never written back). In
+    <tt>MemoryMappedFile::ReadWrite</tt> mode, changes go directly to the file.
+    The second constructor creates a new info file and raw file and maps the
+    latter for writing, see also \ref exportRawVolume().
+
+    The value_type <tt>T</tt> must be binary compatible to the voxels in the file.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_impex.hxx\><br>
+    Namespace: vigra
+
+    \code
+    vigra::VolumeImportInfo info("stack.info");
+    vigra::MemoryMappedVolume<vigra::UInt16> volume(info);
+
+    // 'volume' is a MultiArrayView<3, UInt16> that can be passed to any algorithm
+    std::cout << volume(10, 20, 30) << "\n";
+
+    // create a new float volume on disk and fill it
+    vigra::MemoryMappedVolume<float> result("result.info", volume.shape());
+    ...
+    \endcode
+*/
+template <class T>
+class MemoryMappedVolume
+: public MultiArrayView<3, T>
+{
+  public:
+    typedef MultiArrayView<3, T> view_type;
+    typedef typename view_type::difference_type difference_type;
+
+        /** Map the raw file of the volume described by <tt>info</tt>.
+        */
+    explicit MemoryMappedVolume(VolumeImportInfo const & info,
+                                MemoryMappedFile::AccessMode mode = MemoryMappedFile::CopyOnWrite)
+    {
+        vigra_precondition(info.rawFilename().size() > 0,
+            "MemoryMappedVolume(): volume must be stored in a RAW file.");
+        file_.open(info.rawFilename(), mode);
+        vigra_precondition(file_.size() == prod(info.shape())*sizeof(T),
+            "MemoryMappedVolume(): size of RAW file doesn't match volume shape and value_type.");
+        bind(info.shape());
+    }
+
+        /** Create a volume of the given shape on disk. The voxels are stored in
+            a raw file next to <tt>infoFilename</tt> (with extension ".raw"
+            instead of ".info") and initialized with zero. The info file is
+            written immediately, so that the volume can later be opened with
+            \ref vigra::VolumeImportInfo.
+        */
+    MemoryMappedVolume(std::string const & infoFilename, difference_type const & shape,
+                       std::string const & description = "")
+    {
+        std::string pixeltype = TypeAsString<T>::result();
+        vigra_precondition(pixeltype != "undefined",
+            "MemoryMappedVolume(): value_type is not supported by raw volume files.");
+        vigra_precondition(prod(shape) > 0,
+            "MemoryMappedVolume(): shape must be positive.");
+
+        std::string rawPath = infoFilename;
+        std::string::size_type ext = rawPath.rfind(".info");
+        if(ext != std::string::npos && ext + 5 == rawPath.size())
+            rawPath.erase(ext);
+        rawPath += ".raw";
+        std::string::size_type split = rawPath.find_last_of("/\\");
+        std::string rawName = split == std::string::npos
+                                  ? rawPath
+                                  : rawPath.substr(split + 1);
+
+        std::ofstream info(infoFilename.c_str());
+        vigra_precondition(info.good(), "MemoryMappedVolume(): Unable to create info file.");
+        if(description.size() > 0)
+            info << "description = " << description << "\n";
+        info << "filename = " << rawName << "\n"
+             << "width = " << shape[0] << "\n"
+             << "height = " << shape[1] << "\n"
+             << "depth = " << shape[2] << "\n"
+             << "datatype = " << pixeltype << "\n";
+        info.close();
+        vigra_postcondition(!info.fail(), "MemoryMappedVolume(): Unable to write info file.");
+
+        file_.create(rawPath, prod(shape)*sizeof(T));
+        bind(shape);
+    }
+
+        /** Write modified voxels back to the file (<tt>ReadWrite</tt> mode only).
+        */
+    void flush()
+    {
+        file_.flush();
+    }
+
+  private:
+    MemoryMappedVolume(MemoryMappedVolume const &);
+    MemoryMappedVolume & operator=(MemoryMappedVolume const &);
+
+    void bind(difference_type const & shape)
+    {
+        this->m_shape = shape;
+        this->m_stride = detail::defaultStride<view_type::actual_dimension>(shape);
+        this->m_ptr = reinterpret_cast<T *>(file_.data());
+    }
+
+    MemoryMappedFile file_;
+};
+
+/** \brief Write a 3D volume as a raw voxel file plus info file.
+
+    The info file <tt>infoFilename</tt> and a raw file with extension ".raw" are
+    created as described in \ref vigra::MemoryMappedVolume. The voxels are written
+    through a memory mapping of the raw file, i.e. without intermediate buffers.
+    The result can be read with \ref importVolume() or mapped with
+    \ref vigra::MemoryMappedVolume.
+
+    <b>\#include</b>
+    \<vigra/multi_impex.hxx\>
+
+    Namespace: vigra
+*/
+template <class T, class Stride>
+void exportRawVolume(MultiArrayView <3, T, Stride> const & volume,
+                     std::string const & infoFilename)
+{
+    MemoryMappedVolume<T> file(infoFilename, volume.shape());
+    file.copy(volume);
+}
+
 namespace detail {
 
 template <class T>
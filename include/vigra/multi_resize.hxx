@@ -40,18 +40,53 @@
 #include <vector>
 #include "resizeimage.hxx"
 #include "navigator.hxx"
+#include "parallel.hxx"
 
 namespace vigra {
 
 namespace detail {
 
+    // resizes the lines [begin, end) of the given line start arrays
+template <class SrcLineIterator, class SrcAccessor,
+          class DestLineIterator, class DestAccessor, class TmpType>
+struct ResizeMultiArrayLineFunctor
+{
+    ArrayVector<SrcLineIterator> const & srcLines;
+    SrcAccessor src;
+    ArrayVector<DestLineIterator> const & destLines;
+    DestAccessor dest;
+    resampling_detail::ResamplingKernelTable const & kernels;
+    ArrayVector<double> const & prefilterCoeffs;
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        // temporary array to hold the current line to enable in-place operation
+        ArrayVector<TmpType> tmp(kernels.sourceSize());
+        typename ArrayVector<TmpType>::iterator t = tmp.begin(), tend = tmp.end();
+        typename AccessorTraits<TmpType>::default_accessor ta;
+
+        for(; begin < end; ++begin)
+        {
+            // first copy source to temp for maximum cache efficiency
+            copyLine(srcLines[begin], srcLines[begin] + tmp.size(), src, t, ta);
+
+            for(unsigned int b = 0; b < prefilterCoeffs.size(); ++b)
+            {
+                recursiveFilterLine(t, tend, ta, t, ta,
+                                    prefilterCoeffs[b], BORDER_TREATMENT_REFLECT);
+            }
+            kernels.convolveLine(t, ta, destLines[begin], dest);
+        }
+    }
+};
+
 template <class SrcIterator, class Shape, class SrcAccessor,
           class DestIterator, class DestAccessor, class Kernel>
 void
 internalResizeMultiArrayOneDimension(
                       SrcIterator si, Shape const & sshape, SrcAccessor src,
                       DestIterator di, Shape const & dshape, DestAccessor dest, 
-                      Kernel const & spline, unsigned int d)
+                      Kernel const & spline, unsigned int d, int nthreads)
 {
     enum { N = 1 + SrcIterator::level };
 
@@ -78,26 +113,21 @@ internalResizeMultiArrayOneDimension(
     ArrayVector<double> const & prefilterCoeffs = spline.prefilterCoefficients();
     ArrayVector<Kernel1D<double> > kernels(period);
     createResamplingKernels(spline, mapCoordinate, kernels);
+    resampling_detail::ResamplingKernelTable kernelTable(kernels, mapCoordinate, ssize, dsize);
 
-    // temporary array to hold the current line to enable in-place operation
-    ArrayVector<TmpType> tmp( ssize );
-    typename ArrayVector<TmpType>::iterator t = tmp.begin(), tend = tmp.end();
-    typename AccessorTraits<TmpType>::default_accessor ta;
-    
+    // collect the line starts, so that the lines can be processed independently
+    ArrayVector<typename SNavigator::iterator> srcLines;
+    ArrayVector<typename DNavigator::iterator> destLines;
     for( ; snav.hasMore(); snav++, dnav++ )
     {
-        // first copy source to temp for maximum cache efficiency
-        copyLine( snav.begin(), snav.end(), src, t, ta);
-
-        for(unsigned int b = 0; b < prefilterCoeffs.size(); ++b)
-        {
-            recursiveFilterLine(t, tend, ta, t, ta,
-                                prefilterCoeffs[b], BORDER_TREATMENT_REFLECT);
-        }
-        resamplingConvolveLine(t, tend, ta,
-                               dnav.begin(), dnav.begin() + dsize, dest,
-                               kernels, mapCoordinate);
+        srcLines.push_back(snav.begin());
+        destLines.push_back(dnav.begin());
     }
+
+    ResizeMultiArrayLineFunctor<typename SNavigator::iterator, SrcAccessor,
+                                typename DNavigator::iterator, DestAccessor, TmpType>
+        f = { srcLines, src, destLines, dest, kernelTable, prefilterCoeffs };
+    parallelForChunks(srcLines.size(), f, nthreads);
 }
 
 } // namespace detail
@@ -127,7 +157,8 @@ internalResizeMultiArrayOneDimension(
         resizeMultiArraySplineInterpolation(
                               SrcIterator si, Shape const & sshape, SrcAccessor src,
                               DestIterator di, Shape const & dshape, DestAccessor dest,
-                              Kernel const & spline = BSpline<3, double>());
+                              Kernel const & spline = BSpline<3, double>(),
+                              int nthreads = 1);
     }
     \endcode
 
@@ -142,7 +173,8 @@ internalResizeMultiArrayOneDimension(
         resizeMultiArraySplineInterpolation(
                               triple<SrcIterator, Shape, SrcAccessor> src,
                               triple<DestIterator, Shape, DestAccessor> dest,
-                              Kernel const & spline = BSpline<3, double>());
+                              Kernel const & spline = BSpline<3, double>(),
+                              int nthreads = 1);
     }
     \endcode
 
@@ -160,6 +192,11 @@ internalResizeMultiArrayOneDimension(
     than smoothed by first calling a recursive (sharpening) prefilter as
     described in the above paper. Then the actual interpolation is done
     using \ref resamplingConvolveLine().
+    
+    The kernel weights are computed once per dimension and reused for all
+    lines along that dimension. The lines are processed independently and can be 
+    distributed over <tt>nthreads</tt> threads (see \ref parallelForChunks()). 
+    The result doesn't depend on the number of threads.
 
     The range of both the input and output images (resp. regions)
     must be given. The input image must have a size of at
@@ -203,7 +240,7 @@ void
 resizeMultiArraySplineInterpolation(
                       SrcIterator si, Shape const & sshape, SrcAccessor src,
                       DestIterator di, Shape const & dshape, DestAccessor dest, 
-                      Kernel const & spline)
+                      Kernel const & spline, int nthreads = 1)
 {
     enum { N = 1 + SrcIterator::level };
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
@@ -213,7 +250,7 @@ resizeMultiArraySplineInterpolation(
     if(N==1)
     {
         detail::internalResizeMultiArrayOneDimension(si, sshape, src, 
-                      di, dshape, dest, spline, 0);
+                      di, dshape, dest, spline, 0, nthreads);
     }
     else
     {
@@ -224,7 +261,7 @@ resizeMultiArraySplineInterpolation(
         TmpAccessor ta;
         
         detail::internalResizeMultiArrayOneDimension(si, sshape, src, 
-                             tmp.traverser_begin(), tmpShape, ta, spline, d);
+                             tmp.traverser_begin(), tmpShape, ta, spline, d, nthreads);
         d = 1;
         for(; d<N-1; ++d)
         {
@@ -232,11 +269,11 @@ resizeMultiArraySplineInterpolation(
             MultiArray<N, TmpType> dtmp(tmpShape);
             
             detail::internalResizeMultiArrayOneDimension(tmp.traverser_begin(), tmp.shape(), ta, 
-                                  dtmp.traverser_begin(), tmpShape, ta, spline, d);
+                                  dtmp.traverser_begin(), tmpShape, ta, spline, d, nthreads);
             dtmp.swap(tmp);
         }
         detail::internalResizeMultiArrayOneDimension(tmp.traverser_begin(), tmp.shape(), ta, 
-                                        di, dshape, dest, spline, d);
+                                        di, dshape, dest, spline, d, nthreads);
     }
 }
 
@@ -246,10 +283,10 @@ template <class SrcIterator, class Shape, class SrcAccessor,
 inline void
 resizeMultiArraySplineInterpolation(triple<SrcIterator, Shape, SrcAccessor> src,
                       triple<DestIterator, Shape, DestAccessor> dest,
-                      Kernel const & spline)
+                      Kernel const & spline, int nthreads = 1)
 {
     resizeMultiArraySplineInterpolation(src.first, src.second, src.third,
-                                   dest.first, dest.second, dest.third, spline);
+                                   dest.first, dest.second, dest.third, spline, nthreads);
 }
 
 template <class SrcIterator, class Shape, class SrcAccessor,
@@ -0,0 +1,299 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_PARALLEL_HXX
+#define VIGRA_PARALLEL_HXX
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include "config.hxx"
+#include "error.hxx"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace vigra {
+
+/** \addtogroup ParallelProcessing Parallel Processing
+
+    Helpers for the multi-threaded variants of VIGRA algorithms.
+
+    <b>\#include</b> \<vigra/parallel.hxx\><br>
+    Namespace: vigra
+
+    VIGRA uses OpenMP to distribute independent work items (e.g. the lines of a
+    separable filter pass) over several threads. Parallel execution is always
+    opt-in: algorithms supporting it take a thread count which defaults to 1
+    (i.e. serial execution). A thread count of 0 requests as many threads as
+    OpenMP considers available (<tt>omp_get_max_threads()</tt>). When VIGRA is
+    compiled without OpenMP support (CMake option <tt>WITH_OPENMP=OFF</tt> or a
+    compiler that doesn't support it), all algorithms silently fall back to
+    serial execution. Results never depend on the number of threads.
+*/
+//@{
+
+    /** \brief Determine the number of threads actually used for a request of
+        <tt>requested</tt> threads.
+
+        Returns 1 when VIGRA is compiled without OpenMP support. Otherwise,
+        <tt>requested <= 0</tt> is mapped to <tt>omp_get_max_threads()</tt>.
+    */
+inline int parallelThreadCount(int requested)
+{
+#ifdef _OPENMP
+    return requested > 0
+               ? requested
+               : omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+    /** \brief Index of the calling thread within the current parallel region.
+
+        Returns 0 outside of parallel regions or when compiled without OpenMP.
+    */
+inline int parallelThreadIndex()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+namespace detail {
+
+/* Exceptions must not leave an OpenMP parallel region. ParallelErrorState
+   records the first exception raised by any thread (preserving the vigra
+   exception type) so that it can be rethrown once the region has been joined.
+*/
+class ParallelErrorState
+{
+    typedef void (*Thrower)(StdException *);
+
+    template <class E>
+    static void throwCopy(StdException * e)
+    {
+        E copy(*static_cast<E *>(e));
+        delete e;
+        throw copy;
+    }
+
+  public:
+    ParallelErrorState()
+    : error_(0), thrower_(0), failed_(false)
+    {}
+
+    ~ParallelErrorState()
+    {
+        delete error_;
+    }
+
+        // only a hint to skip remaining work, exact synchronization is done in record()
+    bool failed() const
+    {
+        return failed_;
+    }
+
+    template <class E>
+    void record(E const & e)
+    {
+#ifdef _OPENMP
+        #pragma omp critical (vigra_parallel_error)
+#endif
+        {
+            if(error_ == 0)
+            {
+                error_ = new E(e);
+                thrower_ = &throwCopy<E>;
+                failed_ = true;
+            }
+        }
+    }
+
+        // record the exception currently being handled, must be called
+        // from within a catch block
+    void recordCurrent(char const * unknownMessage)
+    {
+        try
+        {
+            throw;
+        }
+        catch(PreconditionViolation & e)
+        {
+            record(e);
+        }
+        catch(PostconditionViolation & e)
+        {
+            record(e);
+        }
+        catch(InvariantViolation & e)
+        {
+            record(e);
+        }
+        catch(ContractViolation & e)
+        {
+            record(e);
+        }
+        catch(std::bad_alloc & e)
+        {
+            record(e);
+        }
+        catch(std::runtime_error & e)
+        {
+            record(e);
+        }
+        catch(std::exception & e)
+        {
+            record(std::runtime_error(e.what()));
+        }
+        catch(...)
+        {
+            record(std::runtime_error(unknownMessage));
+        }
+    }
+
+    void rethrow()
+    {
+        if(error_ != 0)
+        {
+            StdException * e = error_;
+            error_ = 0;
+            thrower_(e);
+        }
+    }
+
+  private:
+    ParallelErrorState(ParallelErrorState const &);
+    ParallelErrorState & operator=(ParallelErrorState const &);
+
+    StdException * error_;
+    Thrower thrower_;
+    volatile bool failed_;
+};
+
+} // namespace detail
+
+/** \brief Apply a functor to consecutive chunks of an index range in parallel.
+
+    The range <tt>[0, size)</tt> is split into at most <tt>nthreads</tt> chunks
+    of consecutive indices (but each chunk has at least <tt>minChunkSize</tt> elements),
+    and <tt>f(begin, end)</tt> is called once for every chunk. The calls
+    are executed concurrently, so the functor must only write to locations that
+    are disjoint between chunks. Each call of the functor is executed by a single
+    thread, so that scratch memory allocated within the call is effectively
+    thread-local. The function returns after all chunks have been processed.
+    If any call throws, the first exception is rethrown in the calling thread.
+
+    When the (effective) number of threads is 1, <tt>f(0, size)</tt> is simply
+    called directly. See \ref parallelThreadCount() for the interpretation of
+    <tt>nthreads</tt>.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <class Functor>
+        void parallelForChunks(std::ptrdiff_t size, Functor const & f,
+                               int nthreads, std::ptrdiff_t minChunkSize = 1);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    \code
+    struct SquareChunk
+    {
+        double * data;
+
+        void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+        {
+            for(; begin < end; ++begin)
+                data[begin] *= data[begin];
+        }
+    };
+
+    SquareChunk f = { array.data() };
+    parallelForChunks(array.size(), f, 0); // use all available threads
+    \endcode
+*/
+template <class Functor>
+void parallelForChunks(std::ptrdiff_t size, Functor const & f,
+                       int nthreads, std::ptrdiff_t minChunkSize = 1)
+{
+    if(size <= 0)
+        return;
+    if(minChunkSize < 1)
+        minChunkSize = 1;
+    std::ptrdiff_t maxChunks = (size + minChunkSize - 1) / minChunkSize;
+    int chunks = parallelThreadCount(nthreads);
+    if(chunks > maxChunks)
+        chunks = (int)maxChunks;
+    if(chunks <= 1)
+    {
+        f(0, size);
+        return;
+    }
+
+    detail::ParallelErrorState errors;
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(chunks) schedule(static, 1)
+#endif
+    for(int c = 0; c < chunks; ++c)
+    {
+        if(errors.failed())
+            continue;
+        std::ptrdiff_t begin = (size * c) / chunks,
+                       end   = (size * (c + 1)) / chunks;
+        try
+        {
+            f(begin, end);
+        }
+        catch(...)
+        {
+            errors.recordCurrent("parallelForChunks(): unknown exception.");
+        }
+    }
+    errors.rethrow();
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_PARALLEL_HXX
@@ -49,6 +49,7 @@
 #include "matrix.hxx"
 #include "random.hxx"
 #include "functorexpression.hxx"
+#include "parallel.hxx"
 #include "random_forest/rf_common.hxx"
 #include "random_forest/rf_nodeproxy.hxx"
 #include "random_forest/rf_split.hxx"
@@ -448,7 +449,20 @@ class RandomForest
      * \param random    RandomNumberGenerator to be used. Use
      *                  rf_default() to use default value.(RandomMT19337)
      *
+     * When RandomForestOptions::thread_count() has been set (to any
+     * value, including 1), each tree uses its own generator whose seed is
+     * drawn from \a random, so that the forest is reproducible and
+     * independent of the number of threads. Thread counts other than 1
+     * learn the trees concurrently. The visitor's
+     * <tt>visit_after_split()</tt> is called by one thread at a time
+     * (but the trees' splits may be interleaved), whereas
+     * <tt>visit_after_tree()</tt> is called in tree order.
      *
+     * When RandomForestOptions::feature_bins() is not 0, the trees are
+     * learned on 8-bit quantized features, and the visitor sees the
+     * quantized features and a forest whose thresholds refer to the bins.
+     * The thresholds are mapped back to feature values when learning is
+     * finished.
      */
     template <class U, class C1,
              class U2,class C2,
@@ -609,6 +623,13 @@ class RandomForest
      *  save class probabilities
      *  \param stop earlystopping criterion
      *  \sa EarlyStopping
+     *
+     *  Without early stopping (i.e. when \a stop is rf_default()),
+     *  the rows are processed in blocks, applying one tree after the
+     *  other to the entire block, and the blocks are distributed over
+     *  RandomForestOptions::thread_count() threads. An early stopping
+     *  criterion is evaluated for one row after the other, as it may
+     *  keep state across the calls of its <tt>after_prediction()</tt>.
      */
     template <class U, class C1, class T, class C2, class Stop>
     void predictProbabilities(MultiArrayView<2, U, C1>const &   features,
@@ -638,6 +659,41 @@ class RandomForest
 
     /*\}*/
 
+  protected:
+
+        // learn all trees with individually seeded random number generators,
+        // concurrently unless the thread count is 1
+        // (see RandomForestOptions::thread_count())
+    template <class Preprocessor_t, class Visitor_t,
+              class Split_t, class Stop_t, class Random_t>
+    void learnConcurrently(Preprocessor_t &      preprocessor,
+                           Visitor_t &           visitor,
+                           Split_t const &       split,
+                           Stop_t const &        stop,
+                           Random_t const &      random);
+
+        // learn on quantized features (see RandomForestOptions::feature_bins())
+    template <class U, class C1, class U2, class C2,
+              class Split_t, class Stop_t, class Visitor_t, class Random_t>
+    void learnBinned(MultiArrayView<2, U, C1> const  &   features,
+                     MultiArrayView<2, U2,C2> const  &   response,
+                     Visitor_t                           visitor,
+                     Split_t                             split,
+                     Stop_t                              stop,
+                     Random_t                 const  &   random,
+                     VigraTrueType);
+
+    template <class U, class C1, class U2, class C2,
+              class Split_t, class Stop_t, class Visitor_t, class Random_t>
+    void learnBinned(MultiArrayView<2, U, C1> const  &,
+                     MultiArrayView<2, U2,C2> const  &,
+                     Visitor_t, Split_t, Stop_t, Random_t const &,
+                     VigraFalseType)
+    {
+        vigra_precondition(false,
+            "RandomForest::learn(): feature binning requires a split functor "
+            "producing threshold nodes.");
+    }
 };
 
 
@@ -700,6 +756,7 @@ void RandomForest<LabelType, PreprocessorTag>::onlineLearn(MultiArrayView<2,U,C1
     // Give the Split functor information about the data.
     split.set_external_parameters(ext_param_);
     stop.set_external_parameters(ext_param_);
+    detail::prepareSplitFunctor(split, preprocessor.features(), options_.thread_count_);
 
 
     //Create poisson samples
@@ -840,6 +897,7 @@ void RandomForest<LabelType, PreprocessorTag>::reLearnTree(MultiArrayView<2,U,C1
     // Give the Split functor information about the data.
     split.set_external_parameters(ext_param_);
     stop.set_external_parameters(ext_param_);
+    detail::prepareSplitFunctor(split, preprocessor.features(), options_.thread_count_);
 
     /**\todo    replace this crappy class out. It uses function pointers.
      *          and is making code slower according to me.
@@ -882,6 +940,164 @@ void RandomForest<LabelType, PreprocessorTag>::reLearnTree(MultiArrayView<2,U,C1
     online_visitor_.deactivate();
 }
 
+namespace detail {
+
+/* Quantize a range of feature columns into at most binCount bins of
+   approximately equal population. Columns with at most binCount distinct
+   values are represented exactly. edges[j][b] is the midpoint between the
+   largest value of bin b and the smallest value of bin b+1 in column j, so
+   that the bin of x is the number of edges <= x.
+*/
+template <class U, class C>
+struct RFFeatureBinsFunctor
+{
+    MultiArrayView<2, U, C>             features;
+    MultiArrayView<2, UInt8>            bins;
+    ArrayVector<ArrayVector<double> > & edges;
+    int                                 binCount;
+
+    RFFeatureBinsFunctor(MultiArrayView<2, U, C> const & f,
+                         MultiArrayView<2, UInt8> const & b,
+                         ArrayVector<ArrayVector<double> > & e,
+                         int count)
+    : features(f), bins(b), edges(e), binCount(count)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        MultiArrayIndex size = features.shape(0);
+        MultiArrayView<2, UInt8> out(bins);
+        ArrayVector<U> values(size);
+        for(; begin < end; ++begin)
+        {
+            for(MultiArrayIndex k = 0; k < size; ++k)
+                values[k] = features(k, begin);
+            std::sort(values.begin(), values.end());
+
+            MultiArrayIndex distinct = size > 0 ? 1 : 0;
+            for(MultiArrayIndex k = 1; k < size; ++k)
+                if(values[k] != values[k-1])
+                    ++distinct;
+
+            // close the current bin at the first change of value after
+            // it got its share of the remaining samples
+            ArrayVector<double> & e = edges[begin];
+            e.clear();
+            MultiArrayIndex last = 0;
+            for(MultiArrayIndex k = 1; k < size && (int)e.size() < binCount - 1; ++k)
+            {
+                if(values[k] == values[k-1])
+                    continue;
+                if(distinct <= binCount ||
+                   (k - last) * (binCount - (MultiArrayIndex)e.size()) >= size - last)
+                {
+                    e.push_back((double(values[k-1]) + double(values[k])) / 2.0);
+                    last = k;
+                }
+            }
+
+            for(MultiArrayIndex k = 0; k < size; ++k)
+                out(k, begin) = (UInt8)(std::upper_bound(e.begin(), e.end(),
+                                                         double(features(k, begin)))
+                                        - e.begin());
+        }
+    }
+};
+
+    // split functors which can learn on 8-bit features and produce
+    // threshold nodes (see RandomForestOptions::feature_bins())
+template <class Split_t>
+struct RFSupportsFeatureBins
+{
+    typedef VigraFalseType type;
+};
+
+template <>
+struct RFSupportsFeatureBins<RF_DEFAULT>
+{
+    typedef VigraTrueType type;
+};
+
+template <class ColumnDecisionFunctor, class Tag>
+struct RFSupportsFeatureBins<ThresholdSplit<ColumnDecisionFunctor, Tag> >
+{
+    typedef VigraTrueType type;
+};
+
+template <class ColumnDecisionFunctor, class Tag>
+struct RFSupportsFeatureBins<PresortedThresholdSplit<ColumnDecisionFunctor, Tag> >
+{
+    typedef VigraTrueType type;
+};
+
+/* Replace the thresholds of a tree learned on the bins computed by
+   RFFeatureBinsFunctor with the corresponding feature values.
+*/
+template <class Tree>
+void rfMapBinThresholds(Tree & tree, ArrayVector<ArrayVector<double> > const & edges)
+{
+    ArrayVector<Int32> queue(1, 2);
+    for(unsigned int q = 0; q < queue.size(); ++q)
+    {
+        Int32 index = queue[q];
+        if(tree.topology_[index] & LeafNodeTag)
+            continue;
+        vigra_precondition(tree.topology_[index] == i_ThresholdNode,
+            "RandomForest::learn(): feature binning requires a split functor "
+            "producing threshold nodes.");
+        Node<i_ThresholdNode> node(tree.topology_, tree.parameters_, index);
+        // bins >= ceil(threshold) go to the right child
+        int bin = (int)std::ceil(node.threshold());
+        node.threshold() = edges[node.column()][bin - 1];
+        queue.push_back(node.child(0));
+        queue.push_back(node.child(1));
+    }
+}
+
+} // namespace detail
+
+template <class LabelType, class PreprocessorTag>
+template <class U, class C1, class U2, class C2,
+          class Split_t, class Stop_t, class Visitor_t, class Random_t>
+void RandomForest<LabelType, PreprocessorTag>::
+                     learnBinned(MultiArrayView<2, U, C1> const  &   features,
+                                 MultiArrayView<2, U2,C2> const  &   response,
+                                 Visitor_t                           visitor,
+                                 Split_t                             split,
+                                 Stop_t                              stop,
+                                 Random_t                 const  &   random,
+                                 VigraTrueType)
+{
+    vigra_precondition(!options_.prepare_online_learning_,
+        "RandomForest::learn(): feature binning cannot be combined with online learning.");
+    // the binned copy can't be checked by the Processor, and sorting NaNs
+    // in RFFeatureBinsFunctor would be undefined
+    vigra_precondition(!detail::contains_nan(features), 
+        "RandomForest::learn(): Feature Matrix Contains NaNs");
+    vigra_precondition(!detail::contains_inf(features), 
+        "RandomForest::learn(): Feature Matrix Contains inf");
+    MultiArray<2, UInt8> binnedFeatures(features.shape());
+    ArrayVector<ArrayVector<double> > binEdges(features.shape(1));
+    detail::RFFeatureBinsFunctor<U, C1>
+        computeBins(features, binnedFeatures, binEdges, options_.feature_bins_);
+    parallelForChunks(features.shape(1), computeBins, options_.thread_count_);
+
+    int featureBins = options_.feature_bins_;
+    options_.feature_bins_ = 0;
+    try
+    {
+        learn(binnedFeatures, response, visitor, split, stop, random);
+    }
+    catch(...)
+    {
+        options_.feature_bins_ = featureBins;
+        throw;
+    }
+    options_.feature_bins_ = featureBins;
+    for(int k = 0; k < (int)trees_.size(); ++k)
+        detail::rfMapBinThresholds(trees_[k], binEdges);
+}
+
 template <class LabelType, class PreprocessorTag>
 template <class U, class C1,
          class U2,class C2,
@@ -908,7 +1124,14 @@ void RandomForest<LabelType, PreprocessorTag>::
 
     vigra_precondition(features.shape(0) == response.shape(0),
         "RandomForest::learn(): shape mismatch between features and response.");
-    
+
+    if(options_.feature_bins_ != 0)
+    {
+        learnBinned(features, response, visitor_, split_, stop_, random,
+                    typename detail::RFSupportsFeatureBins<Split_t>::type());
+        return;
+    }
+        
     // default values and initialization
     // Value Chooser chooses second argument as value if first argument
     // is of type RF_DEFAULT. (thanks to template magic - don't care about
@@ -934,10 +1157,6 @@ void RandomForest<LabelType, PreprocessorTag>::
         online_visitor_.deactivate();
 
 
-    // Make stl compatible random functor.
-    RandFunctor_t           randint     ( random);
-
-
     // Preprocess the data to get something the split functor can work
     // with. Also fill the ext_param structure by preprocessing
     // option parameters that could only be completely evaluated
@@ -948,11 +1167,22 @@ void RandomForest<LabelType, PreprocessorTag>::
     // Give the Split functor information about the data.
     split.set_external_parameters(ext_param_);
     stop.set_external_parameters(ext_param_);
+    detail::prepareSplitFunctor(split, preprocessor.features(), options_.thread_count_);
 
 
     //initialize trees.
     trees_.resize(options_.tree_count_  , DecisionTree_t(ext_param_));
 
+    if(options_.per_tree_seeding_)
+    {
+        learnConcurrently(preprocessor, visitor, split, stop, random);
+        online_visitor_.deactivate();
+        return;
+    }
+
+    // Make stl compatible random functor.
+    RandFunctor_t           randint     ( random);
+
     Sampler<Random_t > sampler(preprocessor.strata().begin(),
                                preprocessor.strata().end(),
                                detail::make_sampler_opt(options_)
@@ -995,6 +1225,204 @@ void RandomForest<LabelType, PreprocessorTag>::
     online_visitor_.deactivate();
 }
 
+namespace detail {
+
+/* Random state and bootstrap sample of a single tree during concurrent
+   learning. Every tree gets its own generator, so that the result doesn't
+   depend on the order in which the trees are processed.
+*/
+template <class StackEntry_t>
+struct RFTreeLearnJob
+{
+    typedef RandomNumberGenerator<>             Random_t;
+    typedef UniformIntRandomFunctor<Random_t>   RandFunctor_t;
+
+    Random_t            random;
+    RandFunctor_t       randint;
+    Sampler<Random_t>   sampler;
+    StackEntry_t        stack_entry;
+
+    template <class Iter>
+    RFTreeLearnJob(UInt32 seed, Iter strataBegin, Iter strataEnd,
+                   SamplerOptions const & opt, int classCount)
+    : random(seed),
+      randint(random),
+      sampler(strataBegin, strataEnd, opt, random),
+      stack_entry(sampleRoot(sampler, classCount))
+    {}
+
+    static StackEntry_t sampleRoot(Sampler<Random_t> & sampler, int classCount)
+    {
+        sampler.sample();
+        StackEntry_t res(sampler.sampledIndices().begin(),
+                         sampler.sampledIndices().end(),
+                         classCount);
+        res.set_oob_range(sampler.oobIndices().begin(),
+                          sampler.oobIndices().end());
+        return res;
+    }
+};
+
+/* Forwards visit_after_split() of concurrently learned trees to the
+   user's visitor one at a time.
+*/
+template <class Visitor_t>
+struct RFSerializedSplitVisitor
+{
+    Visitor_t & visitor_;
+
+    RFSerializedSplitVisitor(Visitor_t & visitor)
+    : visitor_(visitor)
+    {}
+
+    template<class Tree, class Split, class Region, class Feature_t, class Label_t>
+    void visit_after_split( Tree          & tree,
+                            Split         & split,
+                            Region        & parent,
+                            Region        & leftChild,
+                            Region        & rightChild,
+                            Feature_t     & features,
+                            Label_t       & labels)
+    {
+#ifdef _OPENMP
+        #pragma omp critical (vigra_rf_visitor)
+#endif
+        visitor_.visit_after_split(tree, split, parent, leftChild, rightChild,
+                                   features, labels);
+    }
+};
+
+template <class RF, class Preprocessor_t, class Visitor_t,
+          class Split_t, class Stop_t, class Job>
+struct RFLearnTreesFunctor
+{
+    RF &                                rf;
+    Preprocessor_t &                    preprocessor;
+    RFSerializedSplitVisitor<Visitor_t> & visitor;
+    Split_t const &                     split;
+    Stop_t const &                      stop;
+    SamplerOptions const &              sampler_options;
+    ArrayVector<UInt32> const &         seeds;
+    ArrayVector<Job *> &                jobs;
+    int                                 first_tree;
+
+    RFLearnTreesFunctor(RF & r, Preprocessor_t & p,
+                        RFSerializedSplitVisitor<Visitor_t> & v,
+                        Split_t const & sp, Stop_t const & st,
+                        SamplerOptions const & o,
+                        ArrayVector<UInt32> const & s,
+                        ArrayVector<Job *> & j, int first)
+    : rf(r), preprocessor(p), visitor(v), split(sp), stop(st),
+      sampler_options(o), seeds(s), jobs(j), first_tree(first)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        for(; begin < end; ++begin)
+        {
+            int tree = first_tree + (int)begin;
+            jobs[begin] = new Job(seeds[tree],
+                                  preprocessor.strata().begin(),
+                                  preprocessor.strata().end(),
+                                  sampler_options,
+                                  rf.ext_param_.class_count_);
+            rf.trees_[tree].learn(preprocessor.features(),
+                                  preprocessor.response(),
+                                  jobs[begin]->stack_entry,
+                                  split,
+                                  stop,
+                                  visitor,
+                                  jobs[begin]->randint);
+        }
+    }
+};
+
+template <class Job>
+struct RFTreeLearnJobGuard
+{
+    ArrayVector<Job *> & jobs;
+
+    RFTreeLearnJobGuard(ArrayVector<Job *> & j)
+    : jobs(j)
+    {}
+
+    ~RFTreeLearnJobGuard()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for(unsigned int k = 0; k < jobs.size(); ++k)
+        {
+            delete jobs[k];
+            jobs[k] = 0;
+        }
+    }
+};
+
+} // namespace detail
+
+template <class LabelType, class PreprocessorTag>
+template <class Preprocessor_t, class Visitor_t,
+          class Split_t, class Stop_t, class Random_t>
+void RandomForest<LabelType, PreprocessorTag>::
+                     learnConcurrently(Preprocessor_t &      preprocessor,
+                                       Visitor_t &           visitor,
+                                       Split_t const &       split,
+                                       Stop_t const &        stop,
+                                       Random_t const &      random)
+{
+    typedef detail::RFTreeLearnJob<StackEntry_t> Job;
+
+    int treeCount = (int)trees_.size();
+
+    // The seeds are drawn up front, so that tree ii always gets the same
+    // random stream, regardless of the number of threads.
+    ArrayVector<UInt32> seeds(treeCount);
+    for(int ii = 0; ii < treeCount; ++ii)
+        seeds[ii] = random();
+
+    SamplerOptions sampler_options =
+        detail::make_sampler_opt(options_).sampleSize(ext_param().actual_msample_);
+
+    visitor.visit_at_beginning(*this, preprocessor);
+
+    // Trees are learned in batches of one tree per thread. visit_after_tree()
+    // is then called in tree order for the entire batch, so that visitors
+    // accumulating per-tree results see the same sequence as in serial
+    // learning. Online learning records per-tree state during the splits and
+    // is therefore restricted to one tree at a time.
+    int batchSize = online_visitor_.is_active()
+                        ? 1
+                        : parallelThreadCount(options_.thread_count_);
+    ArrayVector<Job *> jobs(batchSize, (Job *)0);
+    detail::RFTreeLearnJobGuard<Job> guard(jobs);
+    detail::RFSerializedSplitVisitor<Visitor_t> splitVisitor(visitor);
+
+    for(int first = 0; first < treeCount; first += batchSize)
+    {
+        int count = std::min(batchSize, treeCount - first);
+        detail::RFLearnTreesFunctor<RandomForest, Preprocessor_t, Visitor_t,
+                                    Split_t, Stop_t, Job>
+            learnTrees(*this, preprocessor, splitVisitor, split, stop,
+                       sampler_options, seeds, jobs, first);
+        parallelForChunks(count, learnTrees, options_.thread_count_);
+
+        for(int k = 0; k < count; ++k)
+        {
+            visitor.visit_after_tree(*this,
+                                     preprocessor,
+                                     jobs[k]->sampler,
+                                     jobs[k]->stack_entry,
+                                     first + k);
+        }
+        guard.clear();
+    }
+
+    visitor.visit_at_end(*this, preprocessor);
+}
+
 
 
 
@@ -1182,6 +1610,82 @@ void RandomForest<LabelType,PreprocessorTag>
     }
 }
 
+namespace detail {
+
+/* Early stopping functors whose after_prediction() always returns false
+   (and has no side effects) allow for batched prediction.
+*/
+template <class Stop_t>
+struct RFStopNeverTriggers
+{
+    static const bool value = false;
+};
+
+template <>
+struct RFStopNeverTriggers<EarlyStoppStd>
+{
+    static const bool value = true;
+};
+
+/* Applies the forest to blocks of rows, tree by tree, so that the nodes of
+   the current tree stay in cache while they are used for the entire block.
+   The votes of each row are accumulated in the same order as in row-by-row
+   prediction, so that the results are identical.
+*/
+template <class RF, class U, class C1, class T, class C2>
+struct RFPredictBlocksFunctor
+{
+    enum { block_size = 256 };
+
+    RF const &                  rf;
+    MultiArrayView<2, U, C1>    features;
+    MultiArrayView<2, T, C2>    prob;
+
+    RFPredictBlocksFunctor(RF const & r,
+                           MultiArrayView<2, U, C1> const & f,
+                           MultiArrayView<2, T, C2> const & p)
+    : rf(r), features(f), prob(p)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        int classCount = rf.ext_param_.class_count_;
+        int weighted = rf.options_.predict_weighted_;
+        MultiArrayView<2, T, C2> out(prob);
+        ArrayVector<double> totalWeights(block_size);
+
+        for(std::ptrdiff_t blockBegin = begin; blockBegin < end; blockBegin += block_size)
+        {
+            std::ptrdiff_t blockEnd = std::min<std::ptrdiff_t>(blockBegin + block_size, end);
+            std::fill(totalWeights.begin(), totalWeights.end(), 0.0);
+
+            for(int k = 0; k < rf.options_.tree_count_; ++k)
+            {
+                typename RF::DecisionTree_t const & tree = rf.trees_[k];
+                for(std::ptrdiff_t row = blockBegin; row < blockEnd; ++row)
+                {
+                    ArrayVector<double>::const_iterator weights
+                        = tree.predict(rowVector(features, row));
+                    double & totalWeight = totalWeights[row - blockBegin];
+                    for(int l = 0; l < classCount; ++l)
+                    {
+                        double cur_w = weights[l] * (weighted * (*(weights-1))
+                                                   + (1-weighted));
+                        out(row, l) += (T)cur_w;
+                        totalWeight += cur_w;
+                    }
+                }
+            }
+
+            for(std::ptrdiff_t row = blockBegin; row < blockEnd; ++row)
+                for(int l = 0; l < classCount; ++l)
+                    out(row, l) /= detail::RequiresExplicitCast<T>::cast(totalWeights[row - blockBegin]);
+        }
+    }
+};
+
+} // namespace detail
+
 template <class LabelType, class PreprocessorTag>
 template <class U, class C1, class T, class C2, class Stop_t>
 void RandomForest<LabelType, PreprocessorTag>
@@ -1207,12 +1711,26 @@ void RandomForest<LabelType, PreprocessorTag>
       " Probability matrix must have as many columns as there are classes.");
 
     #define RF_CHOOSER(type_) detail::Value_Chooser<type_, Default_##type_> 
+    typedef typename RF_CHOOSER(Stop_t)::type StopType;
     Default_Stop_t default_stop(options_);
-    typename RF_CHOOSER(Stop_t)::type & stop
+    StopType & stop
             = RF_CHOOSER(Stop_t)::choose(stop_, default_stop); 
     #undef RF_CHOOSER 
     stop.set_external_parameters(ext_param_, tree_count());
     prob.init(NumericTraits<T>::zero());
+
+    if(detail::RFStopNeverTriggers<StopType>::value)
+    {
+        // Without early stopping, all trees are applied to all rows, and
+        // rows can be processed in blocks and in parallel.
+        detail::RFPredictBlocksFunctor<RandomForest, U, C1, T, C2>
+            predictBlocks(*this, features, prob);
+        parallelForChunks(rowCount(features), predictBlocks,
+                          options_.thread_count_,
+                          predictBlocks.block_size);
+        return;
+    }
+
     /* This code was originally there for testing early stopping
      * - we wanted the order of the trees to be randomized
     if(tree_indices_.size() != 0)
@@ -1331,4 +1849,5 @@ void RandomForest<LabelType, PreprocessorTag>
 } // namespace vigra
 
 #include "random_forest/rf_algorithm.hxx"
+#include "random_forest/rf_compiled.hxx"
 #endif // VIGRA_RANDOM_FOREST_HXX
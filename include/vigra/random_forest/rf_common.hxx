@@ -198,6 +198,9 @@ class RandomForestOptions
     int tree_count_;
     int min_split_node_size_;
     bool prepare_online_learning_;
+    int thread_count_;
+    bool per_tree_seeding_;
+    int feature_bins_;
     /*\}*/
 
     typedef ArrayVector<double> double_array;
@@ -359,7 +362,10 @@ class RandomForestOptions
         predict_weighted_(false),
         tree_count_(256),
         min_split_node_size_(1),
-        prepare_online_learning_(false)
+        prepare_online_learning_(false),
+        thread_count_(1),
+        per_tree_seeding_(false),
+        feature_bins_(0)
     {}
 
     /**\brief specify stratification strategy
@@ -500,6 +506,57 @@ class RandomForestOptions
         return *this;
     }
 
+    /**\brief How many threads to use for learning and prediction?
+     *
+     * RandomForest::predictProbabilities() distributes the rows over
+     * the threads, which doesn't change the result.
+     * When the thread count is not 1, the trees are learned concurrently.
+     * Once this function has been called (with any thread count, including
+     * 1), each tree uses its own random number generator seeded from the
+     * generator passed to RandomForest::learn(), so that the resulting
+     * forest is identical for all thread counts. Otherwise, the trees are
+     * learned from the generator's sequential random stream as in earlier
+     * versions of VIGRA. 0 means: use all threads available
+     * to OpenMP (see \ref parallelThreadCount()). The thread count is
+     * a runtime setting and is not serialized.
+     *
+     * <br> Default: 1 (serial learning)
+     */
+    RandomForestOptions & thread_count(int in)
+    {
+        vigra_precondition(in >= 0,
+            "RandomForestOptions::thread_count(): thread count must be non-negative.");
+        thread_count_ = in;
+        per_tree_seeding_ = true;
+        return *this;
+    }
+
+    /**\brief Quantize the features into at most this many bins before learning.
+     *
+     * When not 0, RandomForest::learn() replaces every feature column
+     * with an 8-bit bin index. The bins of a column are chosen such that
+     * they contain approximately the same number of samples, and columns
+     * with at most \a in distinct values are represented exactly. The
+     * trees are learned on the bin indices, which takes 1 byte per feature 
+     * value instead of sizeof(U), and GiniSplit/EntropySplit find the splits
+     * by means of class histograms instead of sorting (see
+     * ThresholdSplit::findBestSplit()). Finally, the split thresholds are 
+     * mapped back to feature values (the midpoints between adjacent bins), 
+     * so the forest is applied to the original features as usual. 
+     * Feature binning requires a split functor producing threshold nodes
+     * and cannot be combined with online learning. It is a learning
+     * setting and is not serialized.
+     *
+     * <br> Default: 0 (no binning), otherwise 2 ... 256
+     */
+    RandomForestOptions & feature_bins(int in)
+    {
+        vigra_precondition(in == 0 || (in >= 2 && in <= 256),
+            "RandomForestOptions::feature_bins(): bin count must be 0 or in [2, 256].");
+        feature_bins_ = in;
+        return *this;
+    }
+
     /**\brief Number of examples required for a node to be split.
      *
      *  When the number of examples in a node is below this number,
@@ -0,0 +1,424 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_RF_COMPILED_HXX
+#define VIGRA_RF_COMPILED_HXX
+
+#include <cmath>
+#include <limits>
+#include "../parallel.hxx"
+
+namespace vigra
+{
+
+namespace detail
+{
+
+/* Round a threshold up to the smallest value of type T that is not smaller.
+   Then 'x < threshold' and 'x < roundThresholdUp<T>(threshold)' give the
+   same result for all x representable in T.
+*/
+template <class T>
+T roundThresholdUp(double t)
+{
+    T r = static_cast<T>(t);
+    if(!(static_cast<double>(r) < t))
+        return r;
+    if(r == -std::numeric_limits<T>::infinity())
+        return -std::numeric_limits<T>::max();
+    if(r == T(0))
+        return std::numeric_limits<T>::denorm_min();
+    int e;
+    T m = std::frexp(r, &e);
+    // below a negative power of two, the spacing of T halves
+    if(m == T(-0.5))
+        --e;
+    T ulp = std::ldexp(T(1), e - std::numeric_limits<T>::digits);
+    if(ulp < std::numeric_limits<T>::denorm_min())
+        ulp = std::numeric_limits<T>::denorm_min();
+    return r + ulp;
+}
+
+template <class CRF, class U, class C1, class T, class C2>
+struct CompiledRFPredictBlocksFunctor;
+
+} // namespace detail
+
+/** \brief Compact representation of a trained RandomForest for fast prediction.
+
+    \ingroup MachineLearning
+
+    <b>\#include</b> \<vigra/random_forest.hxx\><br>
+    Namespace: vigra
+
+    A RandomForest stores its trees in a generic format that supports
+    arbitrary node types and online learning, but requires several indirections
+    per node during prediction. A CompiledRandomForest converts a forest of
+    threshold nodes (as created by the default GiniSplit) into a packed array of
+    nodes: each node holds its feature column, the threshold (of type
+    <tt>ThresholdType</tt>) and the index of its left child (the right child
+    directly follows the left one). The nodes of each tree are stored in
+    breadth-first order, so that the top levels of a tree, which are visited
+    by every sample, share a few cache lines. Leaves refer to a table of the
+    (possibly weighted, see RandomForestOptions::predict_weighted()) votes.
+
+    The thresholds are rounded up to <tt>ThresholdType</tt>, so that the
+    predictions are identical to RandomForest::predictProbabilities() whenever
+    the features are exactly representable in <tt>ThresholdType</tt> (e.g. for
+    <tt>float</tt> or 8- and 16-bit integer features with the default
+    <tt>float</tt> thresholds). Use <tt>ThresholdType = double</tt> to get
+    identical results for all feature types.
+
+    The compiled forest is a snapshot: it must be recompiled when the original
+    forest is changed (e.g. by online learning). Forests containing other node
+    types than threshold nodes and constant probability leaves cannot be
+    compiled.
+
+    <b>Usage:</b>
+    \code
+    RandomForest<> rf;
+    rf.learn(features, labels);
+
+    CompiledRandomForest<> crf(rf);
+    crf.thread_count(0); // use all available threads
+
+    MultiArray<2, double> prob(Shape2(new_features.shape(0), crf.class_count()));
+    crf.predictProbabilities(new_features, prob);
+    \endcode
+*/
+template <class LabelType = double, class ThresholdType = float>
+class CompiledRandomForest
+{
+  public:
+    typedef LabelType               LabelT;
+    typedef ThresholdType           Threshold_t;
+    typedef ProblemSpec<LabelType>  ProblemSpec_t;
+
+        /* A node of the compiled forest. For leaves, column is -1 and child
+           is the offset of the leaf's votes in votes_.
+        */
+    struct TreeNode
+    {
+        Int32           column;
+        ThresholdType   threshold;
+        Int32           child;
+    };
+
+    ArrayVector<TreeNode>   nodes_;
+    ArrayVector<Int32>      roots_;
+    ArrayVector<double>     votes_;
+    ProblemSpec_t           ext_param_;
+    int                     thread_count_;
+
+        /** Create an empty forest.
+        */
+    CompiledRandomForest()
+    : thread_count_(1)
+    {}
+
+        /** Compile the given forest (see compile()).
+        */
+    template <class PreprocessorTag>
+    explicit CompiledRandomForest(RandomForest<LabelType, PreprocessorTag> const & rf)
+    : thread_count_(1)
+    {
+        compile(rf);
+    }
+
+        /** Replace the contents of this object with a compiled version of
+            the given forest. The thread count is taken from
+            RandomForestOptions::thread_count() of \a rf.
+        */
+    template <class PreprocessorTag>
+    void compile(RandomForest<LabelType, PreprocessorTag> const & rf);
+
+        /** Set the number of threads used for prediction
+            (see \ref parallelThreadCount()).
+        */
+    CompiledRandomForest & thread_count(int n)
+    {
+        vigra_precondition(n >= 0,
+            "CompiledRandomForest::thread_count(): thread count must be non-negative.");
+        thread_count_ = n;
+        return *this;
+    }
+
+    int thread_count() const
+    {
+        return thread_count_;
+    }
+
+        /** number of trees
+        */
+    int tree_count() const
+    {
+        return (int)roots_.size();
+    }
+
+        /** number of classes
+        */
+    int class_count() const
+    {
+        return ext_param_.class_count_;
+    }
+
+        /** number of feature columns used during training
+        */
+    int column_count() const
+    {
+        return ext_param_.column_count_;
+    }
+
+        /** total number of nodes (including leaves) of all trees
+        */
+    int node_count() const
+    {
+        return (int)nodes_.size();
+    }
+
+        /** \brief predict the class probabilities for multiple samples
+
+            \param features a n x column_count() matrix
+            \param prob a n x class_count() matrix which receives the
+                   class probabilities
+
+            The result equals RandomForest::predictProbabilities() without
+            early stopping (subject to the precision of
+            <tt>ThresholdType</tt>, see above).
+        */
+    template <class U, class C1, class T, class C2>
+    void predictProbabilities(MultiArrayView<2, U, C1> const & features,
+                              MultiArrayView<2, T, C2> &       prob) const;
+
+        /** \brief predict the labels of multiple samples
+
+            \param features a n x column_count() matrix
+            \param labels a n x 1 matrix which receives the labels
+        */
+    template <class U, class C1, class T, class C2>
+    void predictLabels(MultiArrayView<2, U, C1> const & features,
+                       MultiArrayView<2, T, C2> &       labels) const;
+};
+
+template <class LabelType, class ThresholdType>
+template <class PreprocessorTag>
+void CompiledRandomForest<LabelType, ThresholdType>
+    ::compile(RandomForest<LabelType, PreprocessorTag> const & rf)
+{
+    typedef typename RandomForest<LabelType, PreprocessorTag>::DecisionTree_t DecisionTree_t;
+
+    nodes_.clear();
+    roots_.clear();
+    votes_.clear();
+    ext_param_ = rf.ext_param_;
+    thread_count_ = rf.options_.thread_count_;
+
+    int classCount = ext_param_.class_count_;
+    int weighted = rf.options_.predict_weighted_;
+    // topology indices of the nodes in breadth-first order
+    ArrayVector<Int32> queue;
+
+    for(int k = 0; k < rf.tree_count(); ++k)
+    {
+        DecisionTree_t const & tree = rf.trees_[k];
+        Int32 base = (Int32)nodes_.size();
+        roots_.push_back(base);
+        queue.clear();
+        queue.push_back(2);
+        for(unsigned int q = 0; q < queue.size(); ++q)
+        {
+            Int32 index = queue[q];
+            TreeNode node;
+            switch(tree.topology_[index])
+            {
+                case i_ThresholdNode:
+                {
+                    Node<i_ThresholdNode> n(tree.topology_, tree.parameters_, index);
+                    node.column = n.column();
+                    node.threshold = detail::roundThresholdUp<ThresholdType>(n.threshold());
+                    node.child = base + (Int32)queue.size();
+                    queue.push_back(n.child(0));
+                    queue.push_back(n.child(1));
+                    break;
+                }
+                case e_ConstProbNode:
+                {
+                    Node<e_ConstProbNode> n(tree.topology_, tree.parameters_, index);
+                    node.column = -1;
+                    node.threshold = ThresholdType();
+                    node.child = (Int32)votes_.size();
+                    for(int l = 0; l < classCount; ++l)
+                        votes_.push_back(n.prob_begin()[l] * (weighted * n.weights()
+                                                              + (1-weighted)));
+                    break;
+                }
+                default:
+                    vigra_precondition(false,
+                        "CompiledRandomForest::compile(): only forests of threshold "
+                        "nodes and constant probability leaves can be compiled.");
+            }
+            nodes_.push_back(node);
+        }
+    }
+}
+
+namespace detail
+{
+
+/* Same blocking scheme as RFPredictBlocksFunctor, operating on the
+   compiled nodes.
+*/
+template <class CRF, class U, class C1, class T, class C2>
+struct CompiledRFPredictBlocksFunctor
+{
+    enum { block_size = 256, lanes = 8 };
+
+    CRF const &                 crf;
+    MultiArrayView<2, U, C1>    features;
+    MultiArrayView<2, T, C2>    prob;
+
+    CompiledRFPredictBlocksFunctor(CRF const & c,
+                                   MultiArrayView<2, U, C1> const & f,
+                                   MultiArrayView<2, T, C2> const & p)
+    : crf(c), features(f), prob(p)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        typedef typename CRF::TreeNode TreeNode;
+
+        int classCount = crf.class_count();
+        TreeNode const * nodes = crf.nodes_.begin();
+        double const * votes = crf.votes_.begin();
+        MultiArrayView<2, T, C2> out(prob);
+        ArrayVector<double> totalWeights(block_size);
+
+        for(std::ptrdiff_t blockBegin = begin; blockBegin < end; blockBegin += block_size)
+        {
+            std::ptrdiff_t blockEnd = std::min<std::ptrdiff_t>(blockBegin + block_size, end);
+            std::fill(totalWeights.begin(), totalWeights.end(), 0.0);
+
+            for(int k = 0; k < crf.tree_count(); ++k)
+            {
+                TreeNode const * root = nodes + crf.roots_[k];
+                for(std::ptrdiff_t row = blockBegin; row < blockEnd; row += lanes)
+                {
+                    // descend several rows at once to overlap their memory accesses
+                    int count = (int)std::min<std::ptrdiff_t>(lanes, blockEnd - row);
+                    TreeNode const * node[lanes];
+                    for(int j = 0; j < count; ++j)
+                        node[j] = root;
+                    for(bool active = true; active; )
+                    {
+                        active = false;
+                        for(int j = 0; j < count; ++j)
+                        {
+                            TreeNode const * n = node[j];
+                            if(n->column < 0)
+                                continue;
+                            node[j] = nodes + n->child
+                                            + (features(row + j, n->column) < n->threshold ? 0 : 1);
+                            active = true;
+                        }
+                    }
+
+                    for(int j = 0; j < count; ++j)
+                    {
+                        double const * w = votes + node[j]->child;
+                        double & totalWeight = totalWeights[row + j - blockBegin];
+                        for(int l = 0; l < classCount; ++l)
+                        {
+                            out(row + j, l) += (T)w[l];
+                            totalWeight += w[l];
+                        }
+                    }
+                }
+            }
+
+            for(std::ptrdiff_t row = blockBegin; row < blockEnd; ++row)
+                for(int l = 0; l < classCount; ++l)
+                    out(row, l) /= detail::RequiresExplicitCast<T>::cast(totalWeights[row - blockBegin]);
+        }
+    }
+};
+
+} // namespace detail
+
+template <class LabelType, class ThresholdType>
+template <class U, class C1, class T, class C2>
+void CompiledRandomForest<LabelType, ThresholdType>
+    ::predictProbabilities(MultiArrayView<2, U, C1> const & features,
+                           MultiArrayView<2, T, C2> &       prob) const
+{
+    vigra_precondition(rowCount(features) == rowCount(prob),
+      "CompiledRandomForest::predictProbabilities():"
+        " Feature matrix and probability matrix size mismatch.");
+    vigra_precondition(columnCount(features) >= ext_param_.column_count_,
+      "CompiledRandomForest::predictProbabilities():"
+        " Too few columns in feature matrix.");
+    vigra_precondition(columnCount(prob) == (MultiArrayIndex)ext_param_.class_count_,
+      "CompiledRandomForest::predictProbabilities():"
+      " Probability matrix must have as many columns as there are classes.");
+
+    prob.init(NumericTraits<T>::zero());
+    detail::CompiledRFPredictBlocksFunctor<CompiledRandomForest, U, C1, T, C2>
+        predictBlocks(*this, features, prob);
+    parallelForChunks(rowCount(features), predictBlocks,
+                      thread_count_, predictBlocks.block_size);
+}
+
+template <class LabelType, class ThresholdType>
+template <class U, class C1, class T, class C2>
+void CompiledRandomForest<LabelType, ThresholdType>
+    ::predictLabels(MultiArrayView<2, U, C1> const & features,
+                    MultiArrayView<2, T, C2> &       labels) const
+{
+    vigra_precondition(features.shape(0) == labels.shape(0),
+        "CompiledRandomForest::predictLabels(): Label array has wrong size.");
+
+    MultiArray<2, double> prob(MultiArrayShape<2>::type(features.shape(0),
+                                                        ext_param_.class_count_));
+    predictProbabilities(features, prob);
+    for(int k = 0; k < features.shape(0); ++k)
+    {
+        LabelType label;
+        ext_param_.to_classlabel(argMax(rowVector(prob, k)), label);
+        labels(k, 0) = detail::RequiresExplicitCast<T>::cast(label);
+    }
+}
+
+} // namespace vigra
+
+#endif // VIGRA_RF_COMPILED_HXX
@@ -43,8 +43,10 @@
 #include "../array_vector.hxx"
 #include "../sized_int.hxx"
 #include "../matrix.hxx"
+#include "../metaprogramming.hxx"
 #include "../random.hxx"
 #include "../functorexpression.hxx"
+#include "../parallel.hxx"
 #include "rf_nodeproxy.hxx"
 //#include "rf_sampling.hxx"
 #include "rf_region.hxx"
@@ -232,6 +234,23 @@ class SortSamplesByDimensions
     }
 };
 
+/** Functor to sort sample indices by precomputed ranks
+**/
+class SortIndicesByRank
+{
+    UInt32 const * rank_;
+  public:
+
+    SortIndicesByRank(UInt32 const * rank)
+    : rank_(rank)
+    {}
+
+    bool operator()(MultiArrayIndex l, MultiArrayIndex r) const
+    {
+        return rank_[l] < rank_[r];
+    }
+};
+
 template<class DataMatrix>
 class DimensionNotEqual
 {
@@ -515,8 +534,8 @@ class ImpurityLoss
     template<class Counts>
     double decrement_histogram(Counts const & counts)
     {
-        std::transform(counts.begin(), counts.end(),
-                       counts_.begin(), counts_.begin(),
+        std::transform(counts_.begin(), counts_.end(),
+                       counts.begin(), counts_.begin(),
                        std::minus<double>());
         total_counts_ = std::accumulate( counts_.begin(), 
                                          counts_.end(),
@@ -897,6 +916,22 @@ public:
     {
         std::sort(begin, end, 
                   SortSamplesByDimensions<DataSourceF_t>(column, 0));
+        find_split_in_sorted_range(column, labels, begin, end, region_response);
+    }
+
+    /** same as operator(), but the range begin - end must already be
+     *  sorted by the column supplied (see PresortedThresholdSplit).
+     */
+    template<   class DataSourceF_t,
+                class DataSource_t, 
+                class I_Iter, 
+                class Array>
+    void find_split_in_sorted_range(DataSourceF_t   const & column,
+                                    DataSource_t    const & labels,
+                                    I_Iter                & begin, 
+                                    I_Iter                & end,
+                                    Array           const & region_response)
+    {
         typedef typename 
             LossTraits<LineSearchLossTag, DataSource_t>::type LineSearchLoss;
         LineSearchLoss left(labels, ext_param_); //initialize left and right region
@@ -942,6 +977,66 @@ public:
         //std::cin >> in;
     }
 
+    /** same as find_split_in_sorted_range(), but for a column of small
+     *  non-negative integers (e.g. feature bins) whose class histograms
+     *  are given: hist(c, b) is the number of samples of class c in the
+     *  range begin - end with value b. The range is not reordered.
+     *  Only classification losses support this.
+     */
+    template<   class DataSource_t, 
+                class I_Iter, 
+                class Array>
+    void find_split_in_histogram(MultiArrayView<2, double> const & hist,
+                                 DataSource_t    const & labels,
+                                 I_Iter                & begin, 
+                                 I_Iter                & end,
+                                 Array           const & region_response)
+    {
+        typedef typename 
+            LossTraits<LineSearchLossTag, DataSource_t>::type LineSearchLoss;
+        LineSearchLoss left(labels, ext_param_);
+        LineSearchLoss right(labels, ext_param_);
+
+        min_gini_ = right.init(begin, end, region_response);  
+        min_threshold_ = *begin;
+        min_index_     = 0;
+
+        // class histograms of all values below the candidate threshold are
+        // moved from right to left, as in find_split_in_sorted_range()
+        MultiArrayIndex binCount = hist.shape(1);
+        std::ptrdiff_t leftCount = 0;
+        MultiArrayIndex bin = 0;
+        while(bin < binCount && hist.bindOuter(bin).sum<double>() == 0.0)
+            ++bin;
+        for(MultiArrayIndex next = bin + 1; next < binCount; ++next)
+        {
+            if(hist.bindOuter(next).sum<double>() == 0.0)
+                continue;
+            MultiArrayView<1, double> counts = hist.bindOuter(bin);
+            double lr  =  right.decrement_histogram(counts);
+            double ll  =  left.increment_histogram(counts);
+            double loss = lr +ll;
+            leftCount += (std::ptrdiff_t)counts.sum<double>();
+#ifdef CLASSIFIER_TEST
+            if(loss < min_gini_ && !closeAtTolerance(loss, min_gini_))
+#else
+            if(loss < min_gini_ )
+#endif 
+            {
+                bestCurrentCounts[0] = left.response();
+                bestCurrentCounts[1] = right.response();
+#ifdef CLASSIFIER_TEST
+                min_gini_       = loss < min_gini_? loss : min_gini_;
+#else
+                min_gini_       = loss; 
+#endif
+                min_index_      = leftCount;
+                min_threshold_  = (double(bin) + double(next))/2.0;
+            }
+            bin = next;
+        }
+    }
+
     template<class DataSource_t, class Iter, class Array>
     double loss_of_region(DataSource_t const & labels,
                           Iter & begin, 
@@ -984,6 +1079,81 @@ namespace detail
             }
         }
     };
+
+    /* Apply the column decision functor of a ThresholdSplit to the given
+       column (which it sorts on its own).
+    */
+    template<class ColumnDecisionFunctor>
+    struct SortingColumnSearch
+    {
+        ColumnDecisionFunctor & bgfunc;
+
+        SortingColumnSearch(ColumnDecisionFunctor & f)
+        : bgfunc(f)
+        {}
+
+        template<class T, class C, class Labels, class Iter, class Array>
+        void operator()(MultiArrayView<2, T, C> const & features,
+                        int column,
+                        Labels const & labels,
+                        Iter & begin, Iter & end,
+                        Array const & region_response)
+        {
+            bgfunc(columnVector(features, column),
+                   labels, begin, end, region_response);
+        }
+    };
+
+    /* Apply the column decision functor of a ThresholdSplit to an 8-bit
+       column by means of the class histogram of its values, which
+       avoids sorting.
+    */
+    template<class ColumnDecisionFunctor>
+    struct HistogramColumnSearch
+    {
+        ColumnDecisionFunctor & bgfunc;
+        MultiArray<2, double> & hist;
+
+        HistogramColumnSearch(ColumnDecisionFunctor & f, 
+                              MultiArray<2, double> & h)
+        : bgfunc(f), hist(h)
+        {}
+
+        template<class C, class Labels, class Iter, class Array>
+        void operator()(MultiArrayView<2, UInt8, C> const & features,
+                        int column,
+                        Labels const & labels,
+                        Iter & begin, Iter & end,
+                        Array const & region_response)
+        {
+            hist.reshape(Shape2(region_response.size(), 256), 0.0);
+            for(Iter iter = begin; iter != end; ++iter)
+                hist(labels(*iter, 0), features(*iter, column)) += 1.0;
+            bgfunc.find_split_in_histogram(hist, labels, begin, end, 
+                                           region_response);
+        }
+    };
+
+    /* ThresholdSplit uses HistogramColumnSearch instead of sorting when
+       the features are 8-bit and the column decision functor supports it.
+    */
+    template<class ColumnDecisionFunctor, class T>
+    struct UseHistogramColumnSearch
+    {
+        typedef VigraFalseType type;
+    };
+
+    template<>
+    struct UseHistogramColumnSearch<BestGiniOfColumn<GiniCriterion>, UInt8>
+    {
+        typedef VigraTrueType type;
+    };
+
+    template<>
+    struct UseHistogramColumnSearch<BestGiniOfColumn<EntropyCriterion>, UInt8>
+    {
+        typedef VigraTrueType type;
+    };
 }
 
 /** Chooses mtry columns and applies ColumnDecisionFunctor to each of the
@@ -1004,6 +1174,7 @@ class ThresholdSplit: public SplitBase<Tag>
     ArrayVector<double>         min_gini_;
     ArrayVector<std::ptrdiff_t>      min_indices_;
     ArrayVector<double>         min_thresholds_;
+    MultiArray<2, double>       bin_counts_;
 
     int                         bestSplitIndex;
 
@@ -1035,6 +1206,12 @@ class ThresholdSplit: public SplitBase<Tag>
     }
 
 
+    /** find the best split of the given region. 8-bit features (e.g.
+        quantized by RandomForestOptions::feature_bins()) are split by
+        means of class histograms rather than by sorting, when the
+        ColumnDecisionFunctor is BestGiniOfColumn with GiniCriterion or 
+        EntropyCriterion. Both methods give the same split.
+    */
     template<class T, class C, class T2, class C2, class Region, class Random>
     int findBestSplit(MultiArrayView<2, T, C> features,
                       MultiArrayView<2, T2, C2>  labels,
@@ -1042,6 +1219,51 @@ class ThresholdSplit: public SplitBase<Tag>
                       ArrayVector<Region>& childRegions,
                       Random & randint)
     {
+        typedef typename 
+            detail::UseHistogramColumnSearch<ColumnDecisionFunctor, T>::type UseHistogram;
+        return findBestSplit(features, labels, region, childRegions,
+                             randint, UseHistogram());
+    }
+
+  protected:
+
+    template<class T, class C, class T2, class C2, class Region, class Random>
+    int findBestSplit(MultiArrayView<2, T, C> features,
+                      MultiArrayView<2, T2, C2>  labels,
+                      Region & region,
+                      ArrayVector<Region>& childRegions,
+                      Random & randint,
+                      VigraFalseType)
+    {
+        detail::SortingColumnSearch<ColumnDecisionFunctor> search(bgfunc);
+        return findBestSplitImpl(features, labels, region, childRegions,
+                                 randint, search);
+    }
+
+    template<class T, class C, class T2, class C2, class Region, class Random>
+    int findBestSplit(MultiArrayView<2, T, C> features,
+                      MultiArrayView<2, T2, C2>  labels,
+                      Region & region,
+                      ArrayVector<Region>& childRegions,
+                      Random & randint,
+                      VigraTrueType)
+    {
+        detail::HistogramColumnSearch<ColumnDecisionFunctor> search(bgfunc, bin_counts_);
+        return findBestSplitImpl(features, labels, region, childRegions,
+                                 randint, search);
+    }
+
+        // search(features, column, labels, begin, end, classCounts) must
+        // apply bgfunc to the given column
+    template<class T, class C, class T2, class C2, class Region, class Random,
+             class ColumnSearch>
+    int findBestSplitImpl(MultiArrayView<2, T, C> features,
+                          MultiArrayView<2, T2, C2>  labels,
+                          Region & region,
+                          ArrayVector<Region>& childRegions,
+                          Random & randint,
+                          ColumnSearch & search)
+    {
 
         typedef typename Region::IndexIterator IndexIterator;
         if(region.size() == 0)
@@ -1073,7 +1295,7 @@ class ThresholdSplit: public SplitBase<Tag>
         for(int k=0; k<num2try; ++k)
         {
             //this functor does all the work
-            bgfunc(columnVector(features, splitColumns[k]),
+            search(features, splitColumns[k],
                    labels, 
                    region.begin(), region.end(), 
                    region.classCounts());
@@ -1129,6 +1351,259 @@ typedef  ThresholdSplit<BestGiniOfColumn<GiniCriterion> >                      G
 typedef  ThresholdSplit<BestGiniOfColumn<EntropyCriterion> >                 EntropySplit;
 typedef  ThresholdSplit<BestGiniOfColumn<LSQLoss>, RegressionTag>              RegressionSplit;
 
+namespace detail
+{
+
+/* Sort the sample indices in [begin, end) by rank[index], where all ranks
+   are smaller than rankCount. Large ranges are sorted by an LSD radix sort,
+   which only needs a few sequential passes over the data.
+*/
+template<class Iter>
+void sortIndicesByRank(Iter begin, Iter end,
+                       UInt32 const * rank, UInt32 rankCount,
+                       ArrayVector<UInt32> & keys,
+                       ArrayVector<UInt32> & keysTmp,
+                       ArrayVector<Int32> & indicesTmp)
+{
+    enum { bits = 11, buckets = 1 << bits, mask = buckets - 1, minRadixSize = 1024 };
+
+    std::ptrdiff_t size = end - begin;
+    if(size < 2 || rankCount < 2)
+        return;
+    if(size < minRadixSize)
+    {
+        std::sort(begin, end, SortIndicesByRank(rank));
+        return;
+    }
+
+    keys.resize(size);
+    keysTmp.resize(size);
+    indicesTmp.resize(size);
+    for(std::ptrdiff_t k = 0; k < size; ++k)
+        keys[k] = rank[begin[k]];
+
+    UInt32 * key = keys.begin(), * keyTmp = keysTmp.begin();
+    Int32 * index = &*begin, * indexTmp = indicesTmp.begin();
+    std::ptrdiff_t count[buckets];
+    for(unsigned int shift = 0; ((rankCount - 1) >> shift) != 0; shift += bits)
+    {
+        std::fill(count, count + buckets, 0);
+        for(std::ptrdiff_t k = 0; k < size; ++k)
+            ++count[(key[k] >> shift) & mask];
+        std::ptrdiff_t sum = 0;
+        for(int b = 0; b < buckets; ++b)
+        {
+            std::ptrdiff_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for(std::ptrdiff_t k = 0; k < size; ++k)
+        {
+            std::ptrdiff_t target = count[(key[k] >> shift) & mask]++;
+            keyTmp[target] = key[k];
+            indexTmp[target] = index[k];
+        }
+        std::swap(key, keyTmp);
+        std::swap(index, indexTmp);
+    }
+    if(index != &*begin)
+        std::copy(index, index + size, begin);
+}
+
+/* Apply the column decision functor of a PresortedThresholdSplit to the given
+   column, after sorting the region by means of the precomputed ranks.
+*/
+template<class ColumnDecisionFunctor>
+struct PresortedColumnSearch
+{
+    ColumnDecisionFunctor &             bgfunc;
+    MultiArrayView<2, UInt32> const &   ranks;
+    ArrayVector<UInt32> const &         rankCounts;
+    ArrayVector<UInt32> &               keys;
+    ArrayVector<UInt32> &               keysTmp;
+    ArrayVector<Int32> &                indicesTmp;
+
+    PresortedColumnSearch(ColumnDecisionFunctor & f,
+                          MultiArrayView<2, UInt32> const & r,
+                          ArrayVector<UInt32> const & rc,
+                          ArrayVector<UInt32> & k,
+                          ArrayVector<UInt32> & kt,
+                          ArrayVector<Int32> & it)
+    : bgfunc(f), ranks(r), rankCounts(rc), keys(k), keysTmp(kt), indicesTmp(it)
+    {}
+
+    template<class T, class C, class Labels, class Iter, class Array>
+    void operator()(MultiArrayView<2, T, C> const & features,
+                    int column,
+                    Labels const & labels,
+                    Iter & begin, Iter & end,
+                    Array const & region_response)
+    {
+        sortIndicesByRank(begin, end, &ranks(0, column), rankCounts[column],
+                          keys, keysTmp, indicesTmp);
+        bgfunc.find_split_in_sorted_range(columnVector(features, column),
+                                          labels, begin, end, region_response);
+    }
+};
+
+/* Compute the dense ranks (equal values get equal ranks) of a range of
+   feature columns.
+*/
+template<class T, class C>
+struct FeatureRanksFunctor
+{
+    MultiArrayView<2, T, C>     features;
+    MultiArrayView<2, UInt32>   ranks;
+    UInt32 *                    rankCounts;
+
+    FeatureRanksFunctor(MultiArrayView<2, T, C> const & f,
+                        MultiArrayView<2, UInt32> const & r,
+                        UInt32 * rc)
+    : features(f), ranks(r), rankCounts(rc)
+    {}
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        MultiArrayIndex size = features.shape(0);
+        MultiArrayView<2, UInt32> out(ranks);
+        ArrayVector<Int32> order(size);
+        for(; begin < end; ++begin)
+        {
+            for(MultiArrayIndex k = 0; k < size; ++k)
+                order[k] = (Int32)k;
+            std::sort(order.begin(), order.end(),
+                      SortSamplesByDimensions<MultiArrayView<2, T, C> >(features, begin));
+            UInt32 rank = 0;
+            for(MultiArrayIndex k = 0; k < size; ++k)
+            {
+                if(k > 0 && features(order[k-1], begin) != features(order[k], begin))
+                    ++rank;
+                out(order[k], begin) = rank;
+            }
+            rankCounts[begin] = size > 0 ? rank + 1 : 0;
+        }
+    }
+};
+
+} // namespace detail
+
+/** ThresholdSplit which sorts each feature column only once.
+
+    ThresholdSplit sorts the samples of every node by each of the tried
+    feature columns. In contrast, PresortedThresholdSplit replaces the feature
+    values with their ranks once before learning (RandomForest::learn() calls
+    presort() automatically). The samples of a node are then ordered by
+    a radix sort of the ranks, which takes linear time and accesses the
+    data mostly sequentially. The ColumnDecisionFunctor must provide
+    <tt>find_split_in_sorted_range()</tt>, as BestGiniOfColumn does.
+
+    The resulting trees are the same as with the corresponding ThresholdSplit.
+    Like ThresholdSplit, 8-bit features are split by means of class 
+    histograms when possible, so that no ranks are needed. The ranks require 4 bytes per feature value. They are computed only
+    once and shared by all trees of the forest.
+
+    <b>Usage:</b>
+    \code
+    RandomForest<> rf(RandomForestOptions().tree_count(100));
+    rf.learn(features, labels, rf_default(), PresortedGiniSplit());
+    \endcode
+*/
+template<class ColumnDecisionFunctor, class Tag = ClassificationTag>
+class PresortedThresholdSplit
+: public ThresholdSplit<ColumnDecisionFunctor, Tag>
+{
+  public:
+    typedef ThresholdSplit<ColumnDecisionFunctor, Tag> BT;
+
+        // ranks_ refers to rank_storage_ of the functor passed to
+        // RandomForest::learn(), which outlives the per-tree copies
+    MultiArray<2, UInt32>       rank_storage_;
+    MultiArrayView<2, UInt32>   ranks_;
+    ArrayVector<UInt32>         rank_counts_;
+    ArrayVector<UInt32>         keys_, keys_tmp_;
+    ArrayVector<Int32>          indices_tmp_;
+
+    PresortedThresholdSplit()
+    {}
+
+    PresortedThresholdSplit(PresortedThresholdSplit const & other)
+    : BT(other),
+      ranks_(other.ranks_),
+      rank_counts_(other.rank_counts_)
+    {}
+
+    PresortedThresholdSplit & operator=(PresortedThresholdSplit const & other)
+    {
+        if(this != &other)
+        {
+            BT::operator=(other);
+            rank_storage_ = MultiArray<2, UInt32>();
+            ranks_ = other.ranks_;
+            rank_counts_ = other.rank_counts_;
+        }
+        return *this;
+    }
+
+        /** compute the ranks of the given features. Sample indices passed to
+            findBestSplit() refer to the rows of this matrix.
+        */
+    template<class T, class C>
+    void presort(MultiArrayView<2, T, C> const & features, int nthreads = 1)
+    {
+        typedef typename 
+            detail::UseHistogramColumnSearch<ColumnDecisionFunctor, T>::type UseHistogram;
+        if(UseHistogram::asBool)
+            return; // findBestSplit() uses histograms instead of the ranks
+        rank_storage_.reshape(features.shape());
+        rank_counts_.resize(features.shape(1));
+        detail::FeatureRanksFunctor<T, C> computeRanks(features, rank_storage_,
+                                                       rank_counts_.begin());
+        parallelForChunks(features.shape(1), computeRanks, nthreads);
+        ranks_ = rank_storage_;
+    }
+
+    template<class T, class C, class T2, class C2, class Region, class Random>
+    int findBestSplit(MultiArrayView<2, T, C> features,
+                      MultiArrayView<2, T2, C2>  labels,
+                      Region & region,
+                      ArrayVector<Region>& childRegions,
+                      Random & randint)
+    {
+        typedef typename 
+            detail::UseHistogramColumnSearch<ColumnDecisionFunctor, T>::type UseHistogram;
+        if(UseHistogram::asBool || ranks_.shape() != features.shape())
+        {
+            // 8-bit features, or presort() was not called for these features
+            return BT::findBestSplit(features, labels, region, childRegions, randint);
+        }
+        detail::PresortedColumnSearch<ColumnDecisionFunctor>
+            search(BT::bgfunc, ranks_, rank_counts_, keys_, keys_tmp_, indices_tmp_);
+        return BT::findBestSplitImpl(features, labels, region, childRegions,
+                                     randint, search);
+    }
+};
+
+typedef  PresortedThresholdSplit<BestGiniOfColumn<GiniCriterion> >            PresortedGiniSplit;
+typedef  PresortedThresholdSplit<BestGiniOfColumn<EntropyCriterion> >         PresortedEntropySplit;
+typedef  PresortedThresholdSplit<BestGiniOfColumn<LSQLoss>, RegressionTag>    PresortedRegressionSplit;
+
+namespace detail
+{
+
+    // let split functors prepare for the training data before learning
+template<class Split, class T, class C>
+inline void prepareSplitFunctor(Split &, MultiArrayView<2, T, C> const &, int)
+{}
+
+template<class ColumnDecisionFunctor, class Tag, class T, class C>
+inline void prepareSplitFunctor(PresortedThresholdSplit<ColumnDecisionFunctor, Tag> & split,
+                                MultiArrayView<2, T, C> const & features, int nthreads)
+{
+    split.presort(features, nthreads);
+}
+
+} // namespace detail
+
 namespace rf
 {
 
@@ -365,6 +365,114 @@ createResamplingKernels(Kernel const & kernel,
     }
 }
 
+namespace resampling_detail
+{
+
+    // The resampling kernels of all target positions of a line, computed once
+    // and reused for every line of an image. Reflective border treatment is
+    // resolved when the table is built: target point i is computed as
+    //
+    //     sum_m weights[offsets[i] + m] * source[indices[offsets[i] + m]]
+    //
+    // with m < offsets[i+1] - offsets[i], where the sum runs over ascending source 
+    // positions (the same order as in resamplingConvolveLine()). If all taps of 
+    // target point i are inside the source line, first[i] holds the first source 
+    // index (the taps are then consecutive), otherwise first[i] is -1.
+class ResamplingKernelTable
+{
+  public:
+    template <class KernelArray, class MapCoordinate>
+    ResamplingKernelTable(KernelArray const & kernels, MapCoordinate const & mapCoordinate,
+                          int sourceSize, int targetSize)
+    : source_size_(sourceSize),
+      offsets_(targetSize + 1),
+      first_(targetSize)
+    {
+        int wo = sourceSize, wo2 = 2*wo - 2;
+        typename KernelArray::const_iterator kernel = kernels.begin();
+        offsets_[0] = 0;
+        for(int i=0; i<targetSize; ++i, ++kernel)
+        {
+            // use the kernels periodically
+            if(kernel == kernels.end())
+                kernel = kernels.begin();
+
+            int is = mapCoordinate(i);
+            int lbound = is - kernel->right(),
+                hbound = is - kernel->left();
+
+            if(lbound < 0 || hbound >= wo)
+            {
+                vigra_precondition(-lbound < wo && wo2 - hbound >= 0,
+                    "resamplingConvolveLine(): kernel or offset larger than image.");
+                first_[i] = -1;
+            }
+            else
+            {
+                first_[i] = lbound;
+            }
+            for(int m=lbound; m <= hbound; ++m)
+            {
+                weights_.push_back((*kernel)[is - m]);
+                indices_.push_back((m < 0) 
+                                      ? -m 
+                                      : (m >= wo) 
+                                            ? wo2 - m 
+                                            : m);
+            }
+            offsets_[i+1] = weights_.size();
+        }
+    }
+
+    int sourceSize() const
+    {
+        return source_size_;
+    }
+
+    int targetSize() const
+    {
+        return first_.size();
+    }
+
+        // resample the line starting at 's' (of length sourceSize()) into the
+        // line starting at 'd' (of length targetSize())
+    template <class SrcIter, class SrcAcc, class DestIter, class DestAcc>
+    void convolveLine(SrcIter s, SrcAcc src, DestIter d, DestAcc dest) const
+    {
+        typedef typename
+            NumericTraits<typename SrcAcc::value_type>::RealPromote
+            TmpType;
+
+        int wn = targetSize();
+        for(int i=0; i<wn; ++i, ++d)
+        {
+            double const * w    = weights_.begin() + offsets_[i],
+                         * wend = weights_.begin() + offsets_[i+1];
+            TmpType sum = NumericTraits<TmpType>::zero();
+            if(first_[i] >= 0)
+            {
+                SrcIter ss = s + first_[i];
+                for(; w != wend; ++w, ++ss)
+                    sum = TmpType(sum + *w * src(ss));
+            }
+            else
+            {
+                int const * m = indices_.begin() + offsets_[i];
+                for(; w != wend; ++w, ++m)
+                    sum = TmpType(sum + *w * src(s, *m));
+            }
+            dest.set(sum, d);
+        }
+    }
+
+  private:
+    int source_size_;
+    ArrayVector<int> offsets_, first_, indices_;
+    ArrayVector<double> weights_;
+};
+
+} // namespace resampling_detail
+
 /** \brief Apply a resampling filter in the x-direction.
 
     This function implements a convolution operation in x-direction
@@ -874,6 +982,280 @@ void pyramidReduceBurtFilter(ImagePyramid<Image, Alloc> & pyramid, int fromLevel
         pyramidReduceBurtFilter(srcImageRange(pyramid[i-1]), destImageRange(pyramid[i]), centerValue);
 }
 
+/********************************************************/
+/*                                                      */
+/*                   BurtPyramidStream                  */
+/*                                                      */
+/********************************************************/
+
+/** \brief Build a Burt pyramid incrementally from a stream of image rows.
+
+    This class computes the same levels as \ref pyramidReduceBurtFilter() applied 
+    to an \ref vigra::ImagePyramid, but it never needs a complete level in memory. 
+    The rows of the base image are passed in top-to-bottom order, one at a time 
+    (<tt>addRow()</tt>) or in horizontal strips (<tt>addRows()</tt>), for example 
+    as they come from a strip-wise decoder. As soon as a row of some level 
+    can be computed, it is passed to the <tt>sink</tt> and then reduced further. 
+    Each level only keeps five horizontally reduced rows of its predecessor in memory, 
+    so the memory consumption is bounded by about ten rows of the base image, 
+    regardless of the image height. This allows to build deep pyramids of images
+    which don't fit into memory.
+
+    The <tt>sink</tt> is a functor which is called with the signature
+    
+    \code
+    sink(int level, int y, PixelType const * rowBegin, PixelType const * rowEnd);
+    \endcode
+    
+    for all rows of all levels 0 ... <tt>highestLevel</tt> (including the base image, 
+    converted to <tt>PixelType</tt>). The rows of each level arrive in ascending order, 
+    and level <tt>i</tt> has the size of level <tt>i-1</tt> divided by 2 (rounded up). 
+    The results are identical to those of \ref pyramidReduceBurtFilter() with a pyramid 
+    of <tt>PixelType</tt> images.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/resampling_convolution.hxx\><br>
+    Namespace: vigra
+
+    \code
+    // write each level of a 8-bit pyramid to an encoder 
+    // (e.g. a TIFF file, see \ref vigra::Encoder)
+    struct LevelWriter
+    {
+        ArrayVector<Encoder *> encoders; // one encoder per level, sizes set and finalized
+    
+        void operator()(int level, int y, UInt8 const * begin, UInt8 const * end)
+        {
+            std::copy(begin, end, 
+                      static_cast<UInt8 *>(encoders[level]->currentScanlineOfBand(0)));
+            encoders[level]->nextScanline();
+        }
+    };
+    
+    LevelWriter writer = ...;
+    BurtPyramidStream<UInt8, LevelWriter> pyramid(Size2D(width, height), 8, writer);
+    
+    BImage strip(width, 64);
+    while(!pyramid.isComplete())
+    {
+        int rows = std::min(64, height - pyramid.rowsAdded());
+        ... // read the next 'rows' rows of the base image into 'strip'
+        pyramid.addRows(strip.upperLeft(), strip.upperLeft() + Diff2D(width, rows), strip.accessor());
+    }
+    \endcode
+*/
+template <class PixelType, class Sink>
+class BurtPyramidStream
+{
+  public:
+        /** the pixel type of the pyramid levels
+        */
+    typedef PixelType value_type;
+
+        /** the iterator type of the rows passed to the sink 
+        */
+    typedef typename ArrayVector<PixelType>::const_iterator const_iterator;
+
+        /** the type of the intermediate (horizontally reduced) rows
+        */
+    typedef typename NumericTraits<PixelType>::RealPromote TmpType;
+
+        /** Prepare the computation of levels 0 ... <tt>highestLevel</tt> of a pyramid
+            whose base image has the given size. The rows of all levels are passed 
+            to <tt>sink</tt>, which must live as long as this object. <tt>centerValue</tt>
+            has the same meaning as in \ref pyramidReduceBurtFilter().
+        */
+    BurtPyramidStream(Size2D const & baseSize, int highestLevel, Sink & sink, 
+                      double centerValue = 0.4)
+    : sink_(sink),
+      highestLevel_(highestLevel),
+      sizes_(highestLevel + 1),
+      received_(highestLevel + 1, 0),
+      emitted_(highestLevel + 1, 0),
+      lines_(highestLevel + 1),
+      rows_(highestLevel + 1)
+    {
+        vigra_precondition(0.25 <= centerValue && centerValue <= 0.5,
+             "BurtPyramidStream(): centerValue must be between 0.25 and 0.5.");
+        vigra_precondition(baseSize.x > 0 && baseSize.y > 0 && highestLevel >= 0,
+             "BurtPyramidStream(): base size must be positive and highestLevel non-negative.");
+
+        kernel_[0] = kernel_[4] = 0.25 - centerValue / 2.0;
+        kernel_[1] = kernel_[3] = 0.25;
+        kernel_[2] = centerValue;
+
+        for(int level=0; level <= highestLevel; ++level)
+        {
+            sizes_[level] = level == 0
+                                ? baseSize
+                                : Size2D((sizes_[level-1].x + 1) / 2, (sizes_[level-1].y + 1) / 2);
+            lines_[level].resize(sizes_[level].x);
+            if(level > 0)
+                rows_[level].resize(5*sizes_[level].x);
+        }
+    }
+
+        /** Add the next row of the base image. The row must contain
+            <tt>levelSize(0).x</tt> pixels starting at <tt>s</tt>. 
+        */
+    template <class Iterator, class Accessor>
+    void addRow(Iterator s, Accessor src)
+    {
+        vigra_precondition(!isComplete(),
+             "BurtPyramidStream::addRow(): all rows of the base image have already been added.");
+
+        typename ArrayVector<PixelType>::iterator line = lines_[0].begin(), 
+                                                  lend = lines_[0].end();
+        for(; line != lend; ++line, ++s)
+            *line = detail::RequiresExplicitCast<PixelType>::cast(src(s));
+        emitRow(0, received_[0]++);
+    }
+
+        /** Add the next row of the base image, using the default accessor. 
+        */
+    template <class Iterator>
+    void addRow(Iterator s)
+    {
+        addRow(s, StandardConstValueAccessor<typename std::iterator_traits<Iterator>::value_type>());
+    }
+
+        /** Add the rows of the image range <tt>[ul, lr)</tt> as the next strip of 
+            the base image. The width of the strip must equal <tt>levelSize(0).x</tt>.
+        */
+    template <class SrcIterator, class SrcAccessor>
+    void addRows(SrcIterator ul, SrcIterator lr, SrcAccessor src)
+    {
+        vigra_precondition(lr.x - ul.x == sizes_[0].x,
+             "BurtPyramidStream::addRows(): strip width must equal the width of the base image.");
+        vigra_precondition(rowsAdded() + (lr.y - ul.y) <= sizes_[0].y,
+             "BurtPyramidStream::addRows(): too many rows.");
+
+        for(; ul.y < lr.y; ++ul.y)
+            addRow(ul.rowIterator(), src);
+    }
+
+    template <class SrcIterator, class SrcAccessor>
+    void addRows(triple<SrcIterator, SrcIterator, SrcAccessor> src)
+    {
+        addRows(src.first, src.second, src.third);
+    }
+
+        /** the highest level to be computed
+        */
+    int highestLevel() const
+    {
+        return highestLevel_;
+    }
+
+        /** the size of the given level
+        */
+    Size2D levelSize(int level) const
+    {
+        return sizes_[level];
+    }
+
+        /** the number of base image rows added so far
+        */
+    int rowsAdded() const
+    {
+        return received_[0];
+    }
+
+        /** true if all rows of the base image (and therefore of all levels) 
+            have been processed 
+        */
+    bool isComplete() const
+    {
+        return received_[0] == sizes_[0].y;
+    }
+
+  private:
+    BurtPyramidStream(BurtPyramidStream const &); // forbidden
+    BurtPyramidStream & operator=(BurtPyramidStream const &); // forbidden
+
+        // reflective border treatment (also for sizes below 3)
+    static int reflect(int m, int size)
+    {
+        if(size == 1)
+            return 0;
+        while(m < 0 || m >= size)
+            m = (m < 0) ? -m : 2*size - 2 - m;
+        return m;
+    }
+
+        // lines_[level] holds row y of 'level': pass it on and reduce it further
+    void emitRow(int level, int y)
+    {
+        sink_(level, y, lines_[level].begin(), lines_[level].end());
+        if(level < highestLevel_)
+            reduceRow(level + 1);
+    }
+
+        // add the current row of level-1 to 'level' and compute the rows
+        // of 'level' which have become computable 
+    void reduceRow(int level)
+    {
+        typedef typename PromoteTraits<PixelType, double>::Promote SumType;
+        typedef typename PromoteTraits<TmpType, double>::Promote TmpSumType;
+
+        int wold = sizes_[level-1].x, 
+            hold = sizes_[level-1].y,
+            w    = sizes_[level].x,
+            h    = sizes_[level].y;
+        int r = received_[level]++;
+
+        // reduce horizontally into the ring buffer
+        const_iterator s = lines_[level-1].begin();
+        typename ArrayVector<TmpType>::iterator t = rows_[level].begin() + (r % 5)*w;
+        for(int x=0; x<w; ++x)
+        {
+            int is = 2*x;
+            SumType sum = NumericTraits<SumType>::zero();
+            if(is < 2 || is + 2 >= wold)
+            {
+                for(int m=is-2, k=0; m <= is+2; ++m, ++k)
+                    sum += kernel_[k] * s[reflect(m, wold)];
+            }
+            else
+            {
+                const_iterator ss = s + is - 2;
+                for(int k=0; k < 5; ++k, ++ss)
+                    sum += kernel_[k] * *ss;
+            }
+            t[x] = detail::RequiresExplicitCast<TmpType>::cast(sum);
+        }
+
+        // reduce vertically when all required rows are available
+        for(; emitted_[level] < h; ++emitted_[level])
+        {
+            int y = emitted_[level];
+            if(2*y + 2 > r && r < hold - 1)
+                break;
+            typename ArrayVector<TmpType>::const_iterator rows[5];
+            for(int k=0; k<5; ++k)
+                rows[k] = rows_[level].begin() + (reflect(2*y - 2 + k, hold) % 5)*w;
+            typename ArrayVector<PixelType>::iterator d = lines_[level].begin();
+            for(int x=0; x<w; ++x)
+            {
+                TmpSumType sum = NumericTraits<TmpSumType>::zero();
+                for(int k=0; k < 5; ++k)
+                    sum += kernel_[k] * rows[k][x];
+                d[x] = detail::RequiresExplicitCast<PixelType>::cast(sum);
+            }
+            emitRow(level, y);
+        }
+    }
+
+    Sink & sink_;
+    int highestLevel_;
+    double kernel_[5];
+    ArrayVector<Size2D> sizes_;
+    ArrayVector<int> received_, emitted_;
+    ArrayVector<ArrayVector<PixelType> > lines_;
+    ArrayVector<ArrayVector<TmpType> > rows_;
+};
+
 /** \brief Two-fold up-sampling for image pyramid reconstruction.
 
     Sorry, no \ref detailedDocumentation() available yet.
@@ -45,6 +45,7 @@
 #include "separableconvolution.hxx"
 #include "resampling_convolution.hxx"
 #include "splines.hxx"
+#include "parallel.hxx"
 
 namespace vigra {
 
@@ -552,6 +553,73 @@ resizeImageLinearInterpolation(triple<SrcIterator, SrcIterator, SrcAccessor> src
 /*                                                             */
 /***************************************************************/
 
+namespace detail {
+
+    // Resizes the lines [begin, end) of an image along the x-axis (DIRECTION == 0,
+    // i.e. rows) or y-axis (DIRECTION == 1, i.e. columns): the optional spline 
+    // prefilter and anti-aliasing smoothing are applied, followed by the 
+    // resampling convolution.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class TmpType, int DIRECTION>
+struct ResizeSplineLineFunctor
+{
+    SrcIterator src;
+    SrcAccessor src_acc;
+    DestIterator dest;
+    DestAccessor dest_acc;
+    resampling_detail::ResamplingKernelTable const & kernels;
+    ArrayVector<double> const & prefilterCoeffs;
+    double smoothingScale;  // 0.0 if no smoothing is required
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        ArrayVector<TmpType> line(kernels.sourceSize());
+        for(; begin < end; ++begin)
+        {
+            if(DIRECTION == 0)
+                resizeLine((src + Diff2D(0, begin)).rowIterator(), 
+                           (dest + Diff2D(0, begin)).rowIterator(), line);
+            else
+                resizeLine((src + Diff2D(begin, 0)).columnIterator(), 
+                           (dest + Diff2D(begin, 0)).columnIterator(), line);
+        }
+    }
+
+    template <class SrcLineIterator, class DestLineIterator>
+    void resizeLine(SrcLineIterator s, DestLineIterator d, ArrayVector<TmpType> & line) const
+    {
+        typename ArrayVector<TmpType>::iterator t = line.begin(), tend = line.end();
+        typename AccessorTraits<TmpType>::default_accessor ta;
+        int size = line.size();
+
+        if(prefilterCoeffs.size() == 0)
+        {
+            if(smoothingScale == 0.0)
+            {
+                kernels.convolveLine(s, src_acc, d, dest_acc);
+                return;
+            }
+            recursiveSmoothLine(s, s + size, src_acc, t, ta, smoothingScale);
+        }
+        else
+        {
+            recursiveFilterLine(s, s + size, src_acc, t, ta,
+                                prefilterCoeffs[0], BORDER_TREATMENT_REFLECT);
+            for(unsigned int b = 1; b < prefilterCoeffs.size(); ++b)
+            {
+                recursiveFilterLine(t, tend, ta, t, ta,
+                                    prefilterCoeffs[b], BORDER_TREATMENT_REFLECT);
+            }
+            if(smoothingScale != 0.0)
+                recursiveSmoothLine(t, tend, ta, t, ta, smoothingScale);
+        }
+        kernels.convolveLine(t, ta, d, dest_acc);
+    }
+};
+
+} // namespace detail
+
 /** \brief Resize image using B-spline interpolation.
 
     The function implements separable spline interpolation algorithm described in
@@ -579,6 +647,12 @@ resizeImageLinearInterpolation(triple<SrcIterator, SrcIterator, SrcAccessor> src
     and multiplication (+, -, *), multiplication with a scalar
     real number and \ref NumericTraits "NumericTraits".
     The function uses accessors.
+    
+    The kernel weights of all target positions are computed once per axis. 
+    The columns (in the first pass) and rows (in the second pass) are 
+    then processed independently and can be distributed over <tt>nthreads</tt> 
+    threads (see \ref parallelForChunks()). The result doesn't depend on the
+    number of threads.
 
     <b> Declarations:</b>
 
@@ -592,7 +666,7 @@ resizeImageLinearInterpolation(triple<SrcIterator, SrcIterator, SrcAccessor> src
         resizeImageSplineInterpolation(
               SrcImageIterator is, SrcImageIterator iend, SrcAccessor sa,
               DestImageIterator id, DestImageIterator idend, DestAccessor da,
-              SPLINE spline = BSpline<3, double>())
+              SPLINE spline = BSpline<3, double>(), int nthreads = 1)
     }
     \endcode
 
@@ -607,7 +681,7 @@ resizeImageLinearInterpolation(triple<SrcIterator, SrcIterator, SrcAccessor> src
         resizeImageSplineInterpolation(
               triple<SrcImageIterator, SrcImageIterator, SrcAccessor> src,
               triple<DestImageIterator, DestImageIterator, DestAccessor> dest,
-              SPLINE spline = BSpline<3, double>())
+              SPLINE spline = BSpline<3, double>(), int nthreads = 1)
     }
     \endcode
 
@@ -669,7 +743,7 @@ void
 resizeImageSplineInterpolation(
     SrcIterator src_iter, SrcIterator src_iter_end, SrcAccessor src_acc,
     DestIterator dest_iter, DestIterator dest_iter_end, DestAccessor dest_acc,
-    SPLINE const & spline)
+    SPLINE const & spline, int nthreads = 1)
 {
 
     int width_old = src_iter_end.x - src_iter.x;
@@ -703,113 +777,31 @@ resizeImageSplineInterpolation(
 
     BasicImage<TMPTYPE> tmp(width_old, height_new);
 
-    BasicImage<TMPTYPE> line((height_old > width_old) ? height_old : width_old, 1);
-    typename BasicImage<TMPTYPE>::Accessor tmp_acc = tmp.accessor();
     ArrayVector<double> const & prefilterCoeffs = spline.prefilterCoefficients();
 
-    int x,y;
-
+    // the kernels of all target positions are computed once per axis
     ArrayVector<Kernel1D<double> > kernels(yperiod);
     createResamplingKernels(spline, ymapCoordinate, kernels);
-
-    typename BasicImage<TMPTYPE>::Iterator y_tmp = tmp.upperLeft();
-    typename TmpImageIterator::row_iterator line_tmp = line.upperLeft().rowIterator();
-
-    for(x=0; x<width_old; ++x, ++src_iter.x, ++y_tmp.x)
-    {
-
-        typename SrcIterator::column_iterator c_src = src_iter.columnIterator();
-        typename TmpImageIterator::column_iterator c_tmp = y_tmp.columnIterator();
-
-        if(prefilterCoeffs.size() == 0)
-        {
-            if(height_new >= height_old)
-            {
-                resamplingConvolveLine(c_src, c_src + height_old, src_acc,
-                                       c_tmp, c_tmp + height_new, tmp_acc,
-                                       kernels, ymapCoordinate);
-            }
-            else
-            {
-                recursiveSmoothLine(c_src, c_src + height_old, src_acc,
-                     line_tmp, line.accessor(), (double)height_old/height_new/scale);
-                resamplingConvolveLine(line_tmp, line_tmp + height_old, line.accessor(),
-                                       c_tmp, c_tmp + height_new, tmp_acc,
-                                       kernels, ymapCoordinate);
-            }
-        }
-        else
-        {
-            recursiveFilterLine(c_src, c_src + height_old, src_acc,
-                                line_tmp, line.accessor(),
-                                prefilterCoeffs[0], BORDER_TREATMENT_REFLECT);
-            for(unsigned int b = 1; b < prefilterCoeffs.size(); ++b)
-            {
-                recursiveFilterLine(line_tmp, line_tmp + height_old, line.accessor(),
-                                    line_tmp, line.accessor(),
-                                    prefilterCoeffs[b], BORDER_TREATMENT_REFLECT);
-            }
-            if(height_new < height_old)
-            {
-                recursiveSmoothLine(line_tmp, line_tmp + height_old, line.accessor(),
-                     line_tmp, line.accessor(), (double)height_old/height_new/scale);
-            }
-            resamplingConvolveLine(line_tmp, line_tmp + height_old, line.accessor(),
-                                   c_tmp, c_tmp + height_new, tmp_acc,
-                                   kernels, ymapCoordinate);
-        }
-    }
-
-    y_tmp = tmp.upperLeft();
-
-    DestIterator dest = dest_iter;
+    resampling_detail::ResamplingKernelTable ykernels(kernels, ymapCoordinate, height_old, height_new);
 
     kernels.resize(xperiod);
     createResamplingKernels(spline, xmapCoordinate, kernels);
-
-    for(y=0; y < height_new; ++y, ++y_tmp.y, ++dest_iter.y)
-    {
-        typename DestIterator::row_iterator r_dest = dest_iter.rowIterator();
-        typename TmpImageIterator::row_iterator r_tmp = y_tmp.rowIterator();
-
-        if(prefilterCoeffs.size() == 0)
-        {
-            if(width_new >= width_old)
-            {
-                resamplingConvolveLine(r_tmp, r_tmp + width_old, tmp.accessor(),
-                                       r_dest, r_dest + width_new, dest_acc,
-                                       kernels, xmapCoordinate);
-            }
-            else
-            {
-                recursiveSmoothLine(r_tmp, r_tmp + width_old, tmp.accessor(),
-                                  line_tmp, line.accessor(), (double)width_old/width_new/scale);
-                resamplingConvolveLine(line_tmp, line_tmp + width_old, line.accessor(),
-                                       r_dest, r_dest + width_new, dest_acc,
-                                       kernels, xmapCoordinate);
-            }
-        }
-        else
-        {
-            recursiveFilterLine(r_tmp, r_tmp + width_old, tmp.accessor(),
-                                line_tmp, line.accessor(),
-                                prefilterCoeffs[0], BORDER_TREATMENT_REFLECT);
-            for(unsigned int b = 1; b < prefilterCoeffs.size(); ++b)
-            {
-                recursiveFilterLine(line_tmp, line_tmp + width_old, line.accessor(),
-                                    line_tmp, line.accessor(),
-                                    prefilterCoeffs[b], BORDER_TREATMENT_REFLECT);
-            }
-            if(width_new < width_old)
-            {
-                recursiveSmoothLine(line_tmp, line_tmp + width_old, line.accessor(),
-                                    line_tmp, line.accessor(), (double)width_old/width_new/scale);
-            }
-            resamplingConvolveLine(line_tmp, line_tmp + width_old, line.accessor(),
-                                   r_dest, r_dest + width_new, dest_acc,
-                                   kernels, xmapCoordinate);
-        }
-    }
+    resampling_detail::ResamplingKernelTable xkernels(kernels, xmapCoordinate, width_old, width_new);
+
+    // resize the columns, then the rows
+    detail::ResizeSplineLineFunctor<SrcIterator, SrcAccessor, TmpImageIterator, 
+                                    typename TmpImage::Accessor, TMPTYPE, 1> 
+        resizeColumns = { src_iter, src_acc, tmp.upperLeft(), tmp.accessor(), 
+                          ykernels, prefilterCoeffs, 
+                          height_new < height_old ? (double)height_old/height_new/scale : 0.0 };
+    parallelForChunks(width_old, resizeColumns, nthreads);
+
+    detail::ResizeSplineLineFunctor<TmpImageIterator, typename TmpImage::Accessor, 
+                                    DestIterator, DestAccessor, TMPTYPE, 0> 
+        resizeRows = { tmp.upperLeft(), tmp.accessor(), dest_iter, dest_acc, 
+                       xkernels, prefilterCoeffs, 
+                       width_new < width_old ? (double)width_old/width_new/scale : 0.0 };
+    parallelForChunks(height_new, resizeRows, nthreads);
 }
 
 template <class SrcIterator, class SrcAccessor,
@@ -819,10 +811,10 @@ inline
 void
 resizeImageSplineInterpolation(triple<SrcIterator, SrcIterator, SrcAccessor> src,
                       triple<DestIterator, DestIterator, DestAccessor> dest,
-                      SPLINE const & spline)
+                      SPLINE const & spline, int nthreads = 1)
 {
     resizeImageSplineInterpolation(src.first, src.second, src.third,
-                                   dest.first, dest.second, dest.third, spline);
+                                   dest.first, dest.second, dest.third, spline, nthreads);
 }
 
 template <class SrcIterator, class SrcAccessor,
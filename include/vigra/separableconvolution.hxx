@@ -431,6 +431,255 @@ void internalConvolveLineAvoid(SrcIterator is, SrcIterator iend, SrcAccessor sa,
     }
 }
 
+/********************************************************/
+/*                                                      */
+/*            internalConvolveLineSymmetric             */
+/*                                                      */
+/********************************************************/
+
+namespace detail {
+
+    // Returns 1 if the kernel is symmetric (k[-i] == k[i]), -1 if it is
+    // antisymmetric (k[-i] == -k[i]), and 0 otherwise. Only scalar source
+    // types take advantage of symmetry (see convolveLine()), all others get 0.
+template <class SrcValue, class KernelIterator, class KernelAccessor>
+int
+convolveLineSymmetry(KernelIterator ik, KernelAccessor ka, int kleft, int kright,
+                     VigraTrueType /* scalar source */)
+{
+    if(kleft != -kright || kright == 0)
+        return 0;
+    bool symmetric = true, antisymmetric = (ka(ik) == NumericTraits<typename KernelAccessor::value_type>::zero());
+    for(int i=1; i<=kright && (symmetric || antisymmetric); ++i)
+    {
+        if(ka(ik + i) != ka(ik - i))
+            symmetric = false;
+        if(ka(ik + i) != -ka(ik - i))
+            antisymmetric = false;
+    }
+    return symmetric
+              ? 1
+              : antisymmetric
+                  ? -1
+                  : 0;
+}
+
+template <class SrcValue, class KernelIterator, class KernelAccessor>
+inline int
+convolveLineSymmetry(KernelIterator, KernelAccessor, int, int,
+                     VigraFalseType /* scalar source */)
+{
+    return 0;
+}
+
+template <class SrcValue, class KernelIterator, class KernelAccessor>
+inline int
+convolveLineSymmetry(KernelIterator ik, KernelAccessor ka, int kleft, int kright)
+{
+    return convolveLineSymmetry<SrcValue>(ik, ka, kleft, kright,
+                                          typename NumericTraits<SrcValue>::isScalar());
+}
+
+    // Convolution of the interior [start, stop) of a line (where the kernel
+    // fits completely into the line) with a (anti-)symmetric kernel of radius
+    // 'kright'. Mirrored source values are combined before multiplication:
+    //
+    //     sum = k[0]*s[x] + k[1]*(s[x-1] + s[x+1]) + k[2]*(s[x-2] + s[x+2]) + ...
+    //
+    // which halves the number of multiplications. The contiguous variant below
+    // must use exactly the same order of operations.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+void internalConvolveLineSymmetric(SrcIterator is, SrcAccessor sa,
+                                   DestIterator id, DestAccessor da,
+                                   KernelIterator ik, KernelAccessor ka,
+                                   int kright, int symmetry, int start, int stop)
+{
+    typedef typename PromoteTraits<
+            typename SrcAccessor::value_type,
+            typename KernelAccessor::value_type>::Promote SumType;
+
+    is += start;
+    for(int x=start; x<stop; ++x, ++is, ++id)
+    {
+        SumType sum = NumericTraits<SumType>::zero();
+        if(symmetry > 0)
+        {
+            sum += ka(ik) * sa(is);
+            for(int i=1; i<=kright; ++i)
+            {
+                SumType v = sa(is + (-i));
+                v += sa(is + i);
+                sum += ka(ik + i) * v;
+            }
+        }
+        else
+        {
+            for(int i=1; i<=kright; ++i)
+            {
+                SumType v = sa(is + (-i));
+                v -= sa(is + i);
+                sum += ka(ik + i) * v;
+            }
+        }
+        da.set(detail::RequiresExplicitCast<typename
+                      DestAccessor::value_type>::cast(sum), id);
+    }
+}
+
+    // Variant for contiguous source data. The output is computed in chunks, and
+    // the loops within a chunk run over consecutive source elements, so that the 
+    // compiler can vectorize them.
+template <class T, class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+void internalConvolveLineSymmetricContiguous(T const * is,
+                                   DestIterator id, DestAccessor da,
+                                   KernelIterator ik, KernelAccessor ka,
+                                   int kright, int symmetry, int start, int stop)
+{
+    typedef typename KernelAccessor::value_type KernelValue;
+    typedef typename PromoteTraits<T, KernelValue>::Promote SumType;
+    enum { ChunkSize = 256 };
+
+    SumType sum[ChunkSize];
+    for(int x=start; x<stop; x+=ChunkSize)
+    {
+        int size = std::min((int)ChunkSize, stop - x);
+        T const * s = is + x;
+
+        for(int k=0; k<size; ++k)
+            sum[k] = NumericTraits<SumType>::zero();
+        if(symmetry > 0)
+        {
+            KernelValue kv = ka(ik);
+            for(int k=0; k<size; ++k)
+                sum[k] += kv * s[k];
+        }
+        for(int i=1; i<=kright; ++i)
+        {
+            KernelValue kv = ka(ik + i);
+            T const * l = s - i;
+            T const * r = s + i;
+            if(symmetry > 0)
+            {
+                for(int k=0; k<size; ++k)
+                    sum[k] += kv * ((SumType)l[k] + (SumType)r[k]);
+            }
+            else
+            {
+                for(int k=0; k<size; ++k)
+                    sum[k] += kv * ((SumType)l[k] - (SumType)r[k]);
+            }
+        }
+        for(int k=0; k<size; ++k, ++id)
+            da.set(detail::RequiresExplicitCast<typename
+                          DestAccessor::value_type>::cast(sum[k]), id);
+    }
+}
+
+#define VIGRA_CONTIGUOUS_CONVOLVE_LINE(POINTER, ACCESSOR) \
+template <class T, class DestIterator, class DestAccessor, \
+          class KernelIterator, class KernelAccessor> \
+inline void internalConvolveLineSymmetric(POINTER is, ACCESSOR, \
+                                   DestIterator id, DestAccessor da, \
+                                   KernelIterator ik, KernelAccessor ka, \
+                                   int kright, int symmetry, int start, int stop) \
+{ \
+    internalConvolveLineSymmetricContiguous(static_cast<T const *>(is), id, da, ik, ka, \
+                                            kright, symmetry, start, stop); \
+}
+
+VIGRA_CONTIGUOUS_CONVOLVE_LINE(T *, StandardAccessor<T>)
+VIGRA_CONTIGUOUS_CONVOLVE_LINE(T *, StandardValueAccessor<T>)
+VIGRA_CONTIGUOUS_CONVOLVE_LINE(T *, StandardConstAccessor<T>)
+VIGRA_CONTIGUOUS_CONVOLVE_LINE(T *, StandardConstValueAccessor<T>)
+VIGRA_CONTIGUOUS_CONVOLVE_LINE(T const *, StandardConstAccessor<T>)
+VIGRA_CONTIGUOUS_CONVOLVE_LINE(T const *, StandardConstValueAccessor<T>)
+
+#undef VIGRA_CONTIGUOUS_CONVOLVE_LINE
+
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor, class Norm>
+void internalConvolveLine(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                          DestIterator id, DestAccessor da,
+                          KernelIterator ik, KernelAccessor ka,
+                          int kleft, int kright, BorderTreatmentMode border,
+                          Norm norm, int start, int stop)
+{
+    switch(border)
+    {
+      case BORDER_TREATMENT_WRAP:
+      {
+        internalConvolveLineWrap(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_AVOID:
+      {
+        internalConvolveLineAvoid(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_REFLECT:
+      {
+        internalConvolveLineReflect(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_REPEAT:
+      {
+        internalConvolveLineRepeat(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_CLIP:
+      {
+        internalConvolveLineClip(is, iend, sa, id, da, ik, ka, kleft, kright, norm, start, stop);
+        break;
+      }
+      default:
+      {
+        vigra_precondition(0,
+                     "convolveLine(): Unknown border treatment mode.\n");
+      }
+    }
+}
+
+    // Convolution of a line after the preconditions have been checked and
+    // the norm has been computed (needed for BORDER_TREATMENT_CLIP only).
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor, class Norm>
+void convolveLineImpl(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                      DestIterator id, DestAccessor da,
+                      KernelIterator ik, KernelAccessor ka,
+                      int kleft, int kright, BorderTreatmentMode border,
+                      Norm norm, int start, int stop)
+{
+    int w = std::distance( is, iend );
+    int symmetry = border == BORDER_TREATMENT_AVOID
+                       ? 0
+                       : convolveLineSymmetry<typename SrcAccessor::value_type>(ik, ka, kleft, kright);
+    if(symmetry == 0)
+    {
+        internalConvolveLine(is, iend, sa, id, da, ik, ka, kleft, kright, border, norm, start, stop);
+        return;
+    }
+
+    // symmetric kernel: only the borders need the border treatment
+    if(stop == 0)
+        stop = w;
+    int istart = std::min(std::max(start, kright), stop),
+        istop  = std::max(std::min(stop, w - kright), istart);
+
+    if(start < istart)
+        internalConvolveLine(is, iend, sa, id, da, ik, ka, kleft, kright, border, norm, start, istart);
+    internalConvolveLineSymmetric(is, sa, id + (istart - start), da, ik, ka, 
+                                  kright, symmetry, istart, istop);
+    if(istop < stop)
+        internalConvolveLine(is, iend, sa, id + (istop - start), da, ik, ka, kleft, kright, border, norm, istop, stop);
+}
+
+} // namespace detail
+
 /********************************************************/
 /*                                                      */
 /*         Separable convolution functions              */
@@ -448,6 +697,210 @@ void internalConvolveLineAvoid(SrcIterator is, SrcIterator iend, SrcAccessor sa,
 */
 //@{
 
+/********************************************************/
+/*                                                      */
+/*                 FixedPointConvolution                */
+/*                                                      */
+/********************************************************/
+
+/** \brief Option object that selects the fixed-point integer variants of 
+    \ref convolveLine(), \ref separableConvolveX() and \ref separableConvolveY().
+
+    Passing this object to the convolution functions converts the kernel into 
+    integer weights with <tt>F</tt> fractional bits, and the convolution is then 
+    performed entirely in 32-bit integer arithmetic (which the compiler vectorizes
+    for contiguous data). This is considerably faster than the default 
+    floating-point path for 8- and 16-bit images. The source value_type must
+    be a scalar integer type of at most 16 bits.
+    
+    <b>Rounding behaviour:</b>
+    
+    <ul>
+    <li> Each kernel weight <tt>w</tt> is quantized to <tt>round(w * 2<sup>F</sup>)</tt>,
+         rounding half away from zero, so that (anti-)symmetric kernels remain 
+         (anti-)symmetric. The center weight is then adjusted such that the sum of the
+         integer weights equals <tt>round(sum(w) * 2<sup>F</sup>)</tt>, i.e. a 
+         normalized smoothing kernel maps constant images exactly onto themselves.
+    <li> Sums are accumulated exactly in <tt>Int32</tt>. <tt>F</tt> is chosen (or checked, 
+         if given explicitly) such that no overflow can occur for any input.
+    <li> For integral destination types, the result is rounded to nearest, ties towards 
+         plus infinity (<tt>(sum + 2<sup>F-1</sup>) >> F</tt>), and clamped to the 
+         destination's range. For floating-point destinations, the result is 
+         <tt>sum * 2<sup>-F</sup></tt> without further rounding.
+    <li> With <tt>BORDER_TREATMENT_CLIP</tt>, the renormalization at the borders
+         truncates the integer sum towards zero before the final rounding.
+    </ul>
+    
+    The quantization error per output value is thus bounded by 
+    <tt>sum(|w|) * maxSrc * 2<sup>-F-1</sup></tt> before the final rounding.
+    With the automatic choice, <tt>F</tt> is 23 for 8-bit and 15 for 16-bit images 
+    and a normalized non-negative kernel.
+    
+    <b>Usage:</b>
+    
+    <b>\#include</b> \<vigra/separableconvolution.hxx\>
+
+    \code
+    vigra::BImage src(w,h), tmp(w,h), dest(w,h);
+    ...
+    vigra::Kernel1D<double> gauss;
+    gauss.initGaussian(2.0);
+    
+    // automatic choice of the fractional bits
+    vigra::separableConvolveX(srcImageRange(src), destImage(tmp), kernel1d(gauss),
+                              vigra::FixedPointConvolution());
+    // use 12 fractional bits
+    vigra::separableConvolveY(srcImageRange(tmp), destImage(dest), kernel1d(gauss),
+                              vigra::FixedPointConvolution(12));
+    \endcode
+*/
+class FixedPointConvolution
+{
+  public:
+        /** Use <tt>fractionalBits</tt> fractional bits for the kernel weights 
+            (must be in [0, 30]). The default <tt>-1</tt> selects the largest number 
+            of bits (at most 24) that rules out overflow.
+        */
+    explicit FixedPointConvolution(int fractionalBits = -1)
+    : fractional_bits_(fractionalBits)
+    {
+        vigra_precondition(fractionalBits >= -1 && fractionalBits <= 30,
+             "FixedPointConvolution(): fractionalBits must be in [0, 30], or -1 for automatic.");
+    }
+
+        /** The requested number of fractional bits (<tt>-1</tt> means automatic).
+        */
+    int fractionalBits() const
+    {
+        return fractional_bits_;
+    }
+
+  private:
+    int fractional_bits_;
+};
+
+namespace detail {
+
+    // Quantize the kernel [kleft, kright] to integer weights with 'fracBits'
+    // fractional bits (or the largest safe number of bits, if fracBits == -1),
+    // such that convolving values of type SrcValue cannot overflow Int32.
+    // 'res' receives the weights of [kleft, kright], the return value is
+    // the number of fractional bits used.
+template <class SrcValue, class KernelIterator, class KernelAccessor>
+int quantizeConvolutionKernel(KernelIterator ik, KernelAccessor ka,
+                              int kleft, int kright, int fracBits,
+                              ArrayVector<Int32> & res)
+{
+    vigra_precondition(NumericTraits<SrcValue>::isIntegral::asBool && sizeof(SrcValue) <= 2,
+        "FixedPointConvolution: source type must be an integer type of at most 16 bits.");
+
+    double srcMax = std::max(std::abs((double)NumericTraits<SrcValue>::min()),
+                             std::abs((double)NumericTraits<SrcValue>::max()));
+    double sum = 0.0, kmax = 0.0;
+    for(int i=kleft; i<=kright; ++i)
+    {
+        sum += ka(ik + i);
+        kmax = std::max(kmax, std::abs((double)ka(ik + i)));
+    }
+
+    res.resize(kright - kleft + 1);
+    int bits = fracBits < 0 ? 24 : fracBits;
+    for(; bits >= 0; --bits)
+    {
+        double scale = std::ldexp(1.0, bits), absSum = 0.0;
+        if(scale * kmax < 1073741824.0 && std::abs(scale * sum) < 1073741824.0)
+        {
+            Int64 isum = 0;
+            for(int i=kleft; i<=kright; ++i)
+            {
+                res[i - kleft] = roundi(scale * ka(ik + i));
+                isum += res[i - kleft];
+            }
+            // correct the center weight to preserve the kernel's DC gain
+            res[-kleft] += (Int32)(roundi(scale * sum) - isum);
+            for(int i=0; i<(int)res.size(); ++i)
+                absSum += std::abs((double)res[i]);
+            if(absSum * srcMax <= (double)NumericTraits<Int32>::max())
+                return bits;
+        }
+        vigra_precondition(fracBits < 0,
+            "FixedPointConvolution: too many fractional bits, Int32 accumulator would overflow.");
+    }
+    vigra_precondition(false,
+        "FixedPointConvolution: kernel weights too large for Int32 accumulation.");
+    return 0;
+}
+
+    // Rescales the Int32 sums of the fixed-point convolution and writes them
+    // into the actual destination (see FixedPointConvolution for the rounding).
+template <class DestAccessor>
+class FixedPointConvolutionAccessor
+{
+  public:
+    typedef Int32 value_type;
+    typedef typename DestAccessor::value_type DestValue;
+
+    FixedPointConvolutionAccessor(DestAccessor const & a, int bits)
+    : a_(a),
+      bits_(bits),
+      half_(bits > 0 ? 1 << (bits - 1) : 0),
+      scale_(std::ldexp(1.0, -bits))
+    {}
+
+    template <class ITERATOR>
+    void set(Int32 v, ITERATOR const & i) const
+    {
+        a_.set(convert(v, typename NumericTraits<DestValue>::isIntegral()), i);
+    }
+
+  private:
+    DestValue convert(Int32 v, VigraTrueType) const
+    {
+        // the shift rounds towards minus infinity, so that ties round upwards
+        Int64 r = ((Int64)v + half_) >> bits_;
+        return r < (Int64)NumericTraits<DestValue>::min()
+                   ? NumericTraits<DestValue>::min()
+                   : r > (Int64)NumericTraits<DestValue>::max()
+                         ? NumericTraits<DestValue>::max()
+                         : (DestValue)r;
+    }
+
+    DestValue convert(Int32 v, VigraFalseType) const
+    {
+        return (DestValue)(scale_ * v);
+    }
+
+    DestAccessor a_;
+    int bits_;
+    Int32 half_;
+    double scale_;
+};
+
+    // Convolve a line with an already quantized kernel.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor>
+void fixedPointConvolveLine(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                            DestIterator id, DestAccessor da,
+                            ArrayVector<Int32> const & kernel, int bits,
+                            int kleft, int kright, BorderTreatmentMode border,
+                            int start, int stop)
+{
+    double norm = 0.0;
+    if(border == BORDER_TREATMENT_CLIP)
+    {
+        for(int i=0; i<(int)kernel.size(); ++i)
+            norm += kernel[i];
+        vigra_precondition(norm != 0.0,
+                     "convolveLine(): Norm of kernel must be != 0"
+                     " in mode BORDER_TREATMENT_CLIP.\n");
+    }
+    convolveLineImpl(is, iend, sa, id, FixedPointConvolutionAccessor<DestAccessor>(da, bits),
+                     kernel.begin() - kleft, StandardConstAccessor<Int32>(),
+                     kleft, kright, border, norm, start, stop);
+}
+
+} // namespace detail
+
 /** \brief Performs a 1-dimensional convolution of the source signal using the given
     kernel.
 
@@ -474,6 +927,18 @@ void internalConvolveLineAvoid(SrcIterator is, SrcIterator iend, SrcAccessor sa,
     <tt>start</tt>). If <tt>start</tt> and <tt>stop</tt> are both zero 
     (the default), the entire array is convolved.
 
+    When the source values are scalars and the kernel is symmetric or antisymmetric
+    (as are Gaussians and their derivatives), mirrored source values are added
+    (subtracted) before they are multiplied with the common kernel weight. This halves
+    the number of multiplications, but may change the result in the last bits. If the
+    source is a contiguous array (a pointer with a standard accessor), the loops are
+    additionally arranged such that the compiler can vectorize them.
+
+    When a \ref FixedPointConvolution object is passed after the border treatment mode,
+    the kernel is quantized to integer weights, and the convolution is computed
+    in 32-bit integer arithmetic. This requires an integral source type of
+    at most 16 bits and is much faster than the floating-point computation.
+
     <b> Declarations:</b>
 
     pass arguments explicitly:
@@ -487,6 +952,17 @@ void internalConvolveLineAvoid(SrcIterator is, SrcIterator iend, SrcAccessor sa,
                           KernelIterator ik, KernelAccessor ka,
                           int kleft, int kright, BorderTreatmentMode border,
                           int start = 0, int stop = 0 )
+
+        // fixed-point variant
+        template <class SrcIterator, class SrcAccessor,
+                  class DestIterator, class DestAccessor,
+                  class KernelIterator, class KernelAccessor>
+        void convolveLine(SrcIterator is, SrcIterator isend, SrcAccessor sa,
+                          DestIterator id, DestAccessor da,
+                          KernelIterator ik, KernelAccessor ka,
+                          int kleft, int kright, BorderTreatmentMode border,
+                          FixedPointConvolution const & options,
+                          int start = 0, int stop = 0 )
     }
     \endcode
 
@@ -601,33 +1077,11 @@ void convolveLine(SrcIterator is, SrcIterator iend, SrcAccessor sa,
         vigra_precondition(0 <= start && start < stop && stop <= w,
                         "convolveLine(): invalid subrange (start, stop).\n");
 
-    switch(border)
+    // find norm of kernel
+    typedef typename KernelAccessor::value_type KT;
+    KT norm = NumericTraits<KT>::zero();
+    if(border == BORDER_TREATMENT_CLIP)
     {
-      case BORDER_TREATMENT_WRAP:
-      {
-        internalConvolveLineWrap(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_AVOID:
-      {
-        internalConvolveLineAvoid(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_REFLECT:
-      {
-        internalConvolveLineReflect(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_REPEAT:
-      {
-        internalConvolveLineRepeat(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_CLIP:
-      {
-        // find norm of kernel
-        typedef typename KernelAccessor::value_type KT;
-        KT norm = NumericTraits<KT>::zero();
         KernelIterator iik = ik + kleft;
         for(int i=kleft; i<=kright; ++i, ++iik)
             norm += ka(iik);
@@ -635,16 +1089,9 @@ void convolveLine(SrcIterator is, SrcIterator iend, SrcAccessor sa,
         vigra_precondition(norm != NumericTraits<KT>::zero(),
                      "convolveLine(): Norm of kernel must be != 0"
                      " in mode BORDER_TREATMENT_CLIP.\n");
-
-        internalConvolveLineClip(is, iend, sa, id, da, ik, ka, kleft, kright, norm, start, stop);
-        break;
-      }
-      default:
-      {
-        vigra_precondition(0,
-                     "convolveLine(): Unknown border treatment mode.\n");
-      }
     }
+
+    detail::convolveLineImpl(is, iend, sa, id, da, ik, ka, kleft, kright, border, norm, start, stop);
 }
 
 template <class SrcIterator, class SrcAccessor,
@@ -663,6 +1110,54 @@ void convolveLine(triple<SrcIterator, SrcIterator, SrcAccessor> src,
                  kernel.third, kernel.fourth, kernel.fifth, start, stop);
 }
 
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+void convolveLine(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                  DestIterator id, DestAccessor da,
+                  KernelIterator ik, KernelAccessor ka,
+                  int kleft, int kright, BorderTreatmentMode border,
+                  FixedPointConvolution const & options,
+                  int start = 0, int stop = 0)
+{
+    vigra_precondition(kleft <= 0,
+                 "convolveLine(): kleft must be <= 0.\n");
+    vigra_precondition(kright >= 0,
+                 "convolveLine(): kright must be >= 0.\n");
+
+    int w = std::distance( is, iend );
+
+    vigra_precondition(w >= std::max(kright, -kleft) + 1,
+                 "convolveLine(): kernel longer than line.\n");
+                 
+    if(stop != 0)
+        vigra_precondition(0 <= start && start < stop && stop <= w,
+                        "convolveLine(): invalid subrange (start, stop).\n");
+
+    ArrayVector<Int32> kernel;
+    int bits = detail::quantizeConvolutionKernel<typename SrcAccessor::value_type>(
+                         ik, ka, kleft, kright, options.fractionalBits(), kernel);
+    detail::fixedPointConvolveLine(is, iend, sa, id, da, kernel, bits,
+                                   kleft, kright, border, start, stop);
+}
+
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+inline
+void convolveLine(triple<SrcIterator, SrcIterator, SrcAccessor> src,
+                  pair<DestIterator, DestAccessor> dest,
+                  tuple5<KernelIterator, KernelAccessor,
+                         int, int, BorderTreatmentMode> kernel,
+                  FixedPointConvolution const & options,
+                  int start = 0, int stop = 0)
+{
+    convolveLine(src.first, src.second, src.third,
+                 dest.first, dest.second,
+                 kernel.first, kernel.second,
+                 kernel.third, kernel.fourth, kernel.fifth, options, start, stop);
+}
+
 /********************************************************/
 /*                                                      */
 /*                      separableConvolveX              */
@@ -674,6 +1169,9 @@ void convolveLine(triple<SrcIterator, SrcIterator, SrcAccessor> src,
     It calls \ref convolveLine() for every row of the image. See \ref convolveLine() 
     for more information about required interfaces and vigra_preconditions.
 
+    All variants can be given an additional \ref FixedPointConvolution object as
+    last argument in order to select integer arithmetic for 8- and 16-bit images.
+
     <b> Declarations:</b>
 
     pass arguments explicitly:
@@ -773,6 +1271,57 @@ separableConvolveX(triple<SrcIterator, SrcIterator, SrcAccessor> src,
                  kernel.third, kernel.fourth, kernel.fifth);
 }
 
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+void separableConvolveX(SrcIterator supperleft,
+                        SrcIterator slowerright, SrcAccessor sa,
+                        DestIterator dupperleft, DestAccessor da,
+                        KernelIterator ik, KernelAccessor ka,
+                        int kleft, int kright, BorderTreatmentMode border,
+                        FixedPointConvolution const & options)
+{
+    vigra_precondition(kleft <= 0,
+                 "separableConvolveX(): kleft must be <= 0.\n");
+    vigra_precondition(kright >= 0,
+                 "separableConvolveX(): kright must be >= 0.\n");
+
+    int w = slowerright.x - supperleft.x;
+    int h = slowerright.y - supperleft.y;
+
+    vigra_precondition(w >= std::max(kright, -kleft) + 1,
+                 "separableConvolveX(): kernel longer than line\n");
+
+    ArrayVector<Int32> kernel;
+    int bits = detail::quantizeConvolutionKernel<typename SrcAccessor::value_type>(
+                         ik, ka, kleft, kright, options.fractionalBits(), kernel);
+
+    for(int y=0; y<h; ++y, ++supperleft.y, ++dupperleft.y)
+    {
+        typename SrcIterator::row_iterator rs = supperleft.rowIterator();
+        typename DestIterator::row_iterator rd = dupperleft.rowIterator();
+
+        detail::fixedPointConvolveLine(rs, rs+w, sa, rd, da, kernel, bits,
+                                       kleft, kright, border, 0, 0);
+    }
+}
+
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+inline void
+separableConvolveX(triple<SrcIterator, SrcIterator, SrcAccessor> src,
+                  pair<DestIterator, DestAccessor> dest,
+                  tuple5<KernelIterator, KernelAccessor,
+                         int, int, BorderTreatmentMode> kernel,
+                  FixedPointConvolution const & options)
+{
+    separableConvolveX(src.first, src.second, src.third,
+                 dest.first, dest.second,
+                 kernel.first, kernel.second,
+                 kernel.third, kernel.fourth, kernel.fifth, options);
+}
+
 
 
 /********************************************************/
@@ -786,6 +1335,9 @@ separableConvolveX(triple<SrcIterator, SrcIterator, SrcAccessor> src,
     It calls \ref convolveLine() for every column of the image. See \ref convolveLine() 
     for more information about required interfaces and vigra_preconditions.
 
+    All variants can be given an additional \ref FixedPointConvolution object as
+    last argument in order to select integer arithmetic for 8- and 16-bit images.
+
     <b> Declarations:</b>
 
     pass arguments explicitly:
@@ -885,6 +1437,95 @@ separableConvolveY(triple<SrcIterator, SrcIterator, SrcAccessor> src,
                  kernel.third, kernel.fourth, kernel.fifth);
 }
 
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+void separableConvolveY(SrcIterator supperleft,
+                        SrcIterator slowerright, SrcAccessor sa,
+                        DestIterator dupperleft, DestAccessor da,
+                        KernelIterator ik, KernelAccessor ka,
+                        int kleft, int kright, BorderTreatmentMode border,
+                        FixedPointConvolution const & options)
+{
+    vigra_precondition(kleft <= 0,
+                 "separableConvolveY(): kleft must be <= 0.\n");
+    vigra_precondition(kright >= 0,
+                 "separableConvolveY(): kright must be >= 0.\n");
+
+    int w = slowerright.x - supperleft.x;
+    int h = slowerright.y - supperleft.y;
+
+    vigra_precondition(h >= std::max(kright, -kleft) + 1,
+                 "separableConvolveY(): kernel longer than line\n");
+
+    ArrayVector<Int32> kernel;
+    int bits = detail::quantizeConvolutionKernel<typename SrcAccessor::value_type>(
+                         ik, ka, kleft, kright, options.fractionalBits(), kernel);
+
+    // rows where the kernel fits completely into the image
+    int istart = std::min(kright, h), 
+        istop  = std::max(h + kleft, istart);
+
+    // the border rows are processed column by column
+    if(border != BORDER_TREATMENT_AVOID && (istart > 0 || istop < h))
+    {
+        SrcIterator  sx = supperleft;
+        DestIterator dx = dupperleft;
+        for(int x=0; x<w; ++x, ++sx.x, ++dx.x)
+        {
+            typename SrcIterator::column_iterator cs = sx.columnIterator();
+            typename DestIterator::column_iterator cd = dx.columnIterator();
+
+            if(istart > 0)
+                detail::fixedPointConvolveLine(cs, cs+h, sa, cd, da, kernel, bits,
+                                               kleft, kright, border, 0, istart);
+            if(istop < h)
+                detail::fixedPointConvolveLine(cs, cs+h, sa, cd + istop, da, kernel, bits,
+                                               kleft, kright, border, istop, h);
+        }
+    }
+
+    // the interior is processed row by row, such that the innermost loop
+    // runs along the (usually contiguous) rows and can be vectorized
+    detail::FixedPointConvolutionAccessor<DestAccessor> fa(da, bits);
+    ArrayVector<Int32> sum(w);
+    dupperleft.y += istart;
+    for(int y=istart; y<istop; ++y, ++dupperleft.y)
+    {
+        std::fill(sum.begin(), sum.end(), 0);
+        for(int i=kleft; i<=kright; ++i)
+        {
+            Int32 k = kernel[i - kleft];
+            if(k == 0)
+                continue;
+            SrcIterator sy = supperleft;
+            sy.y += y - i;
+            typename SrcIterator::row_iterator rs = sy.rowIterator();
+            for(int x=0; x<w; ++x, ++rs)
+                sum[x] += k * (Int32)sa(rs);
+        }
+        typename DestIterator::row_iterator rd = dupperleft.rowIterator();
+        for(int x=0; x<w; ++x, ++rd)
+            fa.set(sum[x], rd);
+    }
+}
+
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor>
+inline void
+separableConvolveY(triple<SrcIterator, SrcIterator, SrcAccessor> src,
+                  pair<DestIterator, DestAccessor> dest,
+                  tuple5<KernelIterator, KernelAccessor,
+                         int, int, BorderTreatmentMode> kernel,
+                  FixedPointConvolution const & options)
+{
+    separableConvolveY(src.first, src.second, src.third,
+                 dest.first, dest.second,
+                 kernel.first, kernel.second,
+                 kernel.third, kernel.fourth, kernel.fifth, options);
+}
+
 //@}
 
 /********************************************************/
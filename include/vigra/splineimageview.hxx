@@ -45,6 +45,7 @@
 #include "tinyvector.hxx"
 #include "fixedpoint.hxx"
 #include "multi_array.hxx"
+#include "parallel.hxx"
 
 namespace vigra {
 
@@ -53,6 +54,101 @@ namespace vigra {
 /*                    SplineImageView                   */
 /*                                                      */
 /********************************************************/
+namespace detail {
+
+    // A regular sampling grid: point (i, j) is at origin + (i*step[0], j*step[1]).
+struct SplineImageViewGrid
+{
+    TinyVector<double, 2> origin, step;
+};
+
+template <class View, class Points, class Result>
+struct SplineImageViewSampleFunctor
+{
+    View const & view;
+    Points const & points;
+    ArrayVector<MultiArrayShape<2>::type> const & derivatives;
+    Result & res;
+
+    void operator()(std::ptrdiff_t begin, std::ptrdiff_t end) const
+    {
+        view.sampleImpl(begin, end, points, derivatives, res);
+    }
+};
+
+    // Driver of SplineImageView::sample(): the points are split into chunks
+    // which are processed by View::sampleImpl() in parallel.
+template <class View, class C, class S1, class U, class S2>
+void splineImageViewSample(View const & view,
+                           MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                           ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                           MultiArrayView<2, U, S2> res, int nthreads)
+{
+    vigra_precondition(res.shape(0) == points.shape(0) && 
+                       res.shape(1) == (MultiArrayIndex)derivatives.size(),
+        "SplineImageView::sample(): shape mismatch between points, derivatives and result.");
+
+    SplineImageViewSampleFunctor<View, MultiArrayView<1, TinyVector<C, 2>, S1>,
+                                 MultiArrayView<2, U, S2> > f = { view, points, derivatives, res };
+    parallelForChunks(points.shape(0), f, nthreads, 256);
+}
+
+    // Driver of SplineImageView::sampleGrid(): the rows of the grid are split into 
+    // chunks which are processed by View::sampleImpl() in parallel.
+template <class View, class U, class S>
+void splineImageViewSampleGrid(View const & view,
+                               TinyVector<double, 2> const & origin, 
+                               TinyVector<double, 2> const & step,
+                               ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                               MultiArrayView<3, U, S> res, int nthreads)
+{
+    vigra_precondition(res.shape(2) == (MultiArrayIndex)derivatives.size(),
+        "SplineImageView::sampleGrid(): shape mismatch between derivatives and result.");
+
+    SplineImageViewGrid grid = { origin, step };
+    SplineImageViewSampleFunctor<View, SplineImageViewGrid, 
+                                 MultiArrayView<3, U, S> > f = { view, grid, derivatives, res };
+    parallelForChunks(res.shape(1), f, nthreads, 4);
+}
+
+    // Straightforward sampling by means of view(x, y, dx, dy), used by the
+    // views of order 0 and 1 whose access functions have no internal state.
+template <class View, class C, class S1, class U, class S2>
+void splineImageViewSampleDirect(View const & view, std::ptrdiff_t begin, std::ptrdiff_t end,
+                                 MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                                 ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                                 MultiArrayView<2, U, S2> & res)
+{
+    for(; begin < end; ++begin)
+    {
+        double x = points(begin)[0], y = points(begin)[1];
+        for(unsigned int k=0; k<derivatives.size(); ++k)
+            res(begin, k) = RequiresExplicitCast<U>::cast(
+                                view(x, y, derivatives[k][0], derivatives[k][1]));
+    }
+}
+
+template <class View, class U, class S>
+void splineImageViewSampleDirect(View const & view, std::ptrdiff_t begin, std::ptrdiff_t end,
+                                 SplineImageViewGrid const & grid,
+                                 ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                                 MultiArrayView<3, U, S> & res)
+{
+    for(; begin < end; ++begin)
+    {
+        double y = grid.origin[1] + begin*grid.step[1];
+        for(MultiArrayIndex i=0; i<res.shape(0); ++i)
+        {
+            double x = grid.origin[0] + i*grid.step[0];
+            for(unsigned int k=0; k<derivatives.size(); ++k)
+                res(i, begin, k) = RequiresExplicitCast<U>::cast(
+                                       view(x, y, derivatives[k][0], derivatives[k][1]));
+        }
+    }
+}
+
+} // namespace detail
+
 /** \brief Create a continuous view onto a discrete image using splines.
 
     This class is very useful if image values or derivatives at arbitrary
@@ -369,6 +465,72 @@ class SplineImageView
     value_type g2yy(difference_type const & d) const
         { return g2yy(d[0], d[1]); }
 
+        /** Evaluate the spline at many points in one call: <tt>res(k)</tt> receives
+            the derivative of order <tt>(dx, dy)</tt> at the point <tt>points(k)</tt>,
+            i.e. the same value as <tt>splineView(points(k)[0], points(k)[1], dx, dy)</tt>.
+            
+            The points are distributed over <tt>nthreads</tt> threads (see \ref parallelForChunks()).
+            In contrast to the single-point access functions, this function doesn't 
+            modify the view's internal cache, so that it may be called concurrently
+            on the same view. An exception is thrown if any point is outside the
+            first reflection.
+        */
+    template <class C, class S1, class U, class S2>
+    void sample(MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                MultiArrayView<1, U, S2> res,
+                unsigned int dx = 0, unsigned int dy = 0, int nthreads = 1) const
+    {
+        ArrayVector<MultiArrayShape<2>::type> derivatives(1, MultiArrayShape<2>::type(dx, dy));
+        detail::splineImageViewSample(*this, points, derivatives, res.insertSingletonDimension(1), nthreads);
+    }
+
+        /** Evaluate several derivatives at many points in one pass: <tt>res(k, d)</tt>
+            receives the derivative of order <tt>derivatives[d]</tt> (i.e. <tt>(dx, dy)</tt>)
+            at the point <tt>points(k)</tt>. The facet lookup is done only once per point.
+            The shape of <tt>res</tt> must be <tt>(points.size(), derivatives.size())</tt>.
+        */
+    template <class C, class S1, class U, class S2>
+    void sample(MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                MultiArrayView<2, U, S2> res, int nthreads = 1) const
+    {
+        detail::splineImageViewSample(*this, points, derivatives, res, nthreads);
+    }
+
+        /** Evaluate the spline on a regular grid: <tt>res(i, j)</tt> receives the derivative
+            of order <tt>(dx, dy)</tt> at the point <tt>(origin[0] + i*step[0], origin[1] + j*step[1])</tt>.
+            For example, <tt>step = (0.5, 0.5)</tt> resamples the image at twice the resolution.
+            
+            Since all points in a column share the same x-weights and all points in a row 
+            the same y-weights, the weights are computed only once per column and row.
+            The vertical part of the convolution is computed for entire image rows at once
+            (in a loop the compiler can vectorize). This is much faster than 
+            calling <tt>operator()</tt> for each point. The rows are distributed over 
+            <tt>nthreads</tt> threads.
+        */
+    template <class U, class S>
+    void sampleGrid(difference_type const & origin, difference_type const & step,
+                    MultiArrayView<2, U, S> res,
+                    unsigned int dx = 0, unsigned int dy = 0, int nthreads = 1) const
+    {
+        ArrayVector<MultiArrayShape<2>::type> derivatives(1, MultiArrayShape<2>::type(dx, dy));
+        detail::splineImageViewSampleGrid(*this, origin, step, derivatives, 
+                                          res.insertSingletonDimension(2), nthreads);
+    }
+
+        /** Evaluate several derivatives on a regular grid in one pass: <tt>res(i, j, d)</tt> 
+            receives the derivative of order <tt>derivatives[d]</tt> at the point 
+            <tt>(origin[0] + i*step[0], origin[1] + j*step[1])</tt>. The last dimension of 
+            <tt>res</tt> must equal <tt>derivatives.size()</tt>.
+        */
+    template <class U, class S>
+    void sampleGrid(difference_type const & origin, difference_type const & step,
+                    ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                    MultiArrayView<3, U, S> res, int nthreads = 1) const
+    {
+        detail::splineImageViewSampleGrid(*this, origin, step, derivatives, res, nthreads);
+    }
+
         /** The width of the image.
             <tt>0 <= x <= width()-1</tt> is required for all access functions.
         */
@@ -491,12 +653,29 @@ class SplineImageView
     }
 
   protected:
+    template <class V, class P, class R> 
+    friend struct detail::SplineImageViewSampleFunctor;
 
     void init();
     void calculateIndices(double x, double y) const;
+    void calculateIndices(double x, double x1, int w1, int * ix, double & u) const;
     void coefficients(double t, double * const & c) const;
     void derivCoefficients(double t, unsigned int d, double * const & c) const;
     value_type convolve() const;
+    InternalValue convolve(double const * kx, int const * ix, 
+                           double const * ky, int const * iy) const;
+
+    template <class C, class S1, class U, class S2>
+    void sampleImpl(std::ptrdiff_t begin, std::ptrdiff_t end,
+                    MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                    ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                    MultiArrayView<2, U, S2> & res) const;
+
+    template <class U, class S>
+    void sampleImpl(std::ptrdiff_t begin, std::ptrdiff_t end,
+                    detail::SplineImageViewGrid const & grid,
+                    ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                    MultiArrayView<3, U, S> & res) const;
 
     unsigned int w_, h_;
     int w1_, h1_;
@@ -574,53 +753,51 @@ SplineImageView<ORDER, VALUETYPE>::calculateIndices(double x, double y) const
     if(x == x_ && y == y_)
         return;   // still in cache
 
-    if(x > x0_ && x < x1_ && y > y0_ && y < y1_)
+    if(!(x > x0_ && x < x1_ && y > y0_ && y < y1_))
+        vigra_precondition(isValid(x,y),
+                    "SplineImageView::calculateIndices(): coordinates out of range.");
+
+    calculateIndices(x, x1_, w1_, ix_, u_);
+    calculateIndices(y, y1_, h1_, iy_, v_);
+    x_ = x;
+    y_ = y;
+}
+
+    // Indices and facet coordinate along one axis, where 'x1' is the upper
+    // limit of the interior range (the lower one is kcenter_) and 'w1' the
+    // largest coordinate of that axis. Doesn't touch the cache.
+template <int ORDER, class VALUETYPE>
+void
+SplineImageView<ORDER, VALUETYPE>::calculateIndices(double x, double x1, int w1, 
+                                                    int * ix, double & u) const
+{
+    if(x > kcenter_ && x < x1)
     {
         detail::SplineImageViewUnrollLoop1<ORDER>::exec(
-                                (ORDER % 2) ? int(x - kcenter_) : int(x + 0.5 - kcenter_), ix_);
-        detail::SplineImageViewUnrollLoop1<ORDER>::exec(
-                                (ORDER % 2) ? int(y - kcenter_) : int(y + 0.5 - kcenter_), iy_);
-
-        u_ = x - ix_[kcenter_];
-        v_ = y - iy_[kcenter_];
+                                (ORDER % 2) ? int(x - kcenter_) : int(x + 0.5 - kcenter_), ix);
+        u = x - ix[kcenter_];
     }
     else
     {
-        vigra_precondition(isValid(x,y),
+        vigra_precondition(x < w1 + x1 && x > -x1,
                     "SplineImageView::calculateIndices(): coordinates out of range.");
 
         int xCenter = (ORDER % 2) ?
                       (int)VIGRA_CSTD::floor(x) :
                       (int)VIGRA_CSTD::floor(x + 0.5);
-        int yCenter = (ORDER % 2) ?
-                      (int)VIGRA_CSTD::floor(y) :
-                      (int)VIGRA_CSTD::floor(y + 0.5);
 
-        if(x >= x1_)
-        {
-            for(int i = 0; i < ksize_; ++i)
-                ix_[i] = w1_ - vigra::abs(w1_ - xCenter - (i - kcenter_));
-        }
-        else
-        {
-            for(int i = 0; i < ksize_; ++i)
-                ix_[i] = vigra::abs(xCenter - (kcenter_ - i));
-        }
-        if(y >= y1_)
+        if(x >= x1)
         {
             for(int i = 0; i < ksize_; ++i)
-                iy_[i] = h1_ - vigra::abs(h1_ - yCenter - (i - kcenter_));
+                ix[i] = w1 - vigra::abs(w1 - xCenter - (i - kcenter_));
         }
         else
         {
             for(int i = 0; i < ksize_; ++i)
-                iy_[i] = vigra::abs(yCenter - (kcenter_ - i));
+                ix[i] = vigra::abs(xCenter - (kcenter_ - i));
         }
-        u_ = x - xCenter;
-        v_ = y - yCenter;
+        u = x - xCenter;
     }
-    x_ = x;
-    y_ = y;
 }
 
 template <int ORDER, class VALUETYPE>
@@ -642,18 +819,130 @@ void SplineImageView<ORDER, VALUETYPE>::derivCoefficients(double t,
 
 template <int ORDER, class VALUETYPE>
 VALUETYPE SplineImageView<ORDER, VALUETYPE>::convolve() const
+{
+    return detail::RequiresExplicitCast<VALUETYPE>::cast(convolve(kx_, ix_, ky_, iy_));
+}
+
+template <int ORDER, class VALUETYPE>
+typename SplineImageView<ORDER, VALUETYPE>::InternalValue 
+SplineImageView<ORDER, VALUETYPE>::convolve(double const * kx, int const * ix, 
+                                            double const * ky, int const * iy) const
 {
     typedef typename NumericTraits<VALUETYPE>::RealPromote RealPromote;
     RealPromote sum;
     sum = RealPromote(
-      ky_[0]*detail::SplineImageViewUnrollLoop2<ORDER, RealPromote>::exec(kx_, image_.rowBegin(iy_[0]), ix_));
+      ky[0]*detail::SplineImageViewUnrollLoop2<ORDER, RealPromote>::exec(kx, image_.rowBegin(iy[0]), ix));
 
     for(int j=1; j<ksize_; ++j)
     {
         sum += RealPromote(
-          ky_[j]*detail::SplineImageViewUnrollLoop2<ORDER, RealPromote>::exec(kx_, image_.rowBegin(iy_[j]), ix_));
+          ky[j]*detail::SplineImageViewUnrollLoop2<ORDER, RealPromote>::exec(kx, image_.rowBegin(iy[j]), ix));
+    }
+    return sum;
+}
+
+template <int ORDER, class VALUETYPE>
+template <class C, class S1, class U, class S2>
+void 
+SplineImageView<ORDER, VALUETYPE>::sampleImpl(std::ptrdiff_t begin, std::ptrdiff_t end,
+                                   MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                                   ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                                   MultiArrayView<2, U, S2> & res) const
+{
+    int ix[ksize_], iy[ksize_];
+    double kx[ksize_], ky[ksize_], u, v;
+
+    for(; begin < end; ++begin)
+    {
+        double x = points(begin)[0], y = points(begin)[1];
+        calculateIndices(x, x1_, w1_, ix, u);
+        calculateIndices(y, y1_, h1_, iy, v);
+        for(unsigned int k=0; k<derivatives.size(); ++k)
+        {
+            derivCoefficients(u, derivatives[k][0], kx);
+            derivCoefficients(v, derivatives[k][1], ky);
+            res(begin, k) = detail::RequiresExplicitCast<U>::cast(convolve(kx, ix, ky, iy));
+        }
+    }
+}
+
+template <int ORDER, class VALUETYPE>
+template <class U, class S>
+void 
+SplineImageView<ORDER, VALUETYPE>::sampleImpl(std::ptrdiff_t begin, std::ptrdiff_t end,
+                                   detail::SplineImageViewGrid const & grid,
+                                   ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                                   MultiArrayView<3, U, S> & res) const
+{
+    int w = res.shape(0), nd = derivatives.size();
+    if(w == 0 || nd == 0)
+        return;
+
+    // x-indices and x-weights are the same in every row
+    ArrayVector<int> ix(w*ksize_);
+    ArrayVector<double> kx(nd*w*ksize_);
+    int xmin = w1_, xmax = 0;
+    for(int i=0; i<w; ++i)
+    {
+        double u;
+        calculateIndices(grid.origin[0] + i*grid.step[0], x1_, w1_, &ix[i*ksize_], u);
+        for(int m=0; m<ksize_; ++m)
+        {
+            xmin = std::min(xmin, ix[i*ksize_+m]);
+            xmax = std::max(xmax, ix[i*ksize_+m]);
+        }
+        for(int k=0; k<nd; ++k)
+            derivCoefficients(u, derivatives[k][0], &kx[(k*w + i)*ksize_]);
+    }
+    // make the indices relative to the first column used
+    for(int i=0; i<w*ksize_; ++i)
+        ix[i] -= xmin;
+
+    // results of the vertical convolution, one row per distinct y-derivative
+    int cols = xmax - xmin + 1;
+    ArrayVector<InternalValue> tmp(nd*cols);
+    ArrayVector<int> slot(nd);
+    for(int k=0; k<nd; ++k)
+    {
+        slot[k] = k;
+        for(int l=0; l<k; ++l)
+        {
+            if(derivatives[l][1] == derivatives[k][1])
+            {
+                slot[k] = slot[l];
+                break;
+            }
+        }
+    }
+
+    int iy[ksize_];
+    double ky[ksize_], v;
+    for(; begin < end; ++begin)
+    {
+        calculateIndices(grid.origin[1] + begin*grid.step[1], y1_, h1_, iy, v);
+        for(int k=0; k<nd; ++k)
+        {
+            InternalValue * t = &tmp[slot[k]*cols];
+            if(slot[k] == k)
+            {
+                derivCoefficients(v, derivatives[k][1], ky);
+                typename InternalImage::const_row_iterator r = image_.rowBegin(iy[0]) + xmin;
+                for(int c=0; c<cols; ++c)
+                    t[c] = ky[0]*r[c];
+                for(int m=1; m<ksize_; ++m)
+                {
+                    r = image_.rowBegin(iy[m]) + xmin;
+                    for(int c=0; c<cols; ++c)
+                        t[c] += ky[m]*r[c];
+                }
+            }
+            double const * kk = &kx[k*w*ksize_];
+            int const * ii = &ix[0];
+            for(int i=0; i<w; ++i, kk += ksize_, ii += ksize_)
+                res(i, begin, k) = detail::RequiresExplicitCast<U>::cast(
+                           detail::SplineImageViewUnrollLoop2<ORDER, InternalValue>::exec(kk, t, ii));
+        }
     }
-    return detail::RequiresExplicitCast<VALUETYPE>::cast(sum);
 }
 
 template <int ORDER, class VALUETYPE>
@@ -990,7 +1279,53 @@ class SplineImageView0Base
          return x0 == x1 && y0 == y1;
     }
 
+    template <class C, class S1, class U, class S2>
+    void sample(MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                MultiArrayView<1, U, S2> res,
+                unsigned int dx = 0, unsigned int dy = 0, int nthreads = 1) const
+    {
+        ArrayVector<MultiArrayShape<2>::type> derivatives(1, MultiArrayShape<2>::type(dx, dy));
+        detail::splineImageViewSample(*this, points, derivatives, res.insertSingletonDimension(1), nthreads);
+    }
+
+    template <class C, class S1, class U, class S2>
+    void sample(MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                MultiArrayView<2, U, S2> res, int nthreads = 1) const
+    {
+        detail::splineImageViewSample(*this, points, derivatives, res, nthreads);
+    }
+
+    template <class U, class S>
+    void sampleGrid(difference_type const & origin, difference_type const & step,
+                    MultiArrayView<2, U, S> res,
+                    unsigned int dx = 0, unsigned int dy = 0, int nthreads = 1) const
+    {
+        ArrayVector<MultiArrayShape<2>::type> derivatives(1, MultiArrayShape<2>::type(dx, dy));
+        detail::splineImageViewSampleGrid(*this, origin, step, derivatives, 
+                                          res.insertSingletonDimension(2), nthreads);
+    }
+
+    template <class U, class S>
+    void sampleGrid(difference_type const & origin, difference_type const & step,
+                    ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                    MultiArrayView<3, U, S> res, int nthreads = 1) const
+    {
+        detail::splineImageViewSampleGrid(*this, origin, step, derivatives, res, nthreads);
+    }
+
   protected:
+    template <class V, class P, class R> 
+    friend struct detail::SplineImageViewSampleFunctor;
+
+    template <class Points, class Result>
+    void sampleImpl(std::ptrdiff_t begin, std::ptrdiff_t end, Points const & points,
+                    ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                    Result & res) const
+    {
+        detail::splineImageViewSampleDirect(*this, begin, end, points, derivatives, res);
+    }
+
     unsigned int w_, h_;
     INTERNAL_INDEXER internalIndexer_;
 };
@@ -1557,7 +1892,53 @@ class SplineImageView1Base
          return x0 == x1 && y0 == y1;
     }
 
+    template <class C, class S1, class U, class S2>
+    void sample(MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                MultiArrayView<1, U, S2> res,
+                unsigned int dx = 0, unsigned int dy = 0, int nthreads = 1) const
+    {
+        ArrayVector<MultiArrayShape<2>::type> derivatives(1, MultiArrayShape<2>::type(dx, dy));
+        detail::splineImageViewSample(*this, points, derivatives, res.insertSingletonDimension(1), nthreads);
+    }
+
+    template <class C, class S1, class U, class S2>
+    void sample(MultiArrayView<1, TinyVector<C, 2>, S1> const & points,
+                ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                MultiArrayView<2, U, S2> res, int nthreads = 1) const
+    {
+        detail::splineImageViewSample(*this, points, derivatives, res, nthreads);
+    }
+
+    template <class U, class S>
+    void sampleGrid(difference_type const & origin, difference_type const & step,
+                    MultiArrayView<2, U, S> res,
+                    unsigned int dx = 0, unsigned int dy = 0, int nthreads = 1) const
+    {
+        ArrayVector<MultiArrayShape<2>::type> derivatives(1, MultiArrayShape<2>::type(dx, dy));
+        detail::splineImageViewSampleGrid(*this, origin, step, derivatives, 
+                                          res.insertSingletonDimension(2), nthreads);
+    }
+
+    template <class U, class S>
+    void sampleGrid(difference_type const & origin, difference_type const & step,
+                    ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                    MultiArrayView<3, U, S> res, int nthreads = 1) const
+    {
+        detail::splineImageViewSampleGrid(*this, origin, step, derivatives, res, nthreads);
+    }
+
   protected:
+    template <class V, class P, class R> 
+    friend struct detail::SplineImageViewSampleFunctor;
+
+    template <class Points, class Result>
+    void sampleImpl(std::ptrdiff_t begin, std::ptrdiff_t end, Points const & points,
+                    ArrayVector<MultiArrayShape<2>::type> const & derivatives,
+                    Result & res) const
+    {
+        detail::splineImageViewSampleDirect(*this, begin, end, points, derivatives, res);
+    }
+
     unsigned int w_, h_;
     INTERNAL_INDEXER internalIndexer_;
 };
@@ -111,6 +111,8 @@ std::string & operator<<(std::string & s, T const & t)
          <BR>&nbsp;&nbsp;&nbsp;<em>M_PI, M_SQRT2</em>
     <LI> \ref TimingMacros
          <BR>&nbsp;&nbsp;&nbsp;<em>Macros for taking execution speed measurements</em>
+    <LI> \ref ParallelProcessing
+         <BR>&nbsp;&nbsp;&nbsp;<em>Helpers for multi-threaded algorithms (based on OpenMP)</em>
     </UL>
 */
 
@@ -37,9 +37,8 @@
 #include <iostream>
 #include "vigra/stdimage.hxx"
 #include "vigra/stdimagefunctions.hxx"
-#include "vigra/distancetransform.hxx"
+#include "vigra/multi_distance.hxx"
 #include "vigra/labelimage.hxx"
-#include "vigra/seededregiongrowing.hxx"
 #include "vigra/impex.hxx"
 
 using namespace vigra; 
@@ -75,27 +74,31 @@ int main(int argc, char ** argv)
         // marked in the input image
         initImageIf(destImageRange(out), maskImage(in), 0);
         
-        // create image to hold the distance transform
+        // create images to hold the distance transform and the 
+        // coordinates of the nearest point
         vigra::FImage distances(size, size);
+        vigra::BasicImage<vigra::TinyVector<int, 2> > nearest(size, size);
         
-        // calculate Euclidean distance transform
-        distanceTransform(srcImageRange(in), destImage(distances), 0, 2);
+        // calculate the Euclidean distance and feature transform of the points
+        typedef vigra::MultiArrayShape<2>::type Shape;
+        vigra::MultiArrayView<2, float> inView(Shape(size, size), &in(0,0));
+        vigra::MultiArrayView<2, float> distView(Shape(size, size), &distances(0,0));
+        vigra::MultiArrayView<2, vigra::TinyVector<int, 2> > nearestView(Shape(size, size), &nearest(0,0));
+        separableMultiFeatureTransform(srcMultiArrayRange(inView), destMultiArray(distView),
+                                       destMultiArray(nearestView), true);
         
         exportImage(srcImageRange(distances), vigra::ImageExportInfo("distances.gif"));
         std::cout << "Wrote distance transform (distances.gif)" << std::endl;
         
-        // initialize statistics functor for region growing
-        vigra::ArrayOfRegionStatistics<vigra::SeedRgDirectValueFunctor<float> > 
-            statistics(number_of_points);
-
-        // perform region growing, starting at the points marked in the input
-        // image; as the feature (first source) image contains the distances,
-        // the will calculate the voronoi regions of these points
-        seededRegionGrowing(srcImageRange(distances), srcImage(in),
-                            destImage(in), statistics);
+        // each pixel gets the label of its nearest point, 
+        // which results in the voronoi regions of these points
+        vigra::IImage labels(size, size);
+        for(int y=0; y<size; ++y)
+            for(int x=0; x<size; ++x)
+                labels(x,y) = (int)inView[nearest(x,y)];
         
         // in the output image, mark the borders of the voronoi regions black 
-        regionImageToEdgeImage(srcImageRange(in), destImage(out), 0);
+        regionImageToEdgeImage(srcImageRange(labels), destImage(out), 0);
 
         exportImage(srcImageRange(out), vigra::ImageExportInfo("voronoi.gif"));
         std::cout << "Wrote voronoi diagram (voronoi.gif)" << std::endl;
@@ -930,9 +930,15 @@ VolumeImportInfo::VolumeImportInfo(const std::string &filename)
                     shape_[2] = atoi(value.c_str());
                 else if(key == "datatype")
                 {
-                    // FUTURE: store bit depth / signedness
                     if((value == "UNSIGNED_CHAR") || (value == "UNSIGNED_BYTE"))
+                        value = "UINT8";
+                    if(value == "UINT8"  || value == "INT16" || value == "UINT16" ||
+                       value == "INT32"  || value == "UINT32" ||
+                       value == "FLOAT"  || value == "DOUBLE")
+                    {
+                        pixelType_ = value;
                         numBands_ = 1;
+                    }
                     else
                     {
                         std::cerr << "Unknown datatype '" << value << "'!\n";
@@ -961,7 +967,10 @@ VolumeImportInfo::VolumeImportInfo(const std::string &filename)
         if((shape_[0]*shape_[1]*shape_[2] > 0) && (rawFilename_.size() > 0))
         {
             if(!numBands_)
+            {
                 numBands_ = 1; // default to UNSIGNED_CHAR datatype
+                pixelType_ = "UINT8";
+            }
 
             baseName_ = filename;
             if(name_.size() > 0)
@@ -1048,4 +1057,21 @@ MultiArrayIndex VolumeImportInfo::depth() const { return shape_[2]; }
 const std::string & VolumeImportInfo::name() const { return name_; }
 const std::string & VolumeImportInfo::description() const { return description_; }
 
+std::string VolumeImportInfo::rawFilename() const
+{
+    if(rawFilename_.size() == 0)
+        return rawFilename_;
+
+    // absolute paths are used as is
+    if(rawFilename_[0] == '/' || rawFilename_[0] == '\\' ||
+       (rawFilename_.size() > 1 && rawFilename_[1] == ':'))
+        return rawFilename_;
+
+    // relative paths refer to the directory of the info file
+    std::string::size_type split = baseName_.find_last_of("/\\");
+    if(split == std::string::npos)
+        return rawFilename_;
+    return baseName_.substr(0, split + 1) + rawFilename_;
+}
+
 } // namespace vigra
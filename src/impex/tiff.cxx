@@ -61,6 +61,7 @@
 #include "vigra/sized_int.hxx"
 #include "error.hxx"
 #include "tiff.hxx"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -104,7 +105,7 @@ namespace vigra {
 
         // init magic strings
 #if TIFFLIB_VERSION > 20070712
-        desc.magicStrings.resize(3);
+        desc.magicStrings.resize(4);
 #else
         desc.magicStrings.resize(2);
 #endif
@@ -125,6 +126,11 @@ namespace vigra {
         desc.magicStrings[2][1] = '\111';
         desc.magicStrings[2][2] = '\053';
         desc.magicStrings[2][3] = '\000';
+        desc.magicStrings[3].resize(4);
+        desc.magicStrings[3][0] = '\115';
+        desc.magicStrings[3][1] = '\115';
+        desc.magicStrings[3][2] = '\000';
+        desc.magicStrings[3][3] = '\053';
 #endif
 
         // init file extensions
@@ -218,14 +224,32 @@ namespace vigra {
 
         unsigned int scanline;
 
+        // tile geometry (tiled TIFFs only)
+        bool tiled;
+        uint32 tile_width, tile_height;
+        tdata_t tilebuffer;
+
+        // region of interest, and the image column held in the first
+        // pixel of the strip buffer and the buffer's width in pixels
+        uint32 roi_x, roi_y, roi_width, roi_height;
+        uint32 buffer_x, buffer_width;
+        unsigned int buffer_planes;
+
         std::string get_pixeltype_by_sampleformat() const;
         std::string get_pixeltype_by_datatype() const;
 
+        void allocateBuffers();
+        void freeBuffers();
+        void readTileRow( uint32 y );
+        void invertBuffer( tsize_t size );
+
     public:
 
         TIFFDecoderImpl( const std::string & filename );
+        ~TIFFDecoderImpl();
 
         void init( unsigned int imageIndex );
+        void setRegionOfInterest( const Rect2D & roi );
 
         unsigned int getNumImages();
         void setImageIndex( unsigned int index );
@@ -247,6 +271,17 @@ namespace vigra {
         }
 
         scanline = 0;
+        tiled = false;
+        tile_width = tile_height = 0;
+        tilebuffer = 0;
+        roi_x = roi_y = roi_width = roi_height = 0;
+        buffer_x = buffer_width = 0;
+        buffer_planes = 0;
+    }
+
+    TIFFDecoderImpl::~TIFFDecoderImpl()
+    {
+        freeBuffers();
     }
 
     std::string TIFFDecoderImpl::get_pixeltype_by_sampleformat() const
@@ -336,15 +371,16 @@ namespace vigra {
         TIFFGetField( tiff, TIFFTAG_IMAGELENGTH, &height );
 
         // check for tiled TIFFs
-        uint32 tileWidth, tileHeight;
-        if( TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tileWidth ) &&
-            TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tileHeight ) )
-            vigra_precondition( (tileWidth == width) && (tileHeight == height),
-                                "TIFFDecoderImpl::init(): "
-                                "Cannot read tiled TIFFs (not implemented)." );
-
-        // find out strip heights
-        stripheight = 1; // now using scanline interface instead of strip interface
+        tiled = TIFFIsTiled( tiff ) != 0;
+        if ( tiled ) {
+            TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tile_width );
+            TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tile_height );
+            // a row of tiles is decoded at once
+            stripheight = tile_height;
+        } else {
+            // find out strip heights
+            stripheight = 1; // now using scanline interface instead of strip interface
+        }
 
         // get samples_per_pixel
         samples_per_pixel = 0;
@@ -426,6 +462,14 @@ namespace vigra {
                             " set. A suitable default was not found." );
         }
 
+        // compressed planes cannot be read scanline by scanline in
+        // alternating order, so separate planes are decoded strip-wise
+        if ( !tiled && planarconfig == PLANARCONFIG_SEPARATE ) {
+            uint32 rowsperstrip = height;
+            TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &rowsperstrip );
+            stripheight = std::min( rowsperstrip, height );
+        }
+
         // get bits per pixel
         if ( !TIFFGetField( tiff, TIFFTAG_BITSPERSAMPLE, &bits_per_sample ) )
         {
@@ -472,6 +516,9 @@ namespace vigra {
 
         } else {
 
+            vigra_precondition( !tiled, "TIFFDecoderImpl::init(): "
+                                "Cannot read tiled bilevel TIFFs (not implemented)." );
+
             // if each sample is 1 bit long
             pixeltype = "BILEVEL";
 
@@ -551,47 +598,142 @@ namespace vigra {
             iccProfile.swap(iccData);
         }
 
-        // allocate data buffers
-        const unsigned int stripsize = TIFFScanlineSize(tiff);
-        if ( planarconfig == PLANARCONFIG_SEPARATE ) {
-            stripbuffer = new tdata_t[samples_per_pixel];
-            for( unsigned int i = 0; i < samples_per_pixel; ++i ) {
-                stripbuffer[i] = 0;
-            }
-            for( unsigned int i = 0; i < samples_per_pixel; ++i ) {
-                stripbuffer[i] = _TIFFmalloc(stripsize);
-                if(stripbuffer[i] == 0)
-                    throw std::bad_alloc();
-            }
+        // read the entire image by default
+        setRegionOfInterest( Rect2D( Size2D( (int)width, (int)height ) ) );
+    }
+
+    void TIFFDecoderImpl::setRegionOfInterest( const Rect2D & roi )
+    {
+        vigra_precondition( !roi.isEmpty() && roi.left() >= 0 && roi.top() >= 0 &&
+                            (uint32)roi.right() <= width && (uint32)roi.bottom() <= height,
+                            "TIFFDecoderImpl::setRegionOfInterest(): "
+                            "region must be a non-empty part of the image." );
+
+        roi_x = roi.left();
+        roi_y = roi.top();
+        roi_width = roi.width();
+        roi_height = roi.height();
+
+        if ( tiled ) {
+            // the buffer holds all tiles of a tile row intersecting the ROI
+            buffer_x = roi_x - roi_x % tile_width;
+            const uint32 end = roi_x + roi_width;
+            buffer_width = ( ( end - buffer_x + tile_width - 1 ) / tile_width ) * tile_width;
         } else {
-            stripbuffer = new tdata_t[1];
-            stripbuffer[0] = 0;
-            stripbuffer[0] = _TIFFmalloc(stripsize);
-            if(stripbuffer[0] == 0)
-                throw std::bad_alloc();
+            // the scanline interface always reads entire rows
+            buffer_x = 0;
+            buffer_width = width;
         }
+        allocateBuffers();
 
-        // let the codec read a new strip
+        // let the codec read a new strip at the first row of the region
+        scanline = roi_y;
         stripindex = stripheight;
     }
 
+    void TIFFDecoderImpl::allocateBuffers()
+    {
+        freeBuffers();
+
+        buffer_planes =
+            planarconfig == PLANARCONFIG_SEPARATE ? samples_per_pixel : 1;
+        tsize_t stripsize;
+        if ( tiled ) {
+            // TIFFTileRowSize() refers to a single plane for separate planar configuration
+            stripsize = ( TIFFTileRowSize(tiff) / tile_width ) * buffer_width * tile_height;
+            tilebuffer = _TIFFmalloc(TIFFTileSize(tiff));
+            if(tilebuffer == 0)
+                throw std::bad_alloc();
+        } else if ( planarconfig == PLANARCONFIG_SEPARATE ) {
+            // TIFFStripSize() refers to a single plane as well
+            stripsize = TIFFStripSize(tiff);
+        } else {
+            stripsize = TIFFScanlineSize(tiff);
+        }
+
+        stripbuffer = new tdata_t[buffer_planes];
+        for( unsigned int i = 0; i < buffer_planes; ++i ) {
+            stripbuffer[i] = 0;
+        }
+        for( unsigned int i = 0; i < buffer_planes; ++i ) {
+            stripbuffer[i] = _TIFFmalloc(stripsize);
+            if(stripbuffer[i] == 0)
+                throw std::bad_alloc();
+        }
+    }
+
+    void TIFFDecoderImpl::freeBuffers()
+    {
+        if ( stripbuffer != 0 ) {
+            for( unsigned int i = 0; i < buffer_planes; ++i )
+                if ( stripbuffer[i] != 0 )
+                    _TIFFfree(stripbuffer[i]);
+            delete[] stripbuffer;
+            stripbuffer = 0;
+        }
+        if ( tilebuffer != 0 ) {
+            _TIFFfree(tilebuffer);
+            tilebuffer = 0;
+        }
+    }
+
+    void TIFFDecoderImpl::readTileRow( uint32 y )
+    {
+        // only decode the tiles intersecting the region of interest
+        const tsize_t tilerowsize = TIFFTileRowSize(tiff);
+        const tsize_t bufferrowsize = ( tilerowsize / tile_width ) * buffer_width;
+        const uint32 rows = std::min( tile_height, height - y );
+
+        for( uint32 x = buffer_x; x < buffer_x + buffer_width; x += tile_width ) {
+            for( unsigned int plane = 0; plane < buffer_planes; ++plane ) {
+                if ( TIFFReadTile( tiff, tilebuffer, x, y, 0, (tsample_t)plane ) < 0 )
+                    vigra_fail( "TIFFDecoderImpl::readTileRow(): "
+                                "Unable to read tile." );
+                UInt8 * dest = static_cast< UInt8 * >(stripbuffer[plane])
+                    + ( ( x - buffer_x ) / tile_width ) * tilerowsize;
+                const UInt8 * src = static_cast< const UInt8 * >(tilebuffer);
+                for( uint32 row = 0; row < rows; ++row ) {
+                    std::copy( src, src + tilerowsize, dest );
+                    src += tilerowsize;
+                    dest += bufferrowsize;
+                }
+            }
+        }
+    }
+
+    void TIFFDecoderImpl::invertBuffer( tsize_t size )
+    {
+        // invert grayscale images that interpret 0 as white
+        if ( photometric == PHOTOMETRIC_MINISWHITE &&
+             samples_per_pixel == 1 && pixeltype == "UINT8" ) {
+
+            UInt8 * buf = static_cast< UInt8 * >(stripbuffer[0]);
+
+            // invert every pixel
+            for ( tsize_t i = 0; i < size; ++i, ++buf )
+                *buf = 0xff - *buf;
+        }
+    }
+
     const void *
     TIFFDecoderImpl::currentScanlineOfBand( unsigned int band ) const
     {
+        // pixel offset of the current ROI row in the strip buffer
+        const unsigned int pixel = stripindex * buffer_width + roi_x - buffer_x;
         if ( bits_per_sample == 1 ) {
             UInt8 * const buf
                 = static_cast< UInt8 * >(stripbuffer[0]);
             // XXX probably wrong
-            return buf + ( stripindex * width ) / 8;
+            return buf + pixel / 8;
         } else {
             if ( planarconfig == PLANARCONFIG_SEPARATE ) {
                 UInt8 * const buf
                     = static_cast< UInt8 * >(stripbuffer[band]);
-                return buf + ( stripindex * width ) * ( bits_per_sample / 8 );
+                return buf + pixel * ( bits_per_sample / 8 );
             } else {
                 UInt8 * const buf
                     = static_cast< UInt8 * >(stripbuffer[0]);
-                return buf + ( band + stripindex * width * samples_per_pixel )
+                return buf + ( band + pixel * samples_per_pixel )
                     * ( bits_per_sample / 8 );
             }
         }
@@ -601,30 +743,36 @@ namespace vigra {
     {
         // eventually read a new strip
         if ( ++stripindex >= stripheight ) {
-            stripindex = 0;
 
-            if ( planarconfig == PLANARCONFIG_SEPARATE ) {
-                const tsize_t size = TIFFScanlineSize(tiff);
-                for( unsigned int i = 0; i < samples_per_pixel; ++i )
-                    TIFFReadScanline(tiff, stripbuffer[i], scanline++, size);
+            if ( tiled ) {
+                // read the row of tiles containing the current scanline
+                const uint32 y = scanline - scanline % tile_height;
+                readTileRow( y );
+                stripindex = scanline - y;
+                invertBuffer( ( TIFFTileRowSize(tiff) / tile_width ) *
+                              buffer_width * tile_height );
+            } else if ( planarconfig == PLANARCONFIG_SEPARATE ) {
+                // read the strip containing the current scanline in every plane
+                const uint32 y = scanline - scanline % stripheight;
+                for( unsigned int i = 0; i < samples_per_pixel; ++i ) {
+                    if ( TIFFReadEncodedStrip( tiff,
+                             TIFFComputeStrip( tiff, y, (tsample_t)i ),
+                             stripbuffer[i], (tsize_t)-1 ) < 0 )
+                        vigra_fail( "TIFFDecoderImpl::nextScanline(): "
+                                    "Unable to read strip." );
+                }
+                stripindex = scanline - y;
             } else {
-                TIFFReadScanline( tiff, stripbuffer[0], scanline++, 0);
-            }
-
-            // XXX handle bilevel images
+                stripindex = 0;
 
-            // invert grayscale images that interpret 0 as white
-            if ( photometric == PHOTOMETRIC_MINISWHITE &&
-                 samples_per_pixel == 1 && pixeltype == "UINT8" ) {
+                TIFFReadScanline( tiff, stripbuffer[0], scanline, 0);
 
-                UInt8 * buf = static_cast< UInt8 * >(stripbuffer[0]);
-                const unsigned int n = TIFFScanlineSize(tiff);
+                // XXX handle bilevel images
 
-                // invert every pixel
-                for ( unsigned int i = 0; i < n; ++i, ++buf )
-                    *buf = 0xff - *buf;
+                invertBuffer( TIFFScanlineSize(tiff) );
             }
         }
+        ++scanline;
     }
 
     void TIFFDecoder::init( const std::string & filename, unsigned int imageIndex=0 )
@@ -704,6 +852,12 @@ namespace vigra {
         return pimpl->pixeltype;
     }
 
+    bool TIFFDecoder::setRegionOfInterest( const Rect2D & roi )
+    {
+        pimpl->setRegionOfInterest(roi);
+        return true;
+    }
+
     unsigned int TIFFDecoder::getOffset() const
     {
         return pimpl->planarconfig == PLANARCONFIG_SEPARATE ?
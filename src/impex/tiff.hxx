@@ -89,6 +89,8 @@ namespace vigra {
         float getXResolution() const;
         float getYResolution() const;
 
+        bool setRegionOfInterest( const Rect2D & );
+
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
 
@@ -713,6 +713,376 @@ struct ClassifierTest
         std::cerr << "DONE!\n\n";
     }
 
+/**
+        ClassifierTest::RFparallelLearnTest():
+    Learns forests with different thread counts from the same seed. All forests
+    must be identical, and the visitors must see the same trees as in serial 
+    learning.
+**/
+    void RFparallelLearnTest()
+    {
+        std::cerr << "RFparallelLearnTest(): Learning with 1, 2, 3 and all threads. ";
+        int ii = data.size() - 3; // this is the pina_indians dataset
+        int threads[] = { 1, 2, 3, 0 };
+
+        vigra::RandomForest<> RF_ref(vigra::RandomForestOptions().tree_count(64)
+                                                                 .thread_count(1));
+        rf::visitors::OOB_Error oob_ref;
+        rf::visitors::VariableImportanceVisitor var_imp_ref;
+        RF_ref.learn(data.features(ii), data.labels(ii),
+                     create_visitor(oob_ref, var_imp_ref),
+                     rf_default(), rf_default(),
+                     vigra::RandomMT19937(1));
+
+        MultiArray<2, double> prob_ref(MultiArrayShape<2>::type(data.features(ii).shape(0),
+                                                                RF_ref.class_count()));
+        RF_ref.predictProbabilities(data.features(ii), prob_ref);
+
+        for(int k = 1; k < 4; ++k)
+        {
+            vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(64)
+                                                                  .thread_count(threads[k]));
+            rf::visitors::OOB_Error oob_v;
+            rf::visitors::VariableImportanceVisitor var_imp;
+            RF2.learn(data.features(ii), data.labels(ii),
+                      create_visitor(oob_v, var_imp),
+                      rf_default(), rf_default(),
+                      vigra::RandomMT19937(1));
+
+            shouldEqual(RF2.trees_.size(), RF_ref.trees_.size());
+            for(int jj = 0; jj < int(RF2.trees_.size()); ++jj)
+            {
+                should(RF2.trees_[jj].topology_ == RF_ref.trees_[jj].topology_);
+                should(RF2.trees_[jj].parameters_ == RF_ref.trees_[jj].parameters_);
+            }
+            shouldEqual(oob_v.oob_breiman, oob_ref.oob_breiman);
+            shouldEqualSequenceTolerance(var_imp.variable_importance_.begin(),
+                                         var_imp.variable_importance_.end(),
+                                         var_imp_ref.variable_importance_.begin(),
+                                         1e-10);
+
+            MultiArray<2, double> prob(prob_ref.shape());
+            RF2.predictProbabilities(data.features(ii), prob);
+            shouldEqualSequence(prob.begin(), prob.end(), prob_ref.begin());
+        }
+
+        // the ensemble must be as good as one learned from the sequential random 
+        // stream (i.e. without setting the thread count)
+        vigra::RandomForest<> RF_serial(vigra::RandomForestOptions().tree_count(64));
+        rf::visitors::OOB_Error oob_serial;
+        RF_serial.learn(data.features(ii), data.labels(ii),
+                        create_visitor(oob_serial),
+                        rf_default(), rf_default(),
+                        vigra::RandomMT19937(1));
+        should(std::abs(oob_ref.oob_breiman - oob_serial.oob_breiman) < 0.05);
+
+        try
+        {
+            vigra::RandomForestOptions().thread_count(-1);
+            failTest("no exception thrown");
+        }
+        catch(vigra::ContractViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nRandomForestOptions::thread_count(): thread count must be non-negative.");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+        std::cerr << "DONE!\n\n";
+    }
+
+/**
+        ClassifierTest::RFbatchedPredictionTest():
+    Prediction without early stopping processes blocks of rows in parallel. The
+    result must be identical to row-by-row prediction, which is still used for
+    early stopping criteria.
+**/
+    void RFbatchedPredictionTest()
+    {
+        std::cerr << "RFbatchedPredictionTest(): Comparing batched and row-wise prediction. ";
+        int ii = data.size() - 3; // this is the pina_indians dataset
+        vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(32));
+        RF2.learn(data.features(ii), data.labels(ii),
+                  rf_default(), rf_default(), rf_default(),
+                  vigra::RandomMT19937(1));
+
+        MultiArrayShape<2>::type shape(data.features(ii).shape(0), RF2.class_count());
+        for(int weighted = 0; weighted < 2; ++weighted)
+        {
+            RF2.options_.predict_weighted_ = (weighted == 1);
+
+            MultiArray<2, double> prob_rowwise(shape);
+            StopBase never_stop;
+            RF2.predictProbabilities(data.features(ii), prob_rowwise, never_stop);
+
+            int threads[] = { 1, 3, 0 };
+            for(int k = 0; k < 3; ++k)
+            {
+                RF2.options_.thread_count(threads[k]);
+                MultiArray<2, double> prob(shape);
+                RF2.predictProbabilities(data.features(ii), prob);
+                shouldEqualSequence(prob.begin(), prob.end(), prob_rowwise.begin());
+
+                MultiArray<2, float> probf(shape);
+                RF2.predictProbabilities(data.features(ii), probf);
+                MultiArray<2, float> probf_rowwise(shape);
+                RF2.predictProbabilities(data.features(ii), probf_rowwise, never_stop);
+                shouldEqualSequence(probf.begin(), probf.end(), probf_rowwise.begin());
+            }
+        }
+        std::cerr << "DONE!\n\n";
+    }
+
+    void RFcompiledForestTest()
+    {
+        std::cerr << "RFcompiledForestTest(): Comparing compiled and original forest. ";
+        int ii = data.size() - 3; // this is the pina_indians dataset
+        vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(32));
+        RF2.learn(data.features(ii), data.labels(ii),
+                  rf_default(), rf_default(), rf_default(),
+                  vigra::RandomMT19937(1));
+
+        MultiArrayShape<2>::type shape(data.features(ii).shape(0), RF2.class_count());
+        MultiArray<2, float> ffeatures(data.features(ii));
+        for(int weighted = 0; weighted < 2; ++weighted)
+        {
+            RF2.options_.predict_weighted_ = (weighted == 1);
+
+            // double thresholds reproduce the original forest exactly
+            CompiledRandomForest<double, double> crf(RF2);
+            shouldEqual(crf.tree_count(), RF2.tree_count());
+            shouldEqual(crf.class_count(), RF2.class_count());
+            MultiArray<2, double> prob(shape), prob_ref(shape);
+            RF2.predictProbabilities(data.features(ii), prob_ref);
+            crf.predictProbabilities(data.features(ii), prob);
+            shouldEqualSequence(prob.begin(), prob.end(), prob_ref.begin());
+
+            // float thresholds are exact for float features
+            CompiledRandomForest<> crff(RF2);
+            crff.thread_count(3);
+            shouldEqual(crff.node_count(), crf.node_count());
+            RF2.predictProbabilities(ffeatures, prob_ref);
+            crff.predictProbabilities(ffeatures, prob);
+            shouldEqualSequence(prob.begin(), prob.end(), prob_ref.begin());
+
+            MultiArray<2, double> labels(MultiArrayShape<2>::type(shape[0], 1)),
+                                  labels_ref(MultiArrayShape<2>::type(shape[0], 1));
+            RF2.predictLabels(ffeatures, labels_ref);
+            crff.predictLabels(ffeatures, labels);
+            shouldEqualSequence(labels.begin(), labels.end(), labels_ref.begin());
+        }
+
+        // thresholds are rounded up to the next float
+        float tf = vigra::detail::roundThresholdUp<float>(0.7);
+        should(float(0.7) < 0.7);
+        should(tf > 0.7);
+        shouldEqual(tf, 0.70000005f);
+        shouldEqual(vigra::detail::roundThresholdUp<float>(-0.1), -0.1f);
+        should(vigra::detail::roundThresholdUp<float>(-0.5 + 1e-12) > -0.5f);
+        should(vigra::detail::roundThresholdUp<float>(-0.5 + 1e-12) < -0.5f + 1e-7f);
+        shouldEqual(vigra::detail::roundThresholdUp<float>(0.5), 0.5f);
+        should(vigra::detail::roundThresholdUp<float>(1e-300) > 0.0f);
+        std::cerr << "DONE!\n\n";
+    }
+
+    template <class RF>
+    void shouldEqualTrees(RF const & rf1, RF const & rf2)
+    {
+        shouldEqual(rf1.trees_.size(), rf2.trees_.size());
+        for(int jj = 0; jj < int(rf1.trees_.size()); ++jj)
+        {
+            should(rf1.trees_[jj].topology_ == rf2.trees_[jj].topology_);
+            should(rf1.trees_[jj].parameters_ == rf2.trees_[jj].parameters_);
+        }
+    }
+
+/**
+        ClassifierTest::RFpresortedSplitTest():
+    PresortedGiniSplit must produce the same trees as GiniSplit. The large
+    dataset contains ties and uses the radix sort in the upper levels of the
+    trees.
+**/
+    void RFpresortedSplitTest()
+    {
+        std::cerr << "RFpresortedSplitTest(): Comparing presorted and sorting split. ";
+        {
+            int ii = data.size() - 3; // this is the pina_indians dataset
+            vigra::RandomForest<> RF1(vigra::RandomForestOptions().tree_count(16));
+            RF1.learn(data.features(ii), data.labels(ii),
+                      rf_default(), GiniSplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(16));
+            RF2.learn(data.features(ii), data.labels(ii),
+                      rf_default(), PresortedGiniSplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            shouldEqualTrees(RF1, RF2);
+        }
+        {
+            typedef MultiArrayShape<2>::type Shp;
+            vigra::RandomMT19937 random(42);
+            MultiArray<2, double> features(Shp(5000, 6));
+            MultiArray<2, int> labels(Shp(5000, 1));
+            for(int k = 0; k < features.shape(0); ++k)
+            {
+                for(int j = 0; j < features.shape(1); ++j)
+                    features(k, j) = j < 3
+                                        ? random.uniform()
+                                        : (double)random.uniformInt(100);
+                labels(k, 0) = features(k, 0) + 0.01*features(k, 3) + 0.3*random.uniform() > 1.2;
+            }
+            vigra::RandomForest<> RF1(vigra::RandomForestOptions().tree_count(8)
+                                                                  .thread_count(2));
+            RF1.learn(features, labels,
+                      rf_default(), EntropySplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(8)
+                                                                  .thread_count(2));
+            RF2.learn(features, labels,
+                      rf_default(), PresortedEntropySplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            shouldEqualTrees(RF1, RF2);
+        }
+        {
+            typedef MultiArrayShape<2>::type Shp;
+            MultiArray<2, double> features(Shp(200, 2));
+            MultiArray<2, double> response(Shp(200, 1));
+            for(int k = 0; k < features.shape(0); ++k)
+            {
+                features(k, 0) = k - 100.0;
+                features(k, 1) = (k * 37) % 200;
+                response(k, 0) = std::sin(features(k, 0) / 20.0) + features(k, 1) / 100.0;
+            }
+            vigra::RandomForest<double, RegressionTag> RF1(vigra::RandomForestOptions().tree_count(8));
+            RF1.learn(features, response, rf_default(), RegressionSplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            vigra::RandomForest<double, RegressionTag> RF2(vigra::RandomForestOptions().tree_count(8));
+            RF2.learn(features, response, rf_default(), PresortedRegressionSplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            shouldEqualTrees(RF1, RF2);
+        }
+        std::cerr << "DONE!\n\n";
+    }
+
+/**
+        ClassifierTest::RFfeatureBinsTest():
+    The histogram split on 8-bit features must produce the same trees as
+    sorting. Binning features with few distinct values must not change the
+    partitions, and coarse binning must still give a reasonable forest.
+**/
+    void RFfeatureBinsTest()
+    {
+        std::cerr << "RFfeatureBinsTest(): Learning on quantized features. ";
+        typedef MultiArrayShape<2>::type Shp;
+        vigra::RandomMT19937 random(42);
+        MultiArray<2, double> features(Shp(3000, 5));
+        MultiArray<2, int> labels(Shp(3000, 1));
+        for(int k = 0; k < features.shape(0); ++k)
+        {
+            for(int j = 0; j < features.shape(1); ++j)
+                features(k, j) = (double)random.uniformInt(40);
+            labels(k, 0) = features(k, 0) + 0.5*features(k, 1) + 20.0*random.uniform() > 40.0;
+        }
+        {
+            MultiArray<2, UInt8> features8(features);
+            vigra::RandomForest<> RF1(vigra::RandomForestOptions().tree_count(8));
+            RF1.learn(features, labels,
+                      rf_default(), GiniSplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(8));
+            RF2.learn(features8, labels,
+                      rf_default(), GiniSplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            shouldEqualTrees(RF1, RF2);
+            vigra::RandomForest<> RF3(vigra::RandomForestOptions().tree_count(8));
+            RF3.learn(features8, labels,
+                      rf_default(), PresortedEntropySplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            vigra::RandomForest<> RF4(vigra::RandomForestOptions().tree_count(8));
+            RF4.learn(features, labels,
+                      rf_default(), EntropySplit(), rf_default(),
+                      vigra::RandomMT19937(1));
+            shouldEqualTrees(RF3, RF4);
+        }
+        {
+            vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(8)
+                                                                  .feature_bins(64)
+                                                                  .thread_count(2));
+            vigra::RandomForest<> RF3(vigra::RandomForestOptions().tree_count(8)
+                                                                  .thread_count(2));
+            RF2.learn(features, labels,
+                      rf_default(), rf_default(), rf_default(),
+                      vigra::RandomMT19937(1));
+            RF3.learn(features, labels,
+                      rf_default(), rf_default(), rf_default(),
+                      vigra::RandomMT19937(1));
+            for(int jj = 0; jj < 8; ++jj)
+                should(RF2.trees_[jj].topology_ == RF3.trees_[jj].topology_);
+            shouldEqual(RF2.options().feature_bins_, 64);
+
+            MultiArray<2, int> labels2(labels.shape()), labels3(labels.shape());
+            RF2.predictLabels(features, labels2);
+            RF3.predictLabels(features, labels3);
+            should(labels2 == labels3);
+        }
+        {
+            int ii = data.size() - 3; // this is the pina_indians dataset
+            vigra::RandomForest<> RF1(vigra::RandomForestOptions().tree_count(64));
+            rf::visitors::OOB_Error oob1;
+            RF1.learn(data.features(ii), data.labels(ii),
+                      create_visitor(oob1), rf_default(), rf_default(),
+                      vigra::RandomMT19937(1));
+            vigra::RandomForest<> RF2(vigra::RandomForestOptions().tree_count(64)
+                                                                  .feature_bins(16));
+            rf::visitors::OOB_Error oob2;
+            RF2.learn(data.features(ii), data.labels(ii),
+                      create_visitor(oob2), rf_default(), rf_default(),
+                      vigra::RandomMT19937(1));
+            should(std::abs(oob1.oob_breiman - oob2.oob_breiman) < 0.05);
+        }
+        {
+            // invalid features must be rejected before binning
+            int ii = data.size() - 3; 
+            MultiArray<2, double> features(data.features(ii));
+            features(3, 2) = std::numeric_limits<double>::quiet_NaN();
+            vigra::RandomForest<> RF(vigra::RandomForestOptions().tree_count(4)
+                                                                 .feature_bins(16));
+            try
+            {
+                RF.learn(features, data.labels(ii));
+                failTest("RandomForest::learn() failed to reject NaN features.");
+            }
+            catch(PreconditionViolation & e)
+            {
+                std::string expected("\nPrecondition violation!\nRandomForest::learn(): Feature Matrix Contains NaNs");
+                std::string message(e.what());
+                should(0 == expected.compare(message.substr(0,expected.size())));
+            }
+            features(3, 2) = std::numeric_limits<double>::infinity();
+            try
+            {
+                RF.learn(features, data.labels(ii));
+                failTest("RandomForest::learn() failed to reject infinite features.");
+            }
+            catch(PreconditionViolation & e)
+            {
+                std::string expected("\nPrecondition violation!\nRandomForest::learn(): Feature Matrix Contains inf");
+                std::string message(e.what());
+                should(0 == expected.compare(message.substr(0,expected.size())));
+            }
+        }
+        try
+        {
+            vigra::RandomForestOptions().feature_bins(257);
+            failTest("RandomForestOptions::feature_bins() failed to throw exception.");
+        }
+        catch(PreconditionViolation & e)
+        {
+            std::string expected("\nPrecondition violation!\nRandomForestOptions::feature_bins(): bin count must be 0 or in [2, 256].");
+            std::string message(e.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+        std::cerr << "DONE!\n\n";
+    }
+
     void RFwrongLabelTest()
     {
         double rawfeatures [] = 
@@ -947,12 +1317,17 @@ struct ClassifierTestSuite
         add( testCase( &ClassifierTest::RFoobTest));
         add( testCase( &ClassifierTest::RFnoiseTest));
         add( testCase( &ClassifierTest::RFvariableImportanceTest));
+        add( testCase( &ClassifierTest::RFparallelLearnTest));
         add( testCase( &ClassifierTest::RF_NanCheck));
         add( testCase( &ClassifierTest::RF_InfCheck));
         add( testCase( &ClassifierTest::RF_SpliceTest));
         add( testCase( &ClassifierTest::RF_AlgorithmTest));
 #endif
         add( testCase( &ClassifierTest::RFresponseTest));
+        add( testCase( &ClassifierTest::RFbatchedPredictionTest));
+        add( testCase( &ClassifierTest::RFcompiledForestTest));
+        add( testCase( &ClassifierTest::RFpresortedSplitTest));
+        add( testCase( &ClassifierTest::RFfeatureBinsTest));
         
         add( testCase( &ClassifierTest::RFridgeRegressionTest));
         add( testCase( &ClassifierTest::RFSplitFunctorTest));
@@ -0,0 +1,92 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2004-2011 by Ullrich Koethe                  */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+/* Benchmark of color conversions of an 8-bit RGB image (e.g. a tile of a
+   scanned slide) with transformMultiArray() and transformColors().
+
+   Usage: colorconversion_benchmark [size [threads]]
+
+   Prints the run time in ms of the per-pixel functor application and of
+   transformColors() on one and on 'threads' threads (default: all available).
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+#include "vigra/multi_array.hxx"
+#include "vigra/multi_pointoperators.hxx"
+#include "vigra/colorconversions.hxx"
+#include "vigra/random.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+template <class Functor>
+void benchmark(MultiArray<2, RGBValue<UInt8> > const & rgb, Functor const & f, int nthreads)
+{
+    MultiArray<2, TinyVector<float, 3> > res(rgb.shape());
+    USETICTOC;
+    std::cout << std::setw(12) << Functor::targetColorSpace() << std::fixed << std::setprecision(1);
+    TIC;
+    transformMultiArray(srcMultiArrayRange(rgb), destMultiArray(res), f);
+    std::cout << std::setw(14) << TOCN;
+    TIC;
+    transformColors(rgb, res, f, 1);
+    std::cout << std::setw(13) << TOCN;
+    TIC;
+    transformColors(rgb, res, f, nthreads);
+    std::cout << std::setw(13) << TOCN << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 2048;
+    int nthreads = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    MultiArray<2, RGBValue<UInt8> > rgb(MultiArrayShape<2>::type(size, size));
+    RandomMT19937 random(42);
+    for(int k=0; k<rgb.size(); ++k)
+        rgb[k] = RGBValue<UInt8>(random.uniformInt(256), random.uniformInt(256), random.uniformInt(256));
+
+    std::cout << "      target       functor   bulk(1)      bulk(" << parallelThreadCount(nthreads) << ")  [ms]\n";
+    benchmark(rgb, RGB2XYZFunctor<float>(), nthreads);
+    benchmark(rgb, RGB2LabFunctor<float>(), nthreads);
+    benchmark(rgb, RGB2LuvFunctor<float>(), nthreads);
+    benchmark(rgb, RGBPrime2LabFunctor<float>(), nthreads);
+    benchmark(rgb, RGBPrime2YPrimeCbCrFunctor<float>(), nthreads);
+    return 0;
+}
@@ -37,6 +37,8 @@
 #include <iostream>
 #include "unittest.hxx"
 #include "vigra/colorconversions.hxx"
+#include "vigra/multi_pointoperators.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -436,6 +438,102 @@ struct ColorConversionsTest
         
         should(equalColors(transformed[count-1], RGB(142.585, 0.541569, 0.286346)));
     }
+
+    template <class V2, class V1, class Functor>
+    void checkTransformColors(vigra::MultiArray<2, V1> const & src, Functor const & f, 
+                              double tolerance)
+    {
+        typedef typename V1::value_type T1;
+        typedef typename V2::value_type T2;
+        typedef vigra::MultiArrayShape<3>::type Shape3;
+
+        vigra::MultiArray<2, V2> desired(src.shape()), result(src.shape());
+        vigra::transformMultiArray(srcMultiArrayRange(src), destMultiArray(desired), f);
+
+        vigra::MultiArray<3, T1> srcBands(Shape3(src.shape(0), src.shape(1), 3));
+        vigra::MultiArray<3, T2> resultBands(srcBands.shape());
+        for(int k=0; k<3; ++k)
+            srcBands.bindOuter(k) = src.bindElementChannel(k);
+
+        for(int threads=1; threads<=4; threads+=3)
+        {
+            vigra::transformColors(src, result, f, threads);
+            vigra::transformColorBands(srcBands, resultBands, f, threads);
+            for(int i=0; i<src.size(); ++i)
+            {
+                for(int k=0; k<3; ++k)
+                {
+                    double d = desired[i][k];
+                    should(std::abs(result[i][k] - d) <= tolerance*(1.0 + std::abs(d)));
+                    should(result[i][k] == resultBands[i + k*src.size()]);
+                }
+            }
+        }
+    }
+
+    void testTransformColors()
+    {
+        using namespace vigra;
+        typedef MultiArrayShape<2>::type Shape2;
+
+        RandomMT19937 random(7);
+        MultiArray<2, RGBValue<UInt8> > rgb8(Shape2(37, 23));
+        MultiArray<2, TinyVector<float, 3> > rgb(rgb8.shape());
+        for(int i=0; i<rgb8.size(); ++i)
+        {
+            for(int k=0; k<3; ++k)
+            {
+                rgb8[i][k] = (UInt8)random.uniformInt(256);
+                rgb[i][k] = 255.0f*random.uniform53();
+            }
+        }
+        rgb8[0] = RGBValue<UInt8>(0, 0, 0);
+        rgb8[1] = RGBValue<UInt8>(255, 255, 255);
+
+        // dedicated implementations (which compute in double precision, so that
+        // the tolerance mainly accounts for the round-off of the float functors)
+        checkTransformColors<TinyVector<float, 3> >(rgb8, RGB2XYZFunctor<float>(), 1e-6);
+        checkTransformColors<TinyVector<float, 3> >(rgb8, RGBPrime2XYZFunctor<float>(), 1e-6);
+        checkTransformColors<TinyVector<float, 3> >(rgb8, RGB2LabFunctor<float>(), 1e-4);
+        checkTransformColors<TinyVector<float, 3> >(rgb8, RGB2LuvFunctor<float>(), 1e-4);
+        checkTransformColors<TinyVector<float, 3> >(rgb8, RGBPrime2LabFunctor<float>(), 1e-4);
+        checkTransformColors<TinyVector<float, 3> >(rgb8, RGBPrime2LuvFunctor<float>(), 1e-4);
+        checkTransformColors<TinyVector<double, 3> >(rgb8, RGBPrime2LabFunctor<UInt8>(), 1e-10);
+        checkTransformColors<TinyVector<double, 3> >(rgb, RGBPrime2LuvFunctor<double>(), 1e-10);
+        checkTransformColors<TinyVector<double, 3> >(rgb, RGB2LabFunctor<double>(), 1e-10);
+        checkTransformColors<TinyVector<float, 3> >(rgb, RGBPrime2YPrimeCbCrFunctor<float>(), 1e-6);
+        checkTransformColors<TinyVector<float, 3> >(rgb, RGBPrime2YPrimePbPrFunctor<float>(), 1e-6);
+        checkTransformColors<TinyVector<float, 3> >(rgb, RGBPrime2YPrimeIQFunctor<float>(), 1e-6);
+        checkTransformColors<TinyVector<float, 3> >(rgb, RGBPrime2YPrimeUVFunctor<float>(), 1e-6);
+        checkTransformColors<TinyVector<float, 3> >(rgb, YPrimeCbCr2RGBPrimeFunctor<float>(), 1e-5);
+        // the result is rounded to integers
+        checkTransformColors<RGBValue<UInt8> >(rgb, YPrimeCbCr2RGBPrimeFunctor<float>(), 0.0);
+
+        MultiArray<2, TinyVector<float, 3> > xyz(rgb.shape());
+        transformColors(rgb8, xyz, RGB2XYZFunctor<float>());
+        checkTransformColors<TinyVector<float, 3> >(xyz, XYZ2LabFunctor<float>(), 1e-4);
+        checkTransformColors<TinyVector<float, 3> >(xyz, XYZ2LuvFunctor<float>(), 1e-4);
+        checkTransformColors<TinyVector<double, 3> >(xyz, XYZ2RGBFunctor<double>(), 1e-10);
+        checkTransformColors<RGBValue<UInt8> >(xyz, XYZ2RGBFunctor<float>(), 0.0);
+
+        // generic implementation
+        checkTransformColors<TinyVector<float, 3> >(rgb, RGB2sRGBFunctor<float>(), 0.0);
+        checkTransformColors<TinyVector<float, 3> >(rgb, Lab2RGBFunctor<float>(), 0.0);
+        checkTransformColors<RGBValue<UInt8> >(rgb8, RGBPrime2RGBFunctor<UInt8>(), 0.0);
+
+        // in-place operation
+        MultiArray<2, TinyVector<float, 3> > lab(rgb.shape());
+        transformColors(rgb, lab, RGB2LabFunctor<float>());
+        transformColors(rgb, rgb, RGB2LabFunctor<float>());
+        should(rgb == lab);
+
+        for(double x = 1e-8; x < 1e8; x *= 1.37)
+        {
+            should(std::abs(detail::fastCbrt(x) - std::pow(x, 1.0/3.0)) < 1e-12*std::pow(x, 1.0/3.0));
+            should(detail::fastCbrt(-x) == -detail::fastCbrt(x));
+        }
+        shouldEqual(detail::fastCbrt(0.0), 0.0);
+    }
 };
 
 
@@ -464,6 +562,7 @@ struct ColorConversionsTestSuite
         add( testCase(&ColorConversionsTest::testYPrimeCbCrPolar));
         add( testCase(&ColorConversionsTest::testYPrimeIQPolar));
         add( testCase(&ColorConversionsTest::testYPrimeUVPolar));
+        add( testCase(&ColorConversionsTest::testTransformColors));
     }
 };
 
@@ -0,0 +1,93 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2004-2011 by Ullrich Koethe                  */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+
+/* Benchmark of the Gaussian smoothing of 8- and 16-bit images with the
+   floating-point and the fixed-point variants of separableConvolveX/Y().
+
+   Usage: fixedpoint_benchmark [size [sigma]]
+
+   Prints the run time in ms of the x- and y-convolution for both variants.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include "vigra/stdimage.hxx"
+#include "vigra/separableconvolution.hxx"
+#include "vigra/random.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+template <class T>
+void benchmark(int size, double sigma, const char * name)
+{
+    BasicImage<T> src(size, size), tmp(size, size), dest(size, size);
+    RandomMT19937 random;
+    for(typename BasicImage<T>::iterator i = src.begin(); i != src.end(); ++i)
+        *i = (T)random.uniformInt(NumericTraits<T>::max());
+
+    Kernel1D<double> gauss;
+    gauss.initGaussian(sigma);
+
+    USETICTOC;
+    std::cout << std::setw(8) << name << std::fixed << std::setprecision(1);
+    TIC;
+    separableConvolveX(srcImageRange(src), destImage(tmp), kernel1d(gauss));
+    std::cout << std::setw(12) << TOCN;
+    TIC;
+    separableConvolveY(srcImageRange(tmp), destImage(dest), kernel1d(gauss));
+    std::cout << std::setw(12) << TOCN;
+    TIC;
+    separableConvolveX(srcImageRange(src), destImage(tmp), kernel1d(gauss), FixedPointConvolution());
+    std::cout << std::setw(12) << TOCN;
+    TIC;
+    separableConvolveY(srcImageRange(tmp), destImage(dest), kernel1d(gauss), FixedPointConvolution());
+    std::cout << std::setw(12) << TOCN << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 2048;
+    double sigma = argc > 2 ? std::atof(argv[2]) : 2.0;
+
+    std::cout << "image size " << size << "x" << size << ", sigma " << sigma << "\n\n";
+    std::cout << "    type   double x    double y     fixed x     fixed y\n";
+    benchmark<UInt8>(size, sigma, "UInt8");
+    benchmark<UInt16>(size, sigma, "UInt16");
+    return 0;
+}
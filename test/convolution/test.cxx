@@ -43,6 +43,8 @@
 #include "vigra/combineimages.hxx"
 #include "vigra/resampling_convolution.hxx"
 #include "vigra/imagecontainer.hxx"
+#include "vigra/basicgeometry.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -752,6 +754,183 @@ struct ConvolutionTest
         should(acc(i1) == 2.75);
     }
     
+    void symmetricKernelTest()
+    {
+        // symmetric (Gaussian) and antisymmetric (symmetric difference) kernels 
+        // use a faster summation order, which must not depend on whether the 
+        // data are contiguous (rows) or strided (columns)
+        vigra::Kernel1D<double> kernels[2];
+        kernels[0].initGaussian(2.0);
+        kernels[1].initSymmetricDifference();
+        BorderTreatmentMode modes[] = { BORDER_TREATMENT_REFLECT, BORDER_TREATMENT_REPEAT, 
+                                        BORDER_TREATMENT_WRAP, BORDER_TREATMENT_CLIP };
+        
+        Image transposed(lenna.height(), lenna.width());
+        transposeImage(srcImageRange(lenna), destImage(transposed), vigra::major);
+        
+        for(int k=0; k<2; ++k)
+        {
+            for(int m=0; m<4; ++m)
+            {
+                if(k == 1 && modes[m] == BORDER_TREATMENT_CLIP)
+                    continue; // kernel norm is zero
+                kernels[k].setBorderTreatment(modes[m]);
+                
+                Image rows(lenna.size()), columns(transposed.size()), res(lenna.size());
+                separableConvolveX(srcImageRange(lenna), destImage(rows), kernel1d(kernels[k]));
+                separableConvolveY(srcImageRange(transposed), destImage(columns), kernel1d(kernels[k]));
+                transposeImage(srcImageRange(columns), destImage(res), vigra::major);
+                
+                shouldEqualSequence(rows.begin(), rows.end(), res.begin());
+            }
+            
+            // compare with the definition in the interior
+            int r = kernels[k].right(), w = lenna.width();
+            Image rows(lenna.size());
+            separableConvolveX(srcImageRange(lenna), destImage(rows), kernel1d(kernels[k]));
+            for(int y=0; y<lenna.height(); y+=17)
+            {
+                for(int x=r; x<w-r; ++x)
+                {
+                    double sum = 0.0;
+                    for(int i=-r; i<=r; ++i)
+                        sum += kernels[k][i] * lenna(x-i, y);
+                    shouldEqualTolerance(rows(x, y), sum, 1e-12);
+                }
+            }
+
+            // subranges must give the same results as the entire line
+            ArrayVector<Image::value_type> line(w);
+            int start = 1, stop = w - 2;
+            kernels[k].setBorderTreatment(BORDER_TREATMENT_REFLECT);
+            separableConvolveX(srcImageRange(lenna), destImage(rows), kernel1d(kernels[k]));
+            convolveLine(srcIterRange(lenna.rowBegin(5), lenna.rowEnd(5), lenna.accessor()),
+                         destIter(line.begin(), lenna.accessor()), kernel1d(kernels[k]), start, stop);
+            shouldEqualSequence(line.begin(), line.begin() + (stop - start), rows.rowBegin(5) + start);
+        }
+    }
+    
+    void fixedPointConvolutionTest()
+    {
+        typedef vigra::BImage BImage;
+        vigra::Kernel1D<double> gauss;
+        gauss.initGaussian(2.0);
+        BorderTreatmentMode modes[] = { BORDER_TREATMENT_REFLECT, BORDER_TREATMENT_REPEAT, 
+                                        BORDER_TREATMENT_WRAP, BORDER_TREATMENT_CLIP,
+                                        BORDER_TREATMENT_AVOID };
+
+        BImage src(lenna.size()), transposed(lenna.height(), lenna.width());
+        copyImage(srcImageRange(lenna), destImage(src));
+        transposeImage(srcImageRange(src), destImage(transposed), vigra::major);
+
+        for(int m=0; m<5; ++m)
+        {
+            gauss.setBorderTreatment(modes[m]);
+
+            // fixed-point result differs from the floating-point one by at most one gray level
+            BImage ref(src.size()), rows(src.size()), columns(transposed.size()), res(src.size());
+            separableConvolveX(srcImageRange(src), destImage(ref), kernel1d(gauss));
+            separableConvolveX(srcImageRange(src), destImage(rows), kernel1d(gauss), 
+                               FixedPointConvolution());
+            for(BImage::iterator i = ref.begin(), j = rows.begin(); i != ref.end(); ++i, ++j)
+                should(std::abs((int)*i - (int)*j) <= 1);
+
+            // integer arithmetic is exact, so rows and columns must agree exactly
+            separableConvolveY(srcImageRange(transposed), destImage(columns), kernel1d(gauss), 
+                               FixedPointConvolution());
+            transposeImage(srcImageRange(columns), destImage(res), vigra::major);
+            shouldEqualSequence(rows.begin(), rows.end(), res.begin());
+
+            // constant images remain constant
+            BImage constant(20, 17), cres(20, 17);
+            constant.init(201);
+            cres.init(201);
+            separableConvolveX(srcImageRange(constant), destImage(cres), kernel1d(gauss), 
+                               FixedPointConvolution());
+            separableConvolveY(srcImageRange(cres), destImage(cres), kernel1d(gauss), 
+                               FixedPointConvolution(10));
+            for(BImage::iterator i = cres.begin(); i != cres.end(); ++i)
+                shouldEqual(*i, 201);
+        }
+
+        // derivative into a float image
+        vigra::Kernel1D<double> deriv;
+        deriv.initGaussianDerivative(1.5, 1);
+        FImage fref(src.size()), fres(src.size());
+        separableConvolveY(srcImageRange(src), destImage(fref), kernel1d(deriv));
+        separableConvolveY(srcImageRange(src), destImage(fres), kernel1d(deriv), 
+                           FixedPointConvolution());
+        for(FImage::iterator i = fref.begin(), j = fres.begin(); i != fref.end(); ++i, ++j)
+            should(std::abs(*i - *j) < 1e-4);
+
+        // rounding to an integral destination: ties round upwards, results are clamped
+        {
+            static const double kernel[] = { 0.5, 0.5, 0.0 };
+            static const UInt8 line[] = { 0, 1, 2, 255, 0, 3 };
+            static const UInt8 expected[] = { 1, 2, 129, 128, 2, 3 };
+            static const Int8 sexpected[] = { 1, 2, 127, 127, 2, 3 };
+            UInt8 out[6];
+            Int8 sout[6];
+            convolveLine(line, line+6, StandardConstValueAccessor<UInt8>(), 
+                         out, StandardValueAccessor<UInt8>(),
+                         kernel+1, StandardConstValueAccessor<double>(), -1, 1, 
+                         BORDER_TREATMENT_REPEAT, FixedPointConvolution(1));
+            shouldEqualSequence(out, out+6, expected);
+            convolveLine(line, line+6, StandardConstValueAccessor<UInt8>(), 
+                         sout, StandardValueAccessor<Int8>(),
+                         kernel+1, StandardConstValueAccessor<double>(), -1, 1, 
+                         BORDER_TREATMENT_REPEAT, FixedPointConvolution(1));
+            shouldEqualSequence(sout, sout+6, sexpected);
+        }
+
+        // 16-bit data and subranges
+        {
+            typedef vigra::BasicImage<UInt16> UImage;
+            UImage src16(src.size()), res16(src.size());
+            BImage res8(src.size());
+            transformImage(srcImageRange(src), destImage(src16), functor::Arg1()*functor::Param(257));
+            gauss.setBorderTreatment(BORDER_TREATMENT_REFLECT);
+            separableConvolveX(srcImageRange(src16), destImage(res16), kernel1d(gauss), 
+                               FixedPointConvolution());
+            separableConvolveX(srcImageRange(src), destImage(res8), kernel1d(gauss));
+            ArrayVector<UInt16> line(src.width());
+            int start = 3, stop = src.width() - 5;
+            convolveLine(srcIterRange(src16.rowBegin(7), src16.rowEnd(7), src16.accessor()),
+                         destIter(line.begin(), src16.accessor()), kernel1d(gauss), FixedPointConvolution(), 
+                         start, stop);
+            shouldEqualSequence(line.begin(), line.begin() + (stop - start), res16.rowBegin(7) + start);
+
+            for(int x=0; x<src.width(); ++x)
+                should(std::abs((int)res16(x, 7) - 257*(int)res8(x, 7)) <= 257);
+        }
+
+        // preconditions
+        try
+        {
+            separableConvolveX(srcImageRange(src), destImage(fres), kernel1d(gauss), 
+                               FixedPointConvolution(24));
+            failTest("no exception thrown");
+        }
+        catch(vigra::ContractViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nFixedPointConvolution: too many fractional bits");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+        try
+        {
+            separableConvolveX(srcImageRange(fref), destImage(fres), kernel1d(gauss), 
+                               FixedPointConvolution());
+            failTest("no exception thrown");
+        }
+        catch(vigra::ContractViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nFixedPointConvolution: source type must be");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
+    
     void gaussianSmoothingTest()
     {
         double scale = 1.0;
@@ -2037,6 +2216,21 @@ struct ResamplingConvolutionTest
     }
 };
 
+template <class Image>
+struct PyramidRowCollector
+{
+    vigra::ImagePyramid<Image> & pyramid;
+    ArrayVector<int> & nextRow;
+
+    template <class Iterator>
+    void operator()(int level, int y, Iterator begin, Iterator end)
+    {
+        shouldEqual(y, nextRow[level]++);
+        shouldEqual(end - begin, pyramid[level].width());
+        std::copy(begin, end, pyramid[level].rowBegin(y));
+    }
+};
+
 struct ImagePyramidTest
 {
     typedef vigra::DImage Image;
@@ -2109,6 +2303,72 @@ struct ImagePyramidTest
             shouldEqualSequenceTolerance(pyramid[i].begin(), pyramid[i].end(), laplacian[i].begin(), 1e-14);
         }
     }
+
+    void testBurtReduceStream()
+    {
+        {
+            vigra::ImagePyramid<Image> pyramid(0, 4, img), streamed(0, 4, img.size());
+            pyramidReduceBurtFilter(pyramid, 0, 4);
+
+            ArrayVector<int> nextRow(5, 0);
+            PyramidRowCollector<Image> sink = { streamed, nextRow };
+            BurtPyramidStream<double, PyramidRowCollector<Image> > stream(img.size(), 4, sink);
+            shouldEqual(stream.levelSize(4), Size2D(8, 8));
+
+            for(int y=0; y<h; ++y)
+                stream.addRow(img.rowBegin(y));
+            should(stream.isComplete());
+
+            for(int i=0; i<=4; ++i)
+            {
+                shouldEqual(nextRow[i], pyramid[i].height());
+                shouldEqualSequence(pyramid[i].begin(), pyramid[i].end(), streamed[i].begin());
+            }
+        }
+        {
+            // odd sizes, integer pixels, and strips of varying height
+            BImage base(37, 23);
+            RandomMT19937 random;
+            for(BImage::iterator i = base.begin(); i != base.end(); ++i)
+                *i = random.uniformInt(256);
+
+            vigra::ImagePyramid<BImage> pyramid(0, 5, base), streamed(0, 5, base.size());
+            pyramidReduceBurtFilter(pyramid, 0, 3, 0.375);
+
+            ArrayVector<int> nextRow(6, 0);
+            PyramidRowCollector<BImage> sink = { streamed, nextRow };
+            BurtPyramidStream<UInt8, PyramidRowCollector<BImage> > stream(base.size(), 5, sink, 0.375);
+
+            int strips[] = { 1, 4, 7, 2, 9 };
+            for(int k=0; !stream.isComplete(); ++k)
+            {
+                int y = stream.rowsAdded(),
+                    rows = std::min(strips[k % 5], base.height() - y);
+                stream.addRows(srcIterRange(base.upperLeft() + Diff2D(0, y), 
+                                            base.upperLeft() + Diff2D(base.width(), y + rows)));
+            }
+            shouldEqual(stream.rowsAdded(), base.height());
+
+            for(int i=0; i<=3; ++i)
+                shouldEqualSequence(pyramid[i].begin(), pyramid[i].end(), streamed[i].begin());
+            // the smallest levels (where pyramidReduceBurtFilter() requires a size of at least 3)
+            shouldEqual(nextRow[4], 2);
+            shouldEqual(nextRow[5], 1);
+            shouldEqual(stream.levelSize(5), Size2D(2, 1));
+
+            try
+            {
+                stream.addRow(base.rowBegin(0));
+                failTest("no exception thrown");
+            }
+            catch(vigra::ContractViolation & c)
+            {
+                std::string expected("\nPrecondition violation!\nBurtPyramidStream::addRow(): all rows of the base image have already been added.");
+                std::string message(c.what());
+                should(0 == expected.compare(message.substr(0,expected.size())));
+            }
+        }
+    }
         
 };
 
@@ -2138,6 +2398,8 @@ struct ConvolutionTestSuite
         add( testCase( &ConvolutionTest::separableDerivativeAvoidTest));
         add( testCase( &ConvolutionTest::separableSmoothClipTest));
         add( testCase( &ConvolutionTest::separableSmoothWrapTest));
+        add( testCase( &ConvolutionTest::symmetricKernelTest));
+        add( testCase( &ConvolutionTest::fixedPointConvolutionTest));
         add( testCase( &ConvolutionTest::gaussianSmoothingTest));
         add( testCase( &ConvolutionTest::optimalSmoothing3Test));
         add( testCase( &ConvolutionTest::optimalSmoothing5Test));
@@ -2174,6 +2436,7 @@ struct ConvolutionTestSuite
 
         add( testCase( &ImagePyramidTest::testPyramidConstruction));
         add( testCase( &ImagePyramidTest::testBurtReduceExpand));
+        add( testCase( &ImagePyramidTest::testBurtReduceStream));
     }
 };
 
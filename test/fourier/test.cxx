@@ -35,6 +35,7 @@
 
 #include "unittest.hxx"
 #include <stdlib.h>
+#include <cstdio>
 #include <algorithm>
 #include <functional>
 #include <vigra/stdimage.hxx>
@@ -692,6 +693,228 @@ struct MultiFFTTest
         shouldEqualSequenceTolerance(out2.data(), out2.data()+out2.size(),
                                      out4.data(), 1e-15);
     }
+
+    void testPlanCache()
+    {
+        Shape2 s(64, 48), s2(30, 20);
+        DArray2 in(s), in2(s2);
+        CArray2 out(fftwCorrespondingShapeR2C(s)), ref(out.shape()), 
+                out2(fftwCorrespondingShapeR2C(s2));
+        for(int k=0; k<in.size(); ++k)
+            in[k] = rand()/(double)RAND_MAX;
+
+        fourierTransform(in, ref);
+        fftwClearPlanCache<double>();
+        shouldEqual(fftwPlanCacheSize<double>(), 0);
+
+        {
+            FFTWPlan<2, double> plan(in, out);
+            shouldEqual(fftwPlanCacheSize<double>(), 1);
+            {
+                // the same transform reuses the cached plan
+                FFTWPlan<2, double> plan2(in, out);
+                shouldEqual(fftwPlanCacheSize<double>(), 1);
+                plan2.execute(in, out);
+                shouldEqualSequence(out.data(), out.data()+out.size(), ref.data());
+
+                // a different shape needs a new plan
+                fourierTransform(in2, out2);
+                shouldEqual(fftwPlanCacheSize<double>(), 2);
+            }
+
+            // plans in use are not destroyed
+            fftwClearPlanCache<double>();
+            shouldEqual(fftwPlanCacheSize<double>(), 1);
+            out.init(C(0.0));
+            plan.execute(in, out);
+            shouldEqualSequence(out.data(), out.data()+out.size(), ref.data());
+
+            fourierTransform(in, out);
+            shouldEqual(fftwPlanCacheSize<double>(), 1);
+        }
+        fftwClearPlanCache<double>();
+        shouldEqual(fftwPlanCacheSize<double>(), 0);
+
+        {
+            // assignment releases the plan previously held
+            FFTWPlan<2, double> plan(in, out), plan2(in2, out2);
+            shouldEqual(fftwPlanCacheSize<double>(), 2);
+            plan = plan2;
+            fftwClearPlanCache<double>();
+            shouldEqual(fftwPlanCacheSize<double>(), 1);
+            plan.execute(in2, out2);
+        }
+        fftwClearPlanCache<double>();
+        shouldEqual(fftwPlanCacheSize<double>(), 0);
+
+        fftwSetThreadCount(2);
+#ifdef VIGRA_FFTW_THREADS
+        shouldEqual(fftwThreadCount(), 2);
+#else
+        shouldEqual(fftwThreadCount(), 1);
+#endif
+        fourierTransform(in, out);
+        shouldEqualSequenceTolerance(out.data(), out.data()+out.size(), ref.data(), C(1e-12));
+        fftwSetThreadCount(1);
+
+        should(fftwExportWisdom<double>("fftw_test.wisdom"));
+        should(fftwImportWisdom<double>("fftw_test.wisdom"));
+        should(!fftwImportWisdom<double>("no_such_dir/fftw_test.wisdom"));
+        std::remove("fftw_test.wisdom");
+    }
+
+    void testConvolveFFTBatch()
+    {
+        typedef MultiArrayView<2, double> MV;
+        ImageImportInfo info("ghouse.gif");
+        Shape2 s(info.width(), info.height());
+        ArrayVector<DArray2> ins(3, DArray2(s)), outs(3, DArray2(s)), refs(3, DArray2(s));
+        importImage(info, destImage(ins[0]));
+        ins[1] = ins[0];
+        ins[1] *= 2.0;
+        for(int y=0; y<s[1]; ++y)
+            for(int x=0; x<s[0]; ++x)
+                ins[2](x, y) = ins[0](s[0]-1-x, y);
+
+        Kernel2D<double> gauss;
+        gauss.initGaussian(2.0);
+        MV kernel(Shape2(gauss.width(), gauss.height()), &gauss[gauss.upperLeft()]);
+
+        for(int k=0; k<3; ++k)
+            convolveFFT(ins[k], kernel, refs[k]);
+
+        convolveFFTBatch(ins.begin(), ins.end(), kernel, outs.begin());
+        for(int k=0; k<3; ++k)
+            shouldEqualSequenceTolerance(outs[k].data(), outs[k].data()+outs[k].size(),
+                                         refs[k].data(), 1e-14);
+
+        ArrayVector<DArray2> outs2(3, DArray2(s));
+        convolveFFTBatch(ins.begin(), ins.end(), kernel, outs2.begin(), 2);
+        for(int k=0; k<3; ++k)
+            shouldEqualSequence(outs2[k].data(), outs2[k].data()+outs2[k].size(), outs[k].data());
+
+        // kernel in the Fourier domain
+        Shape2 paddedShape = fftwBestPaddedShapeR2C(s + Shape2(16));
+        CArray2 fourierKernel(fftwCorrespondingShapeR2C(paddedShape));
+        Shape2 center = div(fourierKernel.shape(), Shape2::value_type(2));
+        center[0] = 0;
+        for(int y=0; y<fourierKernel.shape(1); ++y)
+        {
+            for(int x=0; x<fourierKernel.shape(0); ++x)
+            {
+                double xx = 2.0 * M_PI * (x - center[0]) / paddedShape[0];
+                double yy = 2.0 * M_PI * (y - center[1]) / paddedShape[1];
+                fourierKernel(x,y) = std::exp(-2.0 * (sq(xx) + sq(yy)));
+            }
+        }
+
+        for(int k=0; k<3; ++k)
+            convolveFFT(ins[k], fourierKernel, refs[k]);
+        convolveFFTBatch(ins.begin(), ins.end(), fourierKernel, outs.begin(), 2);
+        for(int k=0; k<3; ++k)
+            shouldEqualSequenceTolerance(outs[k].data(), outs[k].data()+outs[k].size(),
+                                         refs[k].data(), 1e-14);
+
+        try
+        {
+            convolveFFTBatch(ins.begin(), ins.begin(), kernel, outs.begin());
+            failTest("no exception thrown");
+        }
+        catch(vigra::ContractViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nconvolveFFTBatch(): empty input sequence.");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
+
+    void testConvolveFFTBlockwise()
+    {
+        ImageImportInfo info("ghouse.gif");
+        Shape2 s(info.width(), info.height());
+        DArray2 in(s), ref(s), out(s);
+        importImage(info, destImage(in));
+
+        // asymmetric kernels of odd and even size
+        Shape2 kernelShapes[2] = { Shape2(15, 9), Shape2(12, 17) };
+        for(int j=0; j<2; ++j)
+        {
+            DArray2 kernel(kernelShapes[j]);
+            for(int k=0; k<kernel.size(); ++k)
+                kernel[k] = rand()/(double)RAND_MAX - 0.3;
+
+            convolveFFT(in, kernel, ref);
+
+            convolveFFTBlockwise(in, kernel, out);
+            shouldEqualSequenceTolerance(out.data(), out.data()+out.size(), ref.data(), 1e-10);
+
+            // many small blocks, including incomplete ones at the borders
+            out.init(0.0);
+            convolveFFTBlockwise(in, kernel, out, Shape2(20, 17));
+            shouldEqualSequenceTolerance(out.data(), out.data()+out.size(), ref.data(), 1e-10);
+
+            DArray2 out2(s);
+            convolveFFTBlockwise(in, kernel, out2, Shape2(20, 17), 2);
+            shouldEqualSequence(out2.data(), out2.data()+out2.size(), out.data());
+        }
+
+        // a strided view as input
+        DArray2 kernel(Shape2(7, 7), 1.0 / 49.0);
+        MultiArrayView<2, double, StridedArrayTag> tin = in.transpose();
+        DArray2 tref(tin.shape()), tout(tin.shape());
+        convolveFFT(tin, kernel, tref);
+        convolveFFTBlockwise(tin, kernel, tout, Shape2(32, 32), 2);
+        shouldEqualSequenceTolerance(tout.data(), tout.data()+tout.size(), tref.data(), 1e-10);
+
+        try
+        {
+            convolveFFTBlockwise(in, kernel, in);
+            failTest("no exception thrown");
+        }
+        catch(vigra::ContractViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nconvolveFFTBlockwise(): input and output must not overlap.");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
+
+    void testSeparableConvolveAuto()
+    {
+        ImageImportInfo info("ghouse.gif");
+        Shape2 s(info.width(), info.height());
+        DArray2 in(s), ref(s), out(s);
+        importImage(info, destImage(in));
+
+        // small kernels are applied in the spatial domain, large ones via blockwise FFT
+        double sigmas[2] = { 1.0, 15.0 };
+        for(int j=0; j<2; ++j)
+        {
+            ArrayVector<Kernel1D<double> > kernels(2);
+            kernels[0].initGaussian(sigmas[j]);
+            kernels[1].initGaussianDerivative(sigmas[j], 1);
+            kernels[1].setBorderTreatment(BORDER_TREATMENT_REFLECT);
+
+            separableConvolveMultiArray(srcMultiArrayRange(in), destMultiArray(ref), 
+                                        kernels.begin());
+            separableConvolveAuto(in, kernels.begin(), out, 2);
+            // the derivative is close to zero in flat regions, so compare absolute errors
+            double maxDiff = 0.0;
+            for(int k=0; k<out.size(); ++k)
+                maxDiff = std::max(maxDiff, std::abs(out[k] - ref[k]));
+            shouldEqualTolerance(maxDiff, 0.0, 1e-10);
+        }
+
+        // asymmetric kernel
+        ArrayVector<Kernel1D<double> > kernels(2);
+        kernels[0].initExplicitly(-1, 40) = 1.0;
+        kernels[0].normalize();
+        kernels[1].initGaussian(20.0);
+        separableConvolveMultiArray(srcMultiArrayRange(in), destMultiArray(ref), 
+                                    kernels.begin());
+        separableConvolveAuto(in, kernels.begin(), out);
+        shouldEqualSequenceTolerance(out.data(), out.data()+out.size(), ref.data(), 1e-10);
+    }
 };
 
 struct FFTWTestSuite
@@ -716,6 +939,10 @@ struct FFTWTestSuite
         add( testCase(&MultiFFTTest::testConvolveFFT));
         add( testCase(&MultiFFTTest::testConvolveFFTComplex));
         add( testCase(&MultiFFTTest::testConvolveFourierKernel));
+        add( testCase(&MultiFFTTest::testPlanCache));
+        add( testCase(&MultiFFTTest::testConvolveFFTBatch));
+        add( testCase(&MultiFFTTest::testConvolveFFTBlockwise));
+        add( testCase(&MultiFFTTest::testSeparableConvolveAuto));
     }
 };
 
@@ -41,10 +41,30 @@
 #include "unittest.hxx"
 #include "vigra/hdf5impex.hxx"
 #include "vigra/multi_array.hxx"
+#include "vigra/multi_blockwise.hxx"
+#include "vigra/multi_morphology.hxx"
+#include "vigra/multi_array_chunked_hdf5.hxx"
+#include "vigra/functorexpression.hxx"
+#include "vigra/inspectimage.hxx"
 
 using namespace vigra;
+using namespace vigra::functor;
 
 
+// blockwise binary erosion, needs a halo of 'radius'
+struct BlockwiseErosion
+{
+    double radius;
+
+    void operator()(MultiArrayView<3, UInt8> const & src, MultiArrayView<3, UInt8> dest,
+                    MultiArrayShape<3>::type const & start, MultiArrayShape<3>::type const & stop) const
+    {
+        MultiArray<3, UInt8> tmp(src.shape());
+        multiBinaryErosion(srcMultiArrayRange(src), destMultiArray(tmp), radius);
+        dest = tmp.subarray(start, stop);
+    }
+};
+
 class HDF5ExportImportTest
 {
 
@@ -831,6 +851,90 @@ public:
 
 
 
+    void testBlockwiseProcessing()
+    {
+        typedef MultiArrayShape<3>::type Shape;
+        Shape shape(40, 35, 23);
+        MultiArray<3, float> data(shape);
+        for(int k=0; k<data.size(); ++k)
+            data[k] = (float)((k*7919) % 1000);
+
+        std::string file_name( "testfile_HDF5File_blockwise.hdf5");
+        HDF5File file (file_name, HDF5File::New);
+        file.write("data", data);
+
+        MultiArray<3, float> ref(shape), res(shape), gref(shape);
+        gaussianSmoothMultiArray(srcMultiArrayRange(data), destMultiArray(ref), 2.0);
+        MultiArray<3, TinyVector<float, 3> > grad(shape);
+        gaussianGradientMultiArray(srcMultiArrayRange(data), destMultiArray(grad), 1.5);
+        for(int k=0; k<grad.size(); ++k)
+            gref[k] = (float)norm(grad[k]);
+
+        BlockwiseGaussianSmoothing<3> smooth(2.0);
+        BlockwiseGaussianGradientMagnitude<3> gradient(1.5);
+        shouldEqual(smooth.halo(), Shape(6));
+        
+        // block shapes that do and do not divide the volume shape
+        Shape blockShapes[] = { Shape(16), Shape(20, 7, 23), Shape(100) };
+        for(int b=0; b<3; ++b)
+        {
+            for(int threads=0; threads<3; ++threads)
+            {
+                BlockwiseOptions<3> opt = BlockwiseOptions<3>().blockShape(blockShapes[b]).numThreads(threads);
+
+                blockwiseProcessHDF5<float, float>(file, "data", file, "smoothed", 
+                                                   smooth, smooth.halo(), opt);
+                file.read("smoothed", res);
+                shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+                blockwiseProcessHDF5<float, float>(file, "data", file, "gradient", 
+                                                   gradient, gradient.halo(), opt);
+                file.read("gradient", res);
+                shouldEqualSequence(res.begin(), res.end(), gref.begin());
+            }
+        }
+
+        // non-convolution filter via the overload without options
+        // (the mask spans several blocks of the default shape 128)
+        Shape maskShape(300, 20, 12);
+        MultiArray<3, UInt8> mask(maskShape), eroded(maskShape), mres(maskShape);
+        for(int z=0; z<maskShape[2]; ++z)
+            for(int y=0; y<maskShape[1]; ++y)
+                for(int x=0; x<maskShape[0]; ++x)
+                    mask(x, y, z) = (x / 8 + y / 7 + z / 5) % 3 != 0 ? 1 : 0;
+        file.write("mask", mask);
+        BlockwiseErosion erosion = { 2.0 };
+        multiBinaryErosion(srcMultiArrayRange(mask), destMultiArray(eroded), erosion.radius);
+        should(eroded.any() && eroded != mask);
+        blockwiseProcessHDF5<UInt8, UInt8>(file, "mask", file, "eroded", erosion, Shape(2));
+        file.read("eroded", mres);
+        shouldEqualSequence(mres.begin(), mres.end(), eroded.begin());
+
+#if defined(VIGRA_HDF5_DIRECT_CHUNK_IO) && defined(H5_HAVE_FILTER_DEFLATE)
+        // HDF5 errors in concurrent blocks are reported (instead of deadlocking)
+        file.createDataset<3, float>("corrupt", shape, 0.0f, Shape(16), 5);
+        file.writeBlock("corrupt", Shape(), data);
+        char garbage[] = "not a zlib stream";
+        file.writeRawChunk<3>("corrupt", Shape(1, 1, 0), garbage, sizeof(garbage));
+        for(int threads=1; threads<3; ++threads)
+        {
+            try
+            {
+                blockwiseProcessHDF5<float, float>(file, "corrupt", file, "failed", 
+                                                   smooth, smooth.halo(), 
+                                                   BlockwiseOptions<3>().blockShape(16).numThreads(threads));
+                failTest("no exception thrown");
+            }
+            catch(PostconditionViolation & c)
+            {
+                std::string expected("\nPostcondition violation!\nHDF5File::readBlock(): chunk decompression failed.");
+                std::string message(c.what());
+                should(0 == expected.compare(message.substr(0,expected.size())));
+            }
+        }
+#endif
+    }
+
     void testHDF5FileChunks()
     {
         //write some data and read it again. Only spot test general functionality.
@@ -1003,6 +1107,164 @@ public:
 
 
 
+    void testChunkedArrayHDF5()
+    {
+        std::string file_name( "testfile_ChunkedArrayHDF5.hdf5");
+
+        typedef MultiArrayShape<3>::type Shape3;
+        Shape3 shape(37, 29, 23), chunks(8, 8, 8);
+        MultiArray<3, float> data(shape);
+        for (int i = 0; i < data.size(); ++i)
+            data[i] = (float)(i % 1000) + std::rand() / (float)RAND_MAX;
+
+        // room for four chunks
+        std::size_t budget = 4*prod(chunks)*sizeof(float);
+        {
+            HDF5File file (file_name, HDF5File::New);
+            ChunkedArrayHDF5<3, float> array(file, "chunked", shape, chunks, 5, budget, 1.0f);
+            shouldEqual(array.chunkShape(), chunks);
+            shouldEqual(array.getItem(Shape3(36, 28, 22)), 1.0f);
+
+            array.commitSubarray(Shape3(), data);
+            should(array.residentBytes() <= budget);
+
+            Shape3 p(20, 10, 5);
+            array.setItem(p, -1.0f);
+            data[p] = -1.0f;
+
+            MultiArray<3, float> in_data(shape);
+            array.checkoutSubarray(Shape3(), in_data);
+            should(in_data == data);
+
+            // flush() writes the loaded, modified chunks to the file
+            array.flush();
+            in_data.init(0.0f);
+            file.read("chunked", in_data);
+            should(in_data == data);
+        }
+        {
+            HDF5File file (file_name, HDF5File::Open);
+            MultiArray<3, float> in_data(shape);
+            file.read("chunked", in_data);
+            should(in_data == data);
+
+            ChunkedArrayHDF5<3, float> array(file, "chunked", budget);
+            shouldEqual(array.shape(), shape);
+            shouldEqual(array.chunkShape(), chunks);
+
+            FindMinMax<float> minmax;
+            inspectMultiArray(array, minmax);
+            shouldEqual(minmax.min, -1.0f);
+            shouldEqual(minmax.count, (unsigned int)prod(shape));
+
+            MultiArray<3, float> result(shape);
+            transformMultiArray(array, result, Arg1() * Param(2.0f));
+            data *= 2.0f;
+            should(result == data);
+        }
+    }
+
+    void testHDF5FileParallelChunks()
+    {
+        std::string file_name( "testfile_HDF5File_parallel_chunks.hdf5");
+
+        typedef MultiArrayShape<3>::type Shape3;
+        Shape3 shape(37, 29, 23), chunks(8, 8, 8);
+        MultiArray<3, float> out_data(shape);
+        for (int i = 0; i < out_data.size(); ++i)
+            out_data[i] = (float)(i % 1000) + std::rand() / (float)RAND_MAX;
+
+        MultiArray<2, TinyVector<float, 3> > out_data_2(MultiArrayShape<2>::type(13, 9));
+        for (int i = 0; i < out_data_2.size(); ++i)
+            out_data_2[i] = TinyVector<float, 3>(i + 0.1f, i + 0.2f, i + 0.3f);
+
+        {
+            HDF5File file (file_name, HDF5File::New);
+            file.setThreadCount(4);
+            file.setChunkCacheSize(1 << 20);
+            shouldEqual(file.threadCount(), 4);
+            shouldEqual(file.chunkCacheSize(), (std::size_t)(1 << 20));
+
+            file.write("compressed", out_data, chunks, 6);
+            file.write("uncompressed", out_data, chunks);
+            file.write("vectors", out_data_2, MultiArrayShape<2>::type(4, 4), 3);
+
+            MultiArray<3, float> in_data(shape);
+            file.read("compressed", in_data);
+            should(in_data == out_data);
+            file.read("uncompressed", in_data);
+            should(in_data == out_data);
+
+            MultiArray<2, TinyVector<float, 3> > in_data_2(out_data_2.shape());
+            file.read("vectors", in_data_2);
+            should(in_data_2 == out_data_2);
+
+            // read overlapping blocks twice (the second time from the cache)
+            Shape3 block_offset(5, 3, 9), block_shape(20, 17, 11);
+            MultiArray<3, float> block(block_shape);
+            for(int k=0; k<2; ++k)
+            {
+                file.readBlock("compressed", block_offset, block_shape, block);
+                should(block == out_data.subarray(block_offset, block_offset + block_shape));
+            }
+
+            // write a block which covers some chunks completely and some partially
+            MultiArray<3, float> new_block(block_shape, 42.0f);
+            file.writeBlock("compressed", block_offset, new_block);
+            out_data.subarray(block_offset, block_offset + block_shape) = new_block;
+            file.read("compressed", in_data);
+            should(in_data == out_data);
+
+            // unwritten chunks return the fill value
+            file.createDataset<3, float>("created", shape, 7.0f, chunks, 5);
+            file.readBlock("created", block_offset, block_shape, block);
+            should(block == (MultiArray<3, float>(block_shape, 7.0f)));
+        }
+
+        // the file must be readable via the standard HDF5 pipeline
+        {
+            MultiArray<3, float> in_data(shape);
+            HDF5ImportInfo info(file_name.c_str(), "/compressed");
+            readHDF5(info, in_data);
+            should(in_data == out_data);
+        }
+
+#ifdef H5_HAVE_FILTER_DEFLATE
+        // transfer pre-compressed chunks
+        {
+            HDF5File file (file_name, HDF5File::Open);
+            Shape3 chunk_index(1, 2, 0), chunk_start(8, 16, 0);
+            std::size_t chunk_bytes = prod(chunks)*sizeof(float);
+
+            ArrayVector<char> raw;
+            should(file.readRawChunk<3>("compressed", chunk_index, raw));
+            MultiArray<3, float> chunk(chunks);
+            uLongf size = chunk_bytes;
+            shouldEqual(uncompress((Bytef *)chunk.data(), &size, (Bytef const *)raw.data(), raw.size()), Z_OK);
+            should(chunk == out_data.subarray(chunk_start, chunk_start + chunks));
+
+            chunk += 1.0f;
+            ArrayVector<char> compressed(compressBound(chunk_bytes));
+            size = compressed.size();
+            compress2((Bytef *)compressed.data(), &size, (Bytef const *)chunk.data(), chunk_bytes, 9);
+            file.writeRawChunk<3>("compressed", chunk_index, compressed.data(), size);
+            out_data.subarray(chunk_start, chunk_start + chunks) += 1.0f;
+
+            chunk_index = Shape3(0, 0, 1);
+            chunk_start = Shape3(0, 0, 8);
+            chunk = out_data.subarray(chunk_start, chunk_start + chunks);
+            chunk *= 2.0f;
+            file.writeRawChunk<3>("compressed", chunk_index, (char const *)chunk.data(), chunk_bytes, false);
+            should(!file.readRawChunk<3>("compressed", chunk_index, raw));
+            out_data.subarray(chunk_start, chunk_start + chunks) *= 2.0f;
+
+            MultiArray<3, float> in_data(shape);
+            file.read("compressed", in_data);
+            should(in_data == out_data);
+        }
+#endif
+    }
+
     void testHDF5FileBrowsing()
     {
         //create groups, change current group, ...
@@ -1294,8 +1556,11 @@ struct HDF5ImportExportTestSuite : public vigra::test_suite
         // HDF5File tests
         add(testCase(&HDF5ExportImportTest::testHDF5FileDataAccess));
         add(testCase(&HDF5ExportImportTest::testHDF5FileBlockAccess));
+        add(testCase(&HDF5ExportImportTest::testBlockwiseProcessing));
         add(testCase(&HDF5ExportImportTest::testHDF5FileChunks));
         add(testCase(&HDF5ExportImportTest::testHDF5FileCompression));
+        add(testCase(&HDF5ExportImportTest::testHDF5FileParallelChunks));
+        add(testCase(&HDF5ExportImportTest::testChunkedArrayHDF5));
         add(testCase(&HDF5ExportImportTest::testHDF5FileBrowsing));
         add(testCase(&HDF5ExportImportTest::testHDF5FileAttributes));
         add(testCase(&HDF5ExportImportTest::testHDF5FileTutorial));
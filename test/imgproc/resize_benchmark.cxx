@@ -0,0 +1,167 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2004-2011 by Ullrich Koethe                  */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+/* Benchmark of resizeImageSplineInterpolation() and resizeMultiArraySplineInterpolation(),
+   comparing the line-by-line resampling with resamplingConvolveLine() (which 
+   recomputes the kernel positions for every line) to the precomputed kernel tables 
+   with one and several threads.
+
+   Usage: resize_benchmark [size [threads]]
+
+   Enlarges and reduces a size x size image and a (size/4)^3 volume and prints 
+   the run times in ms.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include "vigra/stdimage.hxx"
+#include "vigra/multi_array.hxx"
+#include "vigra/resizeimage.hxx"
+#include "vigra/multi_resize.hxx"
+#include "vigra/random.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+    // the spline resize with resamplingConvolveLine()
+void resizeReference(FImage const & src, FImage & dest)
+{
+    BSpline<3, double> spline;
+    int wold = src.width(), hold = src.height(), wnew = dest.width(), hnew = dest.height();
+    FImage tmp(wold, hnew);
+    ArrayVector<float> line(std::max(wold, hold));
+    ArrayVector<double> const & prefilterCoeffs = spline.prefilterCoefficients();
+
+    for(int d=0; d<2; ++d)
+    {
+        int sizeOld = d == 0 ? hold : wold, sizeNew = d == 0 ? hnew : wnew;
+        int lines = d == 0 ? wold : hnew;
+        Rational<int> ratio(sizeNew - 1, sizeOld - 1);
+        resampling_detail::MapTargetToSourceCoordinate mapCoordinate(ratio, Rational<int>(0));
+        ArrayVector<Kernel1D<double> > kernels(lcm(ratio.numerator(), ratio.denominator()));
+        createResamplingKernels(spline, mapCoordinate, kernels);
+
+        for(int k=0; k<lines; ++k)
+        {
+            FImage::const_traverser s = d == 0 ? src.upperLeft() + Diff2D(k, 0) : tmp.upperLeft() + Diff2D(0, k);
+            FImage::traverser t = d == 0 ? tmp.upperLeft() + Diff2D(k, 0) : dest.upperLeft() + Diff2D(0, k);
+            if(d == 0)
+                recursiveFilterLine(s.columnIterator(), s.columnIterator() + sizeOld, src.accessor(),
+                                    line.begin(), StandardValueAccessor<float>(),
+                                    prefilterCoeffs[0], BORDER_TREATMENT_REFLECT);
+            else
+                recursiveFilterLine(s.rowIterator(), s.rowIterator() + sizeOld, src.accessor(),
+                                    line.begin(), StandardValueAccessor<float>(),
+                                    prefilterCoeffs[0], BORDER_TREATMENT_REFLECT);
+            if(sizeNew < sizeOld)
+                recursiveSmoothLine(line.begin(), line.begin() + sizeOld, StandardValueAccessor<float>(),
+                                    line.begin(), StandardValueAccessor<float>(), 
+                                    (double)sizeOld/sizeNew/2.0);
+            if(d == 0)
+                resamplingConvolveLine(line.begin(), line.begin() + sizeOld, StandardValueAccessor<float>(),
+                                       t.columnIterator(), t.columnIterator() + sizeNew, tmp.accessor(),
+                                       kernels, mapCoordinate);
+            else
+                resamplingConvolveLine(line.begin(), line.begin() + sizeOld, StandardValueAccessor<float>(),
+                                       t.rowIterator(), t.rowIterator() + sizeNew, dest.accessor(),
+                                       kernels, mapCoordinate);
+        }
+    }
+}
+
+void benchmarkImage(FImage const & img, Size2D newSize, int nthreads)
+{
+    FImage dest(newSize);
+
+    USETICTOC;
+    std::cout << std::setw(12) << newSize.x << std::fixed << std::setprecision(1);
+    TIC;
+    resizeReference(img, dest);
+    std::cout << std::setw(13) << TOCN;
+    TIC;
+    resizeImageSplineInterpolation(srcImageRange(img), destImageRange(dest), BSpline<3, double>(), 1);
+    std::cout << std::setw(13) << TOCN;
+    TIC;
+    resizeImageSplineInterpolation(srcImageRange(img), destImageRange(dest), BSpline<3, double>(), nthreads);
+    std::cout << std::setw(13) << TOCN << std::endl;
+}
+
+void benchmarkVolume(MultiArray<3, float> const & vol, Shape3 newShape, int nthreads)
+{
+    MultiArray<3, float> dest(newShape);
+
+    USETICTOC;
+    std::cout << std::setw(12) << newShape[0] << std::fixed << std::setprecision(1);
+    TIC;
+    resizeMultiArraySplineInterpolation(srcMultiArrayRange(vol), destMultiArrayRange(dest), 
+                                        BSpline<3, double>(), 1);
+    std::cout << std::setw(26) << TOCN;
+    TIC;
+    resizeMultiArraySplineInterpolation(srcMultiArrayRange(vol), destMultiArrayRange(dest), 
+                                        BSpline<3, double>(), nthreads);
+    std::cout << std::setw(13) << TOCN << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 1024;
+    int nthreads = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    RandomMT19937 random;
+    FImage img(size, size);
+    for(FImage::iterator i = img.begin(); i != img.end(); ++i)
+        *i = 255.0f*random.uniform();
+    MultiArray<3, float> vol(Shape3(size/4));
+    for(MultiArray<3, float>::iterator i = vol.begin(); i != vol.end(); ++i)
+        *i = 255.0f*random.uniform();
+
+    std::cout << "image size " << size << "x" << size << ", " 
+              << parallelThreadCount(nthreads) << " threads\n\n";
+    std::cout << "   new width    reference    tables(1)    tables(n)\n";
+    benchmarkImage(img, Size2D(2*size-1, 2*size-1), nthreads);
+    benchmarkImage(img, Size2D(3*size/2, 3*size/2), nthreads);
+    benchmarkImage(img, Size2D(size/3, size/3), nthreads);
+
+    std::cout << "\nvolume size " << size/4 << "^3\n\n";
+    std::cout << "   new width                 tables(1)    tables(n)\n";
+    benchmarkVolume(vol, Shape3(size/2-1), nthreads);
+    benchmarkVolume(vol, Shape3(size/12), nthreads);
+    return 0;
+}
@@ -0,0 +1,121 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2004-2011 by Ullrich Koethe                  */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+
+/* Benchmark of SplineImageView evaluation at many points, comparing
+   single-point access with the batch functions sample() and sampleGrid().
+
+   Usage: splineimageview_benchmark [size [threads]]
+
+   Resamples a size x size image at twice the resolution (value and x-derivative)
+   and prints the run times in ms.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include "vigra/stdimage.hxx"
+#include "vigra/splineimageview.hxx"
+#include "vigra/random.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+template <int ORDER>
+void benchmark(FImage const & img, int nthreads)
+{
+    typedef MultiArrayShape<2>::type Shape2;
+    SplineImageView<ORDER, float> view(srcImageRange(img));
+    int w = 2*img.width() - 1, h = 2*img.height() - 1;
+
+    ArrayVector<Shape2> derivatives;
+    derivatives.push_back(Shape2(0, 0));
+    derivatives.push_back(Shape2(1, 0));
+
+    MultiArray<3, float> res(Shape3(w, h, 2));
+    MultiArray<1, TinyVector<double, 2> > points(Shape1(w*h));
+    for(int y=0, k=0; y<h; ++y)
+        for(int x=0; x<w; ++x, ++k)
+            points(k) = TinyVector<double, 2>(0.5*x, 0.5*y);
+    MultiArrayView<2, float> pres(Shape2(w*h, 2), res.data());
+
+    USETICTOC;
+    std::cout << std::setw(6) << ORDER << std::fixed << std::setprecision(1);
+    TIC;
+    for(int y=0; y<h; ++y)
+    {
+        for(int x=0; x<w; ++x)
+        {
+            res(x, y, 0) = view(0.5*x, 0.5*y);
+            res(x, y, 1) = view.dx(0.5*x, 0.5*y);
+        }
+    }
+    std::cout << std::setw(13) << TOCN;
+    TIC;
+    view.sample(points, derivatives, pres, 1);
+    std::cout << std::setw(13) << TOCN;
+    TIC;
+    view.sample(points, derivatives, pres, nthreads);
+    std::cout << std::setw(13) << TOCN;
+    TIC;
+    view.sampleGrid(TinyVector<double, 2>(0.0, 0.0), TinyVector<double, 2>(0.5, 0.5), 
+                    derivatives, res, 1);
+    std::cout << std::setw(13) << TOCN;
+    TIC;
+    view.sampleGrid(TinyVector<double, 2>(0.0, 0.0), TinyVector<double, 2>(0.5, 0.5), 
+                    derivatives, res, nthreads);
+    std::cout << std::setw(13) << TOCN << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 1024;
+    int nthreads = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    FImage img(size, size);
+    RandomMT19937 random;
+    for(FImage::iterator i = img.begin(); i != img.end(); ++i)
+        *i = 255.0f*random.uniform();
+
+    std::cout << "image size " << size << "x" << size << ", " 
+              << parallelThreadCount(nthreads) << " threads\n\n";
+    std::cout << " order   operator()   points(1)    points(n)     grid(1)      grid(n)\n";
+    benchmark<1>(img, nthreads);
+    benchmark<2>(img, nthreads);
+    benchmark<3>(img, nthreads);
+    benchmark<5>(img, nthreads);
+    return 0;
+}
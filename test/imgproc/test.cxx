@@ -46,6 +46,8 @@
 #include "vigra/affinegeometry.hxx"
 #include "vigra/impex.hxx"
 #include "vigra/meshgrid.hxx"
+#include "vigra/random.hxx"
+#include "vigra/multi_resize.hxx"
 
 using namespace vigra;
 
@@ -1230,6 +1232,60 @@ struct ResizeImageTest
         }
     }
 
+    void testSplineInterpolationParallel()
+    {
+        int w = img.width(), h = img.height();
+        Size2D sizes[] = { Size2D(2*w-1, 2*h-1), Size2D(301, 187), 
+                           Size2D(42, 42), Size2D(w/2, 3*h/2) };
+
+        for(int k=0; k<4; ++k)
+        {
+            Image serial(sizes[k]), parallel(sizes[k]);
+
+            resizeImageSplineInterpolation(srcImageRange(img), destImageRange(serial), 
+                                           BSpline<3, double>());
+            resizeImageSplineInterpolation(srcImageRange(img), destImageRange(parallel), 
+                                           BSpline<3, double>(), 3);
+            shouldEqualSequence(serial.begin(), serial.end(), parallel.begin());
+
+            resizeImageSplineInterpolation(srcImageRange(img), destImageRange(serial), 
+                                           CatmullRomSpline<double>());
+            resizeImageSplineInterpolation(srcImageRange(img), destImageRange(parallel), 
+                                           CatmullRomSpline<double>(), 3);
+            shouldEqualSequence(serial.begin(), serial.end(), parallel.begin());
+
+            RGBImage rgbSerial(sizes[k]), rgbParallel(sizes[k]);
+            resizeImageSplineInterpolation(srcImageRange(rgb), destImageRange(rgbSerial), 
+                                           BSpline<5, double>());
+            resizeImageSplineInterpolation(srcImageRange(rgb), destImageRange(rgbParallel), 
+                                           BSpline<5, double>(), 3);
+            shouldEqualSequence(rgbSerial.begin(), rgbSerial.end(), rgbParallel.begin());
+        }
+
+        // when enlarging, the result must coincide with the spline interpolant
+        DImage src(w, h), dest(301, 187);
+        copyImage(srcImageRange(img), destImage(src));
+        resizeImageSplineInterpolation(srcImageRange(src), destImageRange(dest), 
+                                       BSpline<3, double>(), 2);
+        SplineImageView<3, double> spline(srcImageRange(src));
+        double xscale = (w - 1.0) / (dest.width() - 1.0),
+               yscale = (h - 1.0) / (dest.height() - 1.0);
+        for(int y=0; y<dest.height(); ++y)
+            for(int x=0; x<dest.width(); ++x)
+                shouldEqualTolerance(dest(x, y), spline(x*xscale, y*yscale), 1e-10);
+
+        // the same for resizeMultiArraySplineInterpolation()
+        typedef MultiArrayShape<2>::type Shape;
+        MultiArray<2, double> msrc(Shape(w, h)), mserial(Shape(301, 187)), mparallel(Shape(301, 187));
+        copyImage(srcImageRange(src), destImage(msrc));
+        resizeMultiArraySplineInterpolation(srcMultiArrayRange(msrc), destMultiArrayRange(mserial), 
+                                            BSpline<3, double>());
+        resizeMultiArraySplineInterpolation(srcMultiArrayRange(msrc), destMultiArrayRange(mparallel), 
+                                            BSpline<3, double>(), 3);
+        shouldEqualSequence(mserial.begin(), mserial.end(), mparallel.begin());
+        shouldEqualSequenceTolerance(mserial.begin(), mserial.end(), dest.begin(), 1e-10);
+    }
+
     void testCatmullRomInterpolationExtensionHandControled()
     {
         vigra::DImage src(6, 7), dest(10, 10, 145.346);
@@ -1471,6 +1527,73 @@ struct SplineImageViewTest
         catch(vigra::PreconditionViolation) {}
     }
 
+    void testBatchSampling()
+    {
+        typedef MultiArrayShape<2>::type Shape2;
+        SplineImageView<N, double> view(srcImageRange(img));
+
+        // arbitrary points, including the reflected border region
+        int count = 1000;
+        RandomMT19937 random(42);
+        MultiArray<1, TinyVector<double, 2> > points((Shape1(count)));
+        for(int k=0; k<count; ++k)
+            points(k) = TinyVector<double, 2>(1.4*img.width()*random.uniform() - 0.2*img.width(),
+                                              1.4*img.height()*random.uniform() - 0.2*img.height());
+        points(0) = TinyVector<double, 2>(0.0, 0.0);
+        points(1) = TinyVector<double, 2>(img.width() - 1.0, img.height() - 1.0);
+
+        ArrayVector<Shape2> derivatives;
+        derivatives.push_back(Shape2(0, 0));
+        derivatives.push_back(Shape2(1, 0));
+        derivatives.push_back(Shape2(0, 1));
+        derivatives.push_back(Shape2(1, 1));
+        derivatives.push_back(Shape2(2, 0));
+
+        MultiArray<2, double> res(Shape2(count, derivatives.size()));
+        view.sample(points, derivatives, res, 3);
+        MultiArray<1, float> dx((Shape1(count)));
+        view.sample(points, dx, 1, 0);
+        for(int k=0; k<count; ++k)
+        {
+            for(unsigned int d=0; d<derivatives.size(); ++d)
+                shouldEqual(res(k, d), view(points(k)[0], points(k)[1], 
+                                            derivatives[d][0], derivatives[d][1]));
+            shouldEqual(dx(k), (float)view.dx(points(k)[0], points(k)[1]));
+        }
+
+        // regular grid
+        TinyVector<double, 2> origin(-3.3, -2.1), step(0.7, 0.45);
+        MultiArray<3, double> grid(Shape3(170, 240, derivatives.size()));
+        view.sampleGrid(origin, step, derivatives, grid, 2);
+        MultiArray<2, double> values(Shape2(170, 240));
+        view.sampleGrid(origin, step, values);
+        for(int j=0; j<grid.shape(1); ++j)
+        {
+            for(int i=0; i<grid.shape(0); ++i)
+            {
+                double x = origin[0] + i*step[0], y = origin[1] + j*step[1];
+                for(unsigned int d=0; d<derivatives.size(); ++d)
+                    should(std::abs(grid(i, j, d) - view(x, y, derivatives[d][0], derivatives[d][1])) < 1e-10);
+                shouldEqual(values(i, j), grid(i, j, 0));
+            }
+        }
+
+        // errors
+        points(17) = TinyVector<double, 2>(2.0*img.width(), 0.0);
+        try
+        {
+            view.sample(points, derivatives, res, 2);
+            failTest("Out-of-range coordinate failed to throw exception");
+        }
+        catch(vigra::PreconditionViolation &) {}
+        try
+        {
+            view.sample(points, dx.subarray(Shape1(1), Shape1(count)));
+            failTest("Shape mismatch failed to throw exception");
+        }
+        catch(vigra::PreconditionViolation &) {}
+    }
+
     void testVectorSIV()
     {
         // (compile-time only test for now)
@@ -1669,26 +1792,32 @@ struct ImageFunctionsTestSuite
         add( testCase( &ResizeImageTest::testCubicInterpolationExtensionWithLena));
         add( testCase( &ResizeImageTest::testCubicInterpolationReductionWithLena));
         add( testCase( &ResizeImageTest::testCatmullRomInterpolationExtensionHandControled));
+        add( testCase( &ResizeImageTest::testSplineInterpolationParallel));
         add( testCase( &SplineImageViewTest<0>::testPSF));
         add( testCase( &SplineImageViewTest<0>::testCoefficientArray));
         add( testCase( &SplineImageViewTest<0>::testImageResize0));
         add( testCase( &SplineImageViewTest<0>::testOutside));
+        add( testCase( &SplineImageViewTest<0>::testBatchSampling));
         add( testCase( &SplineImageViewTest<1>::testPSF));
         add( testCase( &SplineImageViewTest<1>::testCoefficientArray));
         add( testCase( &SplineImageViewTest<1>::testImageResize1));
         add( testCase( &SplineImageViewTest<1>::testOutside));
+        add( testCase( &SplineImageViewTest<1>::testBatchSampling));
         add( testCase( &SplineImageViewTest<2>::testPSF));
         add( testCase( &SplineImageViewTest<2>::testCoefficientArray));
         add( testCase( &SplineImageViewTest<2>::testImageResize));
         add( testCase( &SplineImageViewTest<2>::testOutside));
+        add( testCase( &SplineImageViewTest<2>::testBatchSampling));
         add( testCase( &SplineImageViewTest<3>::testPSF));
         add( testCase( &SplineImageViewTest<3>::testCoefficientArray));
         add( testCase( &SplineImageViewTest<3>::testImageResize));
         add( testCase( &SplineImageViewTest<3>::testOutside));
+        add( testCase( &SplineImageViewTest<3>::testBatchSampling));
         add( testCase( &SplineImageViewTest<5>::testPSF));
         add( testCase( &SplineImageViewTest<5>::testCoefficientArray));
         add( testCase( &SplineImageViewTest<5>::testImageResize));
         add( testCase( &SplineImageViewTest<5>::testOutside));
+        add( testCase( &SplineImageViewTest<5>::testBatchSampling));
         add( testCase( &SplineImageViewTest<5>::testVectorSIV));
 
         add( testCase( &GeometricTransformsTest::testSimpleGeometry));
@@ -41,6 +41,7 @@
 #include "vigra/impex.hxx"
 #include "unittest.hxx"
 #include "vigra/multi_array.hxx"
+#include "vigra/multi_impex.hxx"
 
 using namespace vigra;
 
@@ -249,6 +250,103 @@ public:
 #endif
     }
 
+    void testRegionOfInterest ()
+    {
+        vigra::Rect2D roi (vigra::Point2D (13, 27), vigra::Size2D (50, 31));
+
+        exportImage (srcImageRange (img), vigra::ImageExportInfo ("res.pgm"));
+        vigra::ImageImportInfo info ("res.pgm");
+        Image res (roi.size ());
+        importImage (info, roi, destImage (res));
+        for (int y = 0; y < roi.height (); ++y)
+            for (int x = 0; x < roi.width (); ++x)
+                shouldEqual (res (x, y), img (x + roi.left (), y + roi.top ()));
+
+        vigra::ImageImportInfo rgbinfo ("lennargb.xv");
+        vigra::BRGBImage rgb (rgbinfo.size ()), rgbres (roi.size ());
+        importImage (rgbinfo, destImage (rgb));
+        importImage (rgbinfo, roi, destImage (rgbres));
+        for (int y = 0; y < roi.height (); ++y)
+            for (int x = 0; x < roi.width (); ++x)
+                shouldEqual (rgbres (x, y), rgb (x + roi.left (), y + roi.top ()));
+
+        try
+        {
+            importImage (info, vigra::Rect2D (vigra::Point2D (0, 0), info.size () + vigra::Size2D (1, 0)),
+                         destImage (res));
+            failTest ("importImage() failed to throw exception for invalid region of interest.");
+        }
+        catch (vigra::PreconditionViolation & e)
+        {
+            std::string expected ("\nPrecondition violation!\nimportImage(): region of interest must be a non-empty part of the image.");
+            std::string message (e.what ());
+            should (0 == expected.compare (message.substr (0, expected.size ())));
+        }
+
+#if defined(HasTIFF)
+        // TIFF only decodes the requested rows
+        exportImage (srcImageRange (img), vigra::ImageExportInfo ("res.tif").setCompression ("LZW"));
+        vigra::ImageImportInfo tiffinfo ("res.tif");
+        importImage (tiffinfo, roi, destImage (res));
+        for (int y = 0; y < roi.height (); ++y)
+            for (int x = 0; x < roi.width (); ++x)
+                shouldEqual (res (x, y), img (x + roi.left (), y + roi.top ()));
+#endif
+    }
+
+    void testTiledTIFF ()
+    {
+#if defined(HasTIFF)
+        // lenna_tiled.tif holds lenna.xv[20..120, 30..105] in 32x32 tiles,
+        // lennargb_tiled.tif the same part of lennargb.xv in 48x16 RGB tiles, and
+        // lennargb_bigtiff.tif the same part as a BigTIFF with separate color planes
+        // in LZW-compressed strips of 8 rows
+        vigra::Point2D origin (20, 30);
+        vigra::Size2D size (100, 75);
+        // crosses tile borders in both directions
+        vigra::Rect2D roi (vigra::Point2D (13, 27), vigra::Size2D (50, 31));
+
+        // striped reference data
+        exportImage (srcIterRange (img.upperLeft () + origin, img.upperLeft () + origin + size),
+                     vigra::ImageExportInfo ("res.tif"));
+        vigra::ImageImportInfo refinfo ("res.tif");
+        Image ref (size), res (size), roires (roi.size ());
+        importImage (refinfo, destImage (ref));
+
+        vigra::ImageImportInfo info ("lenna_tiled.tif");
+        shouldEqual (info.size (), size);
+        importImage (info, destImage (res));
+        shouldEqualSequence (res.begin (), res.end (), ref.begin ());
+        importImage (info, roi, destImage (roires));
+        for (int y = 0; y < roi.height (); ++y)
+            for (int x = 0; x < roi.width (); ++x)
+                shouldEqual (roires (x, y), ref (x + roi.left (), y + roi.top ()));
+
+        vigra::ImageImportInfo rgbinfo ("lennargb.xv");
+        vigra::BRGBImage rgb (rgbinfo.size ());
+        importImage (rgbinfo, destImage (rgb));
+        exportImage (srcIterRange (rgb.upperLeft () + origin, rgb.upperLeft () + origin + size),
+                     vigra::ImageExportInfo ("resrgb.tif"));
+        vigra::ImageImportInfo rgbrefinfo ("resrgb.tif");
+        vigra::BRGBImage rgbref (size), rgbres (size), rgbroires (roi.size ());
+        importImage (rgbrefinfo, destImage (rgbref));
+
+        const char * files[] = { "lennargb_tiled.tif", "lennargb_bigtiff.tif" };
+        for (int k = 0; k < 2; ++k)
+        {
+            vigra::ImageImportInfo tiffinfo (files[k]);
+            shouldEqual (tiffinfo.size (), size);
+            should (tiffinfo.isColor ());
+            importImage (tiffinfo, destImage (rgbres));
+            shouldEqualSequence (rgbres.begin (), rgbres.end (), rgbref.begin ());
+            importImage (tiffinfo, roi, destImage (rgbroires));
+            for (int y = 0; y < roi.height (); ++y)
+                for (int x = 0; x < roi.width (); ++x)
+                    shouldEqual (rgbroires (x, y), rgbref (x + roi.left (), y + roi.top ()));
+        }
+#endif
+    }
+
     void testBMP ()
     {
         testFile ("res.bmp");
@@ -1468,6 +1566,91 @@ public:
     }
 };
 
+class RawVolumeTest
+{
+  public:
+
+    typedef vigra::MultiArray<3, float> Volume;
+
+    Volume volume;
+
+    RawVolumeTest ()
+    : volume (Volume::difference_type (17, 9, 5))
+    {
+        for (int k = 0; k < volume.size (); ++k)
+            volume[k] = 0.5f * k - 3.0f;
+    }
+
+    void testExportImport ()
+    {
+        vigra::exportRawVolume (volume, "resvolume.info");
+
+        vigra::VolumeImportInfo info ("resvolume.info");
+        shouldEqual (info.shape (), volume.shape ());
+        shouldEqual (info.getPixelType (), std::string ("FLOAT"));
+        shouldEqual (info.rawFilename (), std::string ("resvolume.raw"));
+
+        Volume result (info.shape ());
+        importVolume (info, result);
+        shouldEqualSequence (result.begin (), result.end (), volume.begin ());
+
+        // import into a strided view
+        vigra::MultiArray<3, float> transposed (Volume::difference_type (5, 9, 17));
+        vigra::MultiArrayView<3, float, vigra::StridedArrayTag> view (transposed.transpose ());
+        importVolume (info, view);
+        shouldEqualSequence (view.begin (), view.end (), volume.begin ());
+    }
+
+    void testMemoryMapped ()
+    {
+        vigra::exportRawVolume (volume, "resvolume.info");
+        vigra::VolumeImportInfo info ("resvolume.info");
+
+        {
+            // copy-on-write: changes are not written back
+            vigra::MemoryMappedVolume<float> mapped (info);
+            shouldEqual (mapped.shape (), volume.shape ());
+            shouldEqualSequence (mapped.begin (), mapped.end (), volume.begin ());
+            mapped (1, 2, 3) = 42.0f;
+            shouldEqual (mapped (1, 2, 3), 42.0f);
+        }
+        {
+            vigra::MemoryMappedVolume<float> mapped (info, vigra::MemoryMappedFile::ReadWrite);
+            shouldEqual (mapped (1, 2, 3), volume (1, 2, 3));
+            mapped (1, 2, 3) = 42.0f;
+        }
+        Volume result (info.shape ());
+        importVolume (info, result);
+        shouldEqual (result (1, 2, 3), 42.0f);
+        result (1, 2, 3) = volume (1, 2, 3);
+        should (result == volume);
+
+        {
+            // writing a new volume through the mapping
+            vigra::MemoryMappedVolume<vigra::UInt16> created ("resvolume16.info", volume.shape ());
+            for (int k = 0; k < created.size (); ++k)
+                created[k] = (vigra::UInt16)k;
+        }
+        vigra::VolumeImportInfo info16 ("resvolume16.info");
+        shouldEqual (info16.getPixelType (), std::string ("UINT16"));
+        vigra::MemoryMappedVolume<vigra::UInt16> mapped16 (info16, vigra::MemoryMappedFile::ReadOnly);
+        for (int k = 0; k < mapped16.size (); ++k)
+            shouldEqual (mapped16[k], k);
+
+        try
+        {
+            vigra::MemoryMappedVolume<double> wrongType (info);
+            failTest ("MemoryMappedVolume failed to throw exception for mismatching value_type.");
+        }
+        catch (vigra::PreconditionViolation & e)
+        {
+            std::string expected ("\nPrecondition violation!\nMemoryMappedVolume(): size of RAW file doesn't match");
+            std::string message (e.what ());
+            should (0 == expected.compare (message.substr (0, expected.size ())));
+        }
+    }
+};
+
 struct ImageImportExportTestSuite : public vigra::test_suite
 {
     ImageImportExportTestSuite()
@@ -1482,6 +1665,8 @@ struct ImageImportExportTestSuite : public vigra::test_suite
         add(testCase(&ByteImageExportImportTest::testJPEG));
         add(testCase(&ByteImageExportImportTest::testTIFF));
         add(testCase(&ByteImageExportImportTest::testTIFFSequence));
+        add(testCase(&ByteImageExportImportTest::testRegionOfInterest));
+        add(testCase(&ByteImageExportImportTest::testTiledTIFF));
         add(testCase(&ByteImageExportImportTest::testBMP));
         add(testCase(&ByteImageExportImportTest::testPGM));
         add(testCase(&ByteImageExportImportTest::testPNM));
@@ -1558,6 +1743,10 @@ struct ImageImportExportTestSuite : public vigra::test_suite
         add(testCase(&ImageExportImportFailureTest::testSUNImport));
         add(testCase(&ImageExportImportFailureTest::testVIFFExport));
         add(testCase(&ImageExportImportFailureTest::testVIFFImport));
+
+        // raw volumes
+        add(testCase(&RawVolumeTest::testExportImport));
+        add(testCase(&RawVolumeTest::testMemoryMapped));
     }
 };
 
@@ -0,0 +1,106 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2004-2011 by Ullrich Koethe                  */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+/* Benchmark of linalg::mmul() for square matrices from 64x64 up to 4096x4096.
+
+   Usage: mmul_benchmark [max_size [threads]]
+
+   Prints GFLOP/s of the naive triple loop (up to 1024x1024, since it gets
+   very slow beyond), and of mmul() on one and on 'threads' threads
+   (default: all available). When compiled with VIGRA_USE_BLAS, mmul() 
+   measures the BLAS library instead of VIGRA's blocked kernel.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include "vigra/matrix.hxx"
+#include "vigra/random.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+template <class T>
+double gflops(MultiArrayIndex n, double milliseconds)
+{
+    return 2.0 * n * n * n / milliseconds / 1.0e6;
+}
+
+template <class T>
+void benchmark(const char * name, MultiArrayIndex maxSize, int nthreads)
+{
+    std::cout << name << ":\n"
+              << "      size     naive   mmul(1)   mmul(" << parallelThreadCount(nthreads) << ")  [GFLOP/s]\n";
+    RandomMT19937 random(42);
+    for(MultiArrayIndex n = 64; n <= maxSize; n *= 2)
+    {
+        Matrix<T> a(n, n), b(n, n), r(n, n), ref(n, n);
+        for(MultiArrayIndex k = 0; k < a.size(); ++k)
+        {
+            a[k] = (T)random.uniform();
+            b[k] = (T)random.uniform();
+        }
+
+        USETICTOC;
+        std::cout << std::setw(10) << n << std::fixed << std::setprecision(2);
+        if(n <= 1024)
+        {
+            TIC;
+            linalg::detail::mmulImpl(a, b, ref, 1, VigraFalseType());
+            std::cout << std::setw(10) << gflops<T>(n, TOCN);
+        }
+        else
+        {
+            std::cout << std::setw(10) << "-";
+        }
+        TIC;
+        linalg::mmul(a, b, r, 1);
+        std::cout << std::setw(10) << gflops<T>(n, TOCN);
+        TIC;
+        linalg::mmul(a, b, r, nthreads);
+        std::cout << std::setw(10) << gflops<T>(n, TOCN) << std::endl;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    MultiArrayIndex maxSize = argc > 1 ? std::atoi(argv[1]) : 4096;
+    int nthreads = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    benchmark<float>("float", maxSize, nthreads);
+    benchmark<double>("double", maxSize, nthreads);
+    return 0;
+}
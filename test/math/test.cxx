@@ -1529,6 +1529,41 @@ struct LinalgTest
         return ret;
     }
 
+    void testMatrixMultiplication()
+    {
+        // large enough for the blocked kernel, with partial tiles and panels
+        using namespace vigra::linalg;
+
+        unsigned int m = 203, n = 77, k = 300;
+        Matrix a = random_matrix(m, k), b = random_matrix(k, n);
+        Matrix ref(m, n);
+        for(unsigned int j = 0; j < n; ++j)
+            for(unsigned int i = 0; i < m; ++i)
+                for(unsigned int l = 0; l < k; ++l)
+                    ref(i, j) += a(i, l) * b(l, j);
+
+        double epsilon = 1e-10;
+        Matrix r(m, n);
+        mmul(a, b, r);
+        should(vigra::norm(r - ref) < epsilon);
+
+        // the result doesn't depend on the number of threads
+        Matrix r2(m, n);
+        mmul(a, b, r2, 3);
+        shouldEqualSequence(r2.data(), r2.data()+r2.size(), r.data());
+
+        // strided arguments and result
+        Matrix at = transpose(a), bt = transpose(b), rt(n, m);
+        vigra::MultiArrayView<2, double, vigra::StridedArrayTag> rtv = rt.transpose();
+        mmul(at.transpose(), bt.transpose(), rtv);
+        should(vigra::norm(rtv - ref) < epsilon);
+        should(vigra::norm(at.transpose() * bt.transpose() - ref) < epsilon);
+
+        vigra::Matrix<float> af(a), bf(b), rf(m, n);
+        mmul(af, bf, rf, 2);
+        should(vigra::norm(Matrix(rf) - ref) < 1e-3);
+    }
+
     void testMatrix()
     {
         double data[] = {1.0, 5.0,
@@ -2848,6 +2883,7 @@ struct MathTestSuite
 
         add( testCase(&LinalgTest::testOStreamShifting));
         add( testCase(&LinalgTest::testMatrix));
+        add( testCase(&LinalgTest::testMatrixMultiplication));
         add( testCase(&LinalgTest::testArgMinMax));
         add( testCase(&LinalgTest::testColumnAndRowStatistics));
         add( testCase(&LinalgTest::testColumnAndRowPreparation));
@@ -0,0 +1,435 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2011 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */                
+/*                                                                      */
+/************************************************************************/
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "unittest.hxx"
+
+#include "vigra/multi_array_chunked.hxx"
+#include "vigra/functorexpression.hxx"
+#include "vigra/inspectimage.hxx"
+#include "vigra/random.hxx"
+
+using namespace vigra;
+using namespace vigra::functor;
+
+template <class ARRAY>
+struct ChunkedArrayTest
+{
+    typedef MultiArrayShape<3>::type Shape;
+    typedef typename ARRAY::value_type value_type;
+
+    Shape shape, chunkShape;
+    MultiArray<3, value_type> reference;
+
+    ChunkedArrayTest()
+    : shape(50, 37, 21),
+      chunkShape(16, 8, 5),
+      reference(shape)
+    {
+        // piecewise constant data with some noise, so that compression 
+        // has to handle runs as well as literals
+        RandomMT19937 random(42);
+        for(int z=0; z<shape[2]; ++z)
+            for(int y=0; y<shape[1]; ++y)
+                for(int x=0; x<shape[0]; ++x)
+                    reference(x, y, z) = (x < 20) 
+                                            ? value_type(y / 3) 
+                                            : value_type(random.uniformInt(100));
+    }
+
+    ~ChunkedArrayTest()
+    {
+        // delete the backing files created by this test
+        for(unsigned int k=0; k<createdFiles().size(); ++k)
+            std::remove(createdFiles()[k].c_str());
+        createdFiles().clear();
+    }
+
+    static std::vector<std::string> & createdFiles()
+    {
+        static std::vector<std::string> files;
+        return files;
+    }
+
+    static ARRAY * create(Shape const & shape, Shape const & chunkShape, 
+                          std::size_t budget, value_type fill);
+
+    void testFillAndShape()
+    {
+        std::auto_ptr<ARRAY> array(create(shape, chunkShape, 1 << 20, 3));
+
+        shouldEqual(array->shape(), shape);
+        shouldEqual(array->chunkShape(), chunkShape);
+        shouldEqual(array->chunkArrayShape(), Shape(4, 5, 5));
+        shouldEqual(array->size(), prod(shape));
+        shouldEqual(array->residentBytes(), 0u);
+        shouldEqual(array->getItem(Shape(49, 36, 20)), 3);
+        shouldEqual(array->chunkStop(Shape(3, 4, 4)), shape);
+        shouldEqual((*array)[Shape()], 3);
+        shouldEqual(array->residentBytes(), (16*8*5 + 2*5*1)*sizeof(value_type));
+
+        try
+        {
+            array->getItem(shape);
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &)
+        {}
+    }
+
+    void testCheckoutCommit()
+    {
+        std::auto_ptr<ARRAY> array(create(shape, chunkShape, 1 << 20, 0));
+
+        array->commitSubarray(Shape(), reference);
+        MultiArray<3, value_type> result(shape);
+        array->checkoutSubarray(Shape(), result);
+        should(result == reference);
+
+        // blocks not aligned with chunks
+        Shape start(7, 3, 2), stop(41, 30, 17);
+        MultiArray<3, value_type> block(stop - start, value_type(5));
+        array->commitSubarray(start, block);
+        reference.subarray(start, stop) = block;
+        array->checkoutSubarray(Shape(), result);
+        should(result == reference);
+
+        MultiArray<3, value_type> small(Shape(3, 4, 5));
+        array->checkoutSubarray(Shape(30, 30, 15), small);
+        should(small == reference.subarray(Shape(30, 30, 15), Shape(33, 34, 20)));
+
+        shouldEqual(array->getItem(Shape(8, 4, 3)), 5);
+        array->setItem(Shape(8, 4, 3), 7);
+        shouldEqual(array->getItem(Shape(8, 4, 3)), 7);
+    }
+
+    void testIterator()
+    {
+        std::auto_ptr<ARRAY> array(create(shape, chunkShape, 1 << 20, 0));
+
+        typename ARRAY::iterator i = array->begin(), end = array->end();
+        typename MultiArray<3, value_type>::iterator r = reference.begin();
+        MultiArrayIndex count = 0;
+        for(; i != end; ++i, ++r, ++count)
+        {
+            shouldEqual(i.scanOrderIndex(), count);
+            *i = *r;
+        }
+        shouldEqual(count, prod(shape));
+
+        ARRAY const & carray = *array;
+        typename ARRAY::const_iterator ci = carray.begin(), cend = carray.end();
+        should(std::equal(ci, cend, reference.begin()));
+        shouldEqual(array->getItem(Shape(25, 19, 11)), reference(25, 19, 11));
+    }
+
+    void testEviction()
+    {
+        // room for just two chunks (ignored by backends without eviction)
+        std::auto_ptr<ARRAY> array(create(shape, chunkShape, 
+                                          2*prod(chunkShape)*sizeof(value_type), 0));
+        std::size_t budget = array->memoryBudget();
+
+        array->commitSubarray(Shape(), reference);
+        should(array->residentBytes() <= budget);
+
+        MultiArray<3, value_type> result(shape);
+        array->checkoutSubarray(Shape(), result);
+        should(result == reference);
+        should(array->residentBytes() <= budget);
+
+        for(int k=0; k<200; ++k)
+        {
+            Shape p(k % shape[0], (7*k) % shape[1], (13*k) % shape[2]);
+            array->setItem(p, value_type(k));
+            reference[p] = value_type(k);
+        }
+        should(array->residentBytes() <= budget);
+
+        array->setMemoryBudget(0);
+        shouldEqual(array->residentBytes(), 0u);
+        array->checkoutSubarray(Shape(), result);
+        should(result == reference);
+    }
+
+    void testPointOperators()
+    {
+        std::auto_ptr<ARRAY> array(create(shape, chunkShape, 1 << 16, 0)),
+                             other(create(shape, Shape(10, 10, 10), 1 << 16, 0)),
+                             same(create(shape, chunkShape, 1 << 16, 0));
+
+        transformMultiArray(reference, *array, Arg1() + Param(1));
+
+        FindMinMax<value_type> minmax, expected;
+        inspectMultiArray(*array, minmax);
+        inspectMultiArray(srcMultiArrayRange(reference), expected);
+        shouldEqual(minmax.count, expected.count);
+        shouldEqual(minmax.min, expected.min + 1);
+        shouldEqual(minmax.max, expected.max + 1);
+
+        // different chunk shapes
+        transformMultiArray(*array, *other, Arg1() * Param(2));
+        // identical chunk shapes
+        transformMultiArray(*other, *same, Arg1() - Param(2));
+
+        MultiArray<3, value_type> result(shape), desired(shape);
+        transformMultiArray(*same, result, Arg1() - Param(1));
+        transformMultiArray(srcMultiArrayRange(reference), destMultiArray(desired), 
+                            Arg1()*Param(2) - Param(1));
+        should(result == desired);
+    }
+
+    void testChunkLock()
+    {
+        std::auto_ptr<ARRAY> array(create(shape, chunkShape, 1 << 20, 0));
+        {
+            typename ARRAY::ChunkLock lock(*array, Shape(3, 4, 4));
+            shouldEqual(lock.start(), Shape(48, 32, 20));
+            shouldEqual(lock.view().shape(), Shape(2, 5, 1));
+            lock.view().init(9);
+        }
+        shouldEqual(array->getItem(Shape(49, 36, 20)), 9);
+        shouldEqual(array->getItem(Shape(47, 36, 20)), 0);
+    }
+};
+
+template <>
+ChunkedArrayLazy<3, int> * 
+ChunkedArrayTest<ChunkedArrayLazy<3, int> >::create(Shape const & shape, Shape const & chunkShape, 
+                                                    std::size_t, int fill)
+{
+    return new ChunkedArrayLazy<3, int>(shape, chunkShape, fill);
+}
+
+template <>
+ChunkedArrayCompressed<3, int> * 
+ChunkedArrayTest<ChunkedArrayCompressed<3, int> >::create(Shape const & shape, Shape const & chunkShape, 
+                                                          std::size_t budget, int fill)
+{
+    return new ChunkedArrayCompressed<3, int>(shape, chunkShape, budget, fill);
+}
+
+template <>
+ChunkedArrayCompressed<3, float> * 
+ChunkedArrayTest<ChunkedArrayCompressed<3, float> >::create(Shape const & shape, Shape const & chunkShape, 
+                                                            std::size_t budget, float fill)
+{
+    return new ChunkedArrayCompressed<3, float>(shape, chunkShape, budget, fill);
+}
+
+template <>
+ChunkedArrayMmap<3, int> * 
+ChunkedArrayTest<ChunkedArrayMmap<3, int> >::create(Shape const & shape, Shape const & chunkShape, 
+                                                    std::size_t, int fill)
+{
+    static int count = 0;
+    char name[100];
+    std::sprintf(name, "chunked_mmap_%d.dat", count++);
+    createdFiles().push_back(name);
+    return new ChunkedArrayMmap<3, int>(name, shape, chunkShape, fill);
+}
+
+struct RunLengthCodingTest
+{
+    void testRunLengthCoding()
+    {
+        int data[] = { 1, 2, 3, 3, 3, 3, 4, 5, 5, 6, 6, 6, 7 };
+        ArrayVector<char> code;
+        detail::runLengthEncode(data, 13, code);
+        // blocks: [1,2] [3 x4] [4,5,5] [6 x3] [7]
+        shouldEqual(code.size(), 5*sizeof(Int32) + 8*sizeof(int));
+        int result[13];
+        detail::runLengthDecode(code, result, 13);
+        shouldEqualSequence(result, result + 13, data);
+
+        ArrayVector<int> constant(10000, 42);
+        detail::runLengthEncode(constant.data(), constant.size(), code);
+        shouldEqual(code.size(), sizeof(Int32) + sizeof(int));
+
+        ChunkedArrayCompressed<2, UInt8> array(Shape2(1000, 1000), Shape2(100, 100), 0, 1);
+        array.setItem(Shape2(555, 555), 2);
+        shouldEqual(array.getItem(Shape2(555, 555)), 2);
+        shouldEqual(array.residentBytes(), 0u);
+        // only the modified chunk is stored
+        should(array.compressedBytes() < 100u);
+    }
+};
+
+// backing store whose writes fail while 'fail' is true
+struct FailingChunkedArray
+: public ChunkedArray<2, int>
+{
+    bool fail;
+    int stored;
+
+    FailingChunkedArray(std::size_t memoryBudget)
+    : ChunkedArray<2, int>(Shape2(20, 20), Shape2(10, 10), memoryBudget),
+      fail(true),
+      stored(0)
+    {}
+
+    ~FailingChunkedArray()
+    {
+        unloadChunks();
+    }
+
+  protected:
+    virtual int * loadChunk(Shape2 const &, Shape2 const & shape)
+    {
+        int * data = new int[prod(shape)];
+        std::fill(data, data + prod(shape), 0);
+        return data;
+    }
+
+    virtual void storeChunk(Shape2 const &, Shape2 const &, int *)
+    {
+        if(fail)
+            vigra_fail("FailingChunkedArray: disk full.");
+        ++stored;
+    }
+
+    virtual void releaseChunk(Shape2 const &, Shape2 const &, int * data)
+    {
+        delete [] data;
+    }
+};
+
+struct ChunkedArrayStoreTest
+{
+    void testModifiedChunks()
+    {
+        typedef ChunkedArrayCompressed<2, int> Array;
+        Array array(Shape2(100, 100), Shape2(10, 10), 1 << 20, 0);
+
+        // reading via the non-const iterator doesn't mark chunks as modified
+        int sum = 0;
+        for(Array::iterator i = array.begin(), end = array.end(); i != end; ++i)
+            sum += *i;
+        shouldEqual(sum, 0);
+        array.flush();
+        shouldEqual(array.compressedBytes(), 0u);
+
+        // writing does
+        Array::iterator i = array.begin();
+        ++i;
+        *i = 3;
+        *i += 2;
+        shouldEqual((int)*i, 5);
+        array.flush();
+        should(array.compressedBytes() > 0u);
+        should(array.compressedBytes() < 100u);
+        shouldEqual(array.getItem(Shape2(1, 0)), 5);
+    }
+
+    void testStoreErrors()
+    {
+        {
+            FailingChunkedArray array(1 << 20);
+            array.setItem(Shape2(3, 4), 1);
+            try
+            {
+                array.flush();
+                failTest("flush() did not throw.");
+            }
+            catch(std::runtime_error & e)
+            {
+                std::string expected("FailingChunkedArray: disk full.");
+                should(std::string(e.what()).find(expected) != std::string::npos);
+            }
+            // the destructor doesn't throw, although a modified chunk cannot be stored
+        }
+        {
+            // no memory budget: chunks are unloaded when the lock of setItem() 
+            // or the iterator is released, which must not throw
+            FailingChunkedArray array(0);
+            array.setItem(Shape2(3, 4), 1);
+            *array.begin() = 2;
+            should(array.residentBytes() > 0u);
+            shouldEqual(array.getItem(Shape2(3, 4)), 1);
+            shouldEqual(array.getItem(Shape2(0, 0)), 2);
+
+            array.fail = false;
+            array.flush();
+            shouldEqual(array.stored, 1);
+            array.releaseChunks();
+            shouldEqual(array.residentBytes(), 0u);
+        }
+    }
+};
+
+template <class ARRAY>
+struct ChunkedArrayTestSuite
+: public vigra::test_suite
+{
+    ChunkedArrayTestSuite(const char * name)
+    : vigra::test_suite(name)
+    {
+        add( testCase( &ChunkedArrayTest<ARRAY>::testFillAndShape));
+        add( testCase( &ChunkedArrayTest<ARRAY>::testCheckoutCommit));
+        add( testCase( &ChunkedArrayTest<ARRAY>::testIterator));
+        add( testCase( &ChunkedArrayTest<ARRAY>::testEviction));
+        add( testCase( &ChunkedArrayTest<ARRAY>::testPointOperators));
+        add( testCase( &ChunkedArrayTest<ARRAY>::testChunkLock));
+    }
+};
+
+struct ChunkedArrayAllTestSuite
+: public vigra::test_suite
+{
+    ChunkedArrayAllTestSuite()
+    : vigra::test_suite("ChunkedArrayTestSuite")
+    {
+        add( testCase( &RunLengthCodingTest::testRunLengthCoding));
+        add( testCase( &ChunkedArrayStoreTest::testModifiedChunks));
+        add( testCase( &ChunkedArrayStoreTest::testStoreErrors));
+        add( new ChunkedArrayTestSuite<ChunkedArrayLazy<3, int> >("ChunkedArrayLazy<3, int>"));
+        add( new ChunkedArrayTestSuite<ChunkedArrayCompressed<3, int> >("ChunkedArrayCompressed<3, int>"));
+        add( new ChunkedArrayTestSuite<ChunkedArrayCompressed<3, float> >("ChunkedArrayCompressed<3, float>"));
+        add( new ChunkedArrayTestSuite<ChunkedArrayMmap<3, int> >("ChunkedArrayMmap<3, int>"));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    ChunkedArrayAllTestSuite test;
+
+    int failed = test.run(vigra::testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+    return (failed != 0);
+}
@@ -4,7 +4,8 @@
 #include "unittest.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/multi_pointoperators.hxx"
-//#include "vigra/multi_convolution.hxx"
+#include "vigra/multi_convolution.hxx"
+#include "vigra/timing.hxx"
 #include "vigra/basicimageview.hxx"
 #include "vigra/convolution.hxx" 
 #include "vigra/navigator.hxx"
@@ -331,6 +332,43 @@ struct MultiArraySepConvSpeedTest
   }
 
 
+  // compare line-by-line and blocked processing of a single separable pass
+  // (the lines of axes 1 and 2 are strided in memory)
+  void testBlockedPasses()
+  {
+    typedef Kernel1D<float> Kernel;
+    typedef detail::SeparableConvolveLinesFunctor<Image3D::traverser, Size3, 
+                       StandardValueAccessor<PixelType>, Image3D::traverser, 
+                       StandardValueAccessor<PixelType>, Kernel, PixelType> Functor;
+
+    Size3 bigsize(256, 256, 256);
+    Image3D src(bigsize), lines(bigsize), blocks(bigsize);
+    makeBox( src );
+    double megabytes = src.size() * sizeof(PixelType) / (1024.0 * 1024.0);
+    
+    USETICTOC;
+    for(int d=0; d<3; ++d)
+    {
+      Functor f(src.traverser_begin(), Size3(), bigsize, StandardValueAccessor<PixelType>(),
+                lines.traverser_begin(), Size3(), bigsize, StandardValueAccessor<PixelType>(),
+                kernels[d], d);
+      Functor g(src.traverser_begin(), Size3(), bigsize, StandardValueAccessor<PixelType>(),
+                blocks.traverser_begin(), Size3(), bigsize, StandardValueAccessor<PixelType>(),
+                kernels[d], d);
+      
+      TIC;
+      detail::separableConvolveLines(f, 1, 1);
+      double tlines = TOCN;
+      TIC;
+      detail::separableConvolveLines(g, 1, ConvolutionOptions<3>().block_lines);
+      double tblocks = TOCN;
+      
+      std::cout << "   axis " << d << ": line-by-line " << megabytes / tlines * 1000.0 << " MB/s, "
+                << "blocked " << megabytes / tblocks * 1000.0 << " MB/s" << std::endl;
+      shouldEqualSequence(lines.begin(), lines.end(), blocks.begin());
+    }
+  }
+
   void makeBox( Image3D &image )
   {
     const int b = 8;
@@ -371,6 +409,7 @@ struct MultiArraySepConvSpeedTestSuite
         add( testCase( &MultiArraySepConvSpeedTest::test1 ) );
         add( testCase( &MultiArraySepConvSpeedTest::test2 ) );
         add( testCase( &MultiArraySepConvSpeedTest::testCorrectness ) );
+        add( testCase( &MultiArraySepConvSpeedTest::testBlockedPasses ) );
     }
 };
 
@@ -318,6 +318,55 @@ struct MultiArraySeparableConvolutionTest
         }
     }
 
+    void testParallelSmoothing()
+    {
+        makeRandom(srcImage);
+
+        ArrayVector<Kernel1D<double> > kernels(3);
+        kernels[0].initGaussian(1.0);
+        kernels[1].initAveraging(1);
+        kernels[2].initGaussian(2.0);
+
+        Image3D res(shape);
+        separableConvolveMultiArray(srcMultiArrayRange(srcImage), destMultiArray(res), 
+                                    kernels.begin());
+
+        for(int threads=0; threads<5; ++threads)
+        {
+            Image3D pres(shape);
+            separableConvolveMultiArray(srcMultiArrayRange(srcImage), destMultiArray(pres), 
+                                        kernels.begin(), ConvolutionOptions<3>().numThreads(threads));
+            shouldEqualSequence(pres.begin(), pres.end(), res.begin());
+
+            // in-place
+            pres = srcImage;
+            separableConvolveMultiArray(srcMultiArrayRange(pres), destMultiArray(pres), 
+                                        kernels.begin(), ConvolutionOptions<3>().numThreads(threads));
+            shouldEqualSequence(pres.begin(), pres.end(), res.begin());
+
+            // subarray
+            Shape3 start(2, 14, 1), stop(shape[0]-2, 44, shape[2]-1);
+            Image3D subarray(stop-start);
+            separableConvolveMultiArray(srcMultiArrayRange(srcImage), destMultiArray(subarray), 
+                                        kernels.begin(), 
+                                        ConvolutionOptions<3>().subarray(start, stop).numThreads(threads));
+            shouldEqualSequenceTolerance(subarray.begin(), subarray.end(), 
+                                         res.subarray(start, stop).begin(), 1e-6);
+        }
+
+        Image3D sres(shape), pres(shape);
+        gaussianSmoothMultiArray(srcMultiArrayRange(srcImage), destMultiArray(sres), 2.0);
+        gaussianSmoothMultiArray(srcMultiArrayRange(srcImage), destMultiArray(pres), 2.0, 
+                                 ConvolutionOptions<3>().numThreads(4));
+        shouldEqualSequence(pres.begin(), pres.end(), sres.begin());
+
+        Image3x3 sgrad(shape), pgrad(shape);
+        gaussianGradientMultiArray(srcMultiArrayRange(srcImage), destMultiArray(sgrad), 1.5);
+        gaussianGradientMultiArray(srcMultiArrayRange(srcImage), destMultiArray(pgrad), 1.5, 
+                                   ConvolutionOptions<3>().numThreads(3));
+        shouldEqualSequence(pgrad.begin(), pgrad.end(), sgrad.begin());
+    }
+
     void test_inplaceness1( const Image3D &src, float ksize, bool useDerivative )
     {
         Image3D da( src.shape() );
@@ -532,6 +581,7 @@ struct MultiArraySeparableConvolutionTestSuite
                 add( testCase( &MultiArraySeparableConvolutionTest::test_InplaceN ) );
                 add( testCase( &MultiArraySeparableConvolutionTest::test_Inplace1 ) );
                 add( testCase( &MultiArraySeparableConvolutionTest::testSmoothing ) );
+                add( testCase( &MultiArraySeparableConvolutionTest::testParallelSmoothing ) );
                 add( testCase( &MultiArraySeparableConvolutionTest::test_gradient1 ) );
                 add( testCase( &MultiArraySeparableConvolutionTest::test_laplacian ) );
                 add( testCase( &MultiArraySeparableConvolutionTest::test_hessian ) );
@@ -1143,6 +1143,62 @@ struct MultiDistanceTest
         }
     }
 
+    void featureTransformTest()
+    {
+        TinyVector<double, 3> pixelPitch(1.2, 1.0, 2.4);
+        MultiArray<3, TinyVector<int, 3> > features(volume.shape());
+        DoubleVolume dist(volume.shape());
+
+        for(int aniso=0; aniso<2; ++aniso)
+        {
+            TinyVector<double, 3> pitch = aniso ? pixelPitch : TinyVector<double, 3>(1.0);
+
+            for(std::list<std::list<IntVec> >::iterator list_iter=pointslists.begin(); 
+                                              list_iter!=pointslists.end(); ++list_iter)
+            {
+                volume.init(0.0);
+                for(std::list<IntVec>::iterator iter=(*list_iter).begin(); iter!=(*list_iter).end(); ++iter)
+                    volume[*iter] = 1;
+
+                if(aniso)
+                    separableMultiFeatureTransform(srcMultiArrayRange(volume), destMultiArray(dist),
+                                                   destMultiArray(features), true, pitch);
+                else
+                    separableMultiFeatureTransform(srcMultiArrayRange(volume), destMultiArray(dist),
+                                                   destMultiArray(features), true);
+
+                for(int z=0; z<DEPTH; ++z)
+                    for(int y=0; y<HEIGHT; ++y)
+                        for(int x=0; x<WIDTH; ++x)
+                        {
+                            IntVec p(x,y,z), f = features(x,y,z);
+                            double best = 1e10;
+                            for(std::list<IntVec>::iterator iter=(*list_iter).begin(); iter!=(*list_iter).end(); ++iter)
+                                best = std::min(best, (pitch*(p-*iter)).squaredMagnitude());
+
+                            // the feature must be a seed, and no other seed may be closer
+                            shouldEqual(volume[f], 1.0);
+                            double d2 = (pitch*(p-f)).squaredMagnitude();
+                            should(std::abs(d2 - best) < 1e-10);
+                            should(std::abs(dist(x,y,z) - std::sqrt(best)) < 1e-10);
+                        }
+            }
+        }
+
+        // the inverse transform finds the nearest zero point
+        typedef MultiArrayShape<3>::type Shape;
+        MultiArrayView<3, double> vol(Shape(12,10,35), volume_data);
+        MultiArray<3, TinyVector<int, 3> > nearest(vol.shape());
+
+        separableMultiFeatureTransform(srcMultiArrayRange(vol), destMultiArray(nearest), false);
+        for(int k=0; k<vol.elementCount(); ++k)
+        {
+            shouldEqual(vol[nearest[k]], 0.0);
+            Shape p(k % 12, (k / 12) % 10, k / 120);
+            shouldEqual((double)(p - Shape(nearest[k])).squaredMagnitude(), ref_dist2[k]);
+        }
+    }
+
     void distanceTest1D()
     {
         vigra::MultiArray<2,double> res(img2);
@@ -1166,6 +1222,7 @@ struct SimpleAnalysisTestSuite
         add( testCase( &MultiDistanceTest::testDistanceVolumesAnisoptopic));
         add( testCase( &MultiDistanceTest::distanceTransform2DCompare));
         add( testCase( &MultiDistanceTest::distanceTest1D));
+        add( testCase( &MultiDistanceTest::featureTransformTest));
     }
 };
 
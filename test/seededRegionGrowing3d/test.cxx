@@ -39,6 +39,8 @@
 #include "unittest.hxx"
 
 #include "vigra/seededregiongrowing3d.hxx"
+#include "vigra/blockwise_seededregiongrowing.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -288,6 +290,182 @@ struct SeededRegionGrowing3DTest
         shouldEqualSequence(res.begin(), res.end(), vol3.begin());
     }
     
+    struct MeanCostFunctor
+    {
+        typedef double argument_type;
+        typedef double result_type;
+        typedef double cost_type;
+
+        double sum;
+        int count;
+
+        MeanCostFunctor()
+        : sum(0.0), count(0)
+        {}
+
+        void operator()(double const & v)
+        {
+            sum += v;
+            ++count;
+        }
+
+        double cost(double const & v) const
+        {
+            return count == 0 ? v : std::abs(v - sum / count);
+        }
+    };
+
+    template <unsigned int N, class Stats, class Neighborhood>
+    void checkBlockwise(MultiArray<N, double> const & src, MultiArray<N, int> const & seeds,
+                        MultiArray<N, int> const & serial, Stats const & stats, 
+                        SRGType type, Neighborhood neighborhood, double max_cost)
+    {
+        // block sizes from one line/slice to more than the whole array
+        int blockSizes[] = { 1, 3, 8, 16, 40, 100 };
+        for(int b=0; b<6; ++b)
+        {
+            for(int nthreads=1; nthreads<=3; ++nthreads)
+            {
+                MultiArray<N, int> res(src.shape());
+                Stats s(stats);
+                seededRegionGrowingBlockwise(src, seeds, res, s, type, neighborhood,
+                                             nthreads, blockSizes[b], max_cost);
+                shouldEqualSequence(res.begin(), res.end(), serial.begin());
+            }
+        }
+
+        MultiArray<N, int> inplace(seeds);
+        Stats s(stats);
+        seededRegionGrowingBlockwise(src, inplace, inplace, s, type, neighborhood,
+                                     2, 7, max_cost);
+        shouldEqualSequence(inplace.begin(), inplace.end(), serial.begin());
+    }
+
+    void blockwiseTest()
+    {
+        typedef IntVolume::difference_type Shape;
+        Shape shape(20, 15, 40);
+        DoubleVolume boundaries(shape), plateaus(shape);
+        IntVolume seeds(shape);
+        vigra::RandomMT19937 random(7);
+
+        // seeds at the minima of a noisy distance transform (as in watersheds),
+        // only in the first half of the volume, so that the blocks of the
+        // second half contain no seeds
+        int seedCount = 30;
+        ArrayVector<Shape> points;
+        for(int k=1; k<=seedCount; ++k)
+        {
+            points.push_back(Shape(random.uniformInt(shape[0]), random.uniformInt(shape[1]), 
+                                   random.uniformInt(shape[2] / 2)));
+            seeds[points.back()] = k;
+        }
+        for(int z=0; z<shape[2]; ++z)
+            for(int y=0; y<shape[1]; ++y)
+                for(int x=0; x<shape[0]; ++x)
+                {
+                    double d = NumericTraits<double>::max();
+                    for(int k=0; k<seedCount; ++k)
+                        d = std::min(d, (double)squaredNorm(points[k] - Shape(x,y,z)));
+                    boundaries(x,y,z) = std::sqrt(d) + 0.5*random.uniform();
+                    // many candidates of equal cost
+                    plateaus(x,y,z) = std::floor(std::sqrt(d) / 2.0);
+                }
+
+        SRGType types[] = { CompleteGrow, KeepContours, 
+                            SRGType(CompleteGrow | StopAtThreshold), 
+                            SRGType(KeepContours | StopAtThreshold) };
+        for(int t=0; t<4; ++t)
+        {
+            for(int i=0; i<2; ++i)
+            {
+                DoubleVolume const & src = i == 0 ? boundaries : plateaus;
+
+                vigra::ArrayOfRegionStatistics<DirectCostFunctor> cost(seedCount), serialCost(seedCount);
+                IntVolume serial(shape);
+                seededRegionGrowing3D(srcMultiArrayRange(src), srcMultiArray(seeds),
+                                      destMultiArray(serial), serialCost, types[t], NeighborCode3DSix(), 3.0);
+                if(types[t] == CompleteGrow)
+                    should(*argMin(serial.begin(), serial.end()) > 0);
+                checkBlockwise(src, seeds, serial, cost, types[t], NeighborCode3DSix(), 3.0);
+
+                // static costs are flooded concurrently
+                vigra::ArrayOfRegionStatistics<SeedRgDirectValueFunctor<double> > direct(seedCount);
+                checkBlockwise(src, seeds, serial, direct, types[t], NeighborCode3DSix(), 3.0);
+
+                // statistics that are updated while the regions grow
+                vigra::ArrayOfRegionStatistics<MeanCostFunctor> mean(seedCount), serialMean(seedCount);
+                seededRegionGrowing3D(srcMultiArrayRange(src), srcMultiArray(seeds),
+                                      destMultiArray(serial), serialMean, types[t], NeighborCode3DSix(), 3.0);
+                checkBlockwise(src, seeds, serial, mean, types[t], NeighborCode3DSix(), 3.0);
+
+                // stats are updated as in the serial algorithm
+                IntVolume res(shape);
+                seededRegionGrowingBlockwise(src, seeds, res, mean, types[t], NeighborCode3DSix(),
+                                             3, 8, 3.0);
+                for(int k=0; k<=seedCount; ++k)
+                {
+                    shouldEqual(mean[k].count, serialMean[k].count);
+                    shouldEqualTolerance(mean[k].sum, serialMean[k].sum, 1e-10);
+                }
+            }
+        }
+
+        // a constant volume, where all candidates only differ by distance and
+        // insertion order, with seeds in every block
+        DoubleVolume constant(shape, 1.0);
+        vigra::ArrayOfRegionStatistics<SeedRgDirectValueFunctor<double> > direct(2*seedCount);
+        IntVolume manySeeds(seeds);
+        for(int k=seedCount+1; k<=2*seedCount; ++k)
+            manySeeds(random.uniformInt(shape[0]), random.uniformInt(shape[1]), 
+                      random.uniformInt(shape[2])) = k;
+        for(int t=0; t<2; ++t)
+        {
+            IntVolume serial(shape);
+            seededRegionGrowing3D(srcMultiArrayRange(constant), srcMultiArray(manySeeds),
+                                  destMultiArray(serial), direct, types[t], NeighborCode3DTwentySix());
+            checkBlockwise(constant, manySeeds, serial, direct, types[t], NeighborCode3DTwentySix(),
+                           NumericTraits<double>::max());
+        }
+
+        MultiArray<2, double> image(boundaries.bindOuter(0));
+        MultiArray<2, int> seeds2(image.shape()), serial2(image.shape());
+        for(int k=1; k<=10; ++k)
+            seeds2(random.uniformInt(shape[0]), random.uniformInt(shape[1] / 2)) = k;
+        for(int t=0; t<4; ++t)
+        {
+            vigra::ArrayOfRegionStatistics<MeanCostFunctor> mean(10), serialMean(10);
+            seededRegionGrowing(srcImageRange(image), srcImage(seeds2), destImage(serial2),
+                                serialMean, types[t], FourNeighborCode(), 3.0);
+            checkBlockwise(image, seeds2, serial2, mean, types[t], FourNeighborCode(), 3.0);
+
+            vigra::ArrayOfRegionStatistics<DirectCostFunctor> cost(10), serialCost(10);
+            seededRegionGrowing(srcImageRange(image), srcImage(seeds2), destImage(serial2),
+                                serialCost, types[t], EightNeighborCode(), 3.0);
+            checkBlockwise(image, seeds2, serial2, cost, types[t], EightNeighborCode(), 3.0);
+
+            vigra::ArrayOfRegionStatistics<SeedRgDirectValueFunctor<double> > direct(10);
+            checkBlockwise(image, seeds2, serial2, direct, types[t], EightNeighborCode(), 3.0);
+        }
+
+        // few gray levels, where the repairs let pixels arrive the same way
+        // again after arriving differently in between
+        vigra::RandomMT19937 levels(277);
+        MultiArray<2, double> quantized(Shape2(40, 13));
+        MultiArray<2, int> seeds3(quantized.shape()), serial3(quantized.shape());
+        for(int k=1; k<=3; ++k)
+            seeds3(levels.uniformInt(40), levels.uniformInt(13)) = k;
+        for(int k=0; k<quantized.size(); ++k)
+            quantized[k] = std::floor(levels.uniform() * 20.0);
+        for(int t=0; t<4; ++t)
+        {
+            vigra::ArrayOfRegionStatistics<SeedRgDirectValueFunctor<double> > direct(3);
+            seededRegionGrowing(srcImageRange(quantized), srcImage(seeds3), destImage(serial3),
+                                direct, types[t], FourNeighborCode(), 10.0);
+            checkBlockwise(quantized, seeds3, serial3, direct, types[t], FourNeighborCode(), 10.0);
+        }
+    }
+
     IntVolume    vol1;
     DoubleVolume vol2;
     IntVolume    vol3;
@@ -306,6 +484,7 @@ struct SeededRegionGrowing3DTestSuite
         add( testCase( &SeededRegionGrowing3DTest::voronoiTest));
         add( testCase( &SeededRegionGrowing3DTest::voronoiTestWithBorder));
         add( testCase( &SeededRegionGrowing3DTest::simpleTest));
+        add( testCase( &SeededRegionGrowing3DTest::blockwiseTest));
     }
 };
 
@@ -0,0 +1,89 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2004-2011 by Ullrich Koethe                  */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+/* Benchmark of the Euclidean distanceTransform() for square images from
+   256x256 up to 4096x4096 with a few random object pixels (i.e. large
+   background regions).
+
+   Usage: distancetransform_benchmark [max_size [threads]]
+
+   Prints the run time in ms of the former vector propagation algorithm
+   (internalDistanceTransform() with the L2 norm functor, which is
+   approximate), and of the exact linear-time algorithm on one and on
+   'threads' threads (default: all available).
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include "vigra/stdimage.hxx"
+#include "vigra/distancetransform.hxx"
+#include "vigra/random.hxx"
+#include "vigra/timing.hxx"
+
+using namespace vigra;
+
+int main(int argc, char ** argv)
+{
+    int maxSize = argc > 1 ? std::atoi(argv[1]) : 4096;
+    int nthreads = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    std::cout << "      size   propagation     exact(1)     exact(" << parallelThreadCount(nthreads) << ")  [ms]\n";
+    RandomMT19937 random(42);
+    for(int n = 256; n <= maxSize; n *= 2)
+    {
+        BImage objects(n, n);
+        for(int k = 0; k < 20; ++k)
+            objects(random.uniformInt(n), random.uniformInt(n)) = 1;
+        FImage dist(n, n);
+
+        USETICTOC;
+        std::cout << std::setw(10) << n << std::fixed << std::setprecision(1);
+        TIC;
+        internalDistanceTransform(objects.upperLeft(), objects.lowerRight(), objects.accessor(),
+                                  dist.upperLeft(), dist.accessor(), 0,
+                                  InternalDistanceTransformL2NormFunctor());
+        std::cout << std::setw(14) << TOCN;
+        TIC;
+        distanceTransform(srcImageRange(objects), destImage(dist), 0, 2);
+        std::cout << std::setw(13) << TOCN;
+        TIC;
+        distanceTransform(srcImageRange(objects), destImage(dist), 0, 2,
+                          TinyVector<double, 2>(1.0), nthreads);
+        std::cout << std::setw(13) << TOCN << std::endl;
+    }
+    return 0;
+}
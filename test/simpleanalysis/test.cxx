@@ -40,6 +40,8 @@
 #include "unittest.hxx"
 #include "vigra/stdimage.hxx"
 #include "vigra/labelimage.hxx"
+#include "vigra/blockwise_labeling.hxx"
+#include "vigra/random.hxx"
 #include "vigra/edgedetection.hxx"
 #include "vigra/distancetransform.hxx"
 #include "vigra/localminmax.hxx"
@@ -366,6 +368,40 @@ struct LabelingTest
         }
     }
 
+    void labelingBlockwiseTest()
+    {
+        // random blobs: smooth a random image and threshold it
+        MultiArray<2, int> src(Shape2(37, 45)), serial(src.shape()), res(src.shape());
+        RandomMT19937 random(3);
+        for(MultiArray<2, int>::iterator i = src.begin(); i != src.end(); ++i)
+            *i = random.uniformInt(10) < 4 ? 1 : 0;
+        for(int y=1; y<src.shape(1); ++y)
+            for(int x=0; x<src.shape(0); ++x)
+                if(random.uniformInt(3) == 0)
+                    src(x, y) = src(x, y-1);
+
+        for(int eight=0; eight<2; ++eight)
+        {
+            unsigned int count = labelImage(srcImageRange(src), destImage(serial), eight == 1);
+            int blockSizes[] = { 1, 4, 10, 45 };
+            for(int k=0; k<4; ++k)
+            {
+                res.init(0);
+                shouldEqual(count, labelImageBlockwise(src, res, eight == 1, 3, blockSizes[k]));
+                shouldEqualSequence(res.begin(), res.end(), serial.begin());
+            }
+
+            serial.init(0); // labelImageWithBackground() doesn't touch the background
+            count = labelImageWithBackground(srcImageRange(src), destImage(serial), eight == 1, 0);
+            for(int k=0; k<4; ++k)
+            {
+                res.init(42);
+                shouldEqual(count, labelImageWithBackgroundBlockwise(src, res, eight == 1, 0, 2, blockSizes[k]));
+                shouldEqualSequence(res.begin(), res.end(), serial.begin());
+            }
+        }
+    }
+
     Image img1, img2, img3, img4;
 };
 
@@ -788,6 +824,62 @@ struct DistanceTransformTest
         }
     }
 
+    void distanceTransformL2ExactTest()
+    {
+        // compare with brute force on random objects, anisotropic pixels
+        // and different thread counts
+        int w = 53, h = 37;
+        vigra::BImage objects(w, h);
+        vigra::RandomMT19937 random(42);
+        for(int k = 0; k < 12; ++k)
+            objects(random.uniformInt(w), random.uniformInt(h)) = 1;
+
+        vigra::TinyVector<double, 2> pitches[] = {
+            vigra::TinyVector<double, 2>(1.0, 1.0),
+            vigra::TinyVector<double, 2>(1.0, 2.5),
+            vigra::TinyVector<double, 2>(0.7, 0.3) };
+        for(int p = 0; p < 3; ++p)
+        {
+            vigra::TinyVector<double, 2> pitch = pitches[p];
+            Image desired(w, h);
+            for(int y = 0; y < h; ++y)
+            {
+                for(int x = 0; x < w; ++x)
+                {
+                    double dist = vigra::NumericTraits<double>::max();
+                    for(int yy = 0; yy < h; ++yy)
+                        for(int xx = 0; xx < w; ++xx)
+                            if(objects(xx, yy) != 0)
+                                dist = std::min(dist, vigra::sq(pitch[0]*(x - xx)) +
+                                                      vigra::sq(pitch[1]*(y - yy)));
+                    desired(x, y) = VIGRA_CSTD::sqrt(dist);
+                }
+            }
+
+            for(int nthreads = 1; nthreads <= 4; nthreads += 3)
+            {
+                Image res(w, h);
+                distanceTransform(srcImageRange(objects), destImage(res), 0, 2, pitch, nthreads);
+                for(int y = 0; y < h; ++y)
+                    for(int x = 0; x < w; ++x)
+                        should(std::abs(res(x, y) - desired(x, y)) < 1e-10);
+            }
+        }
+
+        Image res(w, h);
+        try
+        {
+            distanceTransform(srcImageRange(objects), destImage(res), 0, 1, pitches[1]);
+            failTest("distanceTransform() failed to throw exception.");
+        }
+        catch(vigra::PreconditionViolation & e)
+        {
+            std::string expected("\nPrecondition violation!\ndistanceTransform(): anisotropic pixel pitch");
+            std::string message(e.what());
+            should(0 == expected.compare(message.substr(0, expected.size())));
+        }
+    }
+
 
     Image img;
 };
@@ -2178,6 +2270,7 @@ struct SimpleAnalysisTestSuite
         add( testCase( &LabelingTest::labelingFourWithBackgroundTest1));
         add( testCase( &LabelingTest::labelingFourWithBackgroundTest2));
         add( testCase( &LabelingTest::labelingEightWithBackgroundTest));
+        add( testCase( &LabelingTest::labelingBlockwiseTest));
         add( testCase( &EdgeDetectionTest::edgeDetectionTest));
         add( testCase( &EdgeDetectionTest::edgeToCrackEdgeTest));
         add( testCase( &EdgeDetectionTest::removeShortEdgesTest));
@@ -2189,6 +2282,7 @@ struct SimpleAnalysisTestSuite
         add( testCase( &EdgeDetectionTest::cannyEdgeImageWithThinningTest));
         add( testCase( &DistanceTransformTest::distanceTransformL1Test));
         add( testCase( &DistanceTransformTest::distanceTransformL2Test));
+        add( testCase( &DistanceTransformTest::distanceTransformL2ExactTest));
         add( testCase( &DistanceTransformTest::distanceTransformLInfTest));
 
         add( testCase( &LocalMinMaxTest::localMinimumTest));
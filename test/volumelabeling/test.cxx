@@ -39,6 +39,8 @@
 #include "unittest.hxx"
 
 #include "vigra/labelvolume.hxx"
+#include "vigra/blockwise_labeling.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -383,6 +385,53 @@ struct VolumeLabelingTest
 
     }
 
+    void labelingBlockwiseTest()
+    {
+        // random blobs elongated along z, so that many regions span several slabs
+        IntVolume src(IntVolume::difference_type(9, 11, 30)), serial(src.shape()), res(src.shape());
+        vigra::RandomMT19937 random(5);
+        for(IntVolume::iterator i = src.begin(); i != src.end(); ++i)
+            *i = random.uniformInt(3);
+        for(int z=1; z<src.shape(2); ++z)
+            for(int y=0; y<src.shape(1); ++y)
+                for(int x=0; x<src.shape(0); ++x)
+                    if(random.uniformInt(3) != 0)
+                        src(x, y, z) = src(x, y, z-1);
+
+        int blockSizes[] = { 1, 4, 7, 30 };
+        unsigned int count = labelVolume(srcMultiArrayRange(src), destMultiArray(serial), NeighborCode3DSix());
+        for(int k=0; k<4; ++k)
+        {
+            res.init(0);
+            shouldEqual(count, labelVolumeBlockwise(src, res, NeighborCode3DSix(), 3, blockSizes[k]));
+            shouldEqualSequence(res.begin(), res.end(), serial.begin());
+        }
+
+        count = labelVolume(srcMultiArrayRange(src), destMultiArray(serial), NeighborCode3DTwentySix());
+        for(int k=0; k<4; ++k)
+        {
+            res.init(0);
+            shouldEqual(count, labelVolumeBlockwise(src, res, NeighborCode3DTwentySix(), 2, blockSizes[k]));
+            shouldEqualSequence(res.begin(), res.end(), serial.begin());
+        }
+
+        count = labelVolumeWithBackground(srcMultiArrayRange(src), destMultiArray(serial), NeighborCode3DSix(), 0);
+        for(int k=0; k<4; ++k)
+        {
+            res.init(0);
+            shouldEqual(count, labelVolumeWithBackgroundBlockwise(src, res, NeighborCode3DSix(), 0, 3, blockSizes[k]));
+            shouldEqualSequence(res.begin(), res.end(), serial.begin());
+        }
+
+        count = labelVolumeWithBackground(srcMultiArrayRange(src), destMultiArray(serial), NeighborCode3DTwentySix(), 0);
+        for(int k=0; k<4; ++k)
+        {
+            res.init(0);
+            shouldEqual(count, labelVolumeWithBackgroundBlockwise(src, res, NeighborCode3DTwentySix(), 0, 1, blockSizes[k]));
+            shouldEqualSequence(res.begin(), res.end(), serial.begin());
+        }
+    }
+
     IntVolume vol1, vol2, vol3;
     DoubleVolume vol4, vol5, vol6;
 };
@@ -405,6 +454,7 @@ struct VolumeLabelingTestSuite
         add( testCase( &VolumeLabelingTest::labelingTwentySixTest3));
         add( testCase( &VolumeLabelingTest::labelingTwentySixWithBackgroundTest1));
         add( testCase( &VolumeLabelingTest::labelingAllTest));
+        add( testCase( &VolumeLabelingTest::labelingBlockwiseTest));
     }
 };
 
@@ -453,15 +453,9 @@ SplineView_interpolatedImage(SplineView const & self, double xfactor, double yfa
                                 res(MultiArrayShape<2>::type(wn, hn));
 
     PyAllowThreads _pythread;
-    for(int yn = 0; yn < hn; ++yn)
-    {
-        double yo = yn / yfactor;
-        for(int xn = 0; xn < wn; ++xn)
-        {
-            double xo = xn / xfactor;
-            res(xn, yn) = self(xo, yo, xorder, yorder);
-        }
-    }
+    self.sampleGrid(typename SplineView::difference_type(0.0, 0.0),
+                    typename SplineView::difference_type(1.0 / xfactor, 1.0 / yfactor),
+                    res, xorder, yorder, 1);
     return res;
 }
 
@@ -485,31 +479,70 @@ VIGRA_SPLINE_IMAGE(dxyy, 1, 2)
 
 #undef VIGRA_SPLINE_IMAGE
 
-#define VIGRA_SPLINE_GRADIMAGE(what) \
+template <class SplineView>
+NumpyArray<2, Singleband<typename SplineView::value_type> >
+SplineView_gradImage(SplineView const & self, double xfactor, double yfactor, 
+                     unsigned int derivative, const char * message)
+{
+    typedef typename SplineView::value_type Value;
+    typedef MultiArrayShape<2>::type Shape;
+
+    vigra_precondition(xfactor > 0.0 && yfactor > 0.0, message);
+    int wn = int((self.width() - 1.0) * xfactor + 1.5);
+    int hn = int((self.height() - 1.0) * yfactor + 1.5);
+    NumpyArray<2, Singleband<Value> > res(Shape(wn, hn));
+
+    PyAllowThreads _pythread;
+    if(derivative > 0 && SplineView::order < 2)
+    {
+        // like SplineImageView<1>::g2x() etc.
+        res.init(NumericTraits<Value>::zero());
+        return res;
+    }
+    // dx, dy and, for the derivatives of g2, also dxx, dxy, dyy
+    ArrayVector<Shape> derivatives;
+    derivatives.push_back(Shape(1, 0));
+    derivatives.push_back(Shape(0, 1));
+    if(derivative > 0)
+    {
+        derivatives.push_back(Shape(2, 0));
+        derivatives.push_back(Shape(1, 1));
+        derivatives.push_back(Shape(0, 2));
+    }
+    MultiArray<3, Value> d(MultiArrayShape<3>::type(wn, hn, derivatives.size()));
+    self.sampleGrid(typename SplineView::difference_type(0.0, 0.0),
+                    typename SplineView::difference_type(1.0 / xfactor, 1.0 / yfactor),
+                    derivatives, d, 1);
+
+    // same expressions as SplineImageView::g2(), g2x(), g2y()
+    for(int yn = 0; yn < hn; ++yn)
+    {
+        for(int xn = 0; xn < wn; ++xn)
+        {
+            Value dx = d(xn, yn, 0), dy = d(xn, yn, 1);
+            if(derivative == 0)
+                res(xn, yn) = sq(dx) + sq(dy);
+            else if(derivative == 1)
+                res(xn, yn) = Value(2.0)*(dx * d(xn, yn, 2) + dy * d(xn, yn, 3));
+            else
+                res(xn, yn) = Value(2.0)*(dx * d(xn, yn, 3) + dy * d(xn, yn, 4));
+        }
+    }
+    return res;
+}
+
+#define VIGRA_SPLINE_GRADIMAGE(what, derivative) \
 template <class SplineView> \
 NumpyArray<2, Singleband<typename SplineView::value_type> > \
 SplineView_##what##Image(SplineView const & self, double xfactor, double yfactor) \
 { \
-    vigra_precondition(xfactor > 0.0 && yfactor > 0.0, \
+    return SplineView_gradImage(self, xfactor, yfactor, derivative, \
         "SplineImageView." #what "Image(xfactor, yfactor): factors must be positive."); \
-    int wn = int((self.width() - 1.0) * xfactor + 1.5); \
-    int hn = int((self.height() - 1.0) * yfactor + 1.5); \
-    NumpyArray<2, Singleband<typename SplineView::value_type> > res(MultiArrayShape<2>::type(wn, hn)); \
-    for(int yn = 0; yn < hn; ++yn) \
-    { \
-        double yo = yn / yfactor; \
-        for(int xn = 0; xn < wn; ++xn) \
-        { \
-            double xo = xn / xfactor; \
-            res(xn, yn) = self.what(xo, yo); \
-        } \
-    } \
-    return res; \
 }
 
-VIGRA_SPLINE_GRADIMAGE(g2)
-VIGRA_SPLINE_GRADIMAGE(g2x)
-VIGRA_SPLINE_GRADIMAGE(g2y)
+VIGRA_SPLINE_GRADIMAGE(g2,  0)
+VIGRA_SPLINE_GRADIMAGE(g2x, 1)
+VIGRA_SPLINE_GRADIMAGE(g2y, 2)
 
 #undef VIGRA_SPLINE_GRADIMAGE
 